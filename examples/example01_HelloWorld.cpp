@@ -1,10 +1,10 @@
 /*
 
-vOɏoĂ MinimumOpenPose  OpenPose VvɈ悤ɂCułB
-ȉ̃TvvO MinimumOpenPose pŏ̃vOłB
+プログラム中に出てくる MinimumOpenPose は OpenPose をよりシンプルに扱えるようにしたライブラリです。
+以下のサンプルプログラムは MinimumOpenPose を用いた最小限のプログラムです。
 
-܂A摜̑͂悻 OpenCV ōsĂ܂B
- cv:: ƕtĂ֐ϐ OpenCV Œ`Ă̂łB
+また、画像の操作はおおよそ OpenCV で行っています。
+頭に cv:: と付いている関数名や変数名は OpenCV で定義されているものです。
 
 */
 
@@ -13,22 +13,22 @@
 
 int main(int argc, char* argv[])
 {
-	// MinimumOpenPose ̏
+	// MinimumOpenPose の初期化
 	MinOpenPose openpose(op::PoseModel::BODY_25, op::Point<int>(-1, 368));
 
-	// OpenPose ɓ͂摜pӂ
+	// OpenPose に入力する画像を用意する
 	cv::Mat image = cv::imread("media/human.jpg");
 
-	// OpenPose Ŏp
+	// OpenPose で姿勢推定をする
 	auto people = openpose.estimate(image);
 
-	// p̌ʂ image ɕ`悷
+	// 姿勢推定の結果を image に描画する
 	plotBone(image, people, openpose);
 
-	// ł摜\
+	// できあがった画像を表示する
 	cv::imshow("result", image);
 
-	// L[͂܂őҋ@
+	// キー入力があるまで待機する
 	cv::waitKey(0);
 
 	return 0;
@@ -1,7 +1,7 @@
 /*
 
-MinimumOpenPose ł MinOpenPose::People Ƃf[^^ōi܂B
-̃Tvł MinOpenPose::People ̈ɂĂ܂B
+MinimumOpenPose では MinOpenPose::People というデータ型で骨格情報を扱います。
+このサンプルでは MinOpenPose::People の扱い方についてを解説します。
 
 */
 
@@ -12,65 +12,65 @@ MinimumOpenPose 
 
 int main(int argc, char* argv[])
 {
-	// MinimumOpenPose ̏
+	// MinimumOpenPose の初期化をする
 	MinOpenPose openpose(op::PoseModel::BODY_25, op::Point<int>(-1, 368));
 
-	// OpenPose ɓ͂摜pӂ
+	// OpenPose に入力する画像を用意する
 	cv::Mat image = cv::imread("media/human.jpg");
 
-	// OpenPose Ŏp
+	// OpenPose で姿勢推定をする
 	MinOpenPose::People people = openpose.estimate(image);
 
-	//  OpenPose  people ԂꂽB
-	// people  ʂɉflׂĂ̍iĂB
-	// ̂߁A͉fĂl̐[vB
+	// ここで OpenPose から people が返された。
+	// people は 画面に映る人すべての骨格情報を持っている。
+	// そのため、今回は映っている人数の数だけループする。
 
 	for (auto person_itr = people.begin(); person_itr != people.end(); person_itr++)
 	{
-		// 1l̍i擾
+		// 1人分の骨格情報を取得する
 		MinOpenPose::Person person = person_itr->second;
 
-		// 1l̍i̒ɂ͊֐߂̍WzŊi[ĂB
-		// (BODY_25 fgpĂꍇ25̊֐ߍWĂ)
-		// ̂߁Ax͊֐߂̐[vB
+		// 1人分の骨格情報の中には関節の座標が配列で格納されている。
+		// (BODY_25 モデルを使用している場合は25個の関節座標が入っている)
+		// そのため、今度は関節の数だけループする。
 
 		for (MinOpenPose::Node node : person)
 		{
-			// ֐1̏ node ϐɊi[B
-			// ֐߂̏ɂ͉ʏ XY WƐMli[ĂB
-			// MlƂ́u֐߂ł\v̂悤ȒlłAႯΒႢقǐxႢB
-			// ł́A3̒lR\[ɏo͂B
+			// 関節1つ分の情報が node 変数に格納される。
+			// 関節の情報には画面上の XY 座標と信頼値が格納されている。
+			// 信頼値とは「関節である可能性」のような値であり、低ければ低いほど精度が低い。
+			// ここでは、この3つの値をコンソールに出力する。
 			std::cout
-				<< "x: " << node.x << ", "  // ֐߂̉ʏXW
-				<< "y: " << node.y << ", "  // ֐߂̉ʏXW
-				<< "confidence: " << node.confidence  // ֐߂̐Ml
+				<< "x: " << node.x << ", "  // 関節の画面上のX座標
+				<< "y: " << node.y << ", "  // 関節の画面上のX座標
+				<< "confidence: " << node.confidence  // 関節の信頼値
 				<< std::endl;
 		}
 	}
 
-	// p̌ʂ image ɕ`悷
+	// 姿勢推定の結果を image に描画する
 	plotBone(image, people, openpose);
 
-	// ł摜\
+	// できあがった画像を表示する
 	cv::imshow("result", image);
 
-	// L[͂܂őҋ@
+	// キー入力があるまで待機する
 	cv::waitKey(0);
 
 	/**
 	 
-	⑫
+	補足
 
-	MinOpenPose::People  MinOpenPose::Person Ȃǂ̒gꍇ͐錾`mFƗǂłB
-	̃vO Visual Studio ŎsĂꍇ People ̕ENbNāu錾ֈړvu`ֈړvȂǂIł܂B
-	(̃V[gJbgL[ F12  Ctrl+F12 łB)
-	ɂAϐ֐ANX̒gǂȂĂ̂ȒPɊmFɍsƂł܂B
+	MinOpenPose::People や MinOpenPose::Person などの中身を見たい場合は宣言や定義を確認すると良いです。
+	もしこのプログラムを Visual Studio で実行している場合は People の部分を右クリックして「宣言へ移動」や「定義へ移動」などが選択できます。
+	(これらのショートカットキーは F12 と Ctrl+F12 です。)
+	これにより、変数や関数、クラスの中身がどうなっているのかを簡単に確認しに行くことができます。
 
-	̗ł MinOpenPose::People ̐̂ std::map<size_t, Person> ł邱Ƃ킩܂B
-	܂ MinOpenPose::Person ̐̂ std::vector<Node> łB
-	MinOpenPose::Node ̐̂͒PȂ\̂łB
+	今回の例であれば MinOpenPose::People の正体は std::map<size_t, Person> であることがわかります。
+	また MinOpenPose::Person の正体は std::vector<Node> です。
+	MinOpenPose::Node の正体は単なる構造体です。
 
-	:@std:: n܂Ă֐NX C++ ̕WCułB
+	注:　std:: から始まっている関数名やクラス名は C++ の標準ライブラリです。
 
 
 	*/
@@ -1,7 +1,7 @@
 /*
 
-openpose_ext ł͉摜łȂ̏\łB
-̂߁A̎psTvpӂ܂B
+openpose_ext では画像だけでなく動画の処理も可能です。
+そのため、動画の姿勢推定を行うサンプルを用意しました。
 
 */
 
@@ -13,43 +13,46 @@ openpose_ext 
 
 int main(int argc, char* argv[])
 {
-	// MinimumOpenPose ̏
+	// MinimumOpenPose の初期化をする
 	MinOpenPose openpose(op::PoseModel::BODY_25, op::Point<int>(-1, 368));
 
-	// OpenPose ɓ͂铮pӂ
-	// "media/video.mp4" ͓͂铮t@C̃pXw肷
+	// OpenPose に入力する動画を用意する
+	// "media/video.mp4" は入力する動画ファイルのパスを指定する
 	Video video;
 	video.open("media/video.mp4");
 
-	// vr[邽߂̃EBhE𐶐
-	Preview preview("result");
+	// ウィンドウの表示を別のスレッドで行う (姿勢推定の処理が表示を待たなくなる)
+	DisplayThread display;
 
-	// ̃XLbvȂǂł悤ɂ
-	VideoControllerUI videoControllUI;
-	videoControllUI.addShortcutKeys(preview, video);  // V[gJbgL[̒ǉ
+	// 動画をプレビューするためのウィンドウを生成する
+	Preview preview("result", &display);
 
-	// 悪I܂Ń[v
+	// 動画のスキップなどができるようにする
+	VideoControllerUI videoControllUI(&display);
+	videoControllUI.addShortcutKeys(preview, video);  // ショートカットキーの追加
+
+	// 動画が終わるまでループする
 	while (true)
 	{
-		// ̎̃t[ǂݍ
+		// 動画の次のフレームを読み込む
 		cv::Mat image = video.next();
 
-		// fIꍇ̓[v𔲂
+		// 映像が終了した場合はループを抜ける
 		if (image.empty()) break;
 
-		// OpenPose Ŏp
+		// OpenPose で姿勢推定をする
 		auto people = openpose.estimate(image);
 
-		// p̌ʂ image ɕ`悷
+		// 姿勢推定の結果を image に描画する
 		plotBone(image, people, openpose);
 
-		// ʂXV
-		int ret = preview.preview(image);
+		// 画面を更新する (一時停止中は同じフレームを表示し続けるため、画面の更新の間隔だけ待つ)
+		int ret = preview.preview(image, video.isPlay() ? 1 : 33);
 
-		// Đ̑ʂ\
+		// 再生の操作画面を表示する
 		videoControllUI.showUI(video);
 
-		// EscL[ꂽI
+		// Escキーが押されたら終了する
 		if (0x1b == ret) break;
 	}
 
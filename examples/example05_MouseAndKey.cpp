@@ -1,8 +1,8 @@
 /*
 
-vO̎sɃ}EXL[{[hȂǂgĉʂ𑀍삷Tvpӂ܂B
-}EXړ邱ƂŉʂɊG`Ƃł܂B
-܂AXy[XL[ŉʂZbgł܂B
+プログラムの実行中にマウスやキーボードなどを使って画面を操作するサンプルを用意しました。
+マウスを移動することで画面に絵を描くことができます。
+また、スペースキーで画面をリセットできます。
 
 */
 
@@ -10,66 +10,66 @@
 
 int main(int argc, char* argv[])
 {
-	// 摜vr[邽߂̃EBhE𐶐
+	// 画像をプレビューするためのウィンドウを生成する
 	Preview preview("result");
 
-	// 500x500̔F̉摜𐶐
+	// 500x500の白色の画像を生成する
 	cv::Mat image = cv::Mat(500, 500, CV_8UC3, { 255, 255, 255 });
 
-	// _pă}EXCxgXi[̓o^ł
+	// ラムダ式を用いてマウス操作イベントリスナーの登録ができる
 	preview.addMouseEventListener([&](int event, int x, int y) {
-		// }EXƂ
+		// マウスが動いたとき
 		if (cv::EVENT_MOUSEMOVE == event)
 		{
-			// }EẌʒuɉ~`
+			// マウスの位置に円を描く
 			cv::circle(image, { x, y }, 2, { 0, 0, 0 }, -1);
 		}
 
-		// NbNꂽƂ
+		// 左クリックが押されたとき
 		if (cv::EVENT_LBUTTONDOWN == event)
 		{
-			// Ȃ
+			// 何もしない
 		}
 
-		// ENbNꂽƂ
+		// 右クリックが押されたとき
 		if (cv::EVENT_RBUTTONDOWN == event)
 		{
-			// Ȃ
+			// 何もしない
 		}
 
-		// OpenCV ̃}EXCxg͑ɂ邪Ał͊
+		// OpenCV のマウスイベントは他にもあるが、ここでは割愛する
 	});
 
-	// _păL[{[hCxgXi[̓o^ł
+	// ラムダ式を用いてキーボード操作イベントリスナーの登録ができる
 	preview.addKeyboardEventListener([&](int key) {
-		// Xy[XL[ꂽƂ
+		// スペースキーが押されたとき
 		if (32 == key)
 		{
-			// ʂZbg
+			// 画面をリセットする
 			image = cv::Mat(500, 500, CV_8UC3, { 255, 255, 255 });
 		}
 
-		// AL[ꂽƂ
+		// Aキーが押されたとき
 		if ('a' == key)
 		{
-			// Ȃ
+			// 何もしない
 		}
 
-		// BL[ꂽƂ
+		// Bキーが押されたとき
 		if ('b' == key)
 		{
-			// Ȃ
+			// 何もしない
 		}
 
-		// OpenCV ̃L[Cxg͑ɂ邪Ał͊
+		// OpenCV のキーイベントは他にもあるが、ここでは割愛する
 	});
 
-	// Esc܂Ŗ[v
+	// Escが押されるまで無限ループする
 	while (true) {
-		// ʂXV
+		// 画面を更新する
 		int key = preview.preview(image, 33);
 
-		// Escꂽ烋[v𔲂
+		// Escが押されたらループを抜ける
 		if (0x1b == key) break;
 	}
 
@@ -1,16 +1,16 @@
 /*
 
-OpenPose ͖̏cłB
-x OpenPose ɓ͔͂̂łB
-̂ OpenPose ł̉͌ʂt@CƂēo͂łTvpӂ܂B
+OpenPose の処理は膨大です。
+同じ動画を何度も OpenPose に入力するのは非効率です。
+そのため OpenPose での解析結果をファイルとして入出力できるサンプルを用意しました。
 
-̃Tv́A1xڂ̎sł OpenPose œA͌ʂt@CƂĕۑ܂B
-2xڈȍ~̎sł1xڂ̎sŐꂽt@Cǂݍōif[^擾܂B
+このサンプルは、1度目の実行では OpenPose で動画を処理し、解析結果をファイルとして保存します。
+2度目以降の実行では1度目の実行で生成されたファイルを読み込んで骨格データを取得します。
 
-܂A͌ʂۑt@ĆA͂铮̖O̖".sqlite3"t܂B
-Ƃ "aaa.mp4" Ƃ͂ꍇA̓t@CƓꏊ "aaa.mp4.sqlite3" Ƃt@C܂B
+また、解析結果を保存するファイル名は、入力する動画の名前の末尾に".sqlite3"が付きます。
+たとえば "aaa.mp4" という動画を入力した場合、その動画ファイルと同じ場所に "aaa.mp4.sqlite3" というファイルが生成されます。
 
-̃t@Č` sqlite3 Ȃ̂ DB Browser (SQLite) ȂǂŊJƂł܂B
+このファイルの形式は sqlite3 なので DB Browser (SQLite) などで開くことができます。
 
 */
 
@@ -23,65 +23,75 @@ OpenPose 
 
 int main(int argc, char* argv[])
 {
-	// ͂ft@C̃tpX
+	// 入力する映像ファイルのフルパス
 	std::string videoPath = R"(media/video.mp4)";
 
-	// o͂ SQL t@C̃tpX
+	// 入出力する SQL ファイルのフルパス
 	std::string sqlPath = videoPath + ".sqlite3";
 
-	// MinimumOpenPose ̏
+	// MinimumOpenPose の初期化をする (OpenPose は最初に姿勢推定を行うときに起動する)
 	MinOpenPose openpose(op::PoseModel::BODY_25, op::Point<int>(-1, 368));
 
-	// OpenPose ɓ͂铮pӂ
+	// OpenPose に入力する動画を用意する
 	Video video;
 	video.open(videoPath);
 
-	// vr[邽߂̃EBhE𐶐
+	// 動画をプレビューするためのウィンドウを生成する
 	Preview preview("result");
 
-	// SQL ̓ǂݏsNX̏
+	// SQL の読み書きを行うクラスの初期化
 	SqlOpenPose sql;
 	sql.open(sqlPath, 300);
 
-	// 悪I܂Ń[v
+	// 動画と姿勢推定の設定の組み合わせごとに、結果を保存するテーブルを切り替える
+	sql.selectConfig(video.getFingerprint(), openpose);
+
+	// 動画が終わるまでループする
 	while (true)
 	{
-		// ̎̃t[ǂݍ
+		// 動画の次のフレームを読み込む
 		cv::Mat image = video.next();
 
-		// fIꍇ̓[v𔲂
+		// 映像が終了した場合はループを抜ける
 		if (image.empty()) break;
 
-		// t[ԍȂǂ̏擾
+		// フレーム番号などの情報を取得する
 		Video::FrameInfo frameInfo = video.getInfo();
 
-		// SQLɎpL^Ă΁A̒lg
+		// SQLに姿勢が記録されていれば、その値を使う
 		auto peopleOpt = sql.readBones(frameInfo.frameNumber);
 		MinOpenPose::People people;
 		if (peopleOpt)
 		{
 			people = peopleOpt.value();
+
+			// 30フレーム以内にSQLに記録されていないフレームがあれば、姿勢推定が必要になる前に OpenPose を起動しておく
+			const size_t missingFrame = sql.coverage(sql.tableName(u8"timestamp")).firstMissing(frameInfo.frameNumber);
+			if ((missingFrame < frameInfo.frameNumber + 30) && (missingFrame < frameInfo.frameSum)) openpose.warmup();
 		}
 
-		// SQLɎpL^ĂȂΎps
+		// SQLに姿勢が記録されていなければ姿勢推定を行う
 		else
 		{
-			// p
+			// 姿勢推定
 			people = openpose.estimate(image);
 
-			// ʂ SQL ɕۑ
+			// 結果を SQL に保存
 			sql.writeBones(frameInfo.frameNumber, frameInfo.frameTimeStamp, people);
 		}
 
-		// p̌ʂ image ɕ`悷
+		// 姿勢推定の結果を image に描画する
 		plotBone(image, people, openpose);
 
-		// ʂXV
+		// 画面を更新する
 		int ret  = preview.preview(image);
 
-		// EscL[ꂽI
+		// Escキーが押されたら終了する
 		if (0x1b == ret) break;
 	}
 
+	// SQLに記録されていた結果を使った割合を表示する
+	std::cout << "cache hit rate : " << sql.getCacheHitRate() * 100.0 << "% (" << sql.getCacheHits() << " / " << (sql.getCacheHits() + sql.getCacheMisses()) << ")" << std::endl;
+
 	return 0;
 }
\ No newline at end of file
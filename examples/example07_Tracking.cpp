@@ -1,8 +1,8 @@
 /*
 
-OpenPose ͉摜1PƂŏ܂B
-̂߁Aꍇ͓l̍i1t[IDUȂ܂B
-̃Tvł́At[ԂōłړȂi𓯈lƂ݂ȂID̃gbLOs܂B
+OpenPose は画像を1枚ずつ単独で処理します。
+そのため、動画を処理した場合は同一人物の骨格が今と1フレーム後でIDが振りなおされます。
+このサンプルでは、フレーム間で最も移動が少なかった骨格を同一人物とみなしてIDのトラッキングを行います。
 
 */
 
@@ -16,50 +16,50 @@ OpenPose 
 
 int main(int argc, char* argv[])
 {
-	// ͂ft@C̃tpX
+	// 入力する映像ファイルのフルパス
 	std::string videoPath = R"(media/video.mp4)";
 
-	// o͂ SQL t@C̃tpX
+	// 入出力する SQL ファイルのフルパス
 	std::string sqlPath = videoPath + ".sqlite3";
 
-	// MinimumOpenPose ̏
+	// MinimumOpenPose の初期化をする
 	MinOpenPose openpose(op::PoseModel::BODY_25, op::Point<int>(-1, 368));
 
-	// OpenPose ɓ͂铮pӂ
+	// OpenPose に入力する動画を用意する
 	Video video;
 	video.open(videoPath);
 
-	// vr[邽߂̃EBhE𐶐
+	// 動画をプレビューするためのウィンドウを生成する
 	Preview preview("result");
 
-	// SQL ̓ǂݏsNX̏
+	// SQL の読み書きを行うクラスの初期化
 	SqlOpenPose sql;
 	sql.open(sqlPath, 300);
 
-	// igbLONX
+	// 骨格をトラッキングするクラス
 	Tracking tracker(
-		0.5f,  // ֐߂̐Ml̒lȉłꍇ́A֐߂݂Ȃ̂Ƃď
-		5,     // MlconfidenceThreshold傫֐߂̐̒lłꍇ́A̐lȂ̂Ƃď
-		10,    // xgbLOOꂽl̃t[o߂ĂĔȂꍇ́ÂƂď
-		50.0f  // gbLO̐l1t[i񂾂ƂAړ̒l傫ꍇ͓ľ₩O
+		0.5f,  // 関節の信頼値がこの値以下である場合は、関節が存在しないものとして処理する
+		5,     // 信頼値がconfidenceThresholdより大きい関節の数がこの値未満である場合は、その人がいないものとして処理する
+		10,    // 一度トラッキングが外れた人がこのフレーム数が経過しても再発見されない場合は、消失したものとして処理する
+		50.0f  // トラッキング中の人が1フレーム進んだとき、移動距離がこの値よりも大きい場合は同一人物の候補から外す
 	);
 
-	// sOՂ`悷NX
+	// 歩行軌跡を描画するクラス
 	PlotTrajectory trajectory;
 
-	// 悪I܂Ń[v
+	// 動画が終わるまでループする
 	while (true)
 	{
-		// ̎̃t[ǂݍ
+		// 動画の次のフレームを読み込む
 		cv::Mat image = video.next();
 
-		// fIꍇ̓[v𔲂
+		// 映像が終了した場合はループを抜ける
 		if (image.empty()) break;
 
-		// t[ԍȂǂ̏擾
+		// フレーム番号などの情報を取得する
 		Video::FrameInfo frameInfo = video.getInfo();
 
-		// SQLɎpL^Ă΁A̒lg
+		// SQLに姿勢が記録されていれば、その値を使う
 		auto peopleOpt = sql.readBones(frameInfo.frameNumber);
 		MinOpenPose::People people;
 		if (peopleOpt)
@@ -67,33 +67,33 @@ int main(int argc, char* argv[])
 			people = peopleOpt.value();
 		}
 
-		// SQLɎpL^ĂȂΎps
+		// SQLに姿勢が記録されていなければ姿勢推定を行う
 		else
 		{
-			// p
+			// 姿勢推定
 			people = openpose.estimate(image);
 
-			// ʂ SQL ɕۑ
+			// 結果を SQL に保存
 			sql.writeBones(frameInfo.frameNumber, frameInfo.frameTimeStamp, people);
 		}
 
-		// gbLO
+		// トラッキング
 		auto trackedPeople = tracker.tracking(people, sql, frameInfo.frameNumber).value();
 
-		// sOՂ image ɕ`悷
+		// 歩行軌跡を image に描画する
 		auto trackedPoints = tracker.getJointAverages(trackedPeople);
 		trajectory.plot(image, trackedPoints);
 
-		// p̌ʂ image ɕ`悷
+		// 姿勢推定の結果を image に描画する
 		plotBone(image, trackedPeople, openpose);
 
-		// lID̕`
-		plotId(image, trackedPeople);  // lID̕`
+		// 人のIDの描画
+		plotId(image, trackedPeople);  // 人のIDの描画
 
-		// ʂXV
+		// 画面を更新する
 		int ret = preview.preview(image);
 
-		// EscL[ꂽI
+		// Escキーが押されたら終了する
 		if (0x1b == ret) break;
 	}
 
@@ -1,6 +1,6 @@
 /*
 
-̃Tvł́AʏɈ̏l̐lǂ̕ɈړJEg܂B
+このサンプルでは、画面上に引いた直線の上を何人の人がどの方向に移動したかをカウントします。
 
 */
 
@@ -9,98 +9,168 @@
 #include <Utils/Preview.h>
 #include <Utils/VideoControllerUI.h>
 #include <Utils/PlotInfo.h>
+#include <Utils/Overlay.h>
 #include <Utils/SqlOpenPose.h>
 #include <Utils/Tracking.h>
 #include <Utils/PeopleCounter.h>
+#include <Utils/CrossingLog.h>
+#include <Utils/RegionOfInterest.h>
+#include <Utils/VideoRecorder.h>
 
 int main(int argc, char* argv[])
 {
-	// ͂ft@C̃tpX
+	// 入力する映像ファイルのフルパス
 	std::string videoPath = R"(media/video.mp4)";
 
-	// o͂ SQL t@C̃tpX
+	// 入出力する SQL ファイルのフルパス
 	std::string sqlPath = videoPath + ".sqlite3";
 
-	// OpenPose ̏
+	// OpenPose の初期化をする (OpenPose は最初に姿勢推定を行うときに起動する)
 	MinOpenPose openpose(op::PoseModel::BODY_25, op::Point<int>(-1, 368));
 
-	// OpenPose ɓ͂铮pӂ
+	// OpenPose に入力する動画を用意する
 	Video video;
 	video.open(videoPath);
 
-	// vr[邽߂̃EBhE𐶐
+	// 動画をプレビューするためのウィンドウを生成する
 	Preview preview("result");
 
-	// SQL ̓ǂݏsNX̏
+	// 骨格やIDなどの描画をまとめて映像に合成するクラス
+	Overlay overlay;
+
+	// SQL の読み書きを行うクラスの初期化
 	SqlOpenPose sql;
 	sql.open(sqlPath, 300);
 
-	// igbLONX
+	// 動画と姿勢推定の設定の組み合わせごとに、結果を保存するテーブルを切り替える
+	sql.selectConfig(video.getFingerprint(), openpose);
+
+	// 骨格をトラッキングするクラス
 	Tracking tracker(
-		0.5f,  // ֐߂̐Ml̒lȉłꍇ́A֐߂݂Ȃ̂Ƃď
-		5,     // MlconfidenceThreshold傫֐߂̐̒lłꍇ́A̐lȂ̂Ƃď
-		10,    // xgbLOOꂽl̃t[o߂ĂĔȂꍇ́ÂƂď
-		50.0f  // gbLO̐l1t[i񂾂ƂAړ̒l傫ꍇ͓ľ₩O
+		0.5f,  // 関節の信頼値がこの値以下である場合は、関節が存在しないものとして処理する
+		5,     // 信頼値がconfidenceThresholdより大きい関節の数がこの値未満である場合は、その人がいないものとして処理する
+		10,    // 一度トラッキングが外れた人がこのフレーム数が経過しても再発見されない場合は、消失したものとして処理する
+		50.0f  // トラッキング中の人が1フレーム進んだとき、移動距離がこの値よりも大きい場合は同一人物の候補から外す
 	);
 
-	// ʍslJEgNX
+	// 通行人をカウントするクラス
 	PeopleCounter count(
-		10, 10,    // ̎n_W (X, Y)
-		300, 200,  // ̏I_W (X, Y)
-		10         // ̑
+		10, 10,    // 直線の始点座標 (X, Y)
+		300, 200,  // 直線の終点座標 (X, Y)
+		10         // 直線の太さ
 	);
 
-	// 悪I܂Ń[v
+	// 通過の記録と、1分ごと・1時間ごとの人数を SQL に保存するクラス (時刻は動画の再生位置)
+	CrossingLog crossingLog(sql.tableName(u8""));
+
+	// 通過の前後2秒ずつを、半分の解像度の動画として別スレッドで保存するクラス
+	VideoRecorder recorder;
+	recorder.openClips(videoPath + u8"_crossing", (video.getFps() > 0.0) ? video.getFps() : 30.0, 2000, 2000, 0.5);
+
+	// 姿勢推定を行う領域 (基準線の周辺とトラッキング中の人の周辺のみを姿勢推定する)
+	// (領域を並べても画像全体より計算量が減らない場合は、画像全体を姿勢推定する)
+	RegionOfInterest roi;
+
+	// 前回の処理が途中で終了していた場合は、最後にコミットされたチェックポイントから再開する
+	// (トラッキングの結果はSQLに記録済みのため、カウンタと通過の判定中の人の状態を復元して次のフレームへシークするだけで済む)
+	// シークした位置がずれるとカウンタの状態と合わなくなるため、索引の作成を待ってからシークする (索引が作れない場合は最初から処理する)
+	// (保存済みの索引が無い初回の再開では、索引の作成のために動画を最後まで読み進めるため、再開までに時間がかかる)
+	// チェックポイントのフレーム番号 N は読み込んだフレームの数なので、N にシークすると次に読み込むのは N + 1 番目のフレームになる
+	std::map<std::string, std::string> checkpointStates;
+	auto checkpointFrame = sql.readCheckpoint(checkpointStates);
+	if (checkpointFrame && !video.hasIndex()) std::cout << "building frame index before resuming..." << std::endl;
+	if (checkpointFrame && !video.waitIndex())
+	{
+		std::cout << "frame index is not available, restart from the first frame" << std::endl;
+		checkpointFrame.reset();
+	}
+	if (checkpointFrame && (count.loadState(checkpointStates[u8"counter"]) == 0))
+	{
+		std::cout << "resume from frame " << checkpointFrame.value() + 1 << std::endl;
+		video.seekAbsolute((long long)checkpointFrame.value());
+	}
+
+	// 動画が終わるまでループする
 	while (true)
 	{
-		// ̎̃t[ǂݍ
+		// 動画の次のフレームを読み込む
 		cv::Mat image = video.next();
 
-		// fIꍇ̓[v𔲂
-		if (image.empty()) break;
+		// 映像が終了した場合はチェックポイントを削除してループを抜ける (次回は最初から処理する)
+		if (image.empty())
+		{
+			sql.clearCheckpoint();
+			break;
+		}
 
-		// t[ԍȂǂ̏擾
+		// フレーム番号などの情報を取得する
 		Video::FrameInfo frameInfo = video.getInfo();
 
-		// SQLɎpL^Ă΁A̒lg
+		// SQLに姿勢が記録されていれば、その値を使う
 		auto peopleOpt = sql.readBones(frameInfo.frameNumber);
 		MinOpenPose::People people;
 		if (peopleOpt)
 		{
 			people = peopleOpt.value();
+
+			// 30フレーム以内にSQLに記録されていないフレームがあれば、姿勢推定が必要になる前に OpenPose を起動しておく
+			const size_t missingFrame = sql.coverage(sql.tableName(u8"timestamp")).firstMissing(frameInfo.frameNumber);
+			if ((missingFrame < frameInfo.frameNumber + 30) && (missingFrame < frameInfo.frameSum)) openpose.warmup();
 		}
 
-		// SQLɎpL^ĂȂΎps
+		// SQLに姿勢が記録されていなければ姿勢推定を行う
 		else
 		{
-			// p
-			people = openpose.estimate(image);
+			// 姿勢推定を行う領域の更新
+			roi.clear();
+			count.addRegionOfInterest(roi, 150.0f);
+			roi.addPeople(tracker.currentPeople, 50.0f);
 
-			// ʂ SQL ɕۑ
+			// 姿勢推定
+			people = openpose.estimate(image, roi.getRegions(cv::Size{ image.cols, image.rows }));
+
+			// 結果を SQL に保存
 			sql.writeBones(frameInfo.frameNumber, frameInfo.frameTimeStamp, people);
 		}
 
-		// gbLO
+		// トラッキング
 		auto tracked_people = tracker.tracking(people, sql, frameInfo.frameNumber).value();
 
-		// ʍsl̃JEg
-		count.update(tracker, frameInfo.frameNumber);
+		// 通行人のカウント
+		count.update(tracker, frameInfo.frameNumber, (int64_t)frameInfo.frameTimeStamp);
+
+		// 通過が確定した人の方向を track_summary に記録し、通過の記録と時間帯ごとの人数を SQL に保存する
+		count.writeCrossings(sql, tracker);
+		crossingLog.write(sql, 0, count.getEvents());
 
-		// ʍsl̃JEg󋵂vr[
-		count.drawInfo(image, tracker);
+		// 30フレームごとにチェックポイントを書き込む (次のコミットでデータと一緒にファイルに反映される)
+		if (frameInfo.frameNumber % 30 == 0) sql.writeCheckpoint(frameInfo.frameNumber, { { u8"counter", count.saveState() } });
 
-		// p̌ʂ image ɕ`悷
-		plotBone(image, tracked_people, openpose);
+		// 通行人のカウント状況をプレビュー
+		count.drawInfo(overlay, tracker);
 
-		// lID̕`
-		plotId(image, tracked_people);  // lID̕`
+		// 姿勢推定の結果を image に描画する
+		plotBone(overlay, cv::Size{ image.cols, image.rows }, tracked_people, openpose);
 
-		// ʂXV
+		// 人のIDの描画
+		plotId(overlay, tracked_people);  // 人のIDの描画
+
+		// 描画した部分だけをまとめて image に合成する
+		overlay.composite(image);
+
+		// 通過があった時刻の前後を保存する
+		for (auto&& event : count.getEvents()) recorder.trigger(event.timeStamp);
+		recorder.write(image, (int64_t)frameInfo.frameTimeStamp);
+
+		// 画面を更新する
 		int ret = preview.preview(image);
 
-		// EscL[ꂽI
+		// Escキーが押されたら終了する
 		if (0x1b == ret) break;
 	}
 
+	// SQLに記録されていた結果を使った割合を表示する
+	std::cout << "cache hit rate : " << sql.getCacheHitRate() * 100.0 << "% (" << sql.getCacheHits() << " / " << (sql.getCacheHits() + sql.getCacheMisses()) << ")" << std::endl;
+
 	return 0;
 }
\ No newline at end of file
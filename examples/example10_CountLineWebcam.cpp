@@ -1,7 +1,7 @@
 /*
-̃Tvł́AʏɈ̏l̐lǂ̕ɈړJEg܂B
-example08_CountLine.cppƂ̈Ⴂ͓͂ɓł͂ȂWebJgpĂ_łB
-͌ʂ openpose_ext/build/bin/media ̒ɋL^Jñt@Cŕۑ܂B
+このサンプルでは、画面上に引いた直線の上を何人の人がどの方向に移動したかをカウントします。
+example08_CountLine.cppとの違いは入力に動画ではなくWebカメラを使用している点です。
+解析結果は openpose_ext/build/bin/media の中に記録開始時刻のファイル名で保存されます。
 */
 
 #include <OpenPoseWrapper/MinimumOpenPose.h>
@@ -12,33 +12,38 @@ example08_CountLine.cpp
 #include <Utils/SqlOpenPose.h>
 #include <Utils/Tracking.h>
 #include <Utils/PeopleCounter.h>
+#include <Utils/CrossingLog.h>
+#include <Utils/LatencyController.h>
+#include <Utils/MotionDetector.h>
+#include <Utils/VideoRecorder.h>
 #include <time.h>
 #include <thread>
+#include <chrono>
 
 int main(int argc, char* argv[])
 {
 	/*
-	example10_CountLineWebcamR}hCĂԂƂ̃
+	example10_CountLineWebcamをコマンドラインから呼ぶときのメモ
 
-	R}hC̐
-			example10_CountLineWebcam <rtmpURL> <̊JnXW> <̊JnYW><̏IXW> <̏IYW> <̑>
+	コマンドライン引数の説明
+			example10_CountLineWebcam <rtmpのURL> <直線の開始X座標> <直線の開始Y座標><直線の終了X座標> <直線の終了Y座標> <直線の太さ>
 
-			: example10_CountLineWebcam "rtmp://10.0.0.1/live/guest001" 0 240 640 240 5
+			例: example10_CountLineWebcam "rtmp://10.0.0.1/live/guest001" 0 240 640 240 5
 
-	ȂA̎wȗƃftHg̒lgp
-	rtmpURLȗƁAUSBڑĂWebJgp
+	なお、直線の指定を省略するとデフォルトの値が使用される
+	rtmpのURLを省略すると、USB接続されているWebカメラが使用される
 	*/
 
 	cv::VideoCapture webcam;
 	int startX = 0, startY = 240, endX = 1920, endY = 240, lineWeight = 0;
 	if (argc >= 2) {
-		// R}hC̑1ɃJURLwł
+		// コマンドライン引数の第1引数にカメラのURLを指定できる
 		webcam.open(argv[1]);
 		if (argc >= 7) {
-			// R}hC̑2: ̊Jnn_xW
-			// R}hC̑3: ̊Jnn_yW
-			// R}hC̑4: ̏In_xW
-			// R}hC̑5: ̏In_yW
+			// コマンドライン引数の第2引数: 直線の開始地点のx座標
+			// コマンドライン引数の第3引数: 直線の開始地点のy座標
+			// コマンドライン引数の第4引数: 直線の終了地点のx座標
+			// コマンドライン引数の第5引数: 直線の終了地点のy座標
 			startX = atoi(argv[2]);
 			startY = atoi(argv[3]);
 			endX =   atoi(argv[4]);
@@ -49,11 +54,11 @@ int main(int argc, char* argv[])
 	else {
 		webcam.open(0);
 		/*
-		WindowsŋNsꍇ
+		Windowsで起動が失敗する場合
 			webcam.open(0);
-		̍s
+		の行を
 			webcam.open(cv::CAP_DSHOW + 0);
-		ɏƎ邩ȂłB
+		に書き換えると治るかもしれないです。
 		*/
 	}
 
@@ -62,104 +67,209 @@ int main(int argc, char* argv[])
 		return 0;
 	}
 
-	// ݎ擾 (t@CɎgp)
+	// 現在時刻を取得する (ファイル名に使用する)
 	time_t timer = time(NULL); tm ptm;
 	localtime_s(&ptm, &timer);
 	char time_c_str[256] = { '\0' }; strftime(time_c_str, sizeof(time_c_str), "%Y-%m-%d_%H-%M-%S", &ptm);
 	std::string time(time_c_str);
 	std::cout << time << std::endl;
 
-	// o͂ SQL t@C̃tpX^Jnɂ
-	std::string sqlPath = R"(media/webcam_)" + time + R"(.sqlite3)";
+	// 出力する SQL ファイルは1時間ごとに切り替え、ファイル名は各ファイルの記録開始時刻にする (media/webcam_<開始時刻>.sqlite3)
+	// 30日より前のファイルは自動的に削除する
+	std::string sqlBasePath = R"(media/webcam)";
+	SegmentPolicy segmentPolicy;
+	segmentPolicy.period = std::chrono::hours(1);
+	segmentPolicy.maxAge = std::chrono::hours(24 * 30);
 
-	// OpenPose ̏
+	// OpenPose の初期化をする
 	MinOpenPose openpose(op::PoseModel::BODY_25, op::Point<int>(-1, 368));
 
-	// vr[邽߂̃EBhE𐶐
+	// 動画をプレビューするためのウィンドウを生成する
 	Preview preview("result");
 
-	// SQL ̓ǂݏsNX̏
+	// SQL の読み書きを行うクラスの初期化
+	// (記録中のファイルを別のプロセスから読み込めるように、WALで開く)
 	SqlOpenPose sql;
-	sql.open(sqlPath, 300);
+	sql.openSegments(sqlBasePath, segmentPolicy, 300, false, StorageProfile::LiveIngest);
 
-	// igbLONX
+	// 骨格をトラッキングするクラス
 	Tracking tracker(
-		0.5f,  // ֐߂̐Ml̒lȉłꍇ́A֐߂݂Ȃ̂Ƃď
-		5,     // MlconfidenceThreshold傫֐߂̐̒lłꍇ́A̐lȂ̂Ƃď
-		10,    // xgbLOOꂽl̃t[o߂ĂĔȂꍇ́ÂƂď
-		150.0f  // gbLO̐l1t[i񂾂ƂAړ̒l傫ꍇ͓ľ₩O
+		0.5f,  // 関節の信頼値がこの値以下である場合は、関節が存在しないものとして処理する
+		5,     // 信頼値がconfidenceThresholdより大きい関節の数がこの値未満である場合は、その人がいないものとして処理する
+		10,    // 一度トラッキングが外れた人がこのフレーム数が経過しても再発見されない場合は、消失したものとして処理する
+		150.0f  // トラッキング中の人が1フレーム進んだとき、移動距離がこの値よりも大きい場合は同一人物の候補から外す
 	);
 
-	// ʍslJEgNX
+	// 通行人をカウントするクラス
 	PeopleCounter count(
-		startX, startY,    // ̎n_W (X, Y)
-		endX  , endY  ,  // ̏I_W (X, Y)
-		lineWeight         // ̑
+		startX, startY,    // 直線の始点座標 (X, Y)
+		endX  , endY  ,  // 直線の終点座標 (X, Y)
+		lineWeight         // 直線の太さ
 	);
 
+	// 通過の記録と、1分ごと・1時間ごとの人数を保存する SQL ファイル (セグメントを切り替えても消えないように、別のファイルに記録する)
+	Database crossingDatabase;
+	crossingDatabase.create(sqlBasePath + u8"_crossings.sqlite3", SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE, StorageProfile::LiveIngest);
+	CrossingLog crossingLog;
+	crossingLog.createTableIfNoExist(crossingDatabase);
+	crossingDatabase.commit();
+
+	// 今日既に通過した人数から数え始める
+	const int64_t startTime = (int64_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	auto todayCounts = crossingLog.count(crossingDatabase, 0, CrossingLog::startOfDay(startTime), startTime + 1);
+	if (todayCounts) count.setCounts(todayCounts->up, todayCounts->down);
+
+	// 通過の前後3秒ずつを、描画済みの映像として別スレッドで保存するクラス (解析の処理はエンコードを待たない)
+	VideoRecorder recorder;
+	const double webcamFps = webcam.get(cv::CAP_PROP_FPS);
+	recorder.openClips(sqlBasePath + u8"_crossing", (webcamFps > 0.0) ? webcamFps : 30.0, 3000, 3000);
+
+	// 遅延時間が目標値を超えないように、姿勢推定の解像度とフレームの間引きを調整するクラス
+	LatencyController latencyController(
+		500.0,  // 目標とする遅延時間 (ミリ秒)
+		{ op::Point<int>(-1, 368), op::Point<int>(-1, 256), op::Point<int>(-1, 160) }  // 切り替える解像度の一覧
+	);
+
+	using clock = std::chrono::steady_clock;
 	cv::Mat image, image2;
+	clock::time_point captureTime, captureTime2;  // フレームを取得した時刻
+	uint64_t captureCount = 0;  // 別スレッドで取得したフレームの総数
 	bool exitFlag = false;
-	// ̎̃t[ǂݍ
+	// 動画の次のフレームを読み込む
 	if (!webcam.read(image2)) return 0;
-	// ʃXbhœǂݍ
+	captureTime2 = clock::now();
+	// 基準線の周辺に動きが無いフレームの姿勢推定を省略するクラス
+	// (省略したフレームはトラッキングに渡さないため、止まっている人が消失しないように省略は tracker の numberFramesToLost より短くする)
+	MotionDetector motionDetector(
+		0.002f,  // 動きがあると判定する、変化した画素の割合
+		25.0,    // 画素が変化したと判定する輝度の差
+		160,     // 差分を計算するときの画像の横幅
+		0.05,    // 背景画像を更新する割合
+		9,       // 動きが無い場合でも、このフレーム数ごとに姿勢推定を行う
+		false    // 動きが無いフレームでは前回の結果を使わない
+	);
+	RegionOfInterest motionRoi;
+	count.addRegionOfInterest(motionRoi, 150.0f);
+	motionDetector.setRegionOfInterest(motionRoi, cv::Size{ image2.cols, image2.rows });
+
+	// 別スレッドで動画を読み込む
 	std::mutex mtx;
 	std::thread th([&]() {
+		cv::Mat captured;
 		while (true) {
-			std::scoped_lock{ mtx };
-			if (exitFlag) break;
-			if (!webcam.read(image2)) break;
-			if (image2.empty()) break;
+			{
+				std::scoped_lock lock{ mtx };
+				if (exitFlag) break;
+			}
+			// 読み込みには時間がかかるため、ロックせずに読み込んでから入れ替える
+			bool isRead = webcam.read(captured);
+			std::scoped_lock lock{ mtx };
+			if ((!isRead) || captured.empty()) { image2 = cv::Mat(); break; }
+			image2 = captured.clone();
+			captureTime2 = clock::now();
+			captureCount++;
 		}
 	});
 
-	// 悪I܂Ń[v
+	// 動画が終わるまでループする
 	uint64_t frameNumber = 0;
+	uint64_t lastCaptureCount = 0;
+	double latency = -1.0;
 	while (true)
 	{
-		// ʃXbhœǂݍ񂾓Rs[
+		// 別スレッドで読み込んだ動画をコピー
+		size_t queueDepth = 0;
 		{
-			std::scoped_lock{ mtx };
+			std::scoped_lock lock{ mtx };
 			image = image2.clone();
+			captureTime = captureTime2;
+			queueDepth = (size_t)(captureCount - lastCaptureCount);
+			lastCaptureCount = captureCount;
 		}
 
-		// fIꍇ̓[v𔲂
+		// 映像が終了した場合はループを抜ける
 		if (image.empty()) break;
 
-		// p
-		MinOpenPose::People people = openpose.estimate(image);
+		// 直前のフレームの遅延時間から、このフレームの処理方法を決める
+		auto decision = latencyController.update(latency, queueDepth);
+		if (decision.skip)
+		{
+			// 遅延が大きいフレームは姿勢推定を行わずに最新のフレームまで読み飛ばす
+			// (姿勢推定を行っていないため、遅延時間は計測しなかったものとして次のフレームに渡す)
+			latency = -1.0;
+			continue;
+		}
+
+		// 姿勢推定の解像度を切り替える (変更がある場合のみ OpenPose が再起動される)
+		openpose.setNetInputSize(decision.netInputSize);
 
-		// gbLO
-		auto tracked_people = tracker.tracking(people, sql, frameNumber).value();
+		// 姿勢推定 (基準線の周辺に動きが無いフレームでは省略される)
+		MinOpenPose::People people = motionDetector.estimate(openpose, image);
+		const bool isMotionSkipped = motionDetector.isLastSkipped();
 
-		// ʍsl̃JEg
-		count.update(tracker, frameNumber);
+		// このフレームで使用した解像度を記録する (姿勢推定を省略したフレームは skip = 1 で記録する)
+		if (isMotionSkipped) decision.skip = true;
+		latencyController.write(sql, frameNumber, decision);
 
-		// ʍsl̃JEg󋵂vr[
+		// トラッキング (姿勢推定を省略したフレームは推定したフレームとして記録せず、直前までのトラッキングの結果を使う)
+		auto tracked_people = isMotionSkipped ? tracker.currentPeople : tracker.tracking(people, sql, frameNumber).value();
+
+		// 通行人のカウント (通過した時刻はUNIX時間のミリ秒で記録する)
+		const int64_t now = (int64_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		count.update(tracker, frameNumber, now);
+
+		// 通過が確定した人の方向を track_summary に記録し、通過の記録と時間帯ごとの人数を保存する
+		count.writeCrossings(sql, tracker);
+		if (!count.getEvents().empty())
+		{
+			crossingLog.write(crossingDatabase, 0, count.getEvents());
+			if (crossingDatabase.commit()) std::cout << "failed to commit the crossing log (it will be retried at the next crossing)" << std::endl;
+		}
+
+		// このフレームの記録を終えたことを通知する (コミットの周期とセグメントの切り替えを進める)
+		sql.tick(frameNumber);
+
+		// 通行人のカウント状況をプレビュー
 		count.drawInfo(image, tracker);
 
-		// p̌ʂ image ɕ`悷
+		// 姿勢推定の結果を image に描画する
 		plotBone(image, tracked_people, openpose);
 
+		// 遅延時間と解像度の描画
+		gui::text(image, "latency : " + std::to_string((int)decision.latency) + " ms", { 20, 260 });
+		gui::text(image, "net : " + std::to_string(decision.netInputSize.x) + "x" + std::to_string(decision.netInputSize.y), { 20, 290 });
+		gui::text(image, "skip : " + std::to_string(motionDetector.getSkippedFrames()) + " / " + std::to_string(motionDetector.getSkippedFrames() + motionDetector.getProcessedFrames()), { 20, 320 });
+
+		// 通過があった時刻の前後を保存する
+		for (auto&& event : count.getEvents()) recorder.trigger(event.timeStamp);
+		recorder.write(image, now);
 
 		cv::resize(image, image, cv::Size(640, 480) );
 
-		// ʂXV
+		// 画面を更新する
 		int ret = preview.preview(image);
 
-		// EscL[ꂽI
+		// Escキーが押されたら終了する
 		if (0x1b == ret) break;
 
+		// フレームを取得してから処理が終わるまでの時間 (姿勢推定を省略したフレームは計測しなかったものとして次のフレームに渡す)
+		latency = isMotionSkipped ? -1.0 : (double)std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - captureTime).count();
+
 		frameNumber += 1;
 	}
 
-	// Xbh̏ItO𗧂Ă
+	// スレッドの終了フラグを立てる
 	{
-		std::scoped_lock{ mtx };
+		std::scoped_lock lock{ mtx };
 		exitFlag = true;
 	}
 
-	// Xbh̏I҂
+	// スレッドの終了を待つ
 	th.join();
 
+	// 保存中の映像を書き込んでからファイルを閉じる
+	recorder.close();
+	std::cout << "recorded frames : " << recorder.getWrittenFrames() << ", dropped : " << recorder.getDroppedFrames() << std::endl;
+
 	return 0;
 }
@@ -1,221 +1,280 @@
-﻿#pragma once
-
-#include <openpose/headers.hpp>
-#include <queue>
-#include <mutex>
-#include <thread>
-#include <stdint.h>
-#include <cassert>
-
-/**
- * OpenPose のラッパークラス
- * OpenPose を別スレッドで動かし、 OpenPose の操作を簡単にする
- */
-class MinOpenPose
-{
-private:
-	/**
-	 * OpenPose へ入力する画像を管理するクラス
-	 */
-	class WUserInputProcessing : public op::Worker<std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>>>
-	{
-	private:
-		// OpenPose へ入力する画像を格納するキュー
-		std::queue<std::pair<cv::Mat, size_t>> images;
-
-		// 各スレッドを同期させるための mutex
-		std::mutex& inOutMtx;
-
-		// エラーメッセージ配列
-		std::vector<std::string> errorMessage;
-
-	public:
-		/**
-		 * コンストラクタ
-		 * @param inOutMtx メンバ関数はOpenPose側のスレッドからも呼び出されるので、同期をとるためにmutexを指定する
-		 */
-		WUserInputProcessing(std::mutex& inOutMtx);
-
-		/**
-		 * メンバ変数の初期化用関数
-		 * OpenPose 側で生成されたスレッドから呼び出される
-		 */
-		void initializationOnThread() override;
-
-		/**
-		 * pushImage() で追加された画像を OpenPose に1枚ずつ渡す関数
-		 * OpenPose 側で生成されたスレッドから呼び出される
-		 * @param datumsPtr OpenPose へ入力される前のデータ
-		 */
-		void work(std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>>& datumsPtr) override;
-
-		/**
-		 * OpenPose に入力する画像を追加する関数
-		 * MinimumOpenPose 側から呼び出される
-		 * @param image 追加する画像 (フォーマット : CV_8UC3)
-		 * @param maxQueueSize 追加できる画像数の上限
-		 */
-		int pushImage(const cv::Mat& image, size_t frameNumber, size_t maxQueueSize);
-
-		/**
-		 * エラーを取得する関数
-		 * MinimumOpenPose 側から呼び出される
-		 * @param errorMessage エラーメッセージが格納される変数
-		 * @param clearError クラス内のエラーメッセージを削除するフラグ
-		 */
-		void getErrors(std::vector<std::string>& errorMessage, bool clearErrors);
-
-		/**
-		 * スレッドを停止する関数
-		 * MinimumOpenPose 側から呼び出される
-		 */
-		void shutdown();
-	};
-
-	/**
-	 * OpenPose から出力されるデータを管理するクラス
-	 */
-	class WUserOutputProcessing : public op::Worker<std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>>>
-	{
-	private:
-		// OpenPose から出力されるデータを格納するキュー
-		std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>> results;
-		// 各スレッドを同期させるための mutex
-		std::mutex& inOutMtx;
-		// エラーメッセージ配列
-		std::vector<std::string> errorMessage;
-
-	public:
-		/**
-		 * コンストラクタ
-		 * @param inOutMtx メンバ関数はOpenPose側のスレッドからも呼び出されるので、同期をとるためにmutexを指定する
-		 */
-		WUserOutputProcessing(std::mutex& inOutMtx);
-
-		/**
-		 * メンバ変数の初期化用関数
-		 * OpenPose 側で生成されたスレッドから呼び出される
-		 */
-		void initializationOnThread() override;
-
-		/**
-		 * OpenPose で処理された画像を results キューに追加する関数
-		 * OpenPose 側で生成されたスレッドから呼び出される
-		 * @param datumsPtr OpenPose から出力されたデータ
-		 */
-		void work(std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>>& datumsPtr) override;
-
-		/**
-		 * OpenPose から出力されたデータの個数を取得する関数
-		 */
-		size_t getResultsSize();
-
-		/**
-		 * OpenPose から出力された全てのデータを取得し、キューをリセットする関数
-		 */
-		std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>> getResultsAndReset();
-
-		/**
-		 * エラーを取得する関数
-		 * MinimumOpenPose 側から呼び出される
-		 * @param errorMessage エラーメッセージが格納される変数
-		 * @param clearError クラス内のエラーメッセージを削除するフラグ
-		 */
-		void getErrors(std::vector<std::string>& errorMessage, bool clearErrors);
-
-		/**
-		 * スレッドを停止する関数
-		 * MinimumOpenPose 側から呼び出される
-		 */
-		void shutdown();
-	};
-
-	/**
-	 * OpenPose の処理のステータスを表す
-	 */
-	enum class ProcessState
-	{
-		//! 入力キューに何も溜まっておらず、入力待ちの状態
-		WaitInput = 0,
-		//! 入力キューに溜まっている画像の処理中
-		Processing = 1,
-		//! 入力キューの画像全ての処理が完了し
-		//! getResultsAndReset() が呼び出されるのを待機している状態
-		Finish = 2,
-		//! スレッドが終了した状態
-		Shutdown = 3
-	};
-
-	// OpenPose のラッパークラス
-	std::unique_ptr<op::Wrapper> opWrapper;
-	// OpenPose を実行させるスレッド
-	std::thread opThread;
-	// OpenPose へ入力する画像を管理するクラス
-	std::shared_ptr<WUserInputProcessing> opInput;
-	// OpenPose から出力される画像を管理するクラス
-	std::shared_ptr<WUserOutputProcessing> opOutput;
-	// 現在 OpenPose で処理中の画像の枚数
-	size_t jobCount = 0;
-	// OpenPose 側のスレッドで発生した例外メッセージを格納する変数
-	std::vector<std::string> errorMessage;
-	// OpenPose 側のスレッドと同期するための mutex
-	std::mutex inOutMtx;
-	// OpenPose の設定
-	op::WrapperStructPose wrapperStructPose;
-
-	/**
-	 * OpenPose を開始する
-	 * 既に OpenPose が開始していた場合は何も変更しない
-	 * この関数はコンストラクタで呼ばれる
-	 */
-	int startup(op::PoseModel poseModel = op::PoseModel::BODY_25, op::Point<int> netInputSize = op::Point<int>(-1, 368));
-
-	/**
-	 * OpenPose を終了する
-	 * 既に OpenPose が終了していた場合は何も変更しない
-	 * この関数はデストラクタでも呼ばれる
-	 */
-	void shutdown();
-
-	/**
-	 * OpenPose の起動状態を取得する
-	 * @return 起動している場合はtrueが返る。起動していない場合はfalseが返る。
-	 */
-	bool isStartup();
-
-	/**
-	 * キューに画像を追加する関数
-	 * @param image 追加する画像
-	 * @param maxQueueSize キューの上限
-	 * @return キューの追加に成功すると 0 が返り、失敗すると 1 が返る
-	 */
-	int pushImage(const cv::Mat& image, size_t frameNumber, size_t maxQueueSize = 128);
-
-	/**
-	 * OpenPose の処理のステータスを取得する
-	 * @return OpenPose の処理のステータス
-	 */
-	ProcessState getProcessState();
-
-	/**
-	 * pushImage() で追加された画像の処理結果を取得し、キューをリセットする関数
-	 * getProcessState() が ProcessState::Finish を返すときのみ有効
-	 * @return 処理結果
-	 */
-	std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>> getResultsAndReset();
-
-public:
-	/**
-	 * @param poseModel 姿勢推定に用いるモデルを選択する
-	 * @param netInputSize 姿勢推定を行うネットワークの解像度を指定する (片方に-1を指定すると入力される画像のアスペクト比から自動計算される)
-	 */
-	MinOpenPose(op::PoseModel poseModel = op::PoseModel::BODY_25, op::Point<int> netInputSize = op::Point<int>(-1, 368));
-	virtual ~MinOpenPose();
-
-	struct Node { float x, y, confidence; };
-	using Person = std::vector<Node>;
-	using People = std::map<size_t, Person>;
-	People estimate(const cv::Mat& inputImage);
-
-	op::WrapperStructPose getConfig() const { return wrapperStructPose;  }
+﻿#pragma once
+
+#include <openpose/headers.hpp>
+#include <queue>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#include <cassert>
+
+/**
+ * OpenPose のラッパークラス
+ * OpenPose を別スレッドで動かし、 OpenPose の操作を簡単にする
+ */
+class MinOpenPose
+{
+private:
+	/**
+	 * OpenPose へ入力する画像を管理するクラス
+	 */
+	class WUserInputProcessing : public op::Worker<std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>>>
+	{
+	private:
+		// OpenPose へ入力する画像を格納するキュー
+		std::queue<std::pair<cv::Mat, size_t>> images;
+
+		// 各スレッドを同期させるための mutex
+		std::mutex& inOutMtx;
+
+		// エラーメッセージ配列
+		std::vector<std::string> errorMessage;
+
+	public:
+		/**
+		 * コンストラクタ
+		 * @param inOutMtx メンバ関数はOpenPose側のスレッドからも呼び出されるので、同期をとるためにmutexを指定する
+		 */
+		WUserInputProcessing(std::mutex& inOutMtx);
+
+		/**
+		 * メンバ変数の初期化用関数
+		 * OpenPose 側で生成されたスレッドから呼び出される
+		 */
+		void initializationOnThread() override;
+
+		/**
+		 * pushImage() で追加された画像を OpenPose に1枚ずつ渡す関数
+		 * OpenPose 側で生成されたスレッドから呼び出される
+		 * @param datumsPtr OpenPose へ入力される前のデータ
+		 */
+		void work(std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>>& datumsPtr) override;
+
+		/**
+		 * OpenPose に入力する画像を追加する関数
+		 * MinimumOpenPose 側から呼び出される
+		 * @param image 追加する画像 (フォーマット : CV_8UC3)
+		 * @param maxQueueSize 追加できる画像数の上限
+		 */
+		int pushImage(const cv::Mat& image, size_t frameNumber, size_t maxQueueSize);
+
+		/**
+		 * エラーを取得する関数
+		 * MinimumOpenPose 側から呼び出される
+		 * @param errorMessage エラーメッセージが格納される変数
+		 * @param clearError クラス内のエラーメッセージを削除するフラグ
+		 */
+		void getErrors(std::vector<std::string>& errorMessage, bool clearErrors);
+
+		/**
+		 * スレッドを停止する関数
+		 * MinimumOpenPose 側から呼び出される
+		 */
+		void shutdown();
+	};
+
+	/**
+	 * OpenPose から出力されるデータを管理するクラス
+	 */
+	class WUserOutputProcessing : public op::Worker<std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>>>
+	{
+	private:
+		// OpenPose から出力されるデータを格納するキュー
+		std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>> results;
+		// 各スレッドを同期させるための mutex
+		std::mutex& inOutMtx;
+		// エラーメッセージ配列
+		std::vector<std::string> errorMessage;
+
+	public:
+		/**
+		 * コンストラクタ
+		 * @param inOutMtx メンバ関数はOpenPose側のスレッドからも呼び出されるので、同期をとるためにmutexを指定する
+		 */
+		WUserOutputProcessing(std::mutex& inOutMtx);
+
+		/**
+		 * メンバ変数の初期化用関数
+		 * OpenPose 側で生成されたスレッドから呼び出される
+		 */
+		void initializationOnThread() override;
+
+		/**
+		 * OpenPose で処理された画像を results キューに追加する関数
+		 * OpenPose 側で生成されたスレッドから呼び出される
+		 * @param datumsPtr OpenPose から出力されたデータ
+		 */
+		void work(std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>>& datumsPtr) override;
+
+		/**
+		 * OpenPose から出力されたデータの個数を取得する関数
+		 */
+		size_t getResultsSize();
+
+		/**
+		 * OpenPose から出力された全てのデータを取得し、キューをリセットする関数
+		 */
+		std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>> getResultsAndReset();
+
+		/**
+		 * エラーを取得する関数
+		 * MinimumOpenPose 側から呼び出される
+		 * @param errorMessage エラーメッセージが格納される変数
+		 * @param clearError クラス内のエラーメッセージを削除するフラグ
+		 */
+		void getErrors(std::vector<std::string>& errorMessage, bool clearErrors);
+
+		/**
+		 * スレッドを停止する関数
+		 * MinimumOpenPose 側から呼び出される
+		 */
+		void shutdown();
+	};
+
+	/**
+	 * 姿勢推定を行う領域を並べたモザイクの中の1つのタイル
+	 */
+	struct Tile
+	{
+		// 元の画像の中の位置
+		cv::Rect source;
+		// モザイクの中の左上の位置
+		cv::Point position;
+		// このタイルで検出した人として扱う、重心のX座標の範囲 [coreLeft, coreRight) (元の画像の座標)
+		// 分割した領域の重なりの部分で同じ人が2回検出されないように、重なりの中央で担当を分ける
+		int coreLeft, coreRight;
+	};
+
+	/**
+	 * 領域をタイルに分け、元の画像と同じ高さのモザイクに並べる
+	 * 領域は高さと同じだけ重ねて分割するため、領域の高さより小さい人はどこで分割しても1つのタイルに収まる
+	 * @param imageSize 元の画像の大きさ
+	 * @param regions 姿勢推定を行う領域
+	 * @param tiles 並べたタイルが代入される
+	 * @return モザイクの幅
+	 */
+	static int layoutTiles(const cv::Size& imageSize, const std::vector<cv::Rect>& regions, std::vector<Tile>& tiles);
+
+	/**
+	 * OpenPose の処理のステータスを表す
+	 */
+	enum class ProcessState
+	{
+		//! 入力キューに何も溜まっておらず、入力待ちの状態
+		WaitInput = 0,
+		//! 入力キューに溜まっている画像の処理中
+		Processing = 1,
+		//! 入力キューの画像全ての処理が完了し
+		//! getResultsAndReset() が呼び出されるのを待機している状態
+		Finish = 2,
+		//! スレッドが終了した状態
+		Shutdown = 3
+	};
+
+	// OpenPose のラッパークラス
+	std::unique_ptr<op::Wrapper> opWrapper;
+	// OpenPose を実行させるスレッド
+	std::thread opThread;
+	// OpenPose へ入力する画像を管理するクラス
+	std::shared_ptr<WUserInputProcessing> opInput;
+	// OpenPose から出力される画像を管理するクラス
+	std::shared_ptr<WUserOutputProcessing> opOutput;
+	// 現在 OpenPose で処理中の画像の枚数
+	size_t jobCount = 0;
+	// OpenPose 側のスレッドで発生した例外メッセージを格納する変数
+	std::vector<std::string> errorMessage;
+	// OpenPose 側のスレッドと同期するための mutex
+	std::mutex inOutMtx;
+	// OpenPose の設定
+	op::WrapperStructPose wrapperStructPose;
+	// 一度でも OpenPose を起動したかどうか
+	bool isLaunched = false;
+
+	/**
+	 * OpenPose を開始する
+	 * 既に OpenPose が開始していた場合は何も変更しない
+	 * この関数は最初に estimate() が呼ばれたとき、もしくは warmup() で呼ばれる
+	 */
+	int startup(op::PoseModel poseModel = op::PoseModel::BODY_25, op::Point<int> netInputSize = op::Point<int>(-1, 368));
+
+	/**
+	 * OpenPose を終了する
+	 * 既に OpenPose が終了していた場合は何も変更しない
+	 * この関数はデストラクタでも呼ばれる
+	 */
+	void shutdown();
+
+	/**
+	 * OpenPose の起動状態を取得する
+	 * @return 起動している場合はtrueが返る。起動していない場合はfalseが返る。
+	 */
+	bool isStartup();
+
+	/**
+	 * キューに画像を追加する関数
+	 * @param image 追加する画像
+	 * @param maxQueueSize キューの上限
+	 * @return キューの追加に成功すると 0 が返り、失敗すると 1 が返る
+	 */
+	int pushImage(const cv::Mat& image, size_t frameNumber, size_t maxQueueSize = 128);
+
+	/**
+	 * OpenPose の処理のステータスを取得する
+	 * @return OpenPose の処理のステータス
+	 */
+	ProcessState getProcessState();
+
+	/**
+	 * pushImage() で追加された画像の処理結果を取得し、キューをリセットする関数
+	 * getProcessState() が ProcessState::Finish を返すときのみ有効
+	 * @return 処理結果
+	 */
+	std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>> getResultsAndReset();
+
+public:
+	/**
+	 * OpenPose はこの時点では起動せず、最初に estimate() が呼ばれたときに起動する
+	 * @param poseModel 姿勢推定に用いるモデルを選択する
+	 * @param netInputSize 姿勢推定を行うネットワークの解像度を指定する (片方に-1を指定すると入力される画像のアスペクト比から自動計算される)
+	 */
+	MinOpenPose(op::PoseModel poseModel = op::PoseModel::BODY_25, op::Point<int> netInputSize = op::Point<int>(-1, 368));
+	virtual ~MinOpenPose();
+
+	struct Node { float x, y, confidence; };
+	using Person = std::vector<Node>;
+	using People = std::map<size_t, Person>;
+	People estimate(const cv::Mat& inputImage);
+
+	/**
+	 * 画像の指定された領域のみ姿勢推定を行う
+	 * 各領域は元の画像と同じ縮尺のまま切り出し、元の画像と同じ高さの1枚の画像 (モザイク) に並べて OpenPose に1回だけ入力する
+	 * 横に長い領域は重なりを持たせて分割し、縦に積み重ねてモザイクの幅を抑える
+	 * ネットワークの幅が自動計算される場合の計算量はモザイクの幅に比例するため、モザイクの幅が元の画像の幅以上になる場合
+	 * (もしくはネットワークの幅が固定されている場合) は、領域を使わずに画像全体の姿勢推定を行う
+	 * @param inputImage 入力画像
+	 * @param regions 姿勢推定を行う領域 (画像外の部分は切り捨てられる)
+	 * @return 全ての領域で検出された骨格 (インデックスは領域をまたいで0から振り直される。画像全体を推定した場合は領域外の人も含まれる)
+	 */
+	People estimate(const cv::Mat& inputImage, const std::vector<cv::Rect>& regions);
+
+	op::WrapperStructPose getConfig() const { return wrapperStructPose;  }
+
+	/**
+	 * OpenPose を別スレッドで起動し、モデルの読み込みを始める
+	 * 姿勢推定が必要になることが事前に分かっている場合に呼ぶと、最初の estimate() の待ち時間が短くなる
+	 * 既に起動している場合は何もしない
+	 */
+	void warmup();
+
+	/**
+	 * 姿勢推定を行うネットワークの解像度を変更する
+	 * 解像度はOpenPoseの起動時にしか指定できないため、変更がある場合はOpenPoseを再起動する (数秒かかる)
+	 * @param netInputSize 新しい解像度 (片方に-1を指定すると入力される画像のアスペクト比から自動計算される)
+	 * @return 成功すると 0 が返る
+	 */
+	int setNetInputSize(op::Point<int> netInputSize);
+
+	// 現在のネットワークの解像度を取得する
+	op::Point<int> getNetInputSize() const { return wrapperStructPose.netInputSize; }
 };
\ No newline at end of file
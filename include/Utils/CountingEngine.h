@@ -0,0 +1,340 @@
+#pragma once
+
+#include <OpenPoseWrapper/MinimumOpenPose.h>
+#include <Utils/Gui.h>
+#include <Utils/Geometry.h>
+#include <Utils/RegionOfInterest.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * 複数の基準線と多角形の領域 (ゾーン) を使って人数をカウントするクラス
+ * 基準線とゾーンは一様なグリッドに登録しておき、人ごとに「前のフレームの重心から現在の重心までの線分」の周辺のセルにあるものだけを判定する
+ * そのため、基準線やゾーンが増えても1フレームあたりの処理時間はほとんど増えない
+ */
+class CountingEngine
+{
+private:
+	using Node = MinOpenPose::Node;
+
+public:
+	// 基準線と、その上を通過した人数
+	struct Line
+	{
+		std::string name;
+		cv::Point2f start, end;
+		uint64_t upCount = 0;  // 基準線の上側 (PeopleCounter と同じ向き) に移動した人数
+		uint64_t downCount = 0;  // 基準線の下側に移動した人数
+	};
+
+	// ゾーンと、出入りした人数
+	struct Zone
+	{
+		std::string name;
+		std::vector<cv::Point2f> polygon;
+		cv::Rect2f bounds;
+		uint64_t inCount = 0;  // ゾーンの外から中に入った人数
+		uint64_t outCount = 0;  // ゾーンの中から外に出た人数
+		uint64_t occupancy = 0;  // 現在ゾーンの中にいる人数
+	};
+
+	// update() で検出された通過 (基準線の場合は 1 : 上方向, -1 : 下方向、ゾーンの場合は 1 : 入った, -1 : 出た)
+	struct Crossing
+	{
+		size_t people;
+		bool isZone;
+		size_t index;
+		int direction;
+	};
+
+	/**
+	 * @param cellSize グリッドの1セルの大きさ (画素、人が1フレームで移動する距離より十分大きくする)
+	 * @param numberFramesToLost このフレーム数が経過しても再び検出されない人は、消失したものとして処理する
+	 */
+	CountingEngine(const float cellSize = 64.0f, const size_t numberFramesToLost = 10)
+		: cellSize{ cellSize }, numberFramesToLost{ numberFramesToLost } {}
+
+	virtual ~CountingEngine() {};
+
+	/**
+	 * 基準線を追加する
+	 * @param name 基準線の名前
+	 * @param start 始点
+	 * @param end 終点
+	 * @return 基準線のインデックス
+	 */
+	size_t addLine(const std::string& name, const cv::Point2f& start, const cv::Point2f& end)
+	{
+		Line line;
+		line.name = name;
+		line.start = start;
+		line.end = end;
+		lines.push_back(line);
+		const size_t index = lines.size() - 1;
+		insert(Item{ false, index }, geometry::boundsOf({ start, end }));
+		return index;
+	}
+
+	/**
+	 * ゾーンを追加する
+	 * @param name ゾーンの名前
+	 * @param polygon ゾーンの頂点 (3つ以上)
+	 * @return ゾーンのインデックス
+	 */
+	size_t addZone(const std::string& name, const std::vector<cv::Point2f>& polygon)
+	{
+		Zone zone;
+		zone.name = name;
+		zone.polygon = polygon;
+		zone.bounds = geometry::boundsOf(polygon);
+		zones.push_back(zone);
+		const size_t index = zones.size() - 1;
+		insert(Item{ true, index }, zone.bounds);
+		return index;
+	}
+
+	/**
+	 * 1フレーム分の人の重心を受け取り、基準線の通過とゾーンの出入りをカウントする
+	 * @param centroids 人のIDと重心 (Tracking::getJointAverages(tracker.latestPeople) など)
+	 * @param frameNumber フレーム番号
+	 */
+	void update(const std::map<size_t, Node>& centroids, const size_t frameNumber)
+	{
+		crossings.clear();
+
+		for (auto&& centroid : centroids)
+		{
+			const cv::Point2f point{ centroid.second.x, centroid.second.y };
+			auto itr = tracks.find(centroid.first);
+
+			// 初めて検出された人は、映り始めた位置のゾーンの人数だけ数える
+			if (itr == tracks.end())
+			{
+				Track track;
+				track.point = point;
+				track.lastFrame = frameNumber;
+				stamp++;
+				forEachCandidate(geometry::boundsOf({ point, point }), [&](const Item& item) {
+					if (item.isZone && geometry::isInside(zones[item.index].polygon, point))
+					{
+						track.zones.push_back(item.index);
+						zones[item.index].occupancy++;
+					}
+				});
+				tracks.emplace(centroid.first, track);
+				continue;
+			}
+
+			Track& track = itr->second;
+			track.lastFrame = frameNumber;
+
+			// 止まっている人は判定しない
+			if (point == track.point) continue;
+
+			const cv::Point2f from = track.point;
+			track.point = point;
+
+			// 移動した線分の周辺にある基準線とゾーンだけを判定する
+			stamp++;
+			forEachCandidate(geometry::boundsOf({ from, point }), [&](const Item& item) {
+				if (item.isZone) updateZone(centroid.first, track, item.index, point);
+				else updateLine(centroid.first, track, item.index, from, point);
+			});
+		}
+
+		// しばらく検出されていない人を消失したものとして処理する (ゾーンの中にいた場合は人数から外す)
+		for (auto itr = tracks.begin(); itr != tracks.end();)
+		{
+			if (itr->second.lastFrame + numberFramesToLost >= frameNumber)
+			{
+				itr++;
+				continue;
+			}
+			for (auto&& index : itr->second.zones) zones[index].occupancy--;
+			itr = tracks.erase(itr);
+		}
+	}
+
+	// 基準線の一覧を取得
+	const std::vector<Line>& getLines() const { return lines; }
+
+	// ゾーンの一覧を取得
+	const std::vector<Zone>& getZones() const { return zones; }
+
+	// 直前の update() で検出された通過を取得
+	const std::vector<Crossing>& getCrossings() const { return crossings; }
+
+	// 全ての基準線とゾーンのカウントを0に戻す (追跡中の人の情報も消去される)
+	void reset()
+	{
+		for (auto&& line : lines) line.upCount = line.downCount = 0;
+		for (auto&& zone : zones) zone.inCount = zone.outCount = zone.occupancy = 0;
+		tracks.clear();
+		crossings.clear();
+	}
+
+	// 基準線とゾーン、カウントを描画する
+	void drawInfo(cv::Mat& frame) const
+	{
+		for (auto&& line : lines)
+		{
+			cv::line(frame, line.start, line.end, cv::Scalar{ 255.0, 255.0, 255.0 }, 2);
+			gui::text(frame, line.name + u8" up : " + std::to_string(line.upCount) + u8" down : " + std::to_string(line.downCount),
+				{ (int)line.end.x, (int)line.end.y });
+		}
+		for (auto&& zone : zones)
+		{
+			std::vector<cv::Point> polygon;
+			for (auto&& p : zone.polygon) polygon.push_back(cv::Point{ (int)p.x, (int)p.y });
+			cv::polylines(frame, polygon, true, cv::Scalar{ 255.0, 200.0, 0.0 }, 2);
+			gui::text(frame, zone.name + u8" : " + std::to_string(zone.occupancy) + u8" (in " + std::to_string(zone.inCount)
+				+ u8", out " + std::to_string(zone.outCount) + u8")", { (int)zone.bounds.x, (int)zone.bounds.y });
+		}
+	}
+
+	/**
+	 * 基準線とゾーンの周辺を姿勢推定を行う領域として追加する
+	 * @param roi 領域を追加する RegionOfInterest のインスタンス
+	 * @param margin 基準線やゾーンから領域の端までの距離 (映っている人の身長程度を指定する)
+	 */
+	void addRegionOfInterest(RegionOfInterest& roi, float margin) const
+	{
+		for (auto&& line : lines) roi.addLine(line.start.x, line.start.y, line.end.x, line.end.y, margin);
+		for (auto&& zone : zones) roi.addPolygon(zone.polygon, margin);
+	}
+
+private:
+	// グリッドに登録する基準線かゾーン
+	struct Item
+	{
+		bool isZone;
+		size_t index;
+	};
+
+	// 追跡中の人
+	struct Track
+	{
+		cv::Point2f point;  // 最後に検出された重心
+		size_t lastFrame = 0;  // 最後に検出されたフレーム番号
+		std::vector<size_t> zones;  // 中にいるゾーン
+		std::vector<std::pair<size_t, int>> lastDirections;  // 基準線ごとの最後に通過した方向
+	};
+
+	// グリッドの1セルの大きさ
+	float cellSize;
+
+	// このフレーム数が経過しても再び検出されない人は、消失したものとして処理する
+	size_t numberFramesToLost;
+
+	std::vector<Line> lines;
+	std::vector<Zone> zones;
+
+	// セルごとの基準線とゾーン
+	std::unordered_map<int64_t, std::vector<Item>> grid;
+
+	// 1回の判定で同じ基準線やゾーンを2回判定しないための印 (判定した時点の stamp を記録する)
+	uint64_t stamp = 0;
+	std::vector<uint64_t> lineStamps, zoneStamps;
+
+	// 追跡中の人
+	std::map<size_t, Track> tracks;
+
+	// 直前の update() で検出された通過
+	std::vector<Crossing> crossings;
+
+	// 矩形が重なる全てのセルに登録する
+	void insert(const Item& item, const cv::Rect2f& bounds)
+	{
+		const int left = (int)std::floor(bounds.x / cellSize), right = (int)std::floor((bounds.x + bounds.width) / cellSize);
+		const int top = (int)std::floor(bounds.y / cellSize), bottom = (int)std::floor((bounds.y + bounds.height) / cellSize);
+		for (int y = top; y <= bottom; y++) for (int x = left; x <= right; x++) grid[geometry::cellKey(x, y)].push_back(item);
+		lineStamps.resize(lines.size(), 0);
+		zoneStamps.resize(zones.size(), 0);
+	}
+
+	// 矩形が重なるセルに登録された基準線とゾーンを1回ずつ列挙する (呼び出す前に stamp を進めておく)
+	template<typename Function>
+	void forEachCandidate(const cv::Rect2f& bounds, Function function)
+	{
+		const int left = (int)std::floor(bounds.x / cellSize), right = (int)std::floor((bounds.x + bounds.width) / cellSize);
+		const int top = (int)std::floor(bounds.y / cellSize), bottom = (int)std::floor((bounds.y + bounds.height) / cellSize);
+		for (int y = top; y <= bottom; y++)
+		{
+			for (int x = left; x <= right; x++)
+			{
+				auto cell = grid.find(geometry::cellKey(x, y));
+				if (cell == grid.end()) continue;
+				for (auto&& item : cell->second)
+				{
+					uint64_t& itemStamp = item.isZone ? zoneStamps[item.index] : lineStamps[item.index];
+					if (itemStamp == stamp) continue;
+					itemStamp = stamp;
+					function(item);
+				}
+			}
+		}
+	}
+
+	// 基準線に対して点がどちら側にあるか (正 : 上側, 負 : 下側)
+	static float side(const Line& line, const cv::Point2f& p)
+	{
+		const cv::Point2f vecLine = line.end - line.start;
+		const cv::Point2f vecPoint = p - line.start;
+		return vecPoint.x * vecLine.y - vecPoint.y * vecLine.x;
+	}
+
+	// 人が移動した線分 from -> to が基準線を通過していればカウントする
+	void updateLine(const size_t people, Track& track, const size_t index, const cv::Point2f& from, const cv::Point2f& to)
+	{
+		Line& line = lines[index];
+		const float sideFrom = side(line, from), sideTo = side(line, to);
+		if ((sideFrom > 0.0f) == (sideTo > 0.0f)) return;
+
+		// 基準線の両端が移動した線分の両側にあるかどうか
+		const cv::Point2f move = to - from;
+		const float endFrom = (line.start - from).x * move.y - (line.start - from).y * move.x;
+		const float endTo = (line.end - from).x * move.y - (line.end - from).y * move.x;
+		if ((endFrom > 0.0f) == (endTo > 0.0f)) return;
+
+		// 同じ方向に続けて通過した場合 (基準線の上で止まっていた場合など) は1回だけ数える
+		const int direction = (sideTo > 0.0f) ? 1 : -1;
+		auto last = std::find_if(track.lastDirections.begin(), track.lastDirections.end(), [&](const std::pair<size_t, int>& item) { return item.first == index; });
+		if (last == track.lastDirections.end()) track.lastDirections.push_back({ index, direction });
+		else if (last->second == direction) return;
+		else last->second = direction;
+
+		if (direction > 0) line.upCount++;
+		else line.downCount++;
+		crossings.push_back(Crossing{ people, false, index, direction });
+	}
+
+	// 人が移動した先の点でゾーンの出入りを判定してカウントする
+	void updateZone(const size_t people, Track& track, const size_t index, const cv::Point2f& to)
+	{
+		Zone& zone = zones[index];
+		auto itr = std::find(track.zones.begin(), track.zones.end(), index);
+		const bool wasInside = (itr != track.zones.end());
+		const bool inside = geometry::isInside(zone.polygon, zone.bounds, to);
+		if (wasInside == inside) return;
+
+		if (inside)
+		{
+			track.zones.push_back(index);
+			zone.inCount++;
+			zone.occupancy++;
+		}
+		else
+		{
+			track.zones.erase(itr);
+			zone.outCount++;
+			zone.occupancy--;
+		}
+		crossings.push_back(Crossing{ people, true, index, inside ? 1 : -1 });
+	}
+};
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <Utils/Database.h>
+#include <Utils/PeopleCounter.h>
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <ctime>
+#include <cstdint>
+
+/**
+ * 基準線の通過 (PeopleCounter::CrossingEvent) をSQLに記録し、1分ごと・1時間ごとの人数を集計しておくクラス
+ * 通過を記録するたびに集計用のテーブルも更新するため、長期間の人数は集計済みの行を足し合わせるだけで求まる
+ * 記録先は SqlOpenPose でも、記録専用に開いた Database でもよい (セグメントを切り替える場合は専用のファイルに記録する)
+ */
+class CrossingLog
+{
+public:
+	// 1つの時間帯の人数
+	struct Counts
+	{
+		int64_t time = 0;  // 時間帯の開始時刻 (ミリ秒)
+		uint64_t up = 0;  // 上方向に通過した人数
+		uint64_t down = 0;  // 下方向に通過した人数
+	};
+
+	static constexpr int64_t minute = 60LL * 1000LL;
+	static constexpr int64_t hour = 60LL * minute;
+
+	/**
+	 * @param tableSuffix テーブル名の接尾辞 (SqlOpenPose に記録する場合は sql.tableName(u8"") を指定する)
+	 */
+	CrossingLog(const std::string& tableSuffix = u8"")
+		: eventTable{ u8"crossing_events" + tableSuffix },
+		minuteTable{ u8"crossing_minutes" + tableSuffix },
+		hourTable{ u8"crossing_hours" + tableSuffix } {}
+
+	virtual ~CrossingLog() {};
+
+	/**
+	 * 記録に使うテーブルが存在しない場合は生成する
+	 * @param database 記録先
+	 * @return 成功すると 0 が返る
+	 */
+	int createTableIfNoExist(Database& database) const
+	{
+		if (database.createTableIfNoExist(eventTable, u8"frame INTEGER, time INTEGER, people INTEGER, line INTEGER, direction INTEGER")) return 1;
+		if (database.createIndexIfNoExist(eventTable, u8"people", u8"line", false)) return 1;
+		if (database.createIndexIfNoExist(eventTable, u8"time", false)) return 1;
+		for (auto&& table : { minuteTable, hourTable })
+		{
+			if (database.createTableIfNoExist(table, u8"time INTEGER, line INTEGER, up INTEGER, down INTEGER, PRIMARY KEY(time, line)")) return 1;
+		}
+		return 0;
+	}
+
+	/**
+	 * 通過を1件記録し、集計を更新する
+	 * チェックポイントから再開した場合など、同じフレーム・同じ時刻の同じ人の通過が既に記録されている場合は何もしない
+	 * @param database 記録先
+	 * @param line 基準線のID
+	 * @param event 通過
+	 * @return 成功すると 0 が返る
+	 */
+	int write(Database& database, const int64_t line, const PeopleCounter::CrossingEvent& event) const
+	{
+		try
+		{
+			if (createTableIfNoExist(database)) return 1;
+
+			auto insertQuery = database.getStatement(u8"INSERT INTO " + eventTable + u8" SELECT ?, ?, ?, ?, ? WHERE NOT EXISTS "
+				u8"(SELECT 1 FROM " + eventTable + u8" WHERE people=? AND line=? AND frame=? AND time=?)");
+			if (database.bindAll(*insertQuery, (long long)event.frameNumber, (long long)event.timeStamp, (long long)event.people, (long long)line, event.direction,
+				(long long)event.people, (long long)line, (long long)event.frameNumber, (long long)event.timeStamp)) return 1;
+			if (insertQuery->exec() == 0) return 0;
+
+			// 1分ごと・1時間ごとの人数に加算する
+			const long long up = (event.direction > 0) ? 1 : 0;
+			const long long down = (event.direction > 0) ? 0 : 1;
+			for (auto&& bucket : { std::make_pair(minuteTable, minute), std::make_pair(hourTable, hour) })
+			{
+				auto rollupQuery = database.getStatement(u8"INSERT INTO " + bucket.first + u8" VALUES (?, ?, ?, ?) "
+					u8"ON CONFLICT(time, line) DO UPDATE SET up=up+excluded.up, down=down+excluded.down");
+				if (database.bindAllAndExec(*rollupQuery, (long long)floorTo(event.timeStamp, bucket.second), (long long)line, up, down)) return 1;
+			}
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+			return 1;
+		}
+
+		return 0;
+	}
+
+	/**
+	 * 複数の通過を記録する (PeopleCounter::getEvents() を渡す)
+	 * @param database 記録先
+	 * @param line 基準線のID
+	 * @param events 通過
+	 * @return 成功すると 0 が返る
+	 */
+	int write(Database& database, const int64_t line, const std::vector<PeopleCounter::CrossingEvent>& events) const
+	{
+		for (auto&& event : events) if (write(database, line, event)) return 1;
+		return 0;
+	}
+
+	/**
+	 * 指定した時間の範囲 [from, to) に通過した人数を求める
+	 * 範囲に含まれる1時間ごとの集計、端の1分ごとの集計、さらに端の1分未満の通過を足し合わせる
+	 * @param database 記録先
+	 * @param line 基準線のID
+	 * @param from 範囲の開始時刻 (ミリ秒)
+	 * @param to 範囲の終了時刻 (ミリ秒、この時刻は含まない)
+	 * @return 失敗すると std::nullopt が返る
+	 */
+	std::optional<Counts> count(const Database& database, const int64_t line, const int64_t from, const int64_t to) const
+	{
+		Counts result;
+		result.time = from;
+		if (from >= to) return result;
+		if (!database.isTableExist(eventTable)) return result;
+
+		const int64_t minuteFrom = ceilTo(from, minute), minuteTo = floorTo(to, minute);
+		const int64_t hourFrom = ceilTo(from, hour), hourTo = floorTo(to, hour);
+
+		// 1分に満たない範囲しか無い場合は通過の記録だけを数える
+		if (minuteFrom >= minuteTo) return sum(database, eventTable, line, from, to, result) ? std::nullopt : std::optional<Counts>(result);
+
+		if (sum(database, eventTable, line, from, minuteFrom, result)) return std::nullopt;
+		if (sum(database, eventTable, line, minuteTo, to, result)) return std::nullopt;
+		if (hourFrom >= hourTo)
+		{
+			if (sum(database, minuteTable, line, minuteFrom, minuteTo, result)) return std::nullopt;
+		}
+		else
+		{
+			if (sum(database, minuteTable, line, minuteFrom, hourFrom, result)) return std::nullopt;
+			if (sum(database, hourTable, line, hourFrom, hourTo, result)) return std::nullopt;
+			if (sum(database, minuteTable, line, hourTo, minuteTo, result)) return std::nullopt;
+		}
+		return result;
+	}
+
+	/**
+	 * 指定した時間の範囲の、1時間ごと (もしくは1分ごと) の人数を読み込む (人が通過しなかった時間帯は含まれない)
+	 * @param database 記録先
+	 * @param line 基準線のID
+	 * @param from 範囲の開始時刻 (ミリ秒)
+	 * @param to 範囲の終了時刻 (ミリ秒、この時刻は含まない)
+	 * @param isHourly true の場合は1時間ごと、false の場合は1分ごと
+	 * @return 失敗すると std::nullopt が返る
+	 */
+	std::optional<std::vector<Counts>> readBuckets(const Database& database, const int64_t line, const int64_t from, const int64_t to, const bool isHourly = true) const
+	{
+		std::vector<Counts> result;
+		const std::string& table = isHourly ? hourTable : minuteTable;
+		try
+		{
+			if (!database.isTableExist(table)) return result;
+			auto query = database.getStatement(u8"SELECT time, up, down FROM " + table + u8" WHERE line=? AND ? <= time AND time < ? ORDER BY time ASC");
+			if (database.bindAll(*query, (long long)line, (long long)from, (long long)to)) return std::nullopt;
+			while (query->executeStep())
+			{
+				Counts counts;
+				counts.time = query->getColumn(0).getInt64();
+				counts.up = (uint64_t)query->getColumn(1).getInt64();
+				counts.down = (uint64_t)query->getColumn(2).getInt64();
+				result.push_back(counts);
+			}
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+			return std::nullopt;
+		}
+		return result;
+	}
+
+	// 指定した時刻 (ミリ秒) を含む日の、ローカル時刻での0時の時刻 (ミリ秒) を求める
+	static int64_t startOfDay(const int64_t time)
+	{
+		std::time_t t = (std::time_t)(time / 1000);
+		std::tm tm;
+#ifdef _WIN32
+		localtime_s(&tm, &t);
+#else
+		localtime_r(&t, &tm);
+#endif
+		tm.tm_hour = 0;
+		tm.tm_min = 0;
+		tm.tm_sec = 0;
+		return (int64_t)std::mktime(&tm) * 1000LL;
+	}
+
+private:
+	// テーブル名
+	std::string eventTable, minuteTable, hourTable;
+
+	static int64_t floorTo(const int64_t time, const int64_t unit) { return time - (((time % unit) + unit) % unit); }
+	static int64_t ceilTo(const int64_t time, const int64_t unit) { return -floorTo(-time, unit); }
+
+	// テーブルの [from, to) の範囲の人数を result に加算する
+	int sum(const Database& database, const std::string& table, const int64_t line, const int64_t from, const int64_t to, Counts& result) const
+	{
+		if (from >= to) return 0;
+		try
+		{
+			const std::string columns = (table == eventTable)
+				? u8"SUM(direction > 0), SUM(direction < 0)"
+				: u8"SUM(up), SUM(down)";
+			auto query = database.getStatement(u8"SELECT " + columns + u8" FROM " + table + u8" WHERE line=? AND ? <= time AND time < ?");
+			if (database.bindAll(*query, (long long)line, (long long)from, (long long)to)) return 1;
+			if (query->executeStep())
+			{
+				result.up += (uint64_t)query->getColumn(0).getInt64();
+				result.down += (uint64_t)query->getColumn(1).getInt64();
+			}
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+};
@@ -2,14 +2,64 @@
 
 #include <iostream>
 #include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include <list>
+#include <set>
+#include <unordered_map>
 
 #include <SQLiteCpp/SQLiteCpp.h>
 
+// SQLの用途ごとの設定 (Database::create() で指定する)
+enum class StorageProfile
+{
+	//! SQLiteの初期設定のまま使う (ロールバックジャーナル, コミットごとにfsyncする)
+	Default,
+	//! 姿勢推定の結果を記録しながら別のプロセスからも読み込む (WAL, チェックポイントは別スレッドで行い、WALが大きくなった場合はコミットの際に切り詰める)
+	LiveIngest,
+	//! 既存の動画をまとめて解析する (WAL, fsyncしない, キャッシュを大きくする)
+	BulkImport,
+	//! 記録済みのファイルを読み込むだけ (書き込み禁止, mmapを大きくする, トランザクションを張り続けない)
+	ReadOnlyAnalytics
+};
+
 class Database
 {
 private:
 	std::unique_ptr<SQLite::Transaction> upTransaction;
 
+	// ファイルのパスと、開いたときの設定
+	std::string path;
+	StorageProfile profile = StorageProfile::Default;
+
+	// WALのチェックポイントを行うスレッドと、その停止の通知
+	std::thread checkpointThread;
+	std::mutex checkpointMutex;
+	std::condition_variable checkpointCondition;
+	bool isCheckpointStopped = true;
+
+	// 準備済みのSQL文のキャッシュ (SQL文 -> 準備済みのSQL文と、使われた順の一覧での位置)
+	// 使われた順の一覧は先頭ほど最近使われたもので、容量を超えると末尾から削除される
+	mutable std::list<std::string> statementOrder;
+	mutable std::unordered_map<std::string, std::pair<std::shared_ptr<SQLite::Statement>, std::list<std::string>::iterator>> statements;
+
+	// 存在が確認されたテーブルとIndexの名前
+	mutable std::set<std::string> knownTables;
+	mutable std::set<std::string> knownIndexes;
+
+	// 張っているトランザクションをコミットする (新しいトランザクションは張らない)
+	int commitPending();
+
+	// WALが walSizeLimit 以上になっていれば、書き戻してWALを切り詰める (LiveIngest のコミットの際に呼ばれる)
+	void truncateWal();
+
+	// テーブルまたはIndexが存在するかをsqlite_masterから検索する
+	bool isSchemaExist(const std::string& type, const std::string& name) const;
+
 	void bind(SQLite::Statement&, size_t) const;
 	template<typename Head, typename... Body>
 	void bind(SQLite::Statement& query, size_t index, Head head, Body... body) const
@@ -28,8 +78,63 @@ public:
 
 	std::shared_ptr<SQLite::Database> database;
 
-	int create(const std::string& path, const int aFlags);
-
+	/**
+	 * ファイルを開く、もしくは生成する
+	 * @param path ファイルのパス
+	 * @param aFlags SQLite::OPEN_READWRITE などのフラグ (ReadOnlyAnalytics の場合は SQLite::OPEN_READONLY で開き直す)
+	 * @param profile 用途ごとの設定 (page_size は新しく生成したファイルにのみ反映される)
+	 * @return 成功すると 0 が返る
+	 */
+	int create(const std::string& path, const int aFlags, const StorageProfile profile = StorageProfile::Default);
+
+	// 用途ごとの設定を接続に反映する (createConnection() で開いた接続にも使える)
+	static int applyProfile(SQLite::Database& connection, const StorageProfile profile);
+
+	// 開いたときの設定を取得する
+	StorageProfile getProfile() const { return profile; }
+
+	// キャッシュする準備済みのSQL文の数
+	size_t statementCacheCapacity = 64;
+
+	// LiveIngest で、コミットの際にWALを切り詰める大きさ (バイト, 0の場合は切り詰めない)
+	// 別スレッドのチェックポイント (PASSIVE) は読み込み中の接続があるとWALを先頭から使い直せないため、WALが際限なく大きくなることを防ぐ
+	uint64_t walSizeLimit = 64ull * 1024 * 1024;
+
+	/**
+	 * 準備済みのSQL文を取得する
+	 * 同じSQL文は1度だけコンパイルされ、以降はキャッシュから使い回される
+	 * 戻り値が破棄されるとSQL文はreset()されるため、読み込み中のトランザクションが残らない
+	 * (同じSQL文が使用中の場合は、キャッシュしない新しいSQL文が返る)
+	 * @param query SQL文
+	 * @return 準備済みのSQL文 (バインドされた値は消去されている)
+	 */
+	std::shared_ptr<SQLite::Statement> getStatement(const std::string& query) const;
+
+	// 準備済みのSQL文のキャッシュと、テーブルとIndexの一覧を消去する
+	void clearStatementCache() const;
+
+	// テーブルが存在するかどうか (1度存在が確認されたテーブルはSQLに問い合わせない)
+	bool isTableExist(const std::string& tableName) const;
+
+	/**
+	 * WALのチェックポイントを別スレッドで定期的に行う (LiveIngest では create() の中で自動的に開始される)
+	 * チェックポイントは別の接続で行うため、記録中のスレッドはコミットの際にWALの書き戻しを待たなくてよい
+	 * @param interval チェックポイントを行う周期
+	 * @return 成功すると 0 が返る
+	 */
+	int startCheckpointThread(const std::chrono::milliseconds interval = std::chrono::milliseconds(1000));
+
+	// チェックポイントを行うスレッドを停止する
+	void stopCheckpointThread();
+
+	// 同じファイルに別の接続を開く (別スレッドからの読み込みなどに使う)
+	static std::shared_ptr<SQLite::Database> createConnection(const std::string& path, const int aFlags);
+
+	/**
+	 * 変更をファイルにコミットし、次の変更のためのトランザクションを張り直す
+	 * コミットに失敗した場合は変更を失わないようにトランザクションを残すため、再度呼ぶとコミットをやり直せる
+	 * @return 成功すると 0 が返る (失敗した場合は呼び出し元でエラーとして扱うこと)
+	 */
 	int commit();
 
 	int createTableIfNoExist(const std::string& tableName, const std::string& rowTitles);
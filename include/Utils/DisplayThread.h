@@ -0,0 +1,200 @@
+#pragma once
+
+#include <OpenPoseWrapper/MinimumOpenPose.h>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * ウィンドウの表示 (cv::imshow) とキー入力の待機 (cv::waitKey) を専用のスレッドで行うクラス
+ * 処理側のスレッドは show() で画像を渡すだけで、表示を待たずに次のフレームの処理に進める
+ * ウィンドウごとに最新の画像だけを保持し、表示が間に合わなかった画像は捨てる
+ * キー入力とマウスイベントはキューに溜め、処理側のスレッドで takeEvents() によって取り出す
+ * @note OpenCVのウィンドウの操作は全てこのスレッドで行う必要があるため、このクラスを使う場合は cv::imshow などを直接呼ばないこと
+ * (表示したウィンドウは、デストラクタでスレッドを止める前にこのスレッドで閉じる)
+ */
+class DisplayThread
+{
+public:
+	// キー入力またはマウスイベント
+	struct Event
+	{
+		enum Type : uint8_t { KEY, MOUSE } type = KEY;
+		std::string window;  // マウスイベントが発生したウィンドウ (キー入力はウィンドウを特定できないため空)
+		int key = -1;  // 入力されたキー番号
+		int mouseEvent = 0, x = 0, y = 0;  // マウスイベントの種類と座標
+	};
+
+	/**
+	 * @param fps 画面を更新する頻度 (処理側のフレームレートとは無関係に、この頻度で最新の画像を表示する)
+	 */
+	DisplayThread(const double fps = 30.0)
+		: interval{ std::chrono::microseconds((long long)(1000000.0 / std::max(1.0, fps))) }
+	{
+		displayThread = std::thread([this]() { run(); });
+	}
+
+	virtual ~DisplayThread()
+	{
+		{
+			std::lock_guard<std::mutex> lock(displayMutex);
+			isDisplayStopped = true;
+		}
+		eventCondition.notify_all();
+		if (displayThread.joinable()) displayThread.join();
+	}
+
+	/**
+	 * ウィンドウに表示する画像を渡す (表示は待たない)
+	 * @param window ウィンドウの名前
+	 * @param input 表示する画像 (複製して保持するため、呼び出し後に書き換えても良い)
+	 */
+	void show(const std::string& window, const cv::Mat& input)
+	{
+		if (input.empty()) return;
+		cv::Mat copy = input.clone();
+		std::lock_guard<std::mutex> lock(displayMutex);
+		Mailbox& mailbox = mailboxes[window];
+		mailbox.frame = copy;
+		mailbox.isUpdated = true;
+	}
+
+	/**
+	 * キューに溜まったイベントを取り出す
+	 * @param window このウィンドウで発生したマウスイベントを取り出す
+	 * @param withKeys true の場合はキー入力も取り出す
+	 * @param timeout イベントが1つも無い場合に待機する時間 (負の値を指定するとイベントが来るまで待機する)
+	 */
+	std::vector<Event> takeEvents(const std::string& window, const bool withKeys, const std::chrono::milliseconds timeout = std::chrono::milliseconds(0))
+	{
+		std::vector<Event> result;
+		std::unique_lock<std::mutex> lock(displayMutex);
+		auto take = [&]() {
+			for (auto itr = events.begin(); itr != events.end();)
+			{
+				const bool isTarget = (itr->type == Event::KEY) ? withKeys : (itr->window == window);
+				if (!isTarget)
+				{
+					itr++;
+					continue;
+				}
+				result.push_back(*itr);
+				itr = events.erase(itr);
+			}
+			return !result.empty() || isDisplayStopped;
+		};
+		if (timeout.count() < 0) eventCondition.wait(lock, take);
+		else if (timeout.count() > 0) eventCondition.wait_for(lock, timeout, take);
+		else take();
+		return result;
+	}
+
+private:
+	// ウィンドウごとの最新の画像
+	struct Mailbox
+	{
+		cv::Mat frame;
+		bool isUpdated = false;
+	};
+
+	// マウスイベントのコールバック関数に渡す情報 (ウィンドウが存在する間は同じアドレスに置いておく)
+	struct WindowContext
+	{
+		DisplayThread* display;
+		std::string window;
+	};
+
+	// 画面を更新する間隔
+	std::chrono::microseconds interval;
+
+	// 表示を行うスレッドと、その停止の通知
+	std::thread displayThread;
+	std::mutex displayMutex;
+	std::condition_variable eventCondition;
+	bool isDisplayStopped = false;
+
+	std::map<std::string, Mailbox> mailboxes;
+	std::deque<Event> events;
+
+	// 表示を行うスレッドだけが使う
+	std::map<std::string, std::unique_ptr<WindowContext>> windows;
+
+	void push(const Event& event)
+	{
+		{
+			std::lock_guard<std::mutex> lock(displayMutex);
+
+			// 処理側が取り出さない場合に備えて、古いイベントから捨てる
+			if (events.size() >= 1024) events.pop_front();
+			events.push_back(event);
+		}
+		eventCondition.notify_all();
+	}
+
+	void run()
+	{
+		std::vector<std::pair<std::string, cv::Mat>> frames;
+		while (true)
+		{
+			const auto next = std::chrono::steady_clock::now() + interval;
+
+			// 更新された画像を取り出す
+			frames.clear();
+			{
+				std::lock_guard<std::mutex> lock(displayMutex);
+				if (isDisplayStopped) break;
+				for (auto&& mailbox : mailboxes)
+				{
+					if (!mailbox.second.isUpdated) continue;
+					frames.emplace_back(mailbox.first, mailbox.second.frame);
+					mailbox.second.frame = cv::Mat();
+					mailbox.second.isUpdated = false;
+				}
+			}
+
+			for (auto&& frame : frames)
+			{
+				cv::imshow(frame.first, frame.second);
+
+				// 初めて表示したウィンドウにマウスイベントのコールバック関数を登録する
+				if (windows.count(frame.first) == 0)
+				{
+					windows[frame.first] = std::make_unique<WindowContext>(WindowContext{ this, frame.first });
+					cv::setMouseCallback(frame.first, [](int event, int x, int y, int flags, void* userdata) {
+						WindowContext* context = (WindowContext*)userdata;
+						Event mouse;
+						mouse.type = Event::MOUSE;
+						mouse.window = context->window;
+						mouse.mouseEvent = event;
+						mouse.x = x;
+						mouse.y = y;
+						context->display->push(mouse);
+					}, (void*)windows[frame.first].get());
+				}
+			}
+
+			// ウィンドウのイベントを処理し、キー入力があればキューに入れる
+			const int key = cv::waitKey(1);
+			if (key != -1)
+			{
+				Event event;
+				event.key = key;
+				push(event);
+			}
+
+			std::this_thread::sleep_until(next);
+		}
+
+		// 表示したウィンドウを、作成したこのスレッドで閉じる
+		for (auto&& window : windows) cv::destroyWindow(window.first);
+		if (!windows.empty()) cv::waitKey(1);
+		windows.clear();
+	}
+};
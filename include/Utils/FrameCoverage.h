@@ -0,0 +1,114 @@
+#pragma once
+
+#include <map>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+/**
+ * 記録済みのフレーム番号を連続した区間の集合として管理するクラス
+ * フレームごとにSQLへ問い合わせる代わりに、メモリ上で記録済みかどうかを判定する
+ * 区間の数は記録が途切れている箇所の数に比例するため、長時間の動画でも使用メモリは小さい
+ */
+class FrameCoverage
+{
+private:
+	// 区間の先頭のフレーム番号 -> 区間の末尾の次のフレーム番号
+	std::map<size_t, size_t> ranges;
+
+	// 記録済みのフレーム数
+	size_t frameCount = 0;
+
+public:
+	FrameCoverage() {}
+
+	virtual ~FrameCoverage() {};
+
+	// 全ての区間を削除する
+	void clear()
+	{
+		ranges.clear();
+		frameCount = 0;
+	}
+
+	// 記録済みのフレーム数を取得
+	size_t count() const { return frameCount; }
+
+	// 区間の数を取得
+	size_t rangeCount() const { return ranges.size(); }
+
+	// 指定されたフレームが記録済みかどうか
+	bool contains(size_t frame) const
+	{
+		auto itr = ranges.upper_bound(frame);
+		if (itr == ranges.begin()) return false;
+		itr--;
+		return frame < itr->second;
+	}
+
+	// フレームを記録済みにする
+	void add(size_t frame) { add(frame, frame + 1); }
+
+	/**
+	 * 区間を記録済みにする
+	 * @param first 区間の先頭のフレーム番号
+	 * @param last 区間の末尾の次のフレーム番号
+	 */
+	void add(size_t first, size_t last)
+	{
+		if (first >= last) return;
+
+		// 重なっている区間や隣接している区間を1つにまとめる
+		auto itr = ranges.upper_bound(first);
+		if (itr != ranges.begin())
+		{
+			auto prev = std::prev(itr);
+			if (prev->second >= first) itr = prev;
+		}
+		while ((itr != ranges.end()) && (itr->first <= last))
+		{
+			first = std::min(first, itr->first);
+			last = std::max(last, itr->second);
+			frameCount -= itr->second - itr->first;
+			itr = ranges.erase(itr);
+		}
+		ranges[first] = last;
+		frameCount += last - first;
+	}
+
+	/**
+	 * 指定されたフレーム以降で、最初に記録されていないフレームを取得する
+	 * @param from 検索を開始するフレーム番号
+	 */
+	size_t firstMissing(size_t from = 0) const
+	{
+		auto itr = ranges.upper_bound(from);
+		if (itr == ranges.begin()) return from;
+		itr--;
+		return (from < itr->second) ? itr->second : from;
+	}
+
+	/**
+	 * 指定された範囲の中で記録されていない区間を取得する
+	 * @param first 範囲の先頭のフレーム番号
+	 * @param last 範囲の末尾の次のフレーム番号 (動画の総フレーム数など)
+	 * @return 記録されていない区間 (先頭, 末尾の次) の配列
+	 */
+	std::vector<std::pair<size_t, size_t>> missingRanges(size_t first, size_t last) const
+	{
+		std::vector<std::pair<size_t, size_t>> result;
+		size_t frame = firstMissing(first);
+		auto itr = ranges.upper_bound(frame);
+		while (frame < last)
+		{
+			size_t end = (itr == ranges.end()) ? last : std::min(itr->first, last);
+			result.push_back({ frame, end });
+			if (itr == ranges.end()) break;
+			frame = itr->second;
+			itr++;
+		}
+		return result;
+	}
+};
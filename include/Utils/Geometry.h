@@ -0,0 +1,51 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+// 多角形の判定とグリッドのセルの計算 (CountingEngine と TrackAnalytics で共通に使う)
+namespace geometry
+{
+	// 点の外接矩形を求める
+	inline cv::Rect2f boundsOf(const std::vector<cv::Point2f>& points)
+	{
+		float left = points[0].x, top = points[0].y, right = points[0].x, bottom = points[0].y;
+		for (auto&& p : points)
+		{
+			left = std::min(left, p.x); top = std::min(top, p.y);
+			right = std::max(right, p.x); bottom = std::max(bottom, p.y);
+		}
+		return cv::Rect2f{ left, top, right - left, bottom - top };
+	}
+
+	// 点が矩形の中 (右端と下端を含む) にあるかどうか (NaN の場合は false)
+	inline bool isInside(const cv::Rect2f& bounds, const cv::Point2f& p)
+	{
+		return (p.x >= bounds.x) && (p.y >= bounds.y) && (p.x <= bounds.x + bounds.width) && (p.y <= bounds.y + bounds.height);
+	}
+
+	// 点が多角形の中にあるかどうか (交差数判定)
+	inline bool isInside(const std::vector<cv::Point2f>& polygon, const cv::Point2f& p)
+	{
+		bool inside = false;
+		for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+		{
+			const cv::Point2f& a = polygon[i];
+			const cv::Point2f& b = polygon[j];
+			if (((a.y > p.y) != (b.y > p.y)) && (p.x < (b.x - a.x) * (p.y - a.y) / (b.y - a.y) + a.x)) inside = !inside;
+		}
+		return inside;
+	}
+
+	// 外接矩形で先に判定してから、点が多角形の中にあるかどうかを判定する
+	inline bool isInside(const std::vector<cv::Point2f>& polygon, const cv::Rect2f& bounds, const cv::Point2f& p)
+	{
+		return isInside(bounds, p) && isInside(polygon, p);
+	}
+
+	// グリッドのセルの座標をキーに変換する
+	inline int64_t cellKey(int x, int y) { return ((int64_t)x << 32) ^ (int64_t)(uint32_t)y; }
+}
@@ -0,0 +1,354 @@
+#pragma once
+
+#include <OpenPoseWrapper/MinimumOpenPose.h>
+#include <Utils/Database.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <optional>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+/**
+ * 地面上の座標 (vt::ScreenToGround::translate() で変換した座標) に人がいた量を、一定の解像度のグリッドに時間帯ごとに積算するクラス
+ * 1点ごとに周囲の4セルへ距離に応じて重みを分配する (バイリニア) ため、セルの境界を歩いた人の量も滑らかに積算される
+ * 他のカメラや他の時間帯のグリッドと合算でき、値が0のセルを省いてSQLに保存できる
+ */
+class Heatmap
+{
+private:
+	using Node = MinOpenPose::Node;
+
+public:
+	//! 1時間 (ミリ秒)
+	static constexpr int64_t hour = 60LL * 60LL * 1000LL;
+
+	/**
+	 * @param area グリッドで覆う地面上の範囲
+	 * @param cols グリッドの列数
+	 * @param rows グリッドの行数
+	 * @param bucketMillis 1つの時間帯の長さ (ミリ秒)
+	 */
+	Heatmap(const cv::Rect2f& area, const int cols, const int rows, const int64_t bucketMillis = hour)
+		: area{ area }, cols{ std::max(1, cols) }, rows{ std::max(1, rows) }, bucketMillis{ std::max<int64_t>(1, bucketMillis) },
+		cellWidth{ area.width / (float)std::max(1, cols) }, cellHeight{ area.height / (float)std::max(1, rows) } {}
+
+	virtual ~Heatmap() {};
+
+	/**
+	 * 1点を積算する
+	 * @param time 時刻 (ミリ秒)
+	 * @param point 地面上の座標
+	 * @param weight 積算する量 (フレームの間隔 (秒) を指定すると、人がいた時間の合計になる)
+	 */
+	void add(const int64_t time, const cv::Point2f& point, const float weight = 1.0f)
+	{
+		splat(bucket(time), &point.x, &point.y, 1, weight);
+	}
+
+	/**
+	 * 1フレーム分の人の座標をまとめて積算する
+	 * @param time 時刻 (ミリ秒)
+	 * @param points 人のIDと地面上の座標
+	 * @param weight 1人あたりに積算する量
+	 */
+	void add(const int64_t time, const std::map<size_t, Node>& points, const float weight = 1.0f)
+	{
+		if (points.empty()) return;
+		xs.clear();
+		ys.clear();
+		for (auto&& point : points)
+		{
+			xs.push_back(point.second.x);
+			ys.push_back(point.second.y);
+		}
+		splat(bucket(time), xs.data(), ys.data(), xs.size(), weight);
+	}
+
+	/**
+	 * 別のグリッドを合算する (他のカメラのグリッドや、別に集計した時間帯のグリッド)
+	 * @param other 範囲、解像度、時間帯の長さが同じグリッド
+	 * @return 成功すると 0 が返る
+	 */
+	int merge(const Heatmap& other)
+	{
+		if (!isSameGeometry(other)) return 1;
+		for (auto&& item : other.buckets)
+		{
+			std::vector<float>& cells = bucket(item.first);
+			for (size_t i = 0; i < cells.size(); i++) cells[i] += item.second[i];
+		}
+		return 0;
+	}
+
+	/**
+	 * [from, to) と重なる時間帯を合算したグリッドを取得する
+	 * 時間帯の単位で合算するため、from を含む時間帯と、to より前に始まる時間帯 (途中までしか積算していない現在の時間帯も含む) が全て含まれる
+	 * @param from 開始時刻 (ミリ秒)
+	 * @param to 終了時刻 (ミリ秒、この時刻以降に始まる時間帯は含まない)
+	 * @return rows 行 cols 列の CV_32F の画像
+	 */
+	cv::Mat accumulate(const int64_t from, const int64_t to) const
+	{
+		cv::Mat result(rows, cols, CV_32F, cv::Scalar{ 0.0 });
+		for (auto itr = buckets.lower_bound(bucketStart(from)); (itr != buckets.end()) && (itr->first < to); itr++)
+		{
+			float* dst = (float*)result.data;
+			const float* src = itr->second.data();
+			for (size_t i = 0; i < itr->second.size(); i++) dst[i] += src[i];
+		}
+		return result;
+	}
+
+	/**
+	 * [from, to) と重なる時間帯を合算したグリッドを色付けした画像を取得する (最大値が明るくなるように正規化する、範囲は accumulate() と同じ)
+	 * @param from 開始時刻 (ミリ秒)
+	 * @param to 終了時刻 (ミリ秒)
+	 * @param scale 1セルを表示する画素数
+	 * @return CV_8UC3 の画像
+	 */
+	cv::Mat render(const int64_t from, const int64_t to, const int scale = 4) const
+	{
+		cv::Mat grid = accumulate(from, to);
+		double maxValue = 0.0;
+		cv::minMaxLoc(grid, nullptr, &maxValue);
+
+		cv::Mat gray;
+		grid.convertTo(gray, CV_8U, (maxValue > 0.0) ? (255.0 / maxValue) : 0.0);
+		cv::Mat result;
+		cv::applyColorMap(gray, result, cv::COLORMAP_INFERNO);
+		if (scale > 1) cv::resize(result, result, cv::Size{ cols * scale, rows * scale }, 0.0, 0.0, cv::INTER_NEAREST);
+		return result;
+	}
+
+	/**
+	 * time より前の時間帯をメモリ上から削除する (SQLに保存済みの時間帯を捨てる場合など)
+	 * @param time 時刻 (ミリ秒)
+	 */
+	void dropBefore(const int64_t time)
+	{
+		const int64_t start = bucketStart(time);
+		for (auto itr = buckets.begin(); (itr != buckets.end()) && (itr->first < start);)
+		{
+			dirtyBuckets.erase(itr->first);
+			itr = buckets.erase(itr);
+		}
+	}
+
+	/**
+	 * 前回の write() 以降に積算した時間帯を、値が0のセルを省いてSQLに書き込む
+	 * 同じ名前と時間帯の行が既にある場合は、セルごとに大きい方の値を残す
+	 * (同じ区間を途中まで処理し直した場合に、少ない値で上書きしない。別の区間を同じ時間帯に積算する場合は、read() で読み込んでから add() する)
+	 * @param database 書き込み先
+	 * @param tableName テーブル名
+	 * @param name グリッドの名前 (カメラの名前など)
+	 * @return 成功すると 0 が返る
+	 */
+	int write(Database& database, const std::string& tableName, const std::string& name)
+	{
+		try
+		{
+			if (database.createTableIfNoExist(tableName, u8"name TEXT, time INTEGER, cols INTEGER, rows INTEGER, "
+				u8"area_x REAL, area_y REAL, area_width REAL, area_height REAL, cells BLOB, PRIMARY KEY(name, time)")) return 1;
+
+			auto query = database.getStatement(u8"INSERT OR REPLACE INTO " + tableName + u8" VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)");
+			std::vector<uint8_t> blob;
+			std::vector<float> cells;
+			for (auto&& time : dirtyBuckets)
+			{
+				// 既に書き込まれている行とセルごとに大きい方の値を残す
+				cells = buckets.at(time);
+				if (mergeStored(database, tableName, name, time, cells)) return 1;
+
+				// (セルの番号, 値) の組を値が0でないセルの分だけ並べる
+				blob.clear();
+				for (uint32_t i = 0; i < (uint32_t)cells.size(); i++)
+				{
+					if (cells[i] == 0.0f) continue;
+					const size_t offset = blob.size();
+					blob.resize(offset + sizeof(uint32_t) + sizeof(float));
+					std::memcpy(blob.data() + offset, &i, sizeof(uint32_t));
+					std::memcpy(blob.data() + offset + sizeof(uint32_t), &cells[i], sizeof(float));
+				}
+
+				if (database.bindAll(*query, name, (long long)time, cols, rows, area.x, area.y, area.width, area.height)) return 1;
+				query->bind(9, blob.data(), (int)blob.size());
+				(void)query->exec();
+			}
+			dirtyBuckets.clear();
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+			return 1;
+		}
+
+		return 0;
+	}
+
+	/**
+	 * SQLに保存された [from, to) の時間帯を読み込んで合算する
+	 * @param database 読み込み元
+	 * @param tableName テーブル名
+	 * @param name グリッドの名前 (カメラの名前など、空の場合は全ての名前を合算する)
+	 * @param from 開始時刻 (ミリ秒)
+	 * @param to 終了時刻 (ミリ秒)
+	 * @return 成功すると 0 が返る (範囲や解像度が異なる行がある場合は 1 が返る)
+	 */
+	int read(const Database& database, const std::string& tableName, const std::string& name, const int64_t from, const int64_t to)
+	{
+		try
+		{
+			if (!database.isTableExist(tableName)) return 0;
+			auto query = database.getStatement(u8"SELECT * FROM " + tableName + u8" WHERE (?='' OR name=?) AND ? <= time AND time < ?");
+			if (database.bindAll(*query, name, name, (long long)bucketStart(from), (long long)to)) return 1;
+			while (query->executeStep())
+			{
+				const cv::Rect2f storedArea{ (float)query->getColumn(4).getDouble(), (float)query->getColumn(5).getDouble(),
+					(float)query->getColumn(6).getDouble(), (float)query->getColumn(7).getDouble() };
+				if ((query->getColumn(2).getInt() != cols) || (query->getColumn(3).getInt() != rows) || (storedArea != area)) return 1;
+
+				std::vector<float>& cells = bucket(query->getColumn(1).getInt64());
+				decodeCells((const uint8_t*)query->getColumn(8).getBlob(), (size_t)query->getColumn(8).getBytes(), cells, false);
+			}
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+			return 1;
+		}
+
+		return 0;
+	}
+
+	// 積算した時間帯の一覧 (時間帯の開始時刻 -> rows * cols 個のセル)
+	const std::map<int64_t, std::vector<float>>& getBuckets() const { return buckets; }
+
+	// グリッドで覆う地面上の範囲を取得
+	const cv::Rect2f& getArea() const { return area; }
+
+	// グリッドの列数を取得
+	int getCols() const { return cols; }
+
+	// グリッドの行数を取得
+	int getRows() const { return rows; }
+
+private:
+	// グリッドで覆う地面上の範囲と解像度
+	cv::Rect2f area;
+	int cols, rows;
+
+	// 1つの時間帯の長さ (ミリ秒)
+	int64_t bucketMillis;
+
+	// 1セルの大きさ
+	float cellWidth, cellHeight;
+
+	// 時間帯ごとのグリッド
+	std::map<int64_t, std::vector<float>> buckets;
+
+	// 前回の write() 以降に積算した時間帯
+	std::set<int64_t> dirtyBuckets;
+
+	// add() で使う作業用の配列
+	std::vector<float> xs, ys;
+
+	/**
+	 * SQLに書き込まれている行の値とセルごとに大きい方を cells に残す (行が無い場合は何もしない)
+	 * @return 成功すると 0 が返る (範囲や解像度が異なる行がある場合は 1 が返る)
+	 */
+	int mergeStored(const Database& database, const std::string& tableName, const std::string& name, const int64_t time, std::vector<float>& cells) const
+	{
+		auto query = database.getStatement(u8"SELECT * FROM " + tableName + u8" WHERE name=? AND time=?");
+		if (database.bindAll(*query, name, (long long)time)) return 1;
+		if (!query->executeStep()) return 0;
+
+		const cv::Rect2f storedArea{ (float)query->getColumn(4).getDouble(), (float)query->getColumn(5).getDouble(),
+			(float)query->getColumn(6).getDouble(), (float)query->getColumn(7).getDouble() };
+		if ((query->getColumn(2).getInt() != cols) || (query->getColumn(3).getInt() != rows) || (storedArea != area)) return 1;
+
+		decodeCells((const uint8_t*)query->getColumn(8).getBlob(), (size_t)query->getColumn(8).getBytes(), cells, true);
+		return 0;
+	}
+
+	// (セルの番号, 値) の組を並べたBLOBを cells に加算する (isMax が true の場合は大きい方の値を残す)
+	static void decodeCells(const uint8_t* blob, const size_t bytes, std::vector<float>& cells, const bool isMax)
+	{
+		const size_t count = bytes / (sizeof(uint32_t) + sizeof(float));
+		for (size_t i = 0; i < count; i++)
+		{
+			uint32_t index;
+			float value;
+			std::memcpy(&index, blob + i * (sizeof(uint32_t) + sizeof(float)), sizeof(uint32_t));
+			std::memcpy(&value, blob + i * (sizeof(uint32_t) + sizeof(float)) + sizeof(uint32_t), sizeof(float));
+			if (index >= cells.size()) continue;
+			cells[index] = isMax ? std::max(cells[index], value) : (cells[index] + value);
+		}
+	}
+
+	// 時刻を含む時間帯の開始時刻
+	int64_t bucketStart(const int64_t time) const { return time - (((time % bucketMillis) + bucketMillis) % bucketMillis); }
+
+	// 時刻を含む時間帯のグリッドを取得する (無ければ作成する)
+	std::vector<float>& bucket(const int64_t time)
+	{
+		const int64_t start = bucketStart(time);
+		dirtyBuckets.insert(start);
+		auto itr = buckets.find(start);
+		if (itr != buckets.end()) return itr->second;
+		return buckets.emplace(start, std::vector<float>((size_t)cols * (size_t)rows, 0.0f)).first->second;
+	}
+
+	// 範囲、解像度、時間帯の長さが同じかどうか
+	bool isSameGeometry(const Heatmap& other) const
+	{
+		return (area == other.area) && (cols == other.cols) && (rows == other.rows) && (bucketMillis == other.bucketMillis);
+	}
+
+	/**
+	 * 点を周囲の4セルに重みを分配して積算する
+	 * セルの番号と重みを先に全ての点について求め (分岐の無いループ)、その後でまとめて加算する
+	 */
+	void splat(std::vector<float>& cells, const float* px, const float* py, const size_t count, const float weight)
+	{
+		indices.resize(count);
+		fractions.resize(count * 2);
+		for (size_t i = 0; i < count; i++)
+		{
+			// セルの中心を基準にした座標
+			const float gx = (px[i] - area.x) / cellWidth - 0.5f;
+			const float gy = (py[i] - area.y) / cellHeight - 0.5f;
+
+			// 無限大やNaN、グリッドから大きく外れた座標はintに変換できないため、どのセルにも加算しない位置にする
+			const bool isValid = std::isfinite(gx) && std::isfinite(gy) && (gx > -2.0f) && (gy > -2.0f) && (gx < (float)cols + 1.0f) && (gy < (float)rows + 1.0f);
+			const float fx = isValid ? std::floor(gx) : -2.0f, fy = isValid ? std::floor(gy) : -2.0f;
+			indices[i] = std::make_pair((int)fx, (int)fy);
+			fractions[i * 2 + 0] = isValid ? (gx - fx) : 0.0f;
+			fractions[i * 2 + 1] = isValid ? (gy - fy) : 0.0f;
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			const int x = indices[i].first, y = indices[i].second;
+			const float tx = fractions[i * 2 + 0], ty = fractions[i * 2 + 1];
+			addCell(cells, x, y, (1.0f - tx) * (1.0f - ty) * weight);
+			addCell(cells, x + 1, y, tx * (1.0f - ty) * weight);
+			addCell(cells, x, y + 1, (1.0f - tx) * ty * weight);
+			addCell(cells, x + 1, y + 1, tx * ty * weight);
+		}
+	}
+
+	// splat() で使う作業用の配列
+	std::vector<std::pair<int, int>> indices;
+	std::vector<float> fractions;
+
+	// グリッドの範囲内であればセルに加算する
+	void addCell(std::vector<float>& cells, const int x, const int y, const float value) const
+	{
+		if ((x < 0) || (y < 0) || (x >= cols) || (y >= rows)) return;
+		cells[(size_t)y * (size_t)cols + (size_t)x] += value;
+	}
+};
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <OpenPoseWrapper/MinimumOpenPose.h>
+#include <Utils/SqlOpenPose.h>
+
+#include <vector>
+
+/**
+ * 遅延時間が目標値を超えないように、姿勢推定の解像度とフレームの間引きを調整するクラス
+ * Webカメラなどのリアルタイムな入力で、姿勢推定が入力に追いつかずに遅延が増え続けることを防ぐ
+ */
+class LatencyController
+{
+public:
+	// 1フレームごとの調整結果
+	struct Decision
+	{
+		bool skip;  // このフレームの姿勢推定を省略するかどうか
+		size_t level;  // 使用する解像度の段階 (0が最も高解像度)
+		op::Point<int> netInputSize;  // 使用する解像度
+		double latency;  // 平滑化された遅延時間 (ミリ秒)
+		size_t queueDepth;  // 処理待ちのフレーム数
+	};
+
+	/**
+	 * @param targetLatency 目標とする遅延時間 (ミリ秒)
+	 * @param ladder 切り替える解像度の一覧 (高解像度から低解像度の順に指定する)
+	 * @param maxQueueDepth 処理待ちのフレーム数がこの値を超えた場合はフレームを間引く
+	 * @param framesToSwitch 遅延時間がこのフレーム数連続で目標を外れた場合に解像度を切り替える
+	 * @param hysteresis 解像度を切り替える遅延時間の幅 (目標値に対する割合)
+	 */
+	LatencyController(
+		double targetLatency = 500.0,
+		const std::vector<op::Point<int>>& ladder = { op::Point<int>(-1, 368), op::Point<int>(-1, 256), op::Point<int>(-1, 160) },
+		size_t maxQueueDepth = 2,
+		size_t framesToSwitch = 30,
+		double hysteresis = 0.2
+	) :
+		targetLatency{ targetLatency },
+		ladder{ ladder },
+		maxQueueDepth{ maxQueueDepth },
+		framesToSwitch{ framesToSwitch },
+		hysteresis{ hysteresis }
+	{
+		if (this->ladder.empty()) this->ladder.push_back(op::Point<int>(-1, 368));
+	}
+
+	virtual ~LatencyController() {};
+
+	/**
+	 * 計測した遅延時間から、次のフレームの処理方法を決める
+	 * @param latency 直前のフレームを取得してから処理が終わるまでの時間 (ミリ秒)
+	 *                (直前のフレームを間引いた場合など、計測していない場合は負の値を指定する)
+	 * @param queueDepth 直前のフレームを処理している間に取得されたフレームの数
+	 * @return 次のフレームの処理方法
+	 */
+	Decision update(double latency, size_t queueDepth)
+	{
+		// 解像度を切り替えた直後のフレームは OpenPose の再起動の時間を含むため、遅延時間を計測しなかったものとして扱う
+		// (平滑化された遅延時間は切り替える前の値を保つ)
+		if (isSwitched)
+		{
+			latency = -1.0;
+			isSwitched = false;
+		}
+
+		// 遅延時間を平滑化し、目標から外れている連続フレーム数を数える (計測していないフレームは数えない)
+		if (latency >= 0.0)
+		{
+			smoothedLatency = isFirst ? latency : (smoothedLatency * 0.9 + latency * 0.1);
+			isFirst = false;
+
+			if (smoothedLatency > targetLatency * (1.0 + hysteresis)) { overCount++; underCount = 0; }
+			else if (smoothedLatency < targetLatency * (1.0 - hysteresis) * 0.5) { underCount++; overCount = 0; }
+			else { overCount = 0; underCount = 0; }
+		}
+
+		// 遅延が続く場合は解像度を下げ、余裕がある場合は解像度を上げる
+		if ((overCount >= framesToSwitch) && (level + 1 < ladder.size()))
+		{
+			level++;
+			overCount = 0;
+			isSwitched = true;
+		}
+		if ((underCount >= framesToSwitch) && (level > 0))
+		{
+			level--;
+			underCount = 0;
+			isSwitched = true;
+		}
+
+		// 処理待ちのフレームが溜まっている場合や、1フレームの遅延が目標の2倍を超えた場合は間引いて追いつく
+		bool skip = (queueDepth > maxQueueDepth) || (latency > targetLatency * 2.0);
+		if (skip) skippedFrames++;
+		else processedFrames++;
+
+		return Decision{ skip, level, ladder[level], smoothedLatency, queueDepth };
+	}
+
+	/**
+	 * 調整結果をSQLに記録する
+	 * 後段の処理で、低解像度で推定されたフレームの信頼度を下げるなどの判断に使う
+	 * 姿勢推定を行わなかったフレーム (decision.skip が true のフレーム) は skip = 1 で記録する
+	 * (フレーム番号を割り当てずに読み飛ばしたフレームは、呼び出し側で write() を呼ばないため記録されない)
+	 * @param sql SqlOpenPoseのインスタンスを入れる
+	 * @param frameNumber フレーム番号
+	 * @param decision update() の戻り値
+	 */
+	int write(SqlOpenPose& sql, const size_t frameNumber, const Decision& decision)
+	{
+		// estimation_settingテーブルが存在しない場合はテーブルを生成
+		if (sql.createTableIfNoExist(
+			u8"estimation_setting",
+			u8"frame INTEGER PRIMARY KEY, skip INTEGER, level INTEGER, net_width INTEGER, net_height INTEGER, latency REAL"
+		)) return 1;
+
+		try
+		{
+			auto query = sql.getStatement(u8"INSERT OR REPLACE INTO estimation_setting VALUES (?, ?, ?, ?, ?, ?)");
+			return sql.bindAllAndExec(
+				*query, (long long)frameNumber, (int)decision.skip, (long long)decision.level,
+				decision.netInputSize.x, decision.netInputSize.y, decision.latency
+			);
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+			return 1;
+		}
+	}
+
+	// 間引いたフレーム数を取得
+	uint64_t getSkippedFrames() const { return skippedFrames; }
+
+	// 姿勢推定を行ったフレーム数を取得
+	uint64_t getProcessedFrames() const { return processedFrames; }
+
+private:
+	// 目標とする遅延時間 (ミリ秒)
+	double targetLatency;
+
+	// 切り替える解像度の一覧
+	std::vector<op::Point<int>> ladder;
+
+	// 処理待ちのフレーム数がこの値を超えた場合はフレームを間引く
+	size_t maxQueueDepth;
+
+	// 遅延時間がこのフレーム数連続で目標を外れた場合に解像度を切り替える
+	size_t framesToSwitch;
+
+	// 解像度を切り替える遅延時間の幅
+	double hysteresis;
+
+	// 現在の解像度の段階
+	size_t level = 0;
+
+	// 平滑化された遅延時間
+	double smoothedLatency = 0.0;
+	bool isFirst = true;
+
+	// 直前の update() で解像度を切り替えたかどうか
+	bool isSwitched = false;
+
+	// 遅延時間が目標から外れている連続フレーム数
+	size_t overCount = 0, underCount = 0;
+
+	// 統計情報
+	uint64_t skippedFrames = 0, processedFrames = 0;
+};
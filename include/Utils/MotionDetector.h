@@ -0,0 +1,194 @@
+#pragma once
+
+#include <OpenPoseWrapper/MinimumOpenPose.h>
+#include <Utils/RegionOfInterest.h>
+
+#include <vector>
+
+/**
+ * フレーム間の差分から画面内の動きを検出するクラス
+ * 動きの無いフレームでは姿勢推定を省略することで、人がいない時間帯の処理を軽くする
+ */
+class MotionDetector
+{
+private:
+	using People = MinOpenPose::People;
+
+	// 動きがあると判定する、変化した画素の割合
+	float sensitivity;
+
+	// 画素が変化したと判定する輝度の差
+	double pixelThreshold;
+
+	// 差分を計算するときの画像の横幅 (縮小して計算量を減らす)
+	int analysisWidth;
+
+	// 背景画像を更新する割合 (0.0から1.0, 大きいほど背景が早く更新される)
+	double backgroundRate;
+
+	// 動きが無い場合でも、このフレーム数ごとに姿勢推定を行う
+	uint64_t maxSkipFrames;
+
+	// 動きが無いときに前回の姿勢推定の結果を使うかどうか
+	bool reuseLastPeople;
+
+	// 差分を計算する領域 (空の場合は画面全体)
+	std::vector<cv::Rect> regions;
+
+	// 縮小された背景画像
+	cv::Mat background;
+
+	// 差分を計算する領域のマスク画像
+	cv::Mat mask;
+
+	// 直前のフレームで変化した画素の割合
+	float motionRatio = 0.0f;
+
+	// 前回姿勢推定を行った結果
+	People lastPeople;
+
+	// 前回姿勢推定を行ってから経過したフレーム数
+	uint64_t framesSinceEstimate = 0;
+
+	// 直前の estimate() で姿勢推定を省略したかどうか
+	bool isSkipped = false;
+
+	// 統計情報
+	uint64_t skippedFrames = 0, processedFrames = 0;
+
+public:
+	/**
+	 * @param sensitivity 動きがあると判定する、変化した画素の割合 (小さいほど敏感になる)
+	 * @param pixelThreshold 画素が変化したと判定する輝度の差 (0から255)
+	 * @param analysisWidth 差分を計算するときの画像の横幅
+	 * @param backgroundRate 背景画像を更新する割合
+	 * @param maxSkipFrames 動きが無い場合でも、このフレーム数ごとに姿勢推定を行う
+	 * @param reuseLastPeople trueにすると、動きが無いフレームでは前回の姿勢推定の結果を返す (falseの場合は空の結果を返す)
+	 *                        (前回の結果を使うのは最大 maxSkipFrames フレームまで。空の結果を返す場合は、止まっている人がトラッキングから外れないように
+	 *                        maxSkipFrames を Tracking の numberFramesToLost より小さくする)
+	 */
+	MotionDetector(
+		float sensitivity = 0.002f,
+		double pixelThreshold = 25.0,
+		int analysisWidth = 160,
+		double backgroundRate = 0.05,
+		uint64_t maxSkipFrames = 30,
+		bool reuseLastPeople = true
+	) :
+		sensitivity{ sensitivity },
+		pixelThreshold{ pixelThreshold },
+		analysisWidth{ analysisWidth },
+		backgroundRate{ backgroundRate },
+		maxSkipFrames{ maxSkipFrames },
+		reuseLastPeople{ reuseLastPeople }
+	{
+	}
+
+	virtual ~MotionDetector() {};
+
+	/**
+	 * 差分を計算する領域を指定する
+	 * 人数カウントの基準線の周辺などに限定すると、関係のない場所の動きで姿勢推定が行われなくなる
+	 * @param roi 差分を計算する領域 (領域が空の場合は画面全体)
+	 * @param frameSize 入力画像の解像度
+	 */
+	void setRegionOfInterest(const RegionOfInterest& roi, const cv::Size& frameSize)
+	{
+		regions = roi.empty() ? std::vector<cv::Rect>{} : roi.getRegions(frameSize);
+		mask = cv::Mat();
+	}
+
+	/**
+	 * 画面内に動きがあるかどうかを判定する
+	 * @param frame 入力画像 (フォーマット : CV_8UC3)
+	 * @return 動きがある場合はtrueが返る
+	 */
+	bool update(const cv::Mat& frame)
+	{
+		if (frame.empty()) return false;
+
+		// 縮小してグレースケールに変換し、ノイズを取り除く
+		const double scale = (double)analysisWidth / (double)frame.cols;
+		const cv::Size size{ analysisWidth, std::max(1, (int)((double)frame.rows * scale)) };
+		cv::Mat gray;
+		cv::resize(frame, gray, size, 0.0, 0.0, cv::INTER_AREA);
+		cv::cvtColor(gray, gray, cv::COLOR_BGR2GRAY);
+		cv::GaussianBlur(gray, gray, cv::Size{ 5, 5 }, 0.0);
+
+		// 最初のフレームや解像度が変わった場合は背景画像を作り直す
+		if (background.empty() || (background.cols != gray.cols) || (background.rows != gray.rows))
+		{
+			gray.convertTo(background, CV_32F);
+			mask = cv::Mat();
+			motionRatio = 1.0f;
+			return true;
+		}
+
+		// 差分を計算する領域のマスク画像を生成する
+		if (mask.empty())
+		{
+			mask = cv::Mat(gray.rows, gray.cols, CV_8UC1, cv::Scalar{ regions.empty() ? 255.0 : 0.0 });
+			for (auto&& region : regions)
+			{
+				cv::rectangle(mask, cv::Rect{
+					(int)(region.x * scale), (int)(region.y * scale),
+					std::max(1, (int)(region.width * scale)), std::max(1, (int)(region.height * scale))
+				}, cv::Scalar{ 255.0 }, -1);
+			}
+		}
+
+		// 背景画像との差分が閾値を超えた画素の割合を求める
+		cv::Mat backgroundGray, diff;
+		background.convertTo(backgroundGray, CV_8U);
+		cv::absdiff(gray, backgroundGray, diff);
+		cv::threshold(diff, diff, pixelThreshold, 255.0, cv::THRESH_BINARY);
+		cv::Mat masked;
+		diff.copyTo(masked, mask);
+		const int maskArea = cv::countNonZero(mask);
+		motionRatio = (maskArea == 0) ? 0.0f : ((float)cv::countNonZero(masked) / (float)maskArea);
+
+		// 背景画像を少しずつ現在のフレームに近づける (照明の変化などを吸収する)
+		cv::accumulateWeighted(gray, background, backgroundRate);
+
+		return motionRatio > sensitivity;
+	}
+
+	/**
+	 * 動きがある場合のみ姿勢推定を行う
+	 * @param openpose MinOpenPoseのインスタンス
+	 * @param frame 入力画像
+	 * @param regions 姿勢推定を行う領域 (空の場合は画面全体)
+	 * @return 姿勢推定の結果 (省略した場合は、reuseLastPeopleに応じて前回の結果か空の結果)
+	 */
+	People estimate(MinOpenPose& openpose, const cv::Mat& frame, const std::vector<cv::Rect>& regions = {})
+	{
+		// 動きが無く、最後に姿勢推定をしてから時間が経っていなければ省略する
+		const bool isMoving = update(frame);
+		if ((!isMoving) && (framesSinceEstimate < maxSkipFrames))
+		{
+			framesSinceEstimate++;
+			skippedFrames++;
+			isSkipped = true;
+			return reuseLastPeople ? lastPeople : People{};
+		}
+
+		// 姿勢推定
+		lastPeople = regions.empty() ? openpose.estimate(frame) : openpose.estimate(frame, regions);
+		framesSinceEstimate = 0;
+		processedFrames++;
+		isSkipped = false;
+		return lastPeople;
+	}
+
+	// 直前のフレームで変化した画素の割合を取得
+	float getMotionRatio() const { return motionRatio; }
+
+	// 直前の estimate() で姿勢推定を省略したかどうか (省略したフレームの結果は、姿勢推定の結果として記録しないこと)
+	bool isLastSkipped() const { return isSkipped; }
+
+	// 姿勢推定を省略したフレーム数を取得
+	uint64_t getSkippedFrames() const { return skippedFrames; }
+
+	// 姿勢推定を行ったフレーム数を取得
+	uint64_t getProcessedFrames() const { return processedFrames; }
+};
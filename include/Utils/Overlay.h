@@ -0,0 +1,292 @@
+#pragma once
+
+#include <Utils/Gui.h>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * 1フレーム分の線、円、文字をまとめて受け取り、映像に1回で合成するクラス
+ * 描画はフレームと同じ大きさの重ね合わせ用の画像に行い、描画した範囲のタイルだけを映像にコピーする
+ * 文字は文字列と大きさごとに描画済みの画像をキャッシュし、影と本体の2回の描画をコピーだけで行う
+ * 前のフレームと全く同じ内容 (一時停止中など) の場合は、重ね合わせ用の画像を描き直さずに合成する
+ */
+class Overlay
+{
+public:
+	/**
+	 * @param tileSize 映像にコピーする単位となるタイルの大きさ (画素)
+	 * @param glyphCapacity キャッシュしておく文字列の数の目安 (超えた場合は現在のフレームで使っていない文字列を削除する)
+	 */
+	Overlay(const int tileSize = 64, const size_t glyphCapacity = 256)
+		: tileSize{ tileSize }, glyphCapacity{ glyphCapacity }
+	{
+	}
+
+	virtual ~Overlay() {};
+
+	// 直線を追加する
+	void line(const cv::Point& p1, const cv::Point& p2, const cv::Scalar& color, const int thickness = 1)
+	{
+		Primitive primitive;
+		primitive.type = Primitive::LINE;
+		primitive.p1 = p1;
+		primitive.p2 = p2;
+		primitive.color = color;
+		primitive.size = thickness;
+		primitives.push_back(primitive);
+	}
+
+	// 円を追加する (thickness が負の場合は塗りつぶす)
+	void circle(const cv::Point& center, const int radius, const cv::Scalar& color, const int thickness = 1)
+	{
+		Primitive primitive;
+		primitive.type = Primitive::CIRCLE;
+		primitive.p1 = center;
+		primitive.p2 = cv::Point{ radius, radius };
+		primitive.color = color;
+		primitive.size = thickness;
+		primitives.push_back(primitive);
+	}
+
+	/**
+	 * 影付きの文字を追加する (配置と見た目は gui::text と同じ)
+	 * @return 文字の大きさ
+	 */
+	cv::Size text(
+		const std::string& text,
+		const cv::Point& position,
+		const gui::TextMode textMode = gui::LEFT_TOP,
+		const double fontScale = 0.7f,
+		const cv::Scalar& color = cv::Scalar{ 255, 255, 255, 255 }
+	)
+	{
+		const Glyph& glyph = getGlyph(text, fontScale);
+
+		// 文字の基準点 (gui::text と同じ計算)
+		cv::Point textPosition{ position.x, position.y };
+		if (((int)textMode % 3) == 1) textPosition.x -= glyph.size.width / 2;
+		if (((int)textMode % 3) == 2) textPosition.x -= glyph.size.width;
+		if (((int)textMode / 3) == 0) textPosition.y += (glyph.size.height / 2) + glyph.baseline;
+		if (((int)textMode / 3) == 1) textPosition.y += (glyph.size.height) - glyph.baseline;
+		if (((int)textMode / 3) == 2) textPosition.y -= glyph.baseline;
+
+		// 影、本体の順に描画する
+		Primitive primitive;
+		primitive.type = Primitive::GLYPH;
+		primitive.glyph = &glyph;
+		primitive.p1 = cv::Point{ textPosition.x + glyph.offset.x + glyph.thickness, textPosition.y + glyph.offset.y + glyph.thickness };
+		primitive.color = cv::Scalar{ 0, 0, 0, 255 };
+		primitives.push_back(primitive);
+		primitive.p1 = cv::Point{ textPosition.x + glyph.offset.x, textPosition.y + glyph.offset.y };
+		primitive.color = color;
+		primitives.push_back(primitive);
+
+		return glyph.size;
+	}
+
+	/**
+	 * 追加した線、円、文字を映像に合成し、次のフレームのために空にする
+	 * @param frame 合成先の映像 (CV_8UC3)
+	 */
+	void composite(cv::Mat& frame)
+	{
+		if (frame.empty())
+		{
+			primitives.clear();
+			return;
+		}
+		frameCount++;
+
+		// 映像の大きさが変わった場合は重ね合わせ用の画像を作り直す
+		if (canvas.empty() || (canvas.cols != frame.cols) || (canvas.rows != frame.rows))
+		{
+			canvas = cv::Mat(frame.rows, frame.cols, CV_8UC3, cv::Scalar{ 0, 0, 0 });
+			mask = cv::Mat(frame.rows, frame.cols, CV_8UC1, cv::Scalar{ 0 });
+			tilesX = (frame.cols + tileSize - 1) / tileSize;
+			tilesY = (frame.rows + tileSize - 1) / tileSize;
+			dirty.assign((size_t)(tilesX * tilesY), 0);
+			dirtyTiles.clear();
+			previous.clear();
+		}
+
+		// 前のフレームと内容が異なる場合のみ描き直す
+		if (!isSameAsPrevious())
+		{
+			// 前のフレームで描画したタイルだけを消す
+			for (auto&& index : dirtyTiles)
+			{
+				mask(getTileRect(index)).setTo(cv::Scalar{ 0 });
+				dirty[index] = 0;
+			}
+			dirtyTiles.clear();
+
+			for (auto&& primitive : primitives) draw(primitive);
+			previous.swap(primitives);
+		}
+		primitives.clear();
+
+		// 描画したタイルだけを映像にコピーする
+		for (auto&& index : dirtyTiles)
+		{
+			const cv::Rect rect = getTileRect(index);
+			cv::Mat roi = frame(rect);
+			canvas(rect).copyTo(roi, mask(rect));
+		}
+
+		// キャッシュが大きくなりすぎた場合は、このフレームで使っていない文字列を削除する
+		if (glyphs.size() > glyphCapacity)
+		{
+			for (auto itr = glyphs.begin(); itr != glyphs.end();)
+			{
+				if (itr->second.lastUsed < frameCount) itr = glyphs.erase(itr);
+				else itr++;
+			}
+		}
+	}
+
+	// 最後に合成したタイルの数
+	size_t getDirtyTileCount() const { return dirtyTiles.size(); }
+
+	// 文字列のキャッシュを使えた回数と、使えずに描画した回数
+	uint64_t getGlyphHits() const { return glyphHits; }
+	uint64_t getGlyphMisses() const { return glyphMisses; }
+
+private:
+	// 描画済みの文字列
+	struct Glyph
+	{
+		cv::Mat mask;  // 文字の形 (描画する画素が 255)
+		cv::Point offset;  // 文字の基準点から見た mask の左上の位置
+		cv::Size size;  // cv::getTextSize() で求めた大きさ
+		int baseline = 0;
+		int thickness = 1;
+		uint64_t lastUsed = 0;  // 最後に使ったフレーム
+	};
+
+	// 線、円、文字のいずれか1つ
+	struct Primitive
+	{
+		enum Type : uint8_t { LINE, CIRCLE, GLYPH } type = LINE;
+		cv::Point p1, p2;  // 直線は始点と終点、円は中心と半径、文字は mask の左上
+		cv::Scalar color;
+		int size = 1;  // 線の太さ
+		const Glyph* glyph = nullptr;
+
+		bool operator==(const Primitive& other) const
+		{
+			return (type == other.type) && (p1 == other.p1) && (p2 == other.p2) && (size == other.size) && (glyph == other.glyph)
+				&& (color[0] == other.color[0]) && (color[1] == other.color[1]) && (color[2] == other.color[2]);
+		}
+	};
+
+	int tileSize;
+	size_t glyphCapacity;
+
+	// 重ね合わせ用の画像と、描画した画素を表すマスク
+	cv::Mat canvas, mask;
+
+	// タイルの数と、描画したタイル
+	int tilesX = 0, tilesY = 0;
+	std::vector<uint8_t> dirty;
+	std::vector<size_t> dirtyTiles;
+
+	// このフレームと前のフレームの描画内容
+	std::vector<Primitive> primitives, previous;
+
+	// 文字列と大きさごとの描画済みの文字
+	std::unordered_map<std::string, Glyph> glyphs;
+	uint64_t frameCount = 0;
+	uint64_t glyphHits = 0, glyphMisses = 0;
+
+	bool isSameAsPrevious() const
+	{
+		return (primitives.size() == previous.size()) && std::equal(primitives.begin(), primitives.end(), previous.begin());
+	}
+
+	cv::Rect getTileRect(const size_t index) const
+	{
+		const int x = (int)(index % (size_t)tilesX) * tileSize;
+		const int y = (int)(index / (size_t)tilesX) * tileSize;
+		return cv::Rect{ x, y, std::min(tileSize, canvas.cols - x), std::min(tileSize, canvas.rows - y) };
+	}
+
+	// 範囲に含まれるタイルを描画済みにする
+	void markDirty(int left, int top, int right, int bottom)
+	{
+		left = std::max(0, left / tileSize);
+		top = std::max(0, top / tileSize);
+		right = std::min(tilesX - 1, right / tileSize);
+		bottom = std::min(tilesY - 1, bottom / tileSize);
+		for (int ty = top; ty <= bottom; ty++) for (int tx = left; tx <= right; tx++)
+		{
+			const size_t index = (size_t)(ty * tilesX + tx);
+			if (dirty[index]) continue;
+			dirty[index] = 1;
+			dirtyTiles.push_back(index);
+		}
+	}
+
+	void draw(const Primitive& primitive)
+	{
+		if (primitive.type == Primitive::LINE)
+		{
+			cv::line(canvas, primitive.p1, primitive.p2, primitive.color, primitive.size, 8);
+			cv::line(mask, primitive.p1, primitive.p2, cv::Scalar{ 255 }, primitive.size, 8);
+			const int margin = primitive.size / 2 + 1;
+			markDirty(
+				std::min(primitive.p1.x, primitive.p2.x) - margin, std::min(primitive.p1.y, primitive.p2.y) - margin,
+				std::max(primitive.p1.x, primitive.p2.x) + margin, std::max(primitive.p1.y, primitive.p2.y) + margin
+			);
+		}
+		else if (primitive.type == Primitive::CIRCLE)
+		{
+			cv::circle(canvas, primitive.p1, primitive.p2.x, primitive.color, primitive.size, 8);
+			cv::circle(mask, primitive.p1, primitive.p2.x, cv::Scalar{ 255 }, primitive.size, 8);
+			const int margin = primitive.p2.x + std::max(0, primitive.size) / 2 + 1;
+			markDirty(primitive.p1.x - margin, primitive.p1.y - margin, primitive.p1.x + margin, primitive.p1.y + margin);
+		}
+		else
+		{
+			// 文字の形をマスクにして色を塗る
+			const Glyph& glyph = *primitive.glyph;
+			const cv::Rect rect = cv::Rect{ primitive.p1.x, primitive.p1.y, glyph.mask.cols, glyph.mask.rows } & cv::Rect{ 0, 0, canvas.cols, canvas.rows };
+			if (rect.area() <= 0) return;
+			const cv::Mat shape = glyph.mask(cv::Rect{ rect.x - primitive.p1.x, rect.y - primitive.p1.y, rect.width, rect.height });
+			canvas(rect).setTo(primitive.color, shape);
+			mask(rect).setTo(cv::Scalar{ 255 }, shape);
+			markDirty(rect.x, rect.y, rect.x + rect.width - 1, rect.y + rect.height - 1);
+		}
+	}
+
+	// 描画済みの文字を取得する (無ければ描画してキャッシュする)
+	const Glyph& getGlyph(const std::string& text, const double fontScale)
+	{
+		const std::string key = std::to_string(fontScale) + u8"\n" + text;
+		auto itr = glyphs.find(key);
+		if (itr != glyphs.end())
+		{
+			glyphHits++;
+			itr->second.lastUsed = frameCount + 1;
+			return itr->second;
+		}
+		glyphMisses++;
+
+		Glyph glyph;
+		const cv::HersheyFonts fontFace = cv::FONT_HERSHEY_SIMPLEX;
+		glyph.thickness = (int)(3.0 * fontScale);
+		glyph.size = cv::getTextSize(text, fontFace, fontScale, glyph.thickness, &glyph.baseline);
+
+		// 線の太さの分だけ余白を取って描画する
+		const int pad = glyph.thickness + 1;
+		glyph.mask = cv::Mat(glyph.size.height + glyph.baseline + pad * 2, glyph.size.width + pad * 2, CV_8UC1, cv::Scalar{ 0 });
+		cv::putText(glyph.mask, text, cv::Point{ pad, pad + glyph.size.height }, fontFace, fontScale, cv::Scalar{ 255 }, glyph.thickness, 8);
+		glyph.offset = cv::Point{ -pad, -pad - glyph.size.height };
+		glyph.lastUsed = frameCount + 1;
+
+		return glyphs.emplace(key, glyph).first->second;
+	}
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <OpenPoseWrapper/MinimumOpenPose.h>
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+/**
+ * 1人分の骨格を1つのBLOBに詰めて保存するための変換を行うクラス
+ * 関節1つあたり5バイト (x, y : 1/16画素単位のuint16, 信頼値 : 1/255単位のuint8) で表す
+ * REAL型の列を75列使う場合に比べて、SQLのファイルサイズと読み書きの時間を大きく減らせる
+ */
+class PackedPose
+{
+public:
+	// 関節1つあたりのバイト数
+	static constexpr size_t bytesPerNode = 5;
+
+	// 座標の分解能 (1画素をこの値で分割する)
+	static constexpr float coordinateScale = 16.0f;
+
+	/**
+	 * 骨格をバイト列に変換する
+	 * 座標は 0.0 から 4095.9 の範囲に丸められる (未検出の関節の (0, 0, 0) はそのまま保存される)
+	 * @param person 骨格
+	 * @return 骨格を表すバイト列 (リトルエンディアン)
+	 */
+	static std::vector<uint8_t> pack(const MinOpenPose::Person& person)
+	{
+		std::vector<uint8_t> result(person.size() * bytesPerNode);
+		uint8_t* p = result.data();
+		for (auto&& node : person)
+		{
+			const uint16_t x = quantize(node.x * coordinateScale, 65535.0f);
+			const uint16_t y = quantize(node.y * coordinateScale, 65535.0f);
+			const uint8_t confidence = (uint8_t)quantize(node.confidence * 255.0f, 255.0f);
+			p[0] = (uint8_t)(x & 0xff); p[1] = (uint8_t)(x >> 8);
+			p[2] = (uint8_t)(y & 0xff); p[3] = (uint8_t)(y >> 8);
+			p[4] = confidence;
+			p += bytesPerNode;
+		}
+		return result;
+	}
+
+	/**
+	 * バイト列を骨格に変換する
+	 * @param data pack() で変換されたバイト列
+	 * @param bytes バイト列の長さ
+	 * @return 骨格
+	 */
+	static MinOpenPose::Person unpack(const void* data, size_t bytes)
+	{
+		MinOpenPose::Person result;
+		if (data == nullptr) return result;
+		const uint8_t* p = (const uint8_t*)data;
+		const size_t nodes = bytes / bytesPerNode;
+		result.reserve(nodes);
+		for (size_t i = 0; i < nodes; i++, p += bytesPerNode)
+		{
+			result.push_back(MinOpenPose::Node{
+				(float)(uint16_t)(p[0] | (p[1] << 8)) / coordinateScale,
+				(float)(uint16_t)(p[2] | (p[3] << 8)) / coordinateScale,
+				(float)p[4] / 255.0f
+			});
+		}
+		return result;
+	}
+
+private:
+	// 四捨五入して 0 から maxValue の範囲に収める
+	static uint16_t quantize(float value, float maxValue)
+	{
+		return (uint16_t)std::clamp(value + 0.5f, 0.0f, maxValue);
+	}
+};
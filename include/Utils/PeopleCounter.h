@@ -2,20 +2,33 @@
 
 #include <OpenPoseWrapper/MinimumOpenPose.h>
 #include <Utils/Gui.h>
+#include <Utils/Overlay.h>
 #include <Utils/Tracking.h>
 #include <Utils/Database.h>
 #include <Utils/Vector.h>
+#include <Utils/RegionOfInterest.h>
+#include <sstream>
+#include <algorithm>
 
 class PeopleCounter
 {
 public:
+	// 基準線の通過 (1人が1方向に通過するたびに1回発生する)
+	struct CrossingEvent
+	{
+		size_t people;  // 人のID
+		size_t frameNumber;  // 通過が確定したフレーム番号
+		int64_t timeStamp;  // 通過が確定したフレームの時刻 (ミリ秒)
+		int direction;  // 1 : 上方向, -1 : 下方向
+	};
+
 	/**
-	* ʏɒȀǂ̕ɉlʉ߂JEgNX
-	* @param lineStartX n_XW
-	* @param lineStartY n_YW 
-	* @param lineEndX I_XW
-	* @param lineEndY I_YW
-	* @param lineWeigth ̑
+	* 画面上に直線を引き、その上をどちらの方向に何人が通過したかをカウントするクラス
+	* @param lineStartX 始点のX座標
+	* @param lineStartY 始点のY座標 
+	* @param lineEndX 終点のX座標
+	* @param lineEndY 終点のY座標
+	* @param lineWeigth 直線の太さ
 	*/
 	PeopleCounter(
 		float lineStartX, float lineStartY, float lineEndX, float lineEndY, float lineWeigth
@@ -35,32 +48,89 @@ public:
 
 	virtual ~PeopleCounter() {};
 
-	void update(const Tracking& tracker, const size_t frameNumber)
+	/**
+	 * 人数カウントを行う
+	 * トラッキング中の人ごとに前のフレームの重心を覚えておき、このフレームで移動した線分だけを基準線と判定する
+	 * 全ての基準線を同じ方向に通過した時点で通過が確定し、CrossingEvent が1回だけ発生する
+	 * @param tracker トラッキングを行った Tracking のインスタンス
+	 * @param frameNumber フレーム番号
+	 * @param timeStamp フレームの時刻 (ミリ秒、動画の再生位置やUNIX時間など)
+	 */
+	void update(const Tracking& tracker, const size_t frameNumber, const int64_t timeStamp = 0)
 	{
-		// gbLOOĂȂl̃JE^Zbg
-		dynamicUpCount = 0;
-		dynamicDownCount = 0;
+		events.clear();
 
-		// gbLOOĂȂl̈ړJEg
-		for (auto currentPerson = tracker.currentPeople.begin(); currentPerson != tracker.currentPeople.end(); currentPerson++)
+		// シークして戻った場合は、追跡中の人の状態を捨てる (処理済みのフレームではカウントしない)
+		const bool isSeeked = isStarted && (frameNumber != lastFrameNumber + 1);
+		if (isSeeked) tracks.clear();
+		const bool isCountable = !isStarted || (frameNumber > maxFrameNumber);
+		isStarted = true;
+		lastFrameNumber = frameNumber;
+		maxFrameNumber = std::max(maxFrameNumber, frameNumber);
+
+		// このフレームで検出された人のみ判定する
+		for (auto&& person : tracker.latestPeople)
 		{
-			auto e = judgeUpOrDown(tracker.firstPeople.at(currentPerson->first), currentPerson->second, lines);
-			if (e == Event::UP) dynamicUpCount++;
-			if (e == Event::DOWN) dynamicDownCount++;
+			const Node centroid = Tracking::getJointAverage(person.second);
+			const cv::Point2f point{ centroid.x, centroid.y };
+
+			// 初めて検出された人は位置を覚えるだけ
+			auto itr = tracks.find(person.first);
+			if (itr == tracks.end())
+			{
+				tracks.emplace(person.first, TrackState{ point, std::vector<Event>(lines.size(), Event::NOTHING), Event::NOTHING });
+				continue;
+			}
+
+			// 止まっている人は判定しない
+			TrackState& track = itr->second;
+			if (point == track.point) continue;
+			const cv::Point2f from = track.point;
+			track.point = point;
+
+			// このフレームで移動した線分が、それぞれの基準線を通過したかどうか
+			for (size_t i = 0; i < lines.size(); i++)
+			{
+				const Event e = judgeUpOrDown(from, point, lines[i]);
+				if (e != Event::NOTHING) track.lineEvents[i] = e;
+			}
+
+			// 全ての基準線を同じ方向に通過し、前回確定した方向と異なる場合に通過を確定する
+			const Event e = track.lineEvents.empty() ? Event::NOTHING : track.lineEvents[0];
+			if (e == Event::NOTHING || e == track.counted) continue;
+			if (std::any_of(track.lineEvents.begin(), track.lineEvents.end(), [e](Event lineEvent) { return lineEvent != e; })) continue;
+			track.counted = e;
+			if (!isCountable) continue;
+			if (e == Event::UP) upCount++;
+			if (e == Event::DOWN) downCount++;
+			events.push_back(CrossingEvent{ person.first, frameNumber, timeStamp, (e == Event::UP) ? 1 : -1 });
 		}
 
-		// gbLOOꂽl̈ړJEg
-		for (auto&& index : tracker.untrackedPeopleIndex)
+		// トラッキングが外れた人の状態を捨てる
+		for (auto&& index : tracker.untrackedPeopleIndex) tracks.erase(index);
+	}
+
+	/**
+	 * 直前の update() で確定した通過の方向を track_summary に記録する
+	 * @param sql SqlOpenPoseのインスタンス
+	 * @param tracker update() に渡したTrackingのインスタンス
+	 * @return 成功すると 0 が返る
+	 */
+	int writeCrossings(SqlOpenPose& sql, Tracking& tracker) const
+	{
+		for (auto&& event : events)
 		{
-			auto e = judgeUpOrDown(tracker.firstPeople.at(index), tracker.backPeople.at(index), lines);
-			if (e == Event::UP) staticUpCount++;
-			if (e == Event::DOWN) staticDownCount++;
+			if (tracker.summary.writeCrossing(sql, event.people, event.direction, event.frameNumber)) return 1;
 		}
+		return 0;
 	}
 
+	// 直前の update() で確定した通過を取得
+	const std::vector<CrossingEvent>& getEvents() const { return events; }
+
 	void drawInfo(cv::Mat& frame, const Tracking& tracker)
 	{
-		// ̕`
+		// 基準線の描画
 		for (auto line : lines)
 		{
 			cv::line(
@@ -71,14 +141,18 @@ public:
 			);
 		}
 
-		// gbLO̎n_ƏI_Ԓ`
+		// トラッキングの始点と終点を結ぶ直線を描画
 		for (auto currentPerson = tracker.currentPeople.begin(); currentPerson != tracker.currentPeople.end(); currentPerson++)
 		{
 			size_t index = currentPerson->first;
-			auto&& firstPosition = Tracking::getJointAverage(tracker.firstPeople.at(index));
-			auto&& currentPosition = Tracking::getJointAverage(currentPerson->second);
+			auto first = tracker.firstPeople.find(index);
+			if (first == tracker.firstPeople.end()) continue;
+			auto&& firstPosition = Tracking::getJointAverage(first->second);
+			// update() で求めた重心があればそれを使う
+			auto track = tracks.find(index);
+			Node currentPosition = (track != tracks.end()) ? Node{ track->second.point.x, track->second.point.y, 1.0f } : Tracking::getJointAverage(currentPerson->second);
 
-			// ̕`
+			// 直線の描画
 			cv::line(
 				frame,
 				{ (int)firstPosition.x, (int)firstPosition.y },
@@ -91,45 +165,188 @@ public:
 			);
 		}
 
-		// JEg\
+		// カウントを表示
 		gui::text(frame, std::string("up : ") + std::to_string(getUpCount()), { 20, 200 });
 		gui::text(frame, std::string("down : ") + std::to_string(getDownCount()), { 20, 230 });
 	}
 
-	// Ɉړl̃JEg擾
-	inline uint64_t getUpCount() const { return staticUpCount + dynamicUpCount; }
+	// 基準線とカウントの描画 (まとめて合成する)
+	void drawInfo(Overlay& overlay, const Tracking& tracker)
+	{
+		// 基準線の描画
+		for (auto line : lines)
+		{
+			overlay.line(
+				{ (int)line.lineStartX, (int)line.lineStartY },
+				{ (int)line.lineEndX, (int)line.lineEndY },
+				cv::Scalar{ 255.0, 255.0, 255.0 }, 2
+			);
+		}
 
-	// Ɉړl̃JEg擾
-	inline uint64_t getDownCount() const { return staticDownCount + dynamicDownCount; }
+		// トラッキングの始点と終点を結ぶ直線を描画
+		for (auto currentPerson = tracker.currentPeople.begin(); currentPerson != tracker.currentPeople.end(); currentPerson++)
+		{
+			size_t index = currentPerson->first;
+			auto first = tracker.firstPeople.find(index);
+			if (first == tracker.firstPeople.end()) continue;
+			auto&& firstPosition = Tracking::getJointAverage(first->second);
+			auto track = tracks.find(index);
+			Node currentPosition = (track != tracks.end()) ? Node{ track->second.point.x, track->second.point.y, 1.0f } : Tracking::getJointAverage(currentPerson->second);
+
+			overlay.line(
+				{ (int)firstPosition.x, (int)firstPosition.y },
+				{ (int)currentPosition.x, (int)currentPosition.y },
+				cv::Scalar{
+					(float)((int)((std::sin(((float)index) * 463763.0) + 1.0) * 100000.0) % 120 + 80),
+					(float)((int)((std::sin(((float)index) * 1279.0) + 1.0) * 100000.0) % 120 + 80),
+					(float)((int)((std::sin(((float)index) * 92763.0) + 1.0) * 100000.0) % 120 + 80)
+				}, 2
+			);
+		}
+
+		// カウントを表示
+		overlay.text(std::string("up : ") + std::to_string(getUpCount()), { 20, 200 });
+		overlay.text(std::string("down : ") + std::to_string(getDownCount()), { 20, 230 });
+	}
+
+	/**
+	 * 基準線の周辺を姿勢推定を行う領域として追加する
+	 * @param roi 領域を追加する RegionOfInterest のインスタンス
+	 * @param margin 基準線から領域の端までの距離 (映っている人の身長程度を指定する)
+	 */
+	void addRegionOfInterest(RegionOfInterest& roi, float margin) const
+	{
+		for (auto&& line : lines)
+		{
+			roi.addLine(line.lineStartX, line.lineStartY, line.lineEndX, line.lineEndY, margin);
+		}
+	}
+
+	// 基準線を上方向に移動した人のカウントを取得
+	inline uint64_t getUpCount() const { return upCount; }
+
+	// 基準線を下方向に移動した人のカウントを取得
+	inline uint64_t getDownCount() const { return downCount; }
+
+	/**
+	 * カウンタを設定する (CrossingLog::count() で求めた記録済みの人数から再開する場合など)
+	 * @param up 基準線を上方向に移動した人数
+	 * @param down 基準線を下方向に移動した人数
+	 */
+	void setCounts(const uint64_t up, const uint64_t down)
+	{
+		upCount = up;
+		downCount = down;
+	}
+
+	/**
+	 * 処理を再開するために、メモリ上にしか無いカウンタと追跡中の人の状態を文字列にする (SqlOpenPose::writeCheckpoint() に渡す)
+	 * 「上向きの人数 下向きの人数 update() を呼んだかどうか 最後のフレーム番号 最大のフレーム番号 追跡中の人数」に続けて、
+	 * 人ごとに「ID 重心のX 重心のY 確定した方向 基準線ごとの通過の方向...」を空白区切りで並べる
+	 */
+	std::string saveState() const
+	{
+		std::ostringstream stream;
+		stream.precision(9);
+		stream << upCount << " " << downCount << " " << (int)isStarted << " " << lastFrameNumber << " " << maxFrameNumber << " " << tracks.size();
+		for (auto&& track : tracks)
+		{
+			stream << " " << track.first << " " << track.second.point.x << " " << track.second.point.y << " " << (int)track.second.counted;
+			for (auto&& e : track.second.lineEvents) stream << " " << (int)e;
+		}
+		return stream.str();
+	}
+
+	/**
+	 * saveState() で文字列にしたカウンタと追跡中の人の状態を復元する
+	 * 復元後は、saveState() を呼んだフレームの次のフレームから update() を呼ぶと追跡を続けられる
+	 * (カウンタだけを記録した古い形式の場合は、追跡中の人の状態を空にして再開する)
+	 * @param state saveState() の戻り値
+	 * @return 成功すると 0 が返る
+	 */
+	int loadState(const std::string& state)
+	{
+		std::istringstream stream(state);
+		uint64_t up = 0, down = 0;
+		if (!(stream >> up >> down)) return 1;
+
+		std::map<size_t, TrackState> loadedTracks;
+		int started = 0;
+		size_t lastFrame = 0, maxFrame = 0, trackCount = 0;
+		const bool hasTracks = (bool)(stream >> started >> lastFrame >> maxFrame >> trackCount);
+		if (hasTracks)
+		{
+			auto toEvent = [](const int value, Event& e) {
+				if ((value < (int)Event::UP) || (value > (int)Event::NOTHING)) return false;
+				e = (Event)value;
+				return true;
+			};
+			for (size_t i = 0; i < trackCount; i++)
+			{
+				size_t id = 0;
+				int counted = 0;
+				TrackState track{ cv::Point2f{}, std::vector<Event>(lines.size(), Event::NOTHING), Event::NOTHING };
+				if (!(stream >> id >> track.point.x >> track.point.y >> counted) || !toEvent(counted, track.counted)) return 1;
+				for (auto&& e : track.lineEvents)
+				{
+					int value = 0;
+					if (!(stream >> value) || !toEvent(value, e)) return 1;
+				}
+				loadedTracks.emplace(id, track);
+			}
+		}
+
+		setCounts(up, down);
+		tracks.swap(loadedTracks);
+		events.clear();
+		isStarted = hasTracks && (started != 0);
+		lastFrameNumber = hasTracks ? lastFrame : 0;
+		maxFrameNumber = hasTracks ? maxFrame : 0;
+		return 0;
+	}
 
 private:
 	using People = MinOpenPose::People;
 	using Person = MinOpenPose::Person;
 	using Node = MinOpenPose::Node;
 
-	// gbLOOꂽl̃JE^
-	uint64_t staticUpCount = 0;  // ̏㑤Ɉړl̃JEg
-	uint64_t staticDownCount = 0;  // ̏Ɉړl̃JEg
+	// 基準線の上を上側に移動した人のカウント
+	uint64_t upCount = 0;
 
-	// gbLOOĂȂl̃JE^
-	uint64_t dynamicUpCount = 0;  // ̏㑤Ɉړl̃JEg
-	uint64_t dynamicDownCount = 0;  // ̏Ɉړl̃JEg
+	// 基準線の上を下側に移動した人のカウント
+	uint64_t downCount = 0;
+
+	enum class Event { UP, DOWN, NOTHING };
+
+	// トラッキング中の人ごとの状態
+	struct TrackState
+	{
+		cv::Point2f point;  // 前回検出された重心
+		std::vector<Event> lineEvents;  // 基準線ごとの最後に通過した方向
+		Event counted;  // 最後に確定した通過の方向
+	};
+	std::map<size_t, TrackState> tracks;
 
-	// ̎n_ƏI_
+	// 直前の update() で確定した通過
+	std::vector<CrossingEvent> events;
+
+	// 直前の update() のフレーム番号と、これまでに処理した最大のフレーム番号
+	bool isStarted = false;
+	size_t lastFrameNumber = 0, maxFrameNumber = 0;
+
+	// 直線の始点と終点
 	struct Line {
 		float lineStartX, lineStartY, lineEndX, lineEndY;
 	};
 
-	// lJEgs
+	// 人数カウントを行う基準線
 	std::vector<Line> lines;
 
-	enum class Event { UP, DOWN, NOTHING };
-
-	// p1Startp1End܂łԒp2Startp2End܂łԒĂ邩ǂ擾
-	bool isCross(cv::Point2f& p1Start, cv::Point2f& p1End, cv::Point2f& p2Start, cv::Point2f& p2End) const
+	// p1Startからp1Endまでを結ぶ直線とp2Startからp2Endまでを結ぶ直線が交差しているかどうかを取得
+	bool isCross(const cv::Point2f& p1Start, const cv::Point2f& p1End, const cv::Point2f& p2Start, const cv::Point2f& p2End) const
 	{
-		// p1Startp1Endւ̒p2Startp2Endւ̒Ă邩ǂ߂
-		// Ql : https://imagingsolution.blog.fc2.com/blog-entry-137.html
+		// p1Startからp1Endへの直線とp2Startからp2Endへの直線が交差しているかどうかを求める
+		// 参考 : https://imagingsolution.blog.fc2.com/blog-entry-137.html
 		float s1 = ((p2End.x - p2Start.x) * (p1Start.y - p2Start.y) - (p2End.y - p2Start.y) * (p1Start.x - p2Start.x)) / 2.0;
 		float s2 = ((p2End.x - p2Start.x) * (p2Start.y - p1End.y) - (p2End.y - p2Start.y) * (p2Start.x - p1End.x)) / 2.0;
 		if (s1 + s2 == 0.0) return false;
@@ -137,35 +354,20 @@ private:
 		return (0.0 <= p && p <= 1.0);
 	}
 
-	// peopleStartpeopleEnd܂łԒlineƌĂ邩ǂ擾
-	// ɁAĂꍇ͂ǂ̕ɌĂ̂擾
-	Event judgeUpOrDown(const Person& peopleStart, const Person& peopleEnd, Line& line) const
+	// startPosからendPosまでを結ぶ直線がlineと交差しているかどうか取得
+	// さらに、交差している場合はどちらの方向に交差しているのかを取得
+	Event judgeUpOrDown(const cv::Point2f& startPos, const cv::Point2f& endPos, const Line& line) const
 	{
-		auto startPos = Tracking::getJointAverage(peopleStart);  // s҂̃gbLOJn_
-		auto endPos = Tracking::getJointAverage(peopleEnd);  // s҂̃gbLOI_
-		auto vecLine = cv::Point2f((float)line.lineEndX - (float)line.lineStartX, (float)line.lineEndY - (float)line.lineStartY);  // lJEgs̃xNg
-		auto vecStart = cv::Point2f((float)startPos.x - (float)line.lineStartX, (float)startPos.y - (float)line.lineStartY);  // lJEgs̎n_startPosւ̃xNg
-		auto vecEnd = cv::Point2f((float)endPos.x - (float)line.lineStartX, (float)endPos.y - (float)line.lineStartY);  // lJEgs̎n_vecEndւ̃xNg
-		if (!isCross(cv::Point2f(0.0, 0.0), vecLine, vecStart, vecEnd)) return Event::NOTHING;  // startendԒvecLinȅʉ߂ĂȂꍇ
-		// uvecLine90x]vƁuvecStartvƂ̓ςƂɁAstartPosvecLinȅ㑤ɂ邩ǂ𔻒
+		auto vecLine = cv::Point2f((float)line.lineEndX - (float)line.lineStartX, (float)line.lineEndY - (float)line.lineStartY);  // 人数カウントを行う基準線のベクトル
+		auto vecStart = cv::Point2f((float)startPos.x - (float)line.lineStartX, (float)startPos.y - (float)line.lineStartY);  // 人数カウントを行う基準線の始点からstartPosへのベクトル
+		auto vecEnd = cv::Point2f((float)endPos.x - (float)line.lineStartX, (float)endPos.y - (float)line.lineStartY);  // 人数カウントを行う基準線の始点からvecEndへのベクトル
+		if (!isCross(cv::Point2f(0.0, 0.0), vecLine, vecStart, vecEnd)) return Event::NOTHING;  // startからendを結ぶ直線がvecLineの上を通過していない場合
+		// 「vecLineを90度回転させた線」と「vecStart」との内積をもとに、startPosがvecLineの上側にあるかどうかを判定
 		bool startIsUp = vecStart.x * vecLine.y > vecStart.y * vecLine.x;
-		// uvecLine90x]vƁuvecEndvƂ̓ςƂɁAendPosvecLinȅ㑤ɂ邩ǂ𔻒
+		// 「vecLineを90度回転させた線」と「vecEnd」との内積をもとに、endPosがvecLineの上側にあるかどうかを判定
 		bool endIsUp = vecEnd.x * vecLine.y > vecEnd.y * vecLine.x;
-		if ((!startIsUp) && endIsUp) return Event::UP;  // s҂̃gbLOlJEgs𒴂ďɈړĂꍇ
-		if (startIsUp && (!endIsUp)) return Event::DOWN;  // s҂̃gbLOlJEgs𒴂ĉɈړĂꍇ
-		return Event::NOTHING;  // ȊO
-	}
-
-	// peopleStartpeopleEnd܂łԒSĂlinesƓɌĂ邩ǂ擾
-	// ɁAĂꍇ͂ǂ̕ɌĂ̂擾
-	Event judgeUpOrDown(const Person& peopleStart, const Person& peopleEnd, std::vector<Line>& lines) const
-	{
-		Event e = Event::NOTHING;
-		for (size_t i = 0; i < lines.size(); i++)
-		{
-			if (i == 0) e = judgeUpOrDown(peopleStart, peopleEnd, lines[i]);
-			else if (e != judgeUpOrDown(peopleStart, peopleEnd, lines[i])) return Event::NOTHING;
-		}
-		return e;
+		if ((!startIsUp) && endIsUp) return Event::UP;  // 歩行者のトラッキングが人数カウントを行う基準線を超えて上に移動していた場合
+		if (startIsUp && (!endIsUp)) return Event::DOWN;  // 歩行者のトラッキングが人数カウントを行う基準線を超えて下に移動していた場合
+		return Event::NOTHING;  // それ以外
 	}
 };
\ No newline at end of file
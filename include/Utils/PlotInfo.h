@@ -2,13 +2,18 @@
 
 #include <OpenPoseWrapper/MinimumOpenPose.h>
 #include <Utils/Gui.h>
+#include <Utils/Overlay.h>
 #include <Utils/Video.h>
 #include <Utils/Tracking.h>
 
 #include <chrono>
 #include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <limits>
 
-// t[[gƃt[ԍ̕`
+// フレームレートとフレーム番号の描画
 struct PlotFrameInfo
 {
 	using clock = std::chrono::high_resolution_clock;
@@ -16,84 +21,119 @@ struct PlotFrameInfo
 	PlotFrameInfo() { start = clock::now(); }
 	void plot(cv::Mat& frame, const Video& video)
 	{
-		// t[󂩂mF
+		// フレームが空かを確認する
 		if (frame.empty()) return;
 
-		// fps̑
+		// fpsの測定
 		end = clock::now();
 		auto time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
 		float fps = 1000.0f / (float)time;
 		start = end;
 
-		// ̍Đ̎擾
+		// 動画の再生情報の取得
 		Video::FrameInfo frameInfo_ = video.getInfo();
 
-		// fpsƓ̍ĐԁAt[ԍ̕\
+		// fpsと動画の再生時間、フレーム番号の表示
 		cv::Size ret{ 0, 0 }; int height = 20;
 		ret = gui::text(frame, "fps : " + std::to_string(fps), cv::Point{ 20, height }); height += ret.height + 10;
 		ret = gui::text(frame, "time : " + std::to_string(frameInfo_.frameTimeStamp), cv::Point{ 20, height }); height += ret.height + 10;
 		ret = gui::text(frame, "frame : " + std::to_string(frameInfo_.frameNumber) + " / " + std::to_string(frameInfo_.frameSum), cv::Point{ 20, height }); height += ret.height + 10;
 	}
+	void plot(Overlay& overlay, const Video& video)
+	{
+		// fpsの測定
+		end = clock::now();
+		auto time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+		float fps = 1000.0f / (float)time;
+		start = end;
+
+		// 動画の再生情報の取得
+		Video::FrameInfo frameInfo_ = video.getInfo();
+
+		// fpsと動画の再生時間、フレーム番号の表示
+		cv::Size ret{ 0, 0 }; int height = 20;
+		ret = overlay.text("fps : " + std::to_string(fps), cv::Point{ 20, height }); height += ret.height + 10;
+		ret = overlay.text("time : " + std::to_string(frameInfo_.frameTimeStamp), cv::Point{ 20, height }); height += ret.height + 10;
+		ret = overlay.text("frame : " + std::to_string(frameInfo_.frameNumber) + " / " + std::to_string(frameInfo_.frameSum), cv::Point{ 20, height }); height += ret.height + 10;
+	}
 	void plotFPS(cv::Mat& frame)
 	{
-		// t[󂩂mF
+		// フレームが空かを確認する
 		if (frame.empty()) return;
 
-		// fps̑
+		// fpsの測定
 		end = clock::now();
 		auto time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
 		float fps = 1000.0f / (float)time;
 		start = end;
 
-		// fpsƓ̍ĐԁAt[ԍ̕\
+		// fpsと動画の再生時間、フレーム番号の表示
 		cv::Size ret{ 0, 0 }; int height = 20;
 		ret = gui::text(frame, "fps : " + std::to_string(fps), cv::Point{ 20, height }); height += ret.height + 10;
 	}
 };
 
-// ID̕`
-void plotId(cv::Mat& frame, const MinOpenPose::People& people)
+// IDを表示する位置 (骨格の重心) を求める
+std::vector<std::pair<size_t, cv::Point>> getIdPositions(const MinOpenPose::People& people)
 {
-	// t[󂩂mF
-	if (frame.empty()) return;
-
-	// lIDȉdSʒuɕ\
+	std::vector<std::pair<size_t, cv::Point>> positions;
 	for (auto person = people.begin(); person != people.end(); person++)
 	{
 		cv::Point p; size_t enableNodeSum = 0;
 
-		// ֐߂̐[v (BODY25fgꍇ25)
+		// 関節の数だけループする (BODY25モデルを使う場合は25回)
 		for (auto node : person->second)
 		{
-			// Ml 0 ̊֐߂͍W (0, 0) ɂȂĂ邽ߏO
+			// 信頼値が 0 の関節は座標が (0, 0) になっているため除外する
 			if (node.confidence == 0.0f) continue;
 
-			// Z
+			// 加算
 			p.x += (int)node.x; p.y += (int)node.y; enableNodeSum++;
 		}
 
-		// 0
+		// 0割りを避ける
 		if (enableNodeSum == 0) continue;
 
-		// ȉdSvZ
+		// 骨格の重心を計算
 		p.x /= enableNodeSum; p.y /= enableNodeSum;
-
-		// ID̕\
-		gui::text(frame, std::to_string(person->first), p, gui::CENTER_CENTER, 0.7);
+		positions.emplace_back(person->first, p);
 	}
+	return positions;
 }
 
-// OՂ̕`
+// IDの描画
+void plotId(cv::Mat& frame, const MinOpenPose::People& people)
+{
+	// フレームが空かを確認する
+	if (frame.empty()) return;
+
+	// 人のIDを骨格の重心位置に表示
+	for (auto&& position : getIdPositions(people)) gui::text(frame, std::to_string(position.first), position.second, gui::CENTER_CENTER, 0.7);
+}
+
+// IDの描画 (まとめて合成する)
+void plotId(Overlay& overlay, const MinOpenPose::People& people)
+{
+	for (auto&& position : getIdPositions(people)) overlay.text(std::to_string(position.first), position.second, gui::CENTER_CENTER, 0.7);
+}
+
+// 軌跡の描画
 struct PlotTrajectory
 {
 	cv::Mat image;
 	std::map<size_t, MinOpenPose::Node> back;
+
+	// 軌跡を描画したことのあるタイル (描画していない部分は加算しない)
+	const int tileSize = 64;
+	std::vector<uint8_t> touched;
+	std::vector<cv::Rect> touchedTiles;
+
 	void plot(cv::Mat& frame, const std::map<size_t, MinOpenPose::Node>& peoplePoint)
 	{
-		// t[󂩂mF
+		// フレームが空かを確認する
 		if (frame.empty()) return;
 
-		// trajectoryƃTCYmF
+		// trajectoryとサイズが等しいかを確認する
 		if (
 			image.empty() ||
 			(image.cols != frame.cols) ||
@@ -101,16 +141,18 @@ struct PlotTrajectory
 		)
 		{
 			image = cv::Mat(frame.rows, frame.cols, CV_8UC3, { 0, 0, 0 });
+			touched.assign((size_t)(((frame.cols + tileSize - 1) / tileSize) * ((frame.rows + tileSize - 1) / tileSize)), 0);
+			touchedTiles.clear();
 		}
 
 		for (auto person_itr = peoplePoint.begin(); person_itr != peoplePoint.end(); person_itr++)
 		{
 			size_t id = person_itr->first;
 
-			// 1t[OɓID̐lȂꍇ̓XLbv
+			// 1フレーム前に同じIDの人がいない場合はスキップ
 			if (back.count(id) == 0) continue;
 
-			// ݂̍i1t[O̍ȉdS
+			// 現在の骨格情報と1フレーム前の骨格の重心
 			MinOpenPose::Node start = person_itr->second;
 			MinOpenPose::Node end = back[person_itr->first];
 
@@ -124,32 +166,43 @@ struct PlotTrajectory
 				},
 				2.0
 			);
+			touch(std::min(start.x, end.x) - 2.0f, std::min(start.y, end.y) - 2.0f, std::max(start.x, end.x) + 2.0f, std::max(start.y, end.y) + 2.0f);
 		}
 
-		frame += image;
+		for (auto&& rect : touchedTiles)
+		{
+			cv::Mat roi = frame(rect);
+			roi += image(rect);
+		}
 		
 		back = peoplePoint;
 	}
-};
 
-// i̕`
-void plotBone(cv::Mat& cvFrame, const MinOpenPose::People& people, const MinOpenPose& mop)
-{
-	if (cvFrame.empty()) return;
-	if (people.size() == 0) return;
-
-	op::Array<float> keypoints({ (int)people.size(), (int)((people.begin())->second.size()), 3 });
-	int person_index = 0;
-	for (auto person = people.begin(); person != people.end(); person++, person_index++)
+private:
+	// 範囲に含まれるタイルを描画済みにする
+	void touch(const float left, const float top, const float right, const float bottom)
 	{
-		for (int node_index = 0; node_index < person->second.size(); node_index++)
+		const int tilesX = (image.cols + tileSize - 1) / tileSize;
+		const int tilesY = (image.rows + tileSize - 1) / tileSize;
+		const int x0 = std::max(0, (int)std::floor(left) / tileSize), x1 = std::min(tilesX - 1, (int)std::ceil(right) / tileSize);
+		const int y0 = std::max(0, (int)std::floor(top) / tileSize), y1 = std::min(tilesY - 1, (int)std::ceil(bottom) / tileSize);
+		for (int ty = y0; ty <= y1; ty++) for (int tx = x0; tx <= x1; tx++)
 		{
-			const MinOpenPose::Node node = person->second[node_index];
-			keypoints[{person_index, node_index, 0}] = node.x;
-			keypoints[{person_index, node_index, 1}] = node.y;
-			keypoints[{person_index, node_index, 2}] = node.confidence;
+			if (touched[(size_t)(ty * tilesX + tx)]) continue;
+			touched[(size_t)(ty * tilesX + tx)] = 1;
+			touchedTiles.push_back(cv::Rect{ tx * tileSize, ty * tileSize, std::min(tileSize, image.cols - tx * tileSize), std::min(tileSize, image.rows - ty * tileSize) });
 		}
 	}
+};
+
+// 骨格の線分を列挙する (人ごとの関節を op::Array にコピーせずに、描画する線分の端点、色、太さを求める)
+void forEachBone(
+	const cv::Size& size, const MinOpenPose::People& people, const MinOpenPose& mop,
+	const std::function<void(const cv::Point&, const cv::Point&, const cv::Scalar&, int)>& function
+)
+{
+	if (people.size() == 0) return;
+
 	auto conf = mop.getConfig();
 
 	const std::vector<unsigned int>& pairs = op::getPoseBodyPartPairsRender(conf.poseModel);
@@ -160,58 +213,77 @@ void plotBone(cv::Mat& cvFrame, const MinOpenPose::People& people, const MinOpen
 	const float threshold = conf.renderThreshold;
 
 	// Get frame channels
-	const auto width = cvFrame.size[1];
-	const auto height = cvFrame.size[0];
+	const auto width = size.width;
+	const auto height = size.height;
 	const auto area = width * height;
 
 	// Parameters
-	const auto lineType = 8;
-	const auto shift = 0;
 	const auto numberColors = colors.size();
 	const auto numberScales = poseScales.size();
 	const float thresholdRectangle = 0.1f;
-	const auto numberKeypoints = keypoints.getSize(1);
 
 	// Keypoints
-	for (auto person = 0; person < keypoints.getSize(0); person++)
+	for (auto person = people.begin(); person != people.end(); person++)
 	{
-		const auto personRectangle = op::getKeypointsRectangle(keypoints, person, thresholdRectangle);
-		if (personRectangle.area() > 0)
+		const MinOpenPose::Person& nodes = person->second;
+
+		// 信頼値が thresholdRectangle を超える関節を囲む矩形 (op::getKeypointsRectangle と同じ)
+		float minX = std::numeric_limits<float>::max(), minY = std::numeric_limits<float>::max();
+		float maxX = std::numeric_limits<float>::lowest(), maxY = std::numeric_limits<float>::lowest();
+		for (auto&& node : nodes)
 		{
-			const auto ratioAreas = op::fastMin(
-				1.0f, op::fastMax(
-					personRectangle.width / (float)width, personRectangle.height / (float)height));
-			// Size-dependent variables
-			const auto thicknessRatio = op::fastMax(
-				op::positiveIntRound(std::sqrt(area) * thicknessCircleRatio * ratioAreas), 2);
-			// Negative thickness in cv::circle means that a filled circle is to be drawn.
-			const auto thicknessCircle = op::fastMax(1, (ratioAreas > 0.05f ? thicknessRatio : -1));
-			const auto thicknessLine = op::fastMax(
-				1, op::positiveIntRound(thicknessRatio * thicknessLineRatioWRTCircle));
-			const auto radius = thicknessRatio / 2;
-
-			// Draw lines
-			for (auto pair = 0u; pair < pairs.size(); pair += 2)
+			if (node.confidence <= thresholdRectangle) continue;
+			minX = std::min(minX, node.x); maxX = std::max(maxX, node.x);
+			minY = std::min(minY, node.y); maxY = std::max(maxY, node.y);
+		}
+		if ((maxX <= minX) || (maxY <= minY)) continue;
+
+		const auto ratioAreas = op::fastMin(
+			1.0f, op::fastMax(
+				(maxX - minX) / (float)width, (maxY - minY) / (float)height));
+		// Size-dependent variables
+		const auto thicknessRatio = op::fastMax(
+			op::positiveIntRound(std::sqrt(area) * thicknessCircleRatio * ratioAreas), 2);
+		const auto thicknessLine = op::fastMax(
+			1, op::positiveIntRound(thicknessRatio * thicknessLineRatioWRTCircle));
+
+		// Draw lines
+		for (auto pair = 0u; pair < pairs.size(); pair += 2)
+		{
+			if ((pairs[pair] >= nodes.size()) || (pairs[pair + 1] >= nodes.size())) continue;
+			const MinOpenPose::Node& node1 = nodes[pairs[pair]];
+			const MinOpenPose::Node& node2 = nodes[pairs[pair + 1]];
+			if (node1.confidence > threshold && node2.confidence > threshold)
 			{
-				const auto index1 = (person * numberKeypoints + pairs[pair]) * keypoints.getSize(2);
-				const auto index2 = (person * numberKeypoints + pairs[pair + 1]) * keypoints.getSize(2);
-				if (keypoints[index1 + 2] > threshold && keypoints[index2 + 2] > threshold)
-				{
-					const auto thicknessLineScaled = op::positiveIntRound(
-						thicknessLine * poseScales[pairs[pair + 1] % numberScales]);
-					const auto colorIndex = pairs[pair + 1] * 3; // Before: colorIndex = pair/2*3;
-					const cv::Scalar color{
-						colors[(colorIndex + 2) % numberColors],
-						colors[(colorIndex + 1) % numberColors],
-						colors[colorIndex % numberColors]
-					};
-					const cv::Point keypoint1{
-						op::positiveIntRound(keypoints[index1]), op::positiveIntRound(keypoints[index1 + 1]) };
-					const cv::Point keypoint2{
-						op::positiveIntRound(keypoints[index2]), op::positiveIntRound(keypoints[index2 + 1]) };
-					cv::line(cvFrame, keypoint1, keypoint2, color, thicknessLineScaled, lineType, shift);
-				}
+				const auto thicknessLineScaled = op::positiveIntRound(
+					thicknessLine * poseScales[pairs[pair + 1] % numberScales]);
+				const auto colorIndex = pairs[pair + 1] * 3; // Before: colorIndex = pair/2*3;
+				const cv::Scalar color{
+					colors[(colorIndex + 2) % numberColors],
+					colors[(colorIndex + 1) % numberColors],
+					colors[colorIndex % numberColors]
+				};
+				const cv::Point keypoint1{ op::positiveIntRound(node1.x), op::positiveIntRound(node1.y) };
+				const cv::Point keypoint2{ op::positiveIntRound(node2.x), op::positiveIntRound(node2.y) };
+				function(keypoint1, keypoint2, color, thicknessLineScaled);
 			}
 		}
 	}
-}
\ No newline at end of file
+}
+
+// 骨格の描画
+void plotBone(cv::Mat& cvFrame, const MinOpenPose::People& people, const MinOpenPose& mop)
+{
+	if (cvFrame.empty()) return;
+	forEachBone(cv::Size{ cvFrame.cols, cvFrame.rows }, people, mop, [&](const cv::Point& p1, const cv::Point& p2, const cv::Scalar& color, int thickness) {
+		cv::line(cvFrame, p1, p2, color, thickness, 8, 0);
+	});
+}
+
+// 骨格の描画 (まとめて合成する)
+void plotBone(Overlay& overlay, const cv::Size& size, const MinOpenPose::People& people, const MinOpenPose& mop)
+{
+	forEachBone(size, people, mop, [&](const cv::Point& p1, const cv::Point& p2, const cv::Scalar& color, int thickness) {
+		overlay.line(p1, p2, color, thickness);
+	});
+}
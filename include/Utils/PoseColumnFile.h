@@ -0,0 +1,242 @@
+#pragma once
+
+#include <OpenPoseWrapper/MinimumOpenPose.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <functional>
+#include <cstdint>
+
+/**
+ * 姿勢推定の結果を列ごとに並べて保存するファイル形式 (.pcol) の共通定義
+ *
+ * ファイルの構成 (数値は全てリトルエンディアン)
+ *   ヘッダー (64バイト)
+ *   チャンク : フレーム番号の列 (uint64), 人のIDの列 (uint32), 値の列 (float, 1行あたり骨格は75個, 座標は2個)
+ *              各列の先頭は64バイト境界に揃えられる
+ *   フッター : テーブル名の一覧と、各チャンクのテーブル・行数・フレーム番号の範囲・位置
+ *   末尾     : フッターの位置とサイズ (16バイト) と識別子 (8バイト)
+ *
+ * 1つのテーブルのチャンクはフレーム番号の昇順に並ぶため、区間の読み込みはファイルの先頭から順に読むだけで済む
+ */
+struct PoseColumnFormat
+{
+	// テーブルの種類
+	enum class Kind : uint8_t
+	{
+		//! 骨格 (people, people_with_tracking など)
+		People = 0,
+		//! 座標 (trajectory など)
+		Points = 1
+	};
+
+	// チャンクの情報
+	struct ChunkInfo
+	{
+		uint32_t table;
+		uint64_t rows, firstFrame, lastFrame, offset;
+	};
+
+	// ファイルの識別子
+	static constexpr char magic[8] = { 'P', 'C', 'O', 'L', 'v', '0', '0', '1' };
+
+	// 各列の先頭を揃える境界
+	static constexpr uint64_t alignment = 64;
+
+	// 1行あたりの値の数
+	static size_t valuesPerRow(Kind kind) { return (kind == Kind::People) ? 75 : 2; }
+
+	// 境界に揃えた位置を求める
+	static uint64_t align(uint64_t offset) { return (offset + alignment - 1) / alignment * alignment; }
+
+	// チャンク内の各列の位置を求める
+	static uint64_t idsOffset(const ChunkInfo& chunk) { return align(chunk.offset + chunk.rows * sizeof(uint64_t)); }
+	static uint64_t valuesOffset(const ChunkInfo& chunk) { return align(idsOffset(chunk) + chunk.rows * sizeof(uint32_t)); }
+};
+
+/**
+ * .pcol ファイルに姿勢推定の結果を追記するクラス
+ * 行はテーブルごとにメモリに溜められ、chunkRows 行ごとに1つのチャンクとして書き出される
+ * 既存のファイルを開いた場合は、そのファイルの末尾に追記する
+ */
+class PoseColumnWriter
+{
+public:
+	/**
+	 * @param chunkRows 1つのチャンクに含める行数
+	 */
+	PoseColumnWriter(size_t chunkRows = 4096);
+
+	virtual ~PoseColumnWriter();
+
+	/**
+	 * ファイルを開く、もしくは生成する
+	 * @param path ファイルのパス
+	 * @return 成功すると 0 が返る
+	 */
+	int open(const std::string& path);
+
+	/**
+	 * 骨格を追記する
+	 * テーブルごとに、既に追記したフレーム以前のフレームは無視される (シークして同じフレームを処理し直した場合など)
+	 * @param tableName テーブル名
+	 * @param frameNumber フレーム番号
+	 * @param people 骨格
+	 * @return 成功すると 0 が返る
+	 */
+	int appendPeople(const std::string& tableName, size_t frameNumber, const MinOpenPose::People& people);
+
+	/**
+	 * 座標を追記する
+	 * テーブルごとに、既に追記したフレーム以前のフレームは無視される
+	 * @param tableName テーブル名
+	 * @param frameNumber フレーム番号
+	 * @param points 人のIDと座標
+	 * @return 成功すると 0 が返る
+	 */
+	int appendPoints(const std::string& tableName, size_t frameNumber, const std::map<size_t, MinOpenPose::Node>& points);
+
+	/**
+	 * メモリに溜められた行とフッターを書き出す
+	 * この関数を呼んだ時点までの内容は PoseColumnReader で読み込める
+	 * @return 成功すると 0 が返る
+	 */
+	int flush();
+
+	// フッターを書き出してファイルを閉じる
+	int close();
+
+	// ファイルを開いているかどうか
+	bool isOpen() const { return file.is_open(); }
+
+private:
+	using Kind = PoseColumnFormat::Kind;
+
+	// テーブルごとに溜められている行
+	struct Table
+	{
+		std::string name;
+		Kind kind;
+		int64_t lastFrame = -1;
+		std::vector<uint64_t> frames;
+		std::vector<uint32_t> ids;
+		std::vector<float> values;
+	};
+
+	// 1つのチャンクに含める行数
+	size_t chunkRows;
+
+	// ファイルのパス
+	std::string path;
+
+	// 書き込み中のファイル
+	std::fstream file;
+
+	// 最後のチャンクの末尾 (フッターの書き込み位置)
+	uint64_t dataEnd = 0;
+
+	// 最後に書き出したフッターの末尾 (ファイルの末尾)
+	uint64_t fileEnd = 0;
+
+	// テーブルの一覧 (チャンクのテーブル番号はこの配列のインデックス)
+	std::vector<Table> tables;
+
+	// 書き出したチャンクの一覧
+	std::vector<PoseColumnFormat::ChunkInfo> chunks;
+
+	// テーブルを取得する (存在しない場合は追加する, 種類が異なる場合はnullptrを返す)
+	Table* getTable(const std::string& tableName, Kind kind);
+
+	// テーブルに溜められた行をチャンクとして書き出す
+	int writeChunk(uint32_t tableIndex);
+
+	// フッターと末尾を書き出す
+	int writeFooter();
+};
+
+/**
+ * .pcol ファイルをメモリマップして読み込むクラス
+ * 各列はファイルの内容を直接指すポインタとして取得でき、読み込みの際にコピーは発生しない
+ */
+class PoseColumnReader
+{
+public:
+	// 1つのチャンクの内容 (ポインタはファイルを閉じるまで有効)
+	struct Chunk
+	{
+		size_t rows;
+		uint64_t firstFrame, lastFrame;
+		const uint64_t* frames;
+		const uint32_t* ids;
+		const float* values;
+		size_t valuesPerRow;
+	};
+
+	PoseColumnReader() {}
+
+	virtual ~PoseColumnReader();
+
+	/**
+	 * ファイルを開く
+	 * @param path ファイルのパス
+	 * @return 成功すると 0 が返る
+	 */
+	int open(const std::string& path);
+
+	// ファイルを閉じる
+	void close();
+
+	// テーブル名の一覧を取得する
+	std::vector<std::string> getTableNames() const;
+
+	// テーブルの全てのチャンクをフレーム番号の昇順に取得する
+	std::vector<Chunk> getChunks(const std::string& tableName) const;
+
+	/**
+	 * 指定された区間の骨格を読み込む
+	 * @param tableName テーブル名
+	 * @param firstFrame 区間の先頭のフレーム番号
+	 * @param lastFrame 区間の末尾の次のフレーム番号
+	 * @param callback 骨格が記録されているフレームごとに、フレーム番号の昇順で呼ばれる (falseを返すと読み込みを中断する)
+	 * @return 成功すると 0 が返る
+	 */
+	int readPeopleRange(
+		const std::string& tableName, size_t firstFrame, size_t lastFrame,
+		const std::function<bool(size_t, const MinOpenPose::People&)>& callback
+	) const;
+
+	/**
+	 * 指定された区間の座標を読み込む
+	 * @param tableName テーブル名
+	 * @param firstFrame 区間の先頭のフレーム番号
+	 * @param lastFrame 区間の末尾の次のフレーム番号
+	 * @param callback 区間内の全てのフレームについて、フレーム番号の昇順で呼ばれる
+	 *                 (記録が無いフレームでは空のmapが渡される。falseを返すと読み込みを中断する)
+	 * @return 成功すると 0 が返る
+	 */
+	int readPointsRange(
+		const std::string& tableName, size_t firstFrame, size_t lastFrame,
+		const std::function<bool(size_t, const std::map<size_t, MinOpenPose::Node>&)>& callback
+	) const;
+
+private:
+	// メモリマップされたファイルの内容
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+
+	// OSのファイルハンドル
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+	int fileDescriptor = -1;
+
+	// テーブル名と種類の一覧
+	std::vector<std::pair<std::string, PoseColumnFormat::Kind>> tables;
+
+	// チャンクの一覧
+	std::vector<PoseColumnFormat::ChunkInfo> chunks;
+
+	// フッターを読み込む
+	int readFooter();
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <OpenPoseWrapper/MinimumOpenPose.h>
+#include <Utils/DisplayThread.h>
 
 #include <functional>
 #include <vector>
@@ -13,13 +14,37 @@ private:
 	std::vector<std::function<void(int)>> keyboardEventListener;
 	std::vector<std::function<void(int, int, int)>> mouseEventListener;
 
+	// 表示を行うスレッド (nullptr の場合は preview() を呼んだスレッドで表示する)
+	DisplayThread* display;
+
+	// 表示を行うスレッドから届いたイベントのリスナーを発火し、最後に入力されたキー番号を返す
+	int dispatch(const std::vector<DisplayThread::Event>& events)
+	{
+		int key = -1;
+		for (auto&& event : events)
+		{
+			if (event.type == DisplayThread::Event::MOUSE)
+			{
+				for (auto&& func : mouseEventListener) func(event.mouseEvent, event.x, event.y);
+				continue;
+			}
+			key = event.key;
+			for (auto&& func : keyboardEventListener) func(key);
+		}
+		return key;
+	}
+
 public:
-	// EBhẼ}EXW
+	// ウィンドウ上のマウス座標
 	cv::Point mouse;
 
-	Preview(const std::string windowTitle = "result") : windowTitle(windowTitle), mouse(0, 0)
+	/**
+	 * @param windowTitle ウィンドウの名前
+	 * @param display 表示を行うスレッド (指定した場合、preview() は表示を待たずに戻り、イベントのリスナーは preview() を呼んだスレッドで発火する)
+	 */
+	Preview(const std::string windowTitle = "result", DisplayThread* display = nullptr) : windowTitle(windowTitle), display(display), mouse(0, 0)
 	{
-		// }EXWXV
+		// マウス座標を更新
 		addMouseEventListener([&](int event, int x, int y) {
 			if (event == cv::EVENT_MOUSEMOVE) { mouse.x = x; mouse.y = y; }
 		});
@@ -28,33 +53,45 @@ public:
 	virtual ~Preview() {};
 
 	/**
-	 * w肳ꂽ摜EBhEƂĕ\
-	 * @param input \摜
-	 * @param delay ~bPʂ̑ҋ@ (0w肷ƃL[͂܂Œ~)
-	 * @withoutWaitKey trueɂdelayɂҋ@Ԃ0bɂȂ邪AaddKeyboardEventListener֐̌ʂȂȂ
-	 * @return Ōɓ͂ꂽL[ԍA
+	 * 指定された画像をウィンドウとして表示する
+	 * @param input 表示する画像
+	 * @param delay ミリ秒単位の待機時間 (0を指定するとキー入力があるまで停止する)
+	 * @withoutWaitKey trueにするとdelayによる待機時間が0秒になるが、addKeyboardEventListener関数の効果がなくなる
+	 * @return 最後に入力されたキー番号が帰る
 	 * @note
-	 * OpenCV̎dlÃEBhEꂽԂŃL[͂ĂAǂ̃EBhEɑ΂Ă̑ł邩łȂB
-	 * ܂APreviewNX𐶐A炷ׂwithoutWaitKeytrueɐݒ肷ƁAL[Cxgǂ̃EBhEɑ΂đM邩͗\złȂB
-	 * ̂߁A1̃EBhÊwithoutWaitKeytrueɐݒ肵AȊÕEBhEfalseɐݒ肷邱ƂňꎞIɂ̖łB
+	 * OpenCVの仕様上、複数のウィンドウが生成された状態でキー入力をしても、どのウィンドウに対しての操作であるかを特定できない。
+	 * また、複数個のPreviewクラスを生成し、それらすべてwithoutWaitKeyをtrueに設定すると、キーイベントがどのウィンドウに対して送信されるかは予想できない。
+	 * そのため、1つのウィンドウのみwithoutWaitKeyをtrueに設定し、それ以外のウィンドウをfalseに設定することで一時的にこの問題を回避できる。
+	 * 表示を行うスレッドを指定した場合も、cv::waitKey と同じく delay の間 (イベントが届いた場合はその時点まで) 待機してから戻る。
+	 * 一時停止中のように同じ画像を表示し続ける場合は、delay を大きくするとループが空回りしない。
+	 * キー入力は withoutWaitKey が false のウィンドウで受け取る。
 	 */
 	int preview(const cv::Mat& input, uint32_t delay = 1, bool withoutWaitKey = false)
 	{
-		// EBhE̕\
+		// 表示を行うスレッドに画像を渡し、届いているイベントを処理する
+		if (display)
+		{
+			display->show(windowTitle, input);
+			const auto timeout = withoutWaitKey ? std::chrono::milliseconds(0) : ((delay == 0) ? std::chrono::milliseconds(-1) : std::chrono::milliseconds(delay));
+			const int key = dispatch(display->takeEvents(windowTitle, !withoutWaitKey, timeout));
+			return withoutWaitKey ? 0 : key;
+		}
+
+		// ウィンドウの表示
 		cv::imshow(windowTitle, input);
 
-		// }EXCxg̃R[obN֐̎w
+		// マウスイベントのコールバック関数の指定
 		cv::setMouseCallback(windowTitle, [](int event, int x, int y, int flags, void* userdata) {
-			// }EXCxg̃Xi[̔
+			// マウスイベントのリスナーの発火
 			for (auto&& func : *((std::vector<std::function<void(int, int, int)>>*)userdata)) func(event, x, y);
 		}, (void*)(&mouseEventListener));
 
 		if (withoutWaitKey) return 0;
 
-		// L[͂̎擾
+		// キー入力の取得
 		int key = cv::waitKey(delay);
 
-		// L[Cxg̃Xi[̔
+		// キーイベントのリスナーの発火
 		if (key != -1)
 		{
 			for (auto&& func : keyboardEventListener) func(key);
@@ -63,19 +100,30 @@ public:
 		return key;
 	}
 	
-	// }EXCxg̃R[obN֐o^
+	/**
+	 * 画像を表示せずに、表示を行うスレッドから届いているイベントを処理する (表示を行うスレッドを指定していない場合は何もしない)
+	 * @param withKeys true の場合はキー入力も処理する
+	 * @return 最後に入力されたキー番号が帰る (無い場合は -1)
+	 */
+	int poll(bool withKeys = false)
+	{
+		if (!display) return -1;
+		return dispatch(display->takeEvents(windowTitle, withKeys));
+	}
+
+	// マウスイベントのコールバック関数登録
 	void addMouseEventListener(const std::function<void(int, int, int)>& func)
 	{
 		mouseEventListener.push_back(func);
 	}
 
-	// L[Cxg̃R[obN֐o^
+	// キーイベントのコールバック関数登録
 	void addKeyboardEventListener(const std::function<void(int)>& func)
 	{
 		keyboardEventListener.push_back(func);
 	}
 
-	// NbÑR[obN֐o^
+	// 左クリック時のコールバック関数登録
 	void onClick(const std::function<void(int, int)>& func)
 	{
 		addMouseEventListener([func](int event, int x, int y) {
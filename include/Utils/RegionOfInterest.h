@@ -0,0 +1,150 @@
+#pragma once
+
+#include <OpenPoseWrapper/MinimumOpenPose.h>
+
+#include <vector>
+
+/**
+ * 姿勢推定を行う領域 (ROI) を管理するクラス
+ * 人数カウントの基準線の周辺やトラッキング中の人の周辺のみを姿勢推定することで、OpenPose に入力する画素数を減らす
+ */
+class RegionOfInterest
+{
+private:
+	using People = MinOpenPose::People;
+
+	// 追加された領域 (画像外にはみ出していてもよい)
+	std::vector<cv::Rect> rects;
+
+public:
+	RegionOfInterest() {}
+
+	virtual ~RegionOfInterest() {};
+
+	// 追加された全ての領域を削除する
+	void clear() { rects.clear(); }
+
+	// 領域が1つも追加されていないかどうか
+	bool empty() const { return rects.empty(); }
+
+	// 矩形の領域を追加する
+	void addRect(const cv::Rect& rect)
+	{
+		if (rect.area() > 0) rects.push_back(rect);
+	}
+
+	/**
+	 * 直線の周辺を領域として追加する
+	 * @param x1, y1 直線の始点
+	 * @param x2, y2 直線の終点
+	 * @param margin 直線から領域の端までの距離 (映っている人の身長程度を指定する)
+	 */
+	void addLine(float x1, float y1, float x2, float y2, float margin)
+	{
+		int left   = (int)std::floor(std::min(x1, x2) - margin);
+		int top    = (int)std::floor(std::min(y1, y2) - margin);
+		int right  = (int)std::ceil(std::max(x1, x2) + margin);
+		int bottom = (int)std::ceil(std::max(y1, y2) + margin);
+		addRect(cv::Rect{ left, top, right - left, bottom - top });
+	}
+
+	/**
+	 * 多角形の周辺を領域として追加する
+	 * @param polygon 多角形の頂点
+	 * @param margin 多角形から領域の端までの距離
+	 */
+	void addPolygon(const std::vector<cv::Point2f>& polygon, float margin)
+	{
+		if (polygon.empty()) return;
+		float left = polygon[0].x, top = polygon[0].y, right = polygon[0].x, bottom = polygon[0].y;
+		for (auto&& p : polygon)
+		{
+			left = std::min(left, p.x); top = std::min(top, p.y);
+			right = std::max(right, p.x); bottom = std::max(bottom, p.y);
+		}
+		addLine(left, top, right, bottom, margin);
+	}
+
+	/**
+	 * 骨格の周辺を領域として追加する
+	 * トラッキング中の人 (Tracking::currentPeople など) を指定すると、次のフレームでその人の周辺が姿勢推定される
+	 * @param people 骨格
+	 * @param margin 骨格の外接矩形から領域の端までの距離
+	 */
+	void addPeople(const People& people, float margin)
+	{
+		for (auto&& person : people)
+		{
+			bool isFirst = true;
+			float left = 0.0f, top = 0.0f, right = 0.0f, bottom = 0.0f;
+			for (auto&& node : person.second)
+			{
+				// 信頼値が 0 の関節は座標が (0, 0) になっているため除外する
+				if (node.confidence == 0.0f) continue;
+				if (isFirst)
+				{
+					left = right = node.x; top = bottom = node.y;
+					isFirst = false;
+					continue;
+				}
+				left = std::min(left, node.x); top = std::min(top, node.y);
+				right = std::max(right, node.x); bottom = std::max(bottom, node.y);
+			}
+			if (!isFirst) addLine(left, top, right, bottom, margin);
+		}
+	}
+
+	/**
+	 * OpenPose に入力する領域を取得する
+	 * 画像外の部分は切り捨てられ、重なり合う領域は1つの矩形にまとめられる
+	 * (重なった領域を別々に推定すると同じ人が2回検出されるため)
+	 * @param frameSize 入力画像の解像度
+	 * @return 姿勢推定を行う領域 (領域が1つも追加されていない場合は画像全体)
+	 */
+	std::vector<cv::Rect> getRegions(const cv::Size& frameSize) const
+	{
+		const cv::Rect frameRect{ 0, 0, frameSize.width, frameSize.height };
+		if (rects.empty()) return { frameRect };
+
+		// 画像外の部分を切り捨てる
+		std::vector<cv::Rect> result;
+		for (auto rect : rects)
+		{
+			rect &= frameRect;
+			if (rect.area() > 0) result.push_back(rect);
+		}
+
+		// 重なり合う領域が無くなるまで結合を繰り返す
+		bool merged = true;
+		while (merged)
+		{
+			merged = false;
+			for (size_t i = 0; i < result.size() && !merged; i++)
+			{
+				for (size_t j = i + 1; j < result.size(); j++)
+				{
+					if ((result[i] & result[j]).area() == 0) continue;
+					result[i] |= result[j];
+					result.erase(result.begin() + j);
+					merged = true;
+					break;
+				}
+			}
+		}
+
+		return result;
+	}
+
+	/**
+	 * 画像全体に対する、姿勢推定を行う領域の面積の割合を取得する
+	 * @param frameSize 入力画像の解像度
+	 * @return 0.0 から 1.0 までの値
+	 */
+	float getAreaRatio(const cv::Size& frameSize) const
+	{
+		if (frameSize.area() == 0) return 0.0f;
+		size_t area = 0;
+		for (auto&& rect : getRegions(frameSize)) area += (size_t)rect.area();
+		return (float)area / (float)frameSize.area();
+	}
+};
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <chrono>
+#include <ctime>
+#include <cstdint>
+#include <iostream>
+
+/**
+ * SQLのファイルを一定時間ごと、もしくは一定サイズごとに切り替える (セグメントに分ける) 設定
+ * SqlOpenPose::openSegments() で指定する
+ */
+struct SegmentPolicy
+{
+	//! 新しいセグメントに切り替える周期 (0の場合は時間では切り替えない)
+	std::chrono::seconds period{ 3600 };
+
+	//! セグメントのファイルサイズがこの値を超えたら切り替える (0の場合はサイズでは切り替えない)
+	uint64_t maxBytes = 0;
+
+	//! 残しておくセグメントの数 (0の場合は数では削除しない)
+	size_t maxSegments = 0;
+
+	//! 記録を終えてからこの時間が経過したセグメントを削除する (0の場合は時間では削除しない)
+	std::chrono::hours maxAge{ 0 };
+
+	//! トラッキングを続けるために、新しいセグメントへ引き継ぐフレーム数
+	size_t carryFrames = 300;
+
+	//! 新しいセグメントへ末尾の行を引き継ぐ骨格のテーブル (接尾辞を除いた名前)
+	std::vector<std::string> carryTables = { u8"people_with_tracking" };
+};
+
+/**
+ * セグメントの一覧を記録するファイル (<basePath>.manifest) を読み書きするクラス
+ * 1行に1つのセグメントを、タブ区切りで「パス, 最初のフレーム番号, 最後のフレーム番号, 開始時刻, 終了時刻」の順に記録する
+ * 時刻はUNIX時間 (秒)、記録中のセグメントの終了時刻は0になる
+ */
+class SegmentManifest
+{
+public:
+	// 1つのセグメントの情報
+	struct Segment
+	{
+		std::string path;
+		int64_t firstFrame = -1, lastFrame = -1;
+		int64_t startTime = 0, endTime = 0;
+
+		// 記録中かどうか
+		bool isActive() const { return endTime == 0; }
+	};
+
+	// セグメントの一覧 (古い順)
+	std::vector<Segment> segments;
+
+	SegmentManifest() {}
+
+	virtual ~SegmentManifest() {};
+
+	// 一覧を記録するファイルのパスを求める
+	static std::string manifestPath(const std::string& basePath) { return basePath + u8".manifest"; }
+
+	// 現在のUNIX時間 (秒) を取得する
+	static int64_t now()
+	{
+		return (int64_t)std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	}
+
+	/**
+	 * 新しいセグメントのファイルのパスを求める (<basePath>_<開始時刻>.sqlite3)
+	 * @param basePath セグメントのファイルのパスの先頭
+	 * @param time 開始時刻 (UNIX時間)
+	 */
+	static std::string segmentPath(const std::string& basePath, int64_t time)
+	{
+		std::time_t t = (std::time_t)time;
+		std::tm tm;
+#ifdef _WIN32
+		localtime_s(&tm, &t);
+#else
+		localtime_r(&t, &tm);
+#endif
+		char buffer[32];
+		std::strftime(buffer, sizeof(buffer), "%Y%m%d_%H%M%S", &tm);
+		return basePath + u8"_" + buffer + u8".sqlite3";
+	}
+
+	/**
+	 * 一覧を読み込む (ファイルが無い場合は空の一覧になる)
+	 * @param basePath セグメントのファイルのパスの先頭
+	 * @return 成功すると 0 が返る
+	 */
+	int load(const std::string& basePath)
+	{
+		segments.clear();
+		std::ifstream file(manifestPath(basePath));
+		if (!file.is_open()) return 0;
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (line.empty()) continue;
+			std::istringstream stream(line);
+			Segment segment;
+			std::string value;
+			try
+			{
+				std::getline(stream, segment.path, '\t');
+				std::getline(stream, value, '\t'); segment.firstFrame = std::stoll(value);
+				std::getline(stream, value, '\t'); segment.lastFrame = std::stoll(value);
+				std::getline(stream, value, '\t'); segment.startTime = std::stoll(value);
+				std::getline(stream, value, '\t'); segment.endTime = std::stoll(value);
+			}
+			catch (const std::exception& e)
+			{
+				std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+				return 1;
+			}
+			segments.push_back(segment);
+		}
+
+		return 0;
+	}
+
+	/**
+	 * 一覧を書き込む
+	 * 一時ファイルに書き込んでから置き換えるため、書き込み中に読み込まれても壊れた一覧は見えない
+	 * @param basePath セグメントのファイルのパスの先頭
+	 * @return 成功すると 0 が返る
+	 */
+	int save(const std::string& basePath) const
+	{
+		const std::string path = manifestPath(basePath);
+		const std::string temporaryPath = path + u8".tmp";
+		try
+		{
+			{
+				std::ofstream file(temporaryPath, std::ios::trunc);
+				for (auto&& segment : segments)
+				{
+					file << segment.path << '\t' << segment.firstFrame << '\t' << segment.lastFrame << '\t'
+						<< segment.startTime << '\t' << segment.endTime << '\n';
+				}
+				if (!file.good()) throw std::runtime_error(u8"failed to write " + temporaryPath);
+			}
+			std::filesystem::rename(temporaryPath, path);
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+			return 1;
+		}
+
+		return 0;
+	}
+
+	/**
+	 * 保存期間を過ぎたセグメントをファイルごと削除する (記録中のセグメントは削除しない)
+	 * @param policy 保存期間の設定
+	 * @return 削除したセグメントの数
+	 */
+	size_t applyRetention(const SegmentPolicy& policy)
+	{
+		const int64_t threshold = now() - (int64_t)std::chrono::duration_cast<std::chrono::seconds>(policy.maxAge).count();
+		size_t removed = 0;
+		for (size_t i = 0; i < segments.size();)
+		{
+			const Segment& segment = segments[i];
+			const bool isTooMany = (policy.maxSegments > 0) && (segments.size() > policy.maxSegments);
+			const bool isTooOld = (policy.maxAge.count() > 0) && (segment.endTime < threshold);
+			if (segment.isActive() || !(isTooMany || isTooOld))
+			{
+				i++;
+				continue;
+			}
+
+			// WALのファイルなども含めて削除する
+			std::error_code ec;
+			for (auto&& suffix : { u8"", u8"-wal", u8"-shm", u8"-journal" }) std::filesystem::remove(segment.path + suffix, ec);
+			segments.erase(segments.begin() + i);
+			removed++;
+		}
+		return removed;
+	}
+};
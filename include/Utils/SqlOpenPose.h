@@ -2,22 +2,84 @@
 
 #include <OpenPoseWrapper/MinimumOpenPose.h>
 #include <Utils/Database.h>
+#include <Utils/FrameCoverage.h>
+#include <Utils/PackedPose.h>
+#include <Utils/PoseColumnFile.h>
+#include <Utils/SegmentManifest.h>
 #include <optional>
+#include <functional>
+#include <future>
+#include <chrono>
+#include <tuple>
 
 class SqlOpenPose : public Database
 {
 private:
-    // sqlite3`̃t@CۑpX
+    using People = MinOpenPose::People;
+    using Person = MinOpenPose::Person;
+    using Node = MinOpenPose::Node;
+
+    // sqlite3形式のファイルを保存するパス
     std::string sqlPath;
 
-    // t@CɃR~bg
+    // ファイルにコミットする周期
     long long saveFreq = 0;
 
-    // t@CɃR~bg܂ł̃JEg
+    // ファイルにコミットするまでのカウント
     size_t saveCountDown = 1;
 
-    using People = MinOpenPose::People;
-    using Node = MinOpenPose::Node;
+    // 最後にコミットの周期を数えたフレーム番号
+    std::optional<size_t> lastCountedFrame;
+
+    // 現在選択されている設定のID (0は設定を記録する前から存在するテーブルを使う)
+    long long configId = 0;
+
+    // 現在選択されている設定の結果を格納するテーブル名の接尾辞
+    std::string tableSuffix;
+
+    // キャッシュの統計情報
+    uint64_t cacheHits = 0, cacheMisses = 0;
+
+    // テーブルごとの記録済みフレームの区間 (テーブル名 -> 区間)
+    // 最初に参照されたときにSQLから読み込み、以降は書き込みに合わせて更新する
+    mutable std::map<std::string, FrameCoverage> coverages;
+
+    // 新しく生成する骨格のテーブルを、骨格をBLOBに詰めた形式にするかどうか
+    bool packedSchema = false;
+
+    // テーブルごとの形式 (テーブル名 -> 骨格をBLOBに詰めた形式かどうか)
+    mutable std::map<std::string, bool> packedTables;
+
+    // 先読みする区間のフレーム数 (0の場合は先読みしない)
+    size_t prefetchFrames = 0;
+
+    // 先読みに使う読み込み専用の接続 (先読みのスレッドからのみ使う)
+    std::shared_ptr<SQLite::Database> prefetchDatabase;
+
+    // 先読みが完了した骨格と、その区間 [prefetchFirst, prefetchLast)
+    std::map<size_t, People> prefetchBuffer;
+    size_t prefetchFirst = 0, prefetchLast = 0;
+
+    // 先読み中の骨格と、その区間 [futureFirst, futureLast)
+    std::future<std::map<size_t, People>> prefetchFuture;
+    size_t futureFirst = 0, futureLast = 0;
+
+    // 書き込んだ結果を列形式のファイル (.pcol) にも追記する場合の書き込み先
+    std::shared_ptr<PoseColumnWriter> columnWriter;
+
+    // selectConfig() で選択された設定 (新しいセグメントに切り替えたときに同じ設定を選択し直す)
+    std::optional<std::tuple<std::string, op::PoseModel, op::Point<int>>> selectedConfig;
+
+    // セグメントに分けて記録する場合の、ファイルのパスの先頭と設定 (空の場合はセグメントに分けない)
+    std::string segmentBasePath;
+    SegmentPolicy segmentPolicy;
+    SegmentManifest segmentManifest;
+
+    // 次のフレームを書き込む前に新しいセグメントに切り替えるかどうか
+    bool isRotationDue = false;
+
+    // 1つのupsertで書き込む最大の行数 (1行あたり4つの値をバインドするため、SQLiteの上限の999個を超えないようにする)
+    static constexpr size_t maxRowsPerUpsert = 128;
 
 public:
     SqlOpenPose() {}
@@ -25,48 +87,90 @@ public:
     virtual ~SqlOpenPose() {};
 
     /**
-     * OpenPose̎p̌ʂSQLite3Ƃďo͂NX
-     * @param sqlPath o̓t@C̃pX
-     * @param saveFreq w肵t[ƂɃt@CXV(Ƃ300w肷write֐300Ă΂邲ƂɃt@CXV)
+     * OpenPoseの姿勢推定の結果をSQLite3として出力するクラス
+     * @param sqlPath 出力ファイルのパス
+     * @param saveFreq 指定したフレーム数ごとにファイルを更新する(たとえば300を指定するとwrite関数が300回呼ばれるごとにファイルを更新する)
+     * @param packedSchema trueにすると、新しく生成する骨格のテーブルを骨格をBLOBに詰めた形式にする (既存のテーブルは形式を自動で判別する)
+     * @param profile SQLの用途ごとの設定 (ReadOnlyAnalytics の場合はテーブルを生成しない)
      */
-    int open(const std::string& sqlPath, const long long saveFreq = 0)
+    int open(const std::string& sqlPath, const long long saveFreq = 0, const bool packedSchema = false, const StorageProfile profile = StorageProfile::Default)
     {
         this->sqlPath = sqlPath;
         this->saveFreq = saveFreq;
+        this->packedSchema = packedSchema;
         saveCountDown = saveFreq;
+        lastCountedFrame.reset();
 
-        // t@CJA͐
+        // ファイルを開く、もしくは生成する
         int ret = create(
             sqlPath,
-            SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE
+            SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE,
+            profile
         );
 
         if (ret)
         {
-            std::cout << "t@C̓ǂݍ݁A͐Ɏs܂B" << std::endl;
+            std::cout << "ファイルの読み込み、もしくは生成に失敗しました。" << std::endl;
             return 1;
         }
 
+        // 設定を選択するまでは、設定を記録する前から存在するテーブルを使う
+        configId = 0;
+        tableSuffix.clear();
+        selectedConfig.reset();
+        cacheHits = 0;
+        cacheMisses = 0;
+        coverages.clear();
+        packedTables.clear();
+        clearPrefetch();
+
+        // 読み込み専用の場合は、既に存在するテーブルをそのまま使う
+        if (profile == StorageProfile::ReadOnlyAnalytics) return 0;
+
+        // metaテーブルが存在しない場合はテーブルを生成 (セグメントをまたいで引き継ぐ値などを記録する)
+        if (createTableIfNoExist(u8"meta", u8"key TEXT PRIMARY KEY, value TEXT")) return 1;
+
+        // estimator_configテーブルが存在しない場合はテーブルを生成
+        if (createTableIfNoExist(
+            u8"estimator_config",
+            u8"id INTEGER PRIMARY KEY, fingerprint TEXT, pose_model INTEGER, net_width INTEGER, net_height INTEGER"
+        )) return 1;
+
+        return createPoseTables();
+    }
+
+    /**
+     * 姿勢推定の結果を読み書きするテーブルを、動画と姿勢推定の設定の組み合わせで切り替える
+     * 設定ごとに別のテーブルに結果が保存されるため、1つのファイルに複数の設定の結果を並べて保存できる
+     * 設定のIDは1から割り当て、接尾辞の無いテーブル (この関数を呼ばない場合や、この関数が追加される前に保存された結果) はどの設定にも割り当てない
+     * (別の動画や設定で保存された結果を、指紋を確認せずに使わないようにするため)
+     * @param videoFingerprint 動画の指紋 (Video::getFingerprint() の戻り値)
+     * @param poseModel 姿勢推定に用いるモデル
+     * @param netInputSize 姿勢推定を行うネットワークの解像度
+     * @return 成功すると 0 が返る
+     */
+    int selectConfig(const std::string& videoFingerprint, op::PoseModel poseModel, op::Point<int> netInputSize)
+    {
         try
         {
-            // peoplee[u݂Ȃꍇ̓e[u𐶐
-            std::string row_title = u8"frame INTEGER, people INTEGER";
-            for (int i = 0; i < 25; i++)
+            // 同じ設定が既に記録されていればそのIDを使う
+            SQLite::Statement selectQuery(*database, u8"SELECT id FROM estimator_config WHERE fingerprint=? AND pose_model=? AND net_width=? AND net_height=?");
+            if (bindAll(selectQuery, videoFingerprint, (int)poseModel, netInputSize.x, netInputSize.y)) return 1;
+            if (selectQuery.executeStep())
             {
-                row_title += u8", joint" + std::to_string(i) + u8"x REAL";
-                row_title += u8", joint" + std::to_string(i) + u8"y REAL";
-                row_title += u8", joint" + std::to_string(i) + u8"confidence REAL";
+                configId = selectQuery.getColumn(0).getInt64();
             }
-            if (createTableIfNoExist(u8"people", row_title)) return 1;
 
-            // timestampe[u݂Ȃꍇ̓e[u𐶐
-            if (createTableIfNoExist(u8"timestamp", u8"frame INTEGER PRIMARY KEY, timestamp INTEGER")) return 1;
+            // 記録されていなければ新しいIDを割り当てる (0は接尾辞の無いテーブルを表すため、1から割り当てる)
+            else
+            {
+                SQLite::Statement idQuery(*database, u8"SELECT COALESCE(MAX(id), 0) + 1 FROM estimator_config");
+                (void)idQuery.executeStep();
+                configId = idQuery.getColumn(0).getInt64();
 
-            // x邽߁Aee[uIndex𐶐
-            if (createIndexIfNoExist(u8"people", u8"frame", false)) return 1;
-            if (createIndexIfNoExist(u8"people", u8"people", false)) return 1;
-            if (createIndexIfNoExist(u8"people", u8"frame", u8"people", true)) return 1;
-            if (createIndexIfNoExist(u8"timestamp", u8"frame", true)) return 1;
+                SQLite::Statement insertQuery(*database, u8"INSERT INTO estimator_config VALUES (?, ?, ?, ?, ?)");
+                if (bindAllAndExec(insertQuery, configId, videoFingerprint, (int)poseModel, netInputSize.x, netInputSize.y)) return 1;
+            }
         }
         catch (const std::exception& e)
         {
@@ -74,34 +178,117 @@ public:
             return 1;
         }
 
+        tableSuffix = (configId == 0) ? std::string{} : (u8"_cfg" + std::to_string(configId));
+        selectedConfig = std::make_tuple(videoFingerprint, poseModel, netInputSize);
+        clearPrefetch();
+        return createPoseTables();
+    }
+
+    // MinOpenPoseの設定で selectConfig() を呼ぶ
+    int selectConfig(const std::string& videoFingerprint, const MinOpenPose& openpose)
+    {
+        auto config = openpose.getConfig();
+        return selectConfig(videoFingerprint, config.poseModel, config.netInputSize);
+    }
+
+    // 現在選択されている設定のIDを取得
+    long long getConfigId() const { return configId; }
+
+    /**
+     * 現在選択されている設定の結果を格納するテーブル名を取得する
+     * 姿勢推定の結果から派生するテーブル (trajectory, people_with_tracking など) にも使う
+     * @param baseName 設定を区別しない場合のテーブル名
+     */
+    std::string tableName(const std::string& baseName) const { return baseName + tableSuffix; }
+
+    // readBones() で結果がSQLに記録されていたフレーム数を取得
+    uint64_t getCacheHits() const { return cacheHits; }
+
+    // readBones() で結果がSQLに記録されていなかったフレーム数を取得
+    uint64_t getCacheMisses() const { return cacheMisses; }
+
+    // readBones() で結果がSQLに記録されていた割合を取得 (0.0から1.0)
+    double getCacheHitRate() const
+    {
+        const uint64_t total = cacheHits + cacheMisses;
+        return (total == 0) ? 0.0 : ((double)cacheHits / (double)total);
+    }
+
+    /**
+     * 別スレッドで次の区間の骨格を先読みする
+     * readBones() で連続したフレームを読み込む場合 (記録済みの動画の再生やシークなど) に、1フレームずつ問い合わせる時間を隠す
+     * 先読みには読み込み専用の別の接続を使うため、まだコミットされていないフレームは通常通り読み込まれる
+     * @param frames 1回に先読みするフレーム数 (0を指定すると先読みをやめる)
+     * @return 成功すると 0 が返る
+     */
+    int enablePrefetch(const size_t frames = 300)
+    {
+        clearPrefetch();
+        prefetchFrames = frames;
+        prefetchDatabase.reset();
+        if (frames == 0) return 0;
+
+        try
+        {
+            prefetchDatabase = createConnection(sqlPath, SQLite::OPEN_READONLY);
+            if (applyProfile(*prefetchDatabase, StorageProfile::ReadOnlyAnalytics)) return 1;
+            prefetchDatabase->setBusyTimeout(1000);
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << u8"error : " << __FILE__ << u8" : L" << __LINE__ << u8"\n" << e.what() << std::endl;
+            prefetchFrames = 0;
+            return 1;
+        }
+
         return 0;
     }
 
+    /**
+     * 指定された区間の骨格を1回の検索でまとめて読み込む
+     * @param firstFrame 区間の先頭のフレーム番号
+     * @param lastFrame 区間の末尾の次のフレーム番号
+     * @param callback 記録済みのフレームごとに、フレーム番号の昇順で呼ばれる (falseを返すと読み込みを中断する)
+     * @return 成功すると 0 が返る
+     */
+    int readBonesRange(const size_t firstFrame, const size_t lastFrame, const std::function<bool(size_t, const People&)>& callback)
+    {
+        const std::string peopleTable = tableName(u8"people");
+        return scanBones(*database, peopleTable, isPackedTable(peopleTable), tableName(u8"timestamp"), firstFrame, lastFrame, callback);
+    }
+
     std::optional<People> readBones(const size_t frameNumber)
     {
+        // 先読みした骨格があればそれを使う
+        if (prefetchFrames > 0)
+        {
+            auto prefetched = readPrefetched(frameNumber);
+            if (prefetched)
+            {
+                cacheHits++;
+                return prefetched;
+            }
+        }
+
         try
         {
-            // SQLɃ^CX^v݂ꍇ
-            if (isDataExist(u8"timestamp", u8"frame", frameNumber))
+            // SQLにタイムスタンプが存在した場合
+            if (coverage(tableName(u8"timestamp")).contains(frameNumber))
             {
-                // w肳ꂽt[ԍɉflׂĂ̍i
+                // 指定されたフレーム番号に映る人すべての骨格を検索する
                 People people;
-                SQLite::Statement peopleQuery(*database, u8"SELECT * FROM people WHERE frame=?");
-                peopleQuery.bind(1, (long long)frameNumber);
-                while (peopleQuery.executeStep())
+                const std::string peopleTable = tableName(u8"people");
+                const bool packed = isPackedTable(peopleTable);
+                auto peopleQuery = getStatement(u8"SELECT * FROM " + peopleTable + u8" WHERE frame=?");
+                peopleQuery->bind(1, (long long)frameNumber);
+                while (peopleQuery->executeStep())
                 {
-                    size_t index = (size_t)peopleQuery.getColumn(1).getInt64();
-                    for (int nodeIndex = 0; nodeIndex < 25; nodeIndex++)
-                    {
-                        people[index].push_back(MinOpenPose::Node{
-                            (float)peopleQuery.getColumn(2 + nodeIndex * 3 + 0).getDouble(),
-                            (float)peopleQuery.getColumn(2 + nodeIndex * 3 + 1).getDouble(),
-                            (float)peopleQuery.getColumn(2 + nodeIndex * 3 + 2).getDouble()
-                            });
-                    }
+                    size_t index = (size_t)peopleQuery->getColumn(1).getInt64();
+                    people[index] = getPerson(*peopleQuery, 2, packed);
                 }
 
-                // ʂԂ
+                // 検索結果を返す
+                cacheHits++;
                 return people;
             }
         }
@@ -110,51 +297,45 @@ public:
             std::cout << u8"error : " << __FILE__ << u8" : L" << __LINE__ << u8"\n" << e.what() << std::endl;
         }
 
-        // SQLɎw肳ꂽt[L^ĂȂꍇA̓G[NꍇnulloptԂ
+        // SQL上に指定されたフレームが記録されていない場合、もしくはエラーが起きた場合はnulloptを返す
+        cacheMisses++;
         return std::nullopt;
     }
 
     int writeBones(const size_t frameNumber, const size_t frameTimeStamp, const People& people)
     {
+        // セグメントを切り替える時期であれば、このフレームから新しいセグメントに記録する
+        if (isRotationDue && rotateSegment(frameNumber)) return 1;
+
         try
         {
-            // SQLɃ^CX^v݂ȂꍇSQLɃf[^ǉ
-            if (!isDataExist(u8"timestamp", u8"frame", frameNumber))
+            // SQLにタイムスタンプが存在しなかった場合はSQLにデータを追加する
+            FrameCoverage& timestampCoverage = coverage(tableName(u8"timestamp"));
+            if (!timestampCoverage.contains(frameNumber))
             {
-                // peoplee[u̍XV
-                std::string row = u8"?";
-                for (int colIndex = 0; colIndex < 76; colIndex++) row += u8", ?";
-                row = u8"INSERT INTO people VALUES (" + row + u8")";
-                SQLite::Statement peopleQuery(*database, row);
+                // peopleテーブルの更新
+                const std::string peopleTable = tableName(u8"people");
+                const bool packed = isPackedTable(peopleTable);
+                auto peopleQuery = getStatement(insertPersonQuery(peopleTable));
                 for (auto person = people.begin(); person != people.end(); person++)
                 {
-                    peopleQuery.reset();
-                    peopleQuery.bind(1, (long long)frameNumber);
-                    peopleQuery.bind(2, (long long)person->first);
-                    for (size_t nodeIndex = 0; nodeIndex < person->second.size(); nodeIndex++)
-                    {
-                        peopleQuery.bind(3 + nodeIndex * 3 + 0, (double)person->second[nodeIndex].x);
-                        peopleQuery.bind(3 + nodeIndex * 3 + 1, (double)person->second[nodeIndex].y);
-                        peopleQuery.bind(3 + nodeIndex * 3 + 2, (double)person->second[nodeIndex].confidence);
-                    }
-                    (void)peopleQuery.exec();
+                    peopleQuery->reset();
+                    peopleQuery->bind(1, (long long)frameNumber);
+                    peopleQuery->bind(2, (long long)person->first);
+                    bindPerson(*peopleQuery, 3, person->second, packed);
+                    (void)peopleQuery->exec();
                 }
 
-                // timestampe[u̍XV
-                row = u8"INSERT INTO timestamp VALUES (?, ?)";
-                SQLite::Statement timestampQuery(*database, row);
-                timestampQuery.reset();
-                timestampQuery.bind(1, (long long)frameNumber);
-                timestampQuery.bind(2, (long long)frameTimeStamp);
-                (void)timestampQuery.exec();
+                // timestampテーブルの更新
+                std::string row = u8"INSERT INTO " + tableName(u8"timestamp") + u8" VALUES (?, ?)";
+                auto timestampQuery = getStatement(row);
+                timestampQuery->bind(1, (long long)frameNumber);
+                timestampQuery->bind(2, (long long)frameTimeStamp);
+                (void)timestampQuery->exec();
+                timestampCoverage.add(frameNumber);
+                mirrorPeople(peopleTable, frameNumber, people);
             }
 
-            // sql̃R~bg
-            if ((saveFreq > 0) && (--saveCountDown <= 0))
-            {
-                saveCountDown = saveFreq;
-                commit();
-            }
         }
         catch (const std::exception& e)
         {
@@ -162,7 +343,8 @@ public:
             return 1;
         }
 
-        return 0;
+        // sqlのコミット
+        return countFrame(frameNumber);
     }
 
     std::map<size_t, Node> readPoints(const std::string& tableName, const size_t frameNumber)
@@ -171,17 +353,17 @@ public:
         
         try
         {
-            // SQLɃe[u݂ꍇ
-            if (isDataExist("sqlite_master", "type", "name", "table", tableName))
+            // SQLにテーブルが存在した場合
+            if (isTableExist(tableName))
             {
-                // w肳ꂽt[ԍɉflׂĂ̍ȉdS
-                SQLite::Statement peopleQuery(*database, u8"SELECT * FROM " + tableName + u8" WHERE frame=?");
-                peopleQuery.bind(1, (long long)frameNumber);
-                while (peopleQuery.executeStep())
+                // 指定されたフレーム番号に映る人すべての骨格の重心を検索する
+                auto peopleQuery = getStatement(u8"SELECT * FROM " + tableName + u8" WHERE frame=?");
+                peopleQuery->bind(1, (long long)frameNumber);
+                while (peopleQuery->executeStep())
                 {
-                    size_t index = (size_t)peopleQuery.getColumn(1).getInt64();
-                    float x = (float)peopleQuery.getColumn(2).getDouble();
-                    float y = (float)peopleQuery.getColumn(3).getDouble();
+                    size_t index = (size_t)peopleQuery->getColumn(1).getInt64();
+                    float x = (float)peopleQuery->getColumn(2).getDouble();
+                    float y = (float)peopleQuery->getColumn(3).getDouble();
                     result[index] = Node{ x, y, 0.0 };
                 }
             }
@@ -191,55 +373,847 @@ public:
             std::cout << u8"error : " << __FILE__ << u8" : L" << __LINE__ << u8"\n" << e.what() << std::endl;
         }
 
-        // SQLɎw肳ꂽt[L^ĂȂꍇA̓G[NꍇnulloptԂ
+        // SQL上に指定されたフレームが記録されていない場合、もしくはエラーが起きた場合はnulloptを返す
         return result;
     }
 
+    /**
+     * 指定された区間の座標を1回の検索でまとめて読み込む
+     * @param tableName テーブル名
+     * @param firstFrame 区間の先頭のフレーム番号
+     * @param lastFrame 区間の末尾の次のフレーム番号
+     * @param callback 区間内の全てのフレームについて、フレーム番号の昇順で呼ばれる
+     *                 (記録が無いフレームでは空のmapが渡される。falseを返すと読み込みを中断する)
+     * @return 成功すると 0 が返る
+     */
+    int readPointsRange(
+        const std::string& tableName, const size_t firstFrame, const size_t lastFrame,
+        const std::function<bool(size_t, const std::map<size_t, Node>&)>& callback
+    )
+    {
+        try
+        {
+            if (!isTableExist(tableName)) return 1;
+
+            auto pointsQuery = getStatement(u8"SELECT * FROM " + tableName + u8" WHERE ? <= frame AND frame < ? ORDER BY frame ASC");
+            if (bindAll(*pointsQuery, (long long)firstFrame, (long long)lastFrame)) return 1;
+
+            std::map<size_t, Node> points;
+            size_t frame = firstFrame;
+            while (pointsQuery->executeStep())
+            {
+                // フレームが変わったら、それまでのフレームを渡す
+                size_t rowFrame = (size_t)pointsQuery->getColumn(0).getInt64();
+                for (; frame < rowFrame; frame++)
+                {
+                    if (!callback(frame, points)) return 0;
+                    points.clear();
+                }
+
+                size_t index = (size_t)pointsQuery->getColumn(1).getInt64();
+                float x = (float)pointsQuery->getColumn(2).getDouble();
+                float y = (float)pointsQuery->getColumn(3).getDouble();
+                points[index] = Node{ x, y, 0.0 };
+            }
+            for (; frame < lastFrame; frame++)
+            {
+                if (!callback(frame, points)) return 0;
+                points.clear();
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << u8"error : " << __FILE__ << u8" : L" << __LINE__ << u8"\n" << e.what() << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    /**
+     * 1フレーム分の座標を書き込む
+     * 既に記録済みのフレームは、新しい座標に含まれない人の行だけを削除してから上書きする
+     * @param tableName テーブル名
+     * @param frameNumber フレーム番号
+     * @param points 人のIDと座標
+     * @return 成功すると 0 が返る
+     */
     int writePoints(const std::string& tableName, const size_t frameNumber, const std::map<size_t, Node> points)
+    {
+        if (writePointsBatch(tableName, { { frameNumber, points } })) return 1;
+
+        // sqlのコミット
+        return countFrame(frameNumber);
+    }
+
+    /**
+     * 複数フレーム分の座標をまとめて書き込む
+     * 全ての行を複数行のINSERT ... ON CONFLICT DO UPDATE でまとめて書き込むため、1行ずつ書き込むよりIndexの更新が少ない
+     * 既に記録済みのフレームは、新しい座標に含まれない人の行だけを削除する
+     * コミットは行わない (writeBones() などのコミットの周期、もしくは commit() でファイルに反映される)
+     * @param tableName テーブル名
+     * @param frames フレーム番号と、そのフレームの人のIDと座標の配列
+     * @return 成功すると 0 が返る
+     */
+    int writePointsBatch(const std::string& tableName, const std::vector<std::pair<size_t, std::map<size_t, Node>>>& frames)
     {
         try
         {
-            // e[u݂Ȃꍇ̓e[u𐶐
+            // テーブルが存在しない場合はテーブルを生成
             std::string row_title = u8"frame INTEGER, people INTEGER, x REAL, y REAL";
             if (createTableIfNoExist(tableName, row_title)) return 1;
 
-            // SQĽ邽߂Index쐬
+            // SQLの検索を高速化するためにIndexを作成 (frameとpeopleのIndexはupsertの衝突の判定にも使われる)
             if (createIndexIfNoExist(tableName, u8"frame", false)) return 1;
             if (createIndexIfNoExist(tableName, u8"people", false)) return 1;
             if (createIndexIfNoExist(tableName, u8"frame", u8"people", true)) return 1;
 
-            // SQL̐
-            SQLite::Statement deleteQuery(*database, u8"DELETE FROM " + tableName + u8" WHERE frame=?");
-            SQLite::Statement insertQuery(*database, u8"INSERT INTO " + tableName + u8" VALUES (?, ?, ?, ?)");
+            // 既に記録済みのフレームは、新しい座標に含まれない人の行だけを削除する
+            // (人のIDはJSONの配列として1つの値にバインドし、人数によらず同じSQL文を使い回す)
+            FrameCoverage& tableCoverage = coverage(tableName);
+            for (auto&& frame : frames)
+            {
+                if (!tableCoverage.contains(frame.first)) continue;
+                std::string ids = u8"[";
+                for (auto&& point : frame.second) ids += ((ids.size() > 1) ? u8"," : u8"") + std::to_string(point.first);
+                ids += u8"]";
+                auto deleteQuery = getStatement(u8"DELETE FROM " + tableName + u8" WHERE frame=? AND people NOT IN (SELECT value FROM json_each(?))");
+                if (bindAllAndExec(*deleteQuery, (long long)frame.first, ids)) return 1;
+            }
+
+            // 全ての行を並べる
+            struct Row { size_t frame; size_t people; Node point; };
+            std::vector<Row> rows;
+            for (auto&& frame : frames)
+            {
+                for (auto&& point : frame.second) rows.push_back(Row{ frame.first, point.first, point.second });
+            }
+
+            // 2のべき乗の行数ごとにupsertする (コンパイルされるSQL文の種類を最大でも8種類に抑える)
+            for (size_t first = 0; first < rows.size();)
+            {
+                size_t count = maxRowsPerUpsert;
+                while (count > rows.size() - first) count /= 2;
+
+                std::string query = u8"INSERT INTO " + tableName + u8" VALUES (?, ?, ?, ?)";
+                for (size_t i = 1; i < count; i++) query += u8", (?, ?, ?, ?)";
+                query += u8" ON CONFLICT(frame, people) DO UPDATE SET x=excluded.x, y=excluded.y";
+                auto upsertQuery = getStatement(query);
+                int index = 1;
+                for (size_t i = first; i < first + count; i++)
+                {
+                    upsertQuery->bind(index++, (long long)rows[i].frame);
+                    upsertQuery->bind(index++, (long long)rows[i].people);
+                    upsertQuery->bind(index++, (double)rows[i].point.x);
+                    upsertQuery->bind(index++, (double)rows[i].point.y);
+                }
+                (void)upsertQuery->exec();
+                first += count;
+            }
+
+            for (auto&& frame : frames)
+            {
+                if (!frame.second.empty()) markFrame(tableName, frame.first);
+                if (columnWriter) (void)columnWriter->appendPoints(tableName, frame.first, frame.second);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    /**
+     * これ以降に書き込む結果を、列形式のファイル (.pcol) にも追記する
+     * 追記した内容はコミットと同じ周期で書き出され、PoseColumnReader でメモリマップして読み込める
+     * @param path .pcol ファイルのパス (既に存在する場合は末尾に追記する)
+     * @param chunkRows 1つのチャンクに含める行数
+     * @return 成功すると 0 が返る
+     */
+    int mirrorToColumnFile(const std::string& path, const size_t chunkRows = 4096)
+    {
+        auto writer = std::make_shared<PoseColumnWriter>(chunkRows);
+        if (writer->open(path)) return 1;
+        columnWriter = writer;
+        return 0;
+    }
+
+    /**
+     * 骨格を列形式のファイルに追記する (mirrorToColumnFile() を呼んでいない場合は何もしない)
+     * SqlOpenPose 以外で骨格のテーブルに書き込む場合 (Tracking など) に使う
+     * @param table テーブル名
+     * @param frameNumber フレーム番号
+     * @param people 骨格
+     */
+    void mirrorPeople(const std::string& table, const size_t frameNumber, const People& people)
+    {
+        if (columnWriter) (void)columnWriter->appendPeople(table, frameNumber, people);
+    }
+
+    /**
+     * テーブルに記録済みのフレームの区間を取得する
+     * 初回のみSQLから全てのフレーム番号を読み込み、以降はメモリ上の区間を返す
+     * @param tableName frame列を持つテーブル名 (存在しない場合は空の区間を返す)
+     */
+    FrameCoverage& coverage(const std::string& tableName) const
+    {
+        auto itr = coverages.find(tableName);
+        if (itr != coverages.end()) return itr->second;
+
+        FrameCoverage& result = coverages[tableName];
+        try
+        {
+            if (isTableExist(tableName))
+            {
+                // フレーム番号の昇順に読み込み、連続している間は1つの区間にまとめてから追加する
+                SQLite::Statement frameQuery(*database, u8"SELECT DISTINCT frame FROM " + tableName + u8" ORDER BY frame ASC");
+                bool isFirst = true;
+                size_t first = 0, last = 0;
+                while (frameQuery.executeStep())
+                {
+                    size_t frame = (size_t)frameQuery.getColumn(0).getInt64();
+                    if (isFirst) { first = frame; last = frame + 1; isFirst = false; continue; }
+                    if (frame == last) { last++; continue; }
+                    result.add(first, last);
+                    first = frame;
+                    last = frame + 1;
+                }
+                if (!isFirst) result.add(first, last);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << u8"error : " << __FILE__ << u8" : L" << __LINE__ << u8"\n" << e.what() << std::endl;
+        }
+        return result;
+    }
+
+    // 指定されたフレームがテーブルに記録済みかどうか
+    bool isFrameExist(const std::string& tableName, const size_t frameNumber) const
+    {
+        return coverage(tableName).contains(frameNumber);
+    }
+
+    /**
+     * フレームを記録済みにする
+     * SqlOpenPose を経由せずにテーブルへ書き込んだ場合 (Trackingなど) に呼ぶ
+     */
+    void markFrame(const std::string& tableName, const size_t frameNumber)
+    {
+        coverage(tableName).add(frameNumber);
+    }
+
+    // テーブルを削除し、記録済みのフレームの区間も破棄する
+    int deleteTableIfExist(const std::string& tableName)
+    {
+        coverages.erase(tableName);
+        packedTables.erase(tableName);
+        return Database::deleteTableIfExist(tableName);
+    }
+
+    /**
+     * 骨格を保存するテーブル (people, people_with_tracking など) が存在しない場合は生成する
+     * 列は frame, people と骨格 (open() の packedSchema に応じて75列のREAL型、もしくは1列のBLOB型)
+     * @param tableName テーブル名
+     * @return 成功すると 0 が返る
+     */
+    int createPersonTableIfNoExist(const std::string& tableName)
+    {
+        // 既に存在が確認されたテーブルであれば、列の定義を組み立てずに済ませる
+        if (!isTableExist(tableName))
+        {
+            std::string row_title = u8"frame INTEGER, people INTEGER";
+            if (packedSchema)
+            {
+                row_title += u8", joints BLOB";
+            }
+            else
+            {
+                for (int i = 0; i < 25; i++)
+                {
+                    row_title += u8", joint" + std::to_string(i) + u8"x REAL";
+                    row_title += u8", joint" + std::to_string(i) + u8"y REAL";
+                    row_title += u8", joint" + std::to_string(i) + u8"confidence REAL";
+                }
+            }
+            if (createTableIfNoExist(tableName, row_title)) return 1;
+        }
+
+        // 検索速度を高速化するため、Indexを生成
+        if (createIndexIfNoExist(tableName, u8"frame", false)) return 1;
+        if (createIndexIfNoExist(tableName, u8"people", false)) return 1;
+        if (createIndexIfNoExist(tableName, u8"frame", u8"people", true)) return 1;
+        return 0;
+    }
+
+    /**
+     * 骨格のテーブルが、骨格をBLOBに詰めた形式かどうかを取得する
+     * 形式は列の数から判別する (テーブルが存在しない場合は、これから生成される形式を返す)
+     * @param tableName テーブル名
+     */
+    bool isPackedTable(const std::string& tableName) const
+    {
+        auto itr = packedTables.find(tableName);
+        if (itr != packedTables.end()) return itr->second;
+
+        try
+        {
+            if (!isTableExist(tableName)) return packedSchema;
+            SQLite::Statement columnQuery(*database, u8"SELECT * FROM " + tableName + u8" LIMIT 0");
+            return packedTables[tableName] = (columnQuery.getColumnCount() == 3);
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << u8"error : " << __FILE__ << u8" : L" << __LINE__ << u8"\n" << e.what() << std::endl;
+        }
+        return packedSchema;
+    }
+
+    // 骨格のテーブルに1人分の骨格を追加するSQL文を取得する
+    std::string insertPersonQuery(const std::string& tableName) const
+    {
+        std::string row = u8"?, ?";
+        if (isPackedTable(tableName)) row += u8", ?";
+        else for (int colIndex = 0; colIndex < 75; colIndex++) row += u8", ?";
+        return u8"INSERT INTO " + tableName + u8" VALUES (" + row + u8")";
+    }
+
+    /**
+     * 骨格をSQL文にバインドする
+     * @param query SQL文
+     * @param index 骨格の最初の列のインデックス (1から数える)
+     * @param person 骨格
+     * @param packed 骨格をBLOBに詰めた形式かどうか (isPackedTable() の戻り値)
+     */
+    static void bindPerson(SQLite::Statement& query, const int index, const Person& person, const bool packed)
+    {
+        if (packed)
+        {
+            const std::vector<uint8_t> blob = PackedPose::pack(person);
+            query.bind(index, (const void*)blob.data(), (int)blob.size());
+            return;
+        }
+        for (size_t nodeIndex = 0; nodeIndex < person.size(); nodeIndex++)
+        {
+            query.bind(index + (int)nodeIndex * 3 + 0, (double)person[nodeIndex].x);
+            query.bind(index + (int)nodeIndex * 3 + 1, (double)person[nodeIndex].y);
+            query.bind(index + (int)nodeIndex * 3 + 2, (double)person[nodeIndex].confidence);
+        }
+    }
+
+    /**
+     * 検索結果から骨格を取得する
+     * @param query 検索中のSQL文
+     * @param column 骨格の最初の列のインデックス (0から数える)
+     * @param packed 骨格をBLOBに詰めた形式かどうか (isPackedTable() の戻り値)
+     */
+    static Person getPerson(const SQLite::Statement& query, const int column, const bool packed)
+    {
+        if (packed)
+        {
+            const SQLite::Column blob = query.getColumn(column);
+            return PackedPose::unpack(blob.getBlob(), (size_t)blob.getBytes());
+        }
+        Person person;
+        person.reserve(25);
+        for (int nodeIndex = 0; nodeIndex < 25; nodeIndex++)
+        {
+            person.push_back(Node{
+                (float)query.getColumn(column + nodeIndex * 3 + 0).getDouble(),
+                (float)query.getColumn(column + nodeIndex * 3 + 1).getDouble(),
+                (float)query.getColumn(column + nodeIndex * 3 + 2).getDouble()
+            });
+        }
+        return person;
+    }
 
-            // Ƀf[^ꍇ͏㏑邽߂ɍ폜
-            deleteQuery.reset();
-            deleteQuery.bind(1, (long long)frameNumber);
-            (void)deleteQuery.exec();
+    /**
+     * metaテーブルから値を読み込む
+     * @param key キー
+     * @return 値 (記録されていない場合はnullopt)
+     */
+    std::optional<std::string> readMeta(const std::string& key) const
+    {
+        try
+        {
+            if (!isTableExist(u8"meta")) return std::nullopt;
+            auto query = getStatement(u8"SELECT value FROM meta WHERE key=?");
+            query->bind(1, key);
+            if (query->executeStep()) return query->getColumn(0).getString();
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << u8"error : " << __FILE__ << u8" : L" << __LINE__ << u8"\n" << e.what() << std::endl;
+        }
+        return std::nullopt;
+    }
 
-            // ݂̃t[̏SQLɒǋL
-            for (auto pointItr = points.begin(); pointItr != points.end(); pointItr++)
+    /**
+     * metaテーブルに値を書き込む (同じキーの値は上書きされる)
+     * @param key キー
+     * @param value 値
+     * @return 成功すると 0 が返る
+     */
+    int writeMeta(const std::string& key, const std::string& value)
+    {
+        try
+        {
+            auto query = getStatement(u8"INSERT OR REPLACE INTO meta VALUES (?, ?)");
+            return bindAllAndExec(*query, key, value);
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << u8"error : " << __FILE__ << u8" : L" << __LINE__ << u8"\n" << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    /**
+     * 処理を再開するためのチェックポイントを書き込む
+     * データと同じトランザクションで書き込まれるため、コミットされたチェックポイントは常にコミットされたデータと一致する
+     * (プロセスが途中で終了した場合は、最後にコミットされたチェックポイントから再開できる)
+     * トラッキングの状態は骨格のテーブル自体に記録されているため、ここにはメモリ上にしか無い状態 (カウンタや基準線の判定の途中経過など) を渡す
+     * @param frameNumber 処理を終えた最後のフレーム番号
+     * @param states 名前ごとの状態 (PeopleCounter::saveState() の戻り値など)
+     * @return 成功すると 0 が返る
+     */
+    int writeCheckpoint(const size_t frameNumber, const std::map<std::string, std::string>& states)
+    {
+        const std::string key = tableName(u8"checkpoint");
+        for (auto&& state : states)
+        {
+            if (writeMeta(key + u8"." + state.first, state.second)) return 1;
+        }
+        return writeMeta(key, std::to_string(frameNumber));
+    }
+
+    /**
+     * 最後にコミットされたチェックポイントを読み込む
+     * @param states 名前ごとの状態が代入される
+     * @return 処理を終えた最後のフレーム番号 (チェックポイントが無い場合はnullopt)
+     */
+    std::optional<size_t> readCheckpoint(std::map<std::string, std::string>& states) const
+    {
+        const std::string key = tableName(u8"checkpoint");
+        auto frame = readMeta(key);
+        if (!frame) return std::nullopt;
+
+        states.clear();
+        try
+        {
+            const std::string prefix = key + u8".";
+            auto query = getStatement(u8"SELECT key, value FROM meta WHERE substr(key, 1, ?)=?");
+            if (bindAll(*query, (long long)prefix.size(), prefix)) return std::nullopt;
+            while (query->executeStep())
             {
-                insertQuery.reset();
-                insertQuery.bind(1, (long long)frameNumber);
-                insertQuery.bind(2, (long long)pointItr->first);
-                insertQuery.bind(3, (double)pointItr->second.x);
-                insertQuery.bind(4, (double)pointItr->second.y);
-                (void)insertQuery.exec();
+                const std::string name = query->getColumn(0).getString().substr(prefix.size());
+                states[name] = query->getColumn(1).getString();
+            }
+            return (size_t)std::stoull(frame.value());
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << u8"error : " << __FILE__ << u8" : L" << __LINE__ << u8"\n" << e.what() << std::endl;
+        }
+        return std::nullopt;
+    }
+
+    // チェックポイントを削除する (最後まで処理を終えた場合など)
+    int clearCheckpoint()
+    {
+        try
+        {
+            if (!isTableExist(u8"meta")) return 0;
+            const std::string key = tableName(u8"checkpoint");
+            const std::string prefix = key + u8".";
+            auto query = getStatement(u8"DELETE FROM meta WHERE key=? OR substr(key, 1, ?)=?");
+            return bindAllAndExec(*query, key, (long long)prefix.size(), prefix);
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << u8"error : " << __FILE__ << u8" : L" << __LINE__ << u8"\n" << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    /**
+     * 骨格のテーブルで、新しく現れた人に割り当てるIDを取得する
+     * テーブルに記録されたIDの最大値と、前のセグメントから引き継いだID (metaテーブル) の大きい方の次の値になる
+     * @param tableName テーブル名
+     */
+    size_t nextPeopleId(const std::string& tableName) const
+    {
+        long long next = 0;
+        try
+        {
+            auto carried = readMeta(u8"next_people_id_" + tableName);
+            if (carried) next = std::stoll(carried.value());
+            if (isTableExist(tableName))
+            {
+                auto query = getStatement(u8"SELECT COALESCE(MAX(people) + 1, 0) FROM " + tableName);
+                (void)query->executeStep();
+                next = std::max(next, query->getColumn(0).getInt64());
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << u8"error : " << __FILE__ << u8" : L" << __LINE__ << u8"\n" << e.what() << std::endl;
+        }
+        return (size_t)next;
+    }
+
+    /**
+     * ファイルを一定時間ごと、もしくは一定サイズごとに切り替えながら記録する (24時間記録し続けるWebカメラなど)
+     * セグメントは <basePath>_<開始時刻>.sqlite3 に記録され、一覧は <basePath>.manifest に記録される
+     * 切り替えの際には、トラッキングを続けられるように policy.carryTables の末尾の行と次に割り当てる人のIDを引き継ぐ
+     * 保存期間を過ぎたセグメントはファイルごと削除されるため、記録中のファイルをロックすることはない
+     * @param basePath セグメントのファイルのパスの先頭
+     * @param policy 切り替えと保存期間の設定
+     * @param saveFreq open() と同じ
+     * @param packedSchema open() と同じ
+     * @param profile open() と同じ
+     * @return 成功すると 0 が返る
+     */
+    int openSegments(
+        const std::string& basePath, const SegmentPolicy& policy, const long long saveFreq = 0,
+        const bool packedSchema = false, const StorageProfile profile = StorageProfile::LiveIngest
+    )
+    {
+        if (segmentManifest.load(basePath)) return 1;
+
+        // 前回の記録中に終了したセグメントは、記録を終えたものとして扱う
+        const int64_t now = SegmentManifest::now();
+        for (auto&& segment : segmentManifest.segments)
+        {
+            if (segment.isActive()) segment.endTime = now;
+        }
+
+        // 新しいセグメントを開く
+        SegmentManifest::Segment segment;
+        segment.path = SegmentManifest::segmentPath(basePath, now);
+        segment.startTime = now;
+        if (open(segment.path, saveFreq, packedSchema, profile)) return 1;
+        segmentManifest.segments.push_back(segment);
+        segmentBasePath = basePath;
+        segmentPolicy = policy;
+        isRotationDue = false;
+
+        segmentManifest.applyRetention(segmentPolicy);
+        return segmentManifest.save(segmentBasePath);
+    }
+
+    /**
+     * 新しいセグメントに切り替える (openSegments() を呼んでいない場合は何もしない)
+     * 通常は writeBones() もしくは tick() の中で policy に従って自動的に呼ばれる
+     * @param frameNumber 新しいセグメントに最初に記録するフレーム番号
+     * @return 成功すると 0 が返る
+     */
+    int rotateSegment(const size_t frameNumber)
+    {
+        isRotationDue = false;
+        if (segmentBasePath.empty()) return 0;
+
+        // 引き継ぐ行と、次に割り当てる人のIDを読み込む
+        struct Carry { std::string baseName; std::map<size_t, People> frames; size_t nextId; };
+        std::vector<Carry> carries;
+        try
+        {
+            const long long firstFrame = std::max<long long>(0, (long long)frameNumber - (long long)segmentPolicy.carryFrames);
+            for (auto&& baseName : segmentPolicy.carryTables)
+            {
+                const std::string table = tableName(baseName);
+                if (!isTableExist(table)) continue;
+                const bool packed = isPackedTable(table);
+                Carry carry{ baseName, {}, nextPeopleId(table) };
+
+                // 末尾のフレームの行と、その間に映っていた人が最初に映ったときの行 (通過の判定に使われる)
+                const std::string queries[] = {
+                    u8"SELECT * FROM " + table + u8" WHERE frame >= ?",
+                    u8"SELECT * FROM " + table + u8" WHERE people IN (SELECT people FROM " + table + u8" WHERE frame >= ?) GROUP BY people HAVING frame=MIN(frame)"
+                };
+                for (auto&& text : queries)
+                {
+                    auto query = getStatement(text);
+                    query->bind(1, firstFrame);
+                    while (query->executeStep())
+                    {
+                        const size_t frame = (size_t)query->getColumn(0).getInt64();
+                        const size_t index = (size_t)query->getColumn(1).getInt64();
+                        carry.frames[frame][index] = getPerson(*query, 2, packed);
+                    }
+                }
+                carries.push_back(carry);
             }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << u8"error : " << __FILE__ << u8" : L" << __LINE__ << u8"\n" << e.what() << std::endl;
+            return 1;
+        }
+
+        // 現在のセグメントを閉じる
+        // (閉じるセグメントの情報の更新で、再び切り替える時期と判定されないようにする)
+        if (frameNumber > 0) updateSegment(frameNumber - 1);
+        isRotationDue = false;
+        segmentManifest.segments.back().endTime = SegmentManifest::now();
+        if (commit()) return 1;
 
-            // sql̃R~bg
-            if ((saveFreq > 0) && (--saveCountDown <= 0))
+        // 新しいセグメントを開き、同じ設定を選択し直す
+        // (open() で消去される統計情報と先読みの設定は引き継ぐ)
+        SegmentManifest::Segment segment;
+        segment.firstFrame = (int64_t)frameNumber;
+        segment.startTime = SegmentManifest::now();
+        segment.path = SegmentManifest::segmentPath(segmentBasePath, segment.startTime);
+        // (同じ時刻に切り替えた場合は、既存のファイルに追記しないようにフレーム番号を付ける)
+        std::error_code ec;
+        if (std::filesystem::exists(segment.path, ec)) segment.path += u8"." + std::to_string(frameNumber);
+        const auto config = selectedConfig;
+        const uint64_t hits = cacheHits, misses = cacheMisses;
+        if (open(segment.path, saveFreq, packedSchema, getProfile())) return 1;
+        if (config && selectConfig(std::get<0>(*config), std::get<1>(*config), std::get<2>(*config))) return 1;
+        cacheHits = hits;
+        cacheMisses = misses;
+        if (prefetchFrames > 0) enablePrefetch(prefetchFrames);
+
+        // 引き継いだ行と人のIDを書き込む
+        try
+        {
+            for (auto&& carry : carries)
             {
-                saveCountDown = saveFreq;
-                commit();
+                const std::string table = tableName(carry.baseName);
+                if (createPersonTableIfNoExist(table)) return 1;
+                const bool packed = isPackedTable(table);
+                auto insertQuery = getStatement(insertPersonQuery(table));
+                for (auto&& frame : carry.frames)
+                {
+                    for (auto&& person : frame.second)
+                    {
+                        insertQuery->reset();
+                        insertQuery->bind(1, (long long)frame.first);
+                        insertQuery->bind(2, (long long)person.first);
+                        bindPerson(*insertQuery, 3, person.second, packed);
+                        (void)insertQuery->exec();
+                    }
+                    markFrame(table, frame.first);
+                }
+                if (writeMeta(u8"next_people_id_" + table, std::to_string(carry.nextId))) return 1;
             }
         }
         catch (const std::exception& e)
+        {
+            std::cout << u8"error : " << __FILE__ << u8" : L" << __LINE__ << u8"\n" << e.what() << std::endl;
+            return 1;
+        }
+        if (commit()) return 1;
+
+        // 一覧を更新し、保存期間を過ぎたセグメントを削除する
+        segmentManifest.segments.push_back(segment);
+        segmentManifest.applyRetention(segmentPolicy);
+        return segmentManifest.save(segmentBasePath);
+    }
+
+    /**
+     * 1フレーム分の記録を終えたことを通知する
+     * saveFreq フレームごとにコミットし、セグメントに分けて記録している場合は切り替える時期であれば次のフレームから新しいセグメントに切り替える
+     * writeBones() を使わずに記録する場合 (Tracking や LatencyController だけで記録する場合など) は、毎フレームの記録の最後に呼ぶ
+     * 同じフレーム番号で続けて呼ばれた場合 (writeBones() の後に呼んだ場合など) は、コミットの周期を1フレームとして数える
+     * @param frameNumber 記録を終えたフレーム番号
+     * @return 成功すると 0 が返る
+     */
+    int tick(const size_t frameNumber)
+    {
+        if (countFrame(frameNumber)) return 1;
+        if (isRotationDue) return rotateSegment(frameNumber + 1);
+        return 0;
+    }
+
+    // 記録中のセグメントのパスを取得する (セグメントに分けていない場合は open() で指定したパス)
+    const std::string& getSegmentPath() const { return sqlPath; }
+
+private:
+    /**
+     * コミットの周期を1フレーム進め、周期に達したらコミットしてセグメントの情報を更新する
+     * @param frameNumber 記録したフレーム番号 (直前と同じフレーム番号の場合は数えない)
+     * @return 成功すると 0 が返る
+     */
+    int countFrame(const size_t frameNumber)
+    {
+        if (lastCountedFrame && (*lastCountedFrame == frameNumber)) return 0;
+        lastCountedFrame = frameNumber;
+        if (!segmentBasePath.empty() && (segmentManifest.segments.back().firstFrame < 0)) segmentManifest.segments.back().firstFrame = (int64_t)frameNumber;
+        if ((saveFreq <= 0) || (--saveCountDown > 0)) return 0;
+        saveCountDown = saveFreq;
+
+        try
+        {
+            if (commit()) return 1;
+            if (columnWriter) (void)columnWriter->flush();
+            if (!segmentBasePath.empty()) updateSegment(frameNumber);
+        }
+        catch (const std::exception& e)
         {
             std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
             return 1;
         }
+        return 0;
+    }
+
+    /**
+     * 一覧の記録中のセグメントの情報を更新し、切り替える時期かどうかを判定する
+     * @param frameNumber 最後に記録したフレーム番号
+     */
+    void updateSegment(const size_t frameNumber)
+    {
+        if (segmentManifest.segments.empty()) return;
+        SegmentManifest::Segment& segment = segmentManifest.segments.back();
+        if (segment.firstFrame < 0) segment.firstFrame = (int64_t)frameNumber;
+        segment.lastFrame = std::max(segment.lastFrame, (int64_t)frameNumber);
+        (void)segmentManifest.save(segmentBasePath);
+
+        // 時間とファイルサイズで切り替える時期かどうかを判定する
+        const int64_t elapsed = SegmentManifest::now() - segment.startTime;
+        if ((segmentPolicy.period.count() > 0) && (elapsed >= (int64_t)segmentPolicy.period.count())) isRotationDue = true;
+        if (segmentPolicy.maxBytes > 0)
+        {
+            std::error_code ec;
+            uint64_t bytes = 0;
+            for (auto&& suffix : { u8"", u8"-wal" })
+            {
+                const auto size = std::filesystem::file_size(sqlPath + suffix, ec);
+                if (!ec) bytes += (uint64_t)size;
+            }
+            if (bytes >= segmentPolicy.maxBytes) isRotationDue = true;
+        }
+    }
+
+    // 記録済みのフレームの骨格を区間の先頭から順に読み込む (先読みのスレッドからも呼ばれる)
+    static int scanBones(
+        SQLite::Database& db, const std::string& peopleTable, const bool packed, const std::string& timestampTable,
+        const size_t firstFrame, const size_t lastFrame, const std::function<bool(size_t, const People&)>& callback
+    )
+    {
+        try
+        {
+            // timestampテーブルを基準に結合し、誰も映っていないフレームも1行として取得する
+            SQLite::Statement peopleQuery(db,
+                u8"SELECT t.frame, p.* FROM " + timestampTable + u8" AS t LEFT JOIN " + peopleTable + u8" AS p ON p.frame = t.frame"
+                u8" WHERE ? <= t.frame AND t.frame < ? ORDER BY t.frame ASC, p.people ASC"
+            );
+            peopleQuery.bind(1, (long long)firstFrame);
+            peopleQuery.bind(2, (long long)lastFrame);
+
+            People people;
+            bool isFirst = true;
+            size_t frame = 0;
+            while (peopleQuery.executeStep())
+            {
+                // フレームが変わったら、それまでのフレームを渡す
+                size_t rowFrame = (size_t)peopleQuery.getColumn(0).getInt64();
+                if (isFirst) { frame = rowFrame; isFirst = false; }
+                if (rowFrame != frame)
+                {
+                    if (!callback(frame, people)) return 0;
+                    people.clear();
+                    frame = rowFrame;
+                }
+
+                // 誰も映っていないフレーム
+                if (peopleQuery.getColumn(2).isNull()) continue;
+
+                people[(size_t)peopleQuery.getColumn(2).getInt64()] = getPerson(peopleQuery, 3, packed);
+            }
+            if (!isFirst) (void)callback(frame, people);
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << u8"error : " << __FILE__ << u8" : L" << __LINE__ << u8"\n" << e.what() << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    // 先読みを中断し、先読みした骨格を破棄する
+    void clearPrefetch()
+    {
+        if (prefetchFuture.valid()) prefetchFuture.wait();
+        prefetchFuture = std::future<std::map<size_t, People>>{};
+        prefetchBuffer.clear();
+        prefetchFirst = prefetchLast = 0;
+        futureFirst = futureLast = 0;
+    }
+
+    // 先読みした骨格から指定されたフレームを探し、必要であれば次の区間の先読みを始める
+    std::optional<People> readPrefetched(const size_t frameNumber)
+    {
+        // 先読みが完了していれば、その結果を使う
+        if (prefetchFuture.valid() && (prefetchFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready))
+        {
+            prefetchBuffer = prefetchFuture.get();
+            prefetchFirst = futureFirst;
+            prefetchLast = futureLast;
+        }
+
+        // 先読みした区間に含まれていれば、その骨格を返す
+        std::optional<People> result;
+        const bool inBuffer = (prefetchFirst <= frameNumber) && (frameNumber < prefetchLast);
+        if (inBuffer)
+        {
+            auto itr = prefetchBuffer.find(frameNumber);
+            if (itr != prefetchBuffer.end()) result = itr->second;
+        }
+
+        // 区間の後半に入った場合は続きを、区間外にシークした場合はそこからを先読みする
+        if (!prefetchFuture.valid() && ((!inBuffer) || (frameNumber + prefetchFrames / 2 >= prefetchLast)))
+        {
+            const size_t first = inBuffer ? prefetchLast : frameNumber + 1;
+            const size_t last = first + prefetchFrames;
+
+            // 記録済みのフレームが無い区間は先読みしない (姿勢推定をしながら記録している最中など)
+            if (coverage(tableName(u8"timestamp")).firstMissing(first) > first)
+            {
+                futureFirst = first;
+                futureLast = last;
+                prefetchFuture = std::async(std::launch::async,
+                    [db = prefetchDatabase, peopleTable = tableName(u8"people"), packed = isPackedTable(tableName(u8"people")), timestampTable = tableName(u8"timestamp"), first, last]() {
+                        std::map<size_t, People> buffer;
+                        scanBones(*db, peopleTable, packed, timestampTable, first, last, [&](size_t frame, const People& people) {
+                            buffer[frame] = people;
+                            return true;
+                        });
+                        return buffer;
+                    }
+                );
+            }
+        }
+
+        return result;
+    }
+
+    // 現在選択されている設定の people, timestamp テーブルが存在しない場合は生成する
+    int createPoseTables()
+    {
+        try
+        {
+            const std::string timestampTable = tableName(u8"timestamp");
+
+            // peopleテーブルが存在しない場合はテーブルを生成
+            if (createPersonTableIfNoExist(tableName(u8"people"))) return 1;
+
+            // timestampテーブルが存在しない場合はテーブルを生成
+            if (createTableIfNoExist(timestampTable, u8"frame INTEGER PRIMARY KEY, timestamp INTEGER")) return 1;
+
+            // 検索速度を高速化するため、Indexを生成
+            if (createIndexIfNoExist(timestampTable, u8"frame", true)) return 1;
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << u8"error : " << __FILE__ << u8" : L" << __LINE__ << u8"\n" << e.what() << std::endl;
+            return 1;
+        }
 
         return 0;
     }
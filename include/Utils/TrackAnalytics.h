@@ -0,0 +1,316 @@
+#pragma once
+
+#include <OpenPoseWrapper/MinimumOpenPose.h>
+#include <Utils/Database.h>
+#include <Utils/Geometry.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * トラッキング中の人の地面上の座標 (vt::ScreenToGround::translate() で変換した座標) をフレームごとに受け取り、
+ * 人ごとの速度 (指数移動平均)、移動距離、ゾーンごとの滞在時間を逐次計算するクラス
+ * 速度・移動距離・滞在時間の分布はヒストグラムに集計し、一定時間ごとにSQLに書き込む
+ * ゾーンは外接矩形で一様なグリッドに登録しておき、点を含むセルに登録されたゾーンだけを判定する
+ */
+class TrackAnalytics
+{
+private:
+	using Node = MinOpenPose::Node;
+
+public:
+	// 一定の幅の区間ごとに数えるヒストグラム (最後の区間にはそれ以上の値も含める)
+	struct Histogram
+	{
+		float binWidth = 1.0f;
+		std::vector<uint64_t> counts;
+
+		void add(const float value)
+		{
+			if (counts.empty() || !(value >= 0.0f)) return;
+			const size_t index = std::min(counts.size() - 1, (size_t)(value / binWidth));
+			counts[index]++;
+		}
+
+		void clear() { std::fill(counts.begin(), counts.end(), 0); }
+	};
+
+	// 地面上のゾーン
+	struct Zone
+	{
+		std::string name;
+		std::vector<cv::Point2f> polygon;
+		cv::Rect2f bounds;
+		Histogram dwell;  // 1回の滞在時間 (秒) の分布
+	};
+
+	// トラッキング中の人の状態
+	struct Track
+	{
+		cv::Point2f point;  // 最後の地面上の座標
+		int64_t lastTime = 0;  // 最後に検出された時刻 (ミリ秒)
+		cv::Point2f velocity;  // 速度の指数移動平均 (地面上の単位 / 秒)
+		float distance = 0.0f;  // これまでの移動距離
+		int zone = -1;  // 現在いるゾーン (いない場合は -1)
+		float dwell = 0.0f;  // 現在いるゾーンに入ってからの時間 (秒)
+
+		// 速さ (速度の大きさ)
+		float speed() const { return std::sqrt(velocity.x * velocity.x + velocity.y * velocity.y); }
+	};
+
+	/**
+	 * @param smoothing 速度の指数移動平均の係数 (大きいほど最新の速度を重視する)
+	 * @param lostMillis 最後に検出されてからこの時間 (ミリ秒) が経過した人は、消失したものとして処理する
+	 * @param flushMillis ヒストグラムをSQLに書き込む周期 (ミリ秒)
+	 */
+	TrackAnalytics(const float smoothing = 0.3f, const int64_t lostMillis = 1000, const int64_t flushMillis = 60LL * 1000LL)
+		: smoothing{ smoothing }, lostMillis{ lostMillis }, flushMillis{ flushMillis }
+	{
+		speeds.binWidth = 0.1f;
+		speeds.counts.resize(50, 0);
+		distances.binWidth = 1.0f;
+		distances.counts.resize(50, 0);
+	}
+
+	virtual ~TrackAnalytics() {};
+
+	/**
+	 * 地面上のゾーンを追加する
+	 * @param name ゾーンの名前
+	 * @param polygon ゾーンの頂点 (地面上の座標)
+	 * @param binWidth 滞在時間のヒストグラムの区間の幅 (秒)
+	 * @param bins 滞在時間のヒストグラムの区間の数
+	 * @return ゾーンのインデックス
+	 */
+	size_t addZone(const std::string& name, const std::vector<cv::Point2f>& polygon, const float binWidth = 5.0f, const size_t bins = 60)
+	{
+		Zone zone;
+		zone.name = name;
+		zone.polygon = polygon;
+		zone.bounds = geometry::boundsOf(polygon);
+		zone.dwell.binWidth = binWidth;
+		zone.dwell.counts.resize(bins, 0);
+		zones.push_back(zone);
+		buildGrid();
+		return zones.size() - 1;
+	}
+
+	/**
+	 * 1フレーム分の地面上の座標を受け取り、人ごとの速度、移動距離、滞在時間を更新する
+	 * @param time フレームの時刻 (ミリ秒)
+	 * @param points このフレームで検出された人のIDと地面上の座標
+	 */
+	void update(const int64_t time, const std::map<size_t, Node>& points)
+	{
+		for (auto&& point : points)
+		{
+			const cv::Point2f p{ point.second.x, point.second.y };
+			auto itr = tracks.find(point.first);
+
+			// lostMillis より長く検出されていなかった人 (前方にシークした場合など) は、古い状態を集計してから新しく追跡を始める
+			// (古い位置からの移動を、移動距離や速度に含めないようにする)
+			if ((itr != tracks.end()) && (time - itr->second.lastTime > lostMillis))
+			{
+				finish(itr->second);
+				tracks.erase(itr);
+				itr = tracks.end();
+			}
+
+			if (itr == tracks.end())
+			{
+				Track track;
+				track.point = p;
+				track.lastTime = time;
+				track.zone = findZone(p);
+				tracks.emplace(point.first, track);
+				continue;
+			}
+
+			// 時刻が進んでいないフレーム (シークして戻った場合など) は無視する
+			Track& track = itr->second;
+			const float dt = (float)(time - track.lastTime) / 1000.0f;
+			if (dt <= 0.0f) continue;
+
+			// 速度の指数移動平均と移動距離
+			const cv::Point2f move = p - track.point;
+			const cv::Point2f velocity{ move.x / dt, move.y / dt };
+			track.velocity = track.velocity * (1.0f - smoothing) + velocity * smoothing;
+			track.distance += std::sqrt(move.x * move.x + move.y * move.y);
+			speeds.add(track.speed());
+
+			// ゾーンの滞在時間 (ゾーンを出たときに1回分の滞在時間として集計する)
+			if (track.zone >= 0) track.dwell += dt;
+			const int zone = isInside(track.zone, p) ? track.zone : findZone(p);
+			if (zone != track.zone)
+			{
+				if (track.zone >= 0) zones[track.zone].dwell.add(track.dwell);
+				track.zone = zone;
+				track.dwell = 0.0f;
+			}
+
+			track.point = p;
+			track.lastTime = time;
+		}
+
+		// しばらく検出されていない人を消失したものとして集計する
+		for (auto itr = tracks.begin(); itr != tracks.end();)
+		{
+			if (itr->second.lastTime + lostMillis >= time)
+			{
+				itr++;
+				continue;
+			}
+			finish(itr->second);
+			itr = tracks.erase(itr);
+		}
+
+		if (lastFlushTime < 0) lastFlushTime = time;
+	}
+
+	/**
+	 * 前回の書き込みから flushMillis 以上経過していれば、ヒストグラムをSQLに書き込んでから0に戻す
+	 * @param database 書き込み先
+	 * @param tableName テーブル名
+	 * @param time 現在の時刻 (ミリ秒)
+	 * @return 成功すると 0 が返る
+	 */
+	int flushIfDue(Database& database, const std::string& tableName, const int64_t time)
+	{
+		if ((lastFlushTime < 0) || (time < lastFlushTime + flushMillis)) return 0;
+		return flush(database, tableName, time);
+	}
+
+	/**
+	 * ヒストグラムをSQLに書き込んでから0に戻す
+	 * 1行に「集計を始めた時刻, 指標の名前, ゾーンのインデックス (ゾーンごとでない指標は -1), 区間の幅, 区間ごとの数 (カンマ区切り)」を記録する
+	 * @param database 書き込み先
+	 * @param tableName テーブル名
+	 * @param time 現在の時刻 (ミリ秒)
+	 * @return 成功すると 0 が返る
+	 */
+	int flush(Database& database, const std::string& tableName, const int64_t time)
+	{
+		try
+		{
+			if (database.createTableIfNoExist(tableName, u8"time INTEGER, metric TEXT, zone INTEGER, bin_width REAL, counts TEXT, PRIMARY KEY(time, metric, zone)")) return 1;
+			auto query = database.getStatement(u8"INSERT OR REPLACE INTO " + tableName + u8" VALUES (?, ?, ?, ?, ?)");
+			const long long start = (long long)((lastFlushTime < 0) ? time : lastFlushTime);
+
+			auto write = [&](const std::string& metric, const int zone, Histogram& histogram) {
+				std::string counts;
+				for (size_t i = 0; i < histogram.counts.size(); i++) counts += ((i == 0) ? u8"" : u8",") + std::to_string(histogram.counts[i]);
+				if (database.bindAllAndExec(*query, start, metric, zone, histogram.binWidth, counts)) return 1;
+				histogram.clear();
+				return 0;
+			};
+			if (write(u8"speed", -1, speeds)) return 1;
+			if (write(u8"distance", -1, distances)) return 1;
+			for (size_t i = 0; i < zones.size(); i++) if (write(u8"dwell", (int)i, zones[i].dwell)) return 1;
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+			return 1;
+		}
+		lastFlushTime = time;
+
+		return 0;
+	}
+
+	// トラッキング中の人の状態を取得
+	const std::map<size_t, Track>& getTracks() const { return tracks; }
+
+	// ゾーンの一覧を取得
+	const std::vector<Zone>& getZones() const { return zones; }
+
+	// 前回の書き込み以降の速さ (地面上の単位 / 秒) の分布を取得
+	const Histogram& getSpeeds() const { return speeds; }
+
+	// 前回の書き込み以降に消失した人の移動距離の分布を取得
+	const Histogram& getDistances() const { return distances; }
+
+private:
+	// 速度の指数移動平均の係数
+	float smoothing;
+
+	// 最後に検出されてからこの時間 (ミリ秒) が経過した人は、消失したものとして処理する
+	int64_t lostMillis;
+
+	// ヒストグラムをSQLに書き込む周期 (ミリ秒) と、前回書き込んだ時刻 (まだ書き込んでいない場合は最初のフレームの時刻)
+	int64_t flushMillis;
+	int64_t lastFlushTime = -1;
+
+	std::map<size_t, Track> tracks;
+	std::vector<Zone> zones;
+
+	// ゾーンを登録するグリッドの1セルの大きさと、全てのゾーンを囲む矩形
+	float cellSize = 1.0f;
+	cv::Rect2f gridBounds;
+
+	// セルごとのゾーン (インデックスの小さい順)
+	std::unordered_map<int64_t, std::vector<int>> grid;
+
+	// 速さと移動距離の分布
+	Histogram speeds, distances;
+
+	// 消失した人の移動距離と、最後にいたゾーンの滞在時間を集計する
+	void finish(const Track& track)
+	{
+		distances.add(track.distance);
+		if (track.zone >= 0) zones[track.zone].dwell.add(track.dwell);
+	}
+
+	/**
+	 * 全てのゾーンをグリッドに登録し直す
+	 * セルの大きさはゾーンの外接矩形の大きさの平均にする (地面上の単位によらず、1つのゾーンが数セルに収まるようにする)
+	 */
+	void buildGrid()
+	{
+		float size = 0.0f;
+		for (auto&& zone : zones) size += std::max(zone.bounds.width, zone.bounds.height);
+		cellSize = std::max(size / (float)zones.size(), 1e-6f);
+
+		std::vector<cv::Point2f> corners;
+		for (auto&& zone : zones)
+		{
+			corners.push_back(zone.bounds.tl());
+			corners.push_back(zone.bounds.br());
+		}
+		gridBounds = geometry::boundsOf(corners);
+
+		grid.clear();
+		for (size_t i = 0; i < zones.size(); i++)
+		{
+			const cv::Rect2f& bounds = zones[i].bounds;
+			const int left = cellOf(bounds.x, gridBounds.x), right = cellOf(bounds.x + bounds.width, gridBounds.x);
+			const int top = cellOf(bounds.y, gridBounds.y), bottom = cellOf(bounds.y + bounds.height, gridBounds.y);
+			for (int y = top; y <= bottom; y++) for (int x = left; x <= right; x++) grid[geometry::cellKey(x, y)].push_back((int)i);
+		}
+	}
+
+	// 座標が含まれるセルの番号 (全てのゾーンを囲む矩形の左上を基準にする)
+	int cellOf(const float value, const float origin) const { return (int)std::floor((value - origin) / cellSize); }
+
+	// 点がいずれかのゾーンの中にあればそのインデックスを返す (無ければ -1)
+	int findZone(const cv::Point2f& p) const
+	{
+		// 全てのゾーンを囲む矩形の外 (NaN を含む) であれば、セルを求めずに判定を終える
+		if (!geometry::isInside(gridBounds, p)) return -1;
+		auto cell = grid.find(geometry::cellKey(cellOf(p.x, gridBounds.x), cellOf(p.y, gridBounds.y)));
+		if (cell == grid.end()) return -1;
+		for (auto&& zone : cell->second) if (isInside(zone, p)) return zone;
+		return -1;
+	}
+
+	// 点がゾーンの中にあるかどうか
+	bool isInside(const int zone, const cv::Point2f& p) const
+	{
+		if (zone < 0) return false;
+		return geometry::isInside(zones[zone].polygon, zones[zone].bounds, p);
+	}
+};
@@ -0,0 +1,364 @@
+#pragma once
+
+#include <OpenPoseWrapper/MinimumOpenPose.h>
+#include <Utils/SqlOpenPose.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <optional>
+#include <functional>
+#include <algorithm>
+
+/**
+ * トラッキングした人ごとの要約 (最初と最後のフレーム、重心、移動距離、基準線の通過) を記録するテーブル (track_summary) を管理するクラス
+ * Tracking が骨格を書き込むたびに1人1行を更新するため、人ごとの始点や終点を people_with_tracking の全行から求め直さなくてよい
+ * テーブルが無いファイル (以前のバージョンで記録したファイルや、新しいセグメント) では people_with_tracking から作り直す
+ */
+class TrackSummary
+{
+private:
+	using Person = MinOpenPose::Person;
+	using Node = MinOpenPose::Node;
+
+public:
+	// 1人分の要約
+	struct Track
+	{
+		size_t people = 0;
+		size_t firstFrame = 0, lastFrame = 0;
+
+		// 画面上の重心
+		cv::Point2f firstPoint, lastPoint;
+
+		// 地面上の座標 (地面への変換が設定されていない場合は画面上の重心)
+		cv::Point2f firstGround, lastGround;
+
+		// 地面上の移動距離
+		float pathLength = 0.0f;
+
+		// 基準線を通過した方向 (1 : 上方向, -1 : 下方向, 0 : 通過していない) と、通過が確定したフレーム番号
+		int crossing = 0;
+		std::optional<size_t> crossingFrame;
+	};
+
+	/**
+	 * @param baseName テーブル名 (接尾辞を除いた名前)
+	 * @param staleFrames 最後に検出されてからこのフレーム数が経過した人は、メモリ上の要約から外す (必要になればSQLから読み直す。0 を指定した場合は 1 として扱う)
+	 */
+	TrackSummary(const std::string& baseName = u8"track_summary", const size_t staleFrames = 300)
+		: baseName{ baseName }, staleFrames{ std::max<size_t>(1, staleFrames) } {}
+
+	virtual ~TrackSummary() {};
+
+	// テーブル名を取得
+	std::string tableName(const SqlOpenPose& sql) const { return sql.tableName(baseName); }
+
+	/**
+	 * 画面上の座標を地面上の座標に変換する関数を設定する (vt::ScreenToGround::translate() など)
+	 * 設定しない場合は、画面上の重心の移動距離を記録する
+	 */
+	void setGroundTransform(const std::function<cv::Point2f(const cv::Point2f&)>& transform)
+	{
+		groundTransform = transform;
+		tracks.clear();
+	}
+
+	/**
+	 * テーブルが無ければ作成し、トラッキング済みの骨格から要約を作り直す
+	 * @param sql SqlOpenPoseのインスタンス
+	 * @param trackingTable トラッキング済みの骨格のテーブル名
+	 * @param centroid 骨格の重心を求める関数 (Tracking::getJointAverage)
+	 * @return 成功すると 0 が返る
+	 */
+	int ensure(SqlOpenPose& sql, const std::string& trackingTable, const std::function<Node(const Person&)>& centroid)
+	{
+		const std::string table = tableName(sql);
+		if (sql.isTableExist(table)) return 0;
+
+		if (sql.createTableIfNoExist(table, u8"people INTEGER PRIMARY KEY, first_frame INTEGER, last_frame INTEGER, "
+			u8"first_x REAL, first_y REAL, last_x REAL, last_y REAL, "
+			u8"first_ground_x REAL, first_ground_y REAL, last_ground_x REAL, last_ground_y REAL, "
+			u8"path_length REAL, crossing INTEGER DEFAULT 0, crossing_frame INTEGER")) return 1;
+		if (sql.createIndexIfNoExist(table, u8"last_frame", false)) return 1;
+
+		return backfill(sql, trackingTable, centroid);
+	}
+
+	/**
+	 * トラッキング済みの骨格を全て読み込み、要約を作り直す
+	 * @param sql SqlOpenPoseのインスタンス
+	 * @param trackingTable トラッキング済みの骨格のテーブル名
+	 * @param centroid 骨格の重心を求める関数 (Tracking::getJointAverage)
+	 * @return 成功すると 0 が返る
+	 */
+	int backfill(SqlOpenPose& sql, const std::string& trackingTable, const std::function<Node(const Person&)>& centroid)
+	{
+		// メモリ上にある人 (セグメントを切り替えた場合に引き継がれた人) は、それまでの要約の続きから作り直す
+		std::map<size_t, Track> previous, carried;
+		previous.swap(tracks);
+		try
+		{
+			if (!sql.isTableExist(trackingTable)) return 0;
+			const bool packed = sql.isPackedTable(trackingTable);
+
+			// 1人分読み終えるたびに書き込む
+			auto finish = [&](const Track& track) {
+				if (previous.count(track.people) && (previous.at(track.people).firstFrame == track.firstFrame)) carried[track.people] = track;
+				return write(sql, track);
+			};
+
+			// 人ごとにフレーム順で読み込む
+			auto query = sql.getStatement(u8"SELECT * FROM " + trackingTable + u8" ORDER BY people ASC, frame ASC");
+			std::optional<Track> track;
+			while (query->executeStep())
+			{
+				const size_t frame = (size_t)query->getColumn(0).getInt64();
+				const size_t index = (size_t)query->getColumn(1).getInt64();
+				const Node node = centroid(SqlOpenPose::getPerson(*query, 2, packed));
+				if (track && (track->people != index))
+				{
+					if (finish(*track)) return 1;
+					track.reset();
+				}
+				if (!track)
+				{
+					// フレーム番号が離れている場合は、別の動画や設定の人として扱う
+					auto itr = previous.find(index);
+					if ((itr == previous.end()) || (frame + staleFrames < itr->second.lastFrame) || (itr->second.lastFrame + staleFrames < frame))
+					{
+						track = start(index, frame, node);
+						continue;
+					}
+					track = itr->second;
+				}
+
+				// 引き継いだ要約に含まれているフレームは読み飛ばす
+				if (frame > track->lastFrame) advance(*track, frame, node);
+			}
+			if (track && finish(*track)) return 1;
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+			return 1;
+		}
+		tracks.swap(carried);
+
+		return 0;
+	}
+
+	/**
+	 * 1フレーム分のトラッキングの結果を要約に反映する
+	 * @param sql SqlOpenPoseのインスタンス
+	 * @param frameNumber フレーム番号
+	 * @param centroids このフレームで検出された人のIDと重心 (Tracking::getJointAverages(Tracking::latestPeople))
+	 * @return 成功すると 0 が返る
+	 */
+	int update(SqlOpenPose& sql, const size_t frameNumber, const std::map<size_t, Node>& centroids)
+	{
+		for (auto&& centroid : centroids)
+		{
+			auto itr = tracks.find(centroid.first);
+
+			// メモリ上に無い場合はSQLから読み直す (新しく検出された人であれば作成する)
+			if (itr == tracks.end())
+			{
+				auto track = readTrack(sql, centroid.first);
+				if (track) advance(*track, frameNumber, centroid.second);
+				else track = start(centroid.first, frameNumber, centroid.second);
+				itr = tracks.emplace(centroid.first, *track).first;
+			}
+			else
+			{
+				advance(itr->second, frameNumber, centroid.second);
+			}
+
+			if (write(sql, itr->second)) return 1;
+		}
+
+		// しばらく検出されていない人をメモリ上から外す
+		if ((frameNumber % staleFrames) == 0)
+		{
+			for (auto itr = tracks.begin(); itr != tracks.end();)
+			{
+				if (itr->second.lastFrame + staleFrames < frameNumber) itr = tracks.erase(itr);
+				else itr++;
+			}
+		}
+
+		return 0;
+	}
+
+	/**
+	 * 基準線を通過したことを記録する (PeopleCounter::writeCrossings() から呼ばれる)
+	 * @param sql SqlOpenPoseのインスタンス
+	 * @param people 人のID
+	 * @param direction 通過した方向 (1 : 上方向, -1 : 下方向)
+	 * @param frameNumber 通過が確定したフレーム番号
+	 * @return 成功すると 0 が返る
+	 */
+	int writeCrossing(SqlOpenPose& sql, const size_t people, const int direction, const size_t frameNumber)
+	{
+		auto itr = tracks.find(people);
+		if (itr != tracks.end())
+		{
+			itr->second.crossing = direction;
+			itr->second.crossingFrame = frameNumber;
+		}
+		try
+		{
+			auto query = sql.getStatement(u8"UPDATE " + tableName(sql) + u8" SET crossing=?, crossing_frame=? WHERE people=?");
+			return sql.bindAllAndExec(*query, direction, (long long)frameNumber, (long long)people);
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+			return 1;
+		}
+	}
+
+	/**
+	 * 1人分の要約を読み込む
+	 * @param sql SqlOpenPoseのインスタンス
+	 * @param people 人のID
+	 * @return 記録されていない場合は std::nullopt が返る
+	 */
+	std::optional<Track> readTrack(const SqlOpenPose& sql, const size_t people) const
+	{
+		try
+		{
+			const std::string table = tableName(sql);
+			if (!sql.isTableExist(table)) return std::nullopt;
+			auto query = sql.getStatement(u8"SELECT * FROM " + table + u8" WHERE people=?");
+			if (sql.bindAll(*query, (long long)people)) return std::nullopt;
+			if (!query->executeStep()) return std::nullopt;
+			return getTrack(*query);
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+			return std::nullopt;
+		}
+	}
+
+	/**
+	 * firstFrameNumberフレームからendFrameNumberフレームまでの間に映っていた人の要約を読み込む
+	 * @param sql SqlOpenPoseのインスタンス
+	 * @param firstFrameNumber 最初のフレーム番号
+	 * @param endFrameNumber 最後のフレーム番号
+	 * @return 失敗すると std::nullopt が返る
+	 */
+	std::optional<std::vector<Track>> readTracks(const SqlOpenPose& sql, const size_t firstFrameNumber, const size_t endFrameNumber) const
+	{
+		std::vector<Track> result;
+		try
+		{
+			const std::string table = tableName(sql);
+			if (!sql.isTableExist(table)) return result;
+			auto query = sql.getStatement(u8"SELECT * FROM " + table + u8" WHERE ? <= last_frame AND first_frame <= ? ORDER BY people ASC");
+			if (sql.bindAll(*query, (long long)firstFrameNumber, (long long)endFrameNumber)) return std::nullopt;
+			while (query->executeStep()) result.push_back(getTrack(*query));
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+			return std::nullopt;
+		}
+		return result;
+	}
+
+private:
+	// テーブル名 (接尾辞を除いた名前)
+	std::string baseName;
+
+	// 最後に検出されてからこのフレーム数が経過した人は、メモリ上の要約から外す
+	size_t staleFrames;
+
+	// 画面上の座標を地面上の座標に変換する関数
+	std::function<cv::Point2f(const cv::Point2f&)> groundTransform;
+
+	// 最近検出された人の要約 (SQLと同じ内容)
+	std::map<size_t, Track> tracks;
+
+	// 画面上の重心を地面上の座標に変換する
+	cv::Point2f toGround(const cv::Point2f& point) const
+	{
+		return groundTransform ? groundTransform(point) : point;
+	}
+
+	// 新しく検出された人の要約を作成する
+	Track start(const size_t people, const size_t frameNumber, const Node& node) const
+	{
+		Track track;
+		track.people = people;
+		track.firstFrame = track.lastFrame = frameNumber;
+		track.firstPoint = track.lastPoint = cv::Point2f{ node.x, node.y };
+		track.firstGround = track.lastGround = toGround(track.firstPoint);
+		return track;
+	}
+
+	// 要約に1フレーム分の重心を追加する
+	void advance(Track& track, const size_t frameNumber, const Node& node) const
+	{
+		const cv::Point2f point{ node.x, node.y };
+		if (frameNumber > track.lastFrame)
+		{
+			const cv::Point2f ground = toGround(point);
+			const cv::Point2f move = ground - track.lastGround;
+			track.pathLength += std::sqrt(move.x * move.x + move.y * move.y);
+			track.lastFrame = frameNumber;
+			track.lastPoint = point;
+			track.lastGround = ground;
+		}
+		else if (frameNumber < track.firstFrame)
+		{
+			// シークして戻った場合など、始点より前のフレームが後から処理された場合は始点だけ置き換える
+			track.firstFrame = frameNumber;
+			track.firstPoint = point;
+			track.firstGround = toGround(point);
+		}
+	}
+
+	// 要約を書き込む (基準線の通過は writeCrossing() で書き込むため変更しない)
+	int write(SqlOpenPose& sql, const Track& track) const
+	{
+		try
+		{
+			const std::string table = tableName(sql);
+			auto query = sql.getStatement(u8"INSERT INTO " + table + u8" (people, first_frame, last_frame, first_x, first_y, last_x, last_y, "
+				u8"first_ground_x, first_ground_y, last_ground_x, last_ground_y, path_length) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?) "
+				u8"ON CONFLICT(people) DO UPDATE SET first_frame=excluded.first_frame, last_frame=excluded.last_frame, "
+				u8"first_x=excluded.first_x, first_y=excluded.first_y, last_x=excluded.last_x, last_y=excluded.last_y, "
+				u8"first_ground_x=excluded.first_ground_x, first_ground_y=excluded.first_ground_y, "
+				u8"last_ground_x=excluded.last_ground_x, last_ground_y=excluded.last_ground_y, path_length=excluded.path_length");
+			return sql.bindAllAndExec(*query,
+				(long long)track.people, (long long)track.firstFrame, (long long)track.lastFrame,
+				track.firstPoint.x, track.firstPoint.y, track.lastPoint.x, track.lastPoint.y,
+				track.firstGround.x, track.firstGround.y, track.lastGround.x, track.lastGround.y, track.pathLength);
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+			return 1;
+		}
+	}
+
+	// SQLの1行を要約に変換する
+	static Track getTrack(SQLite::Statement& query)
+	{
+		Track track;
+		track.people = (size_t)query.getColumn(0).getInt64();
+		track.firstFrame = (size_t)query.getColumn(1).getInt64();
+		track.lastFrame = (size_t)query.getColumn(2).getInt64();
+		track.firstPoint = cv::Point2f{ (float)query.getColumn(3).getDouble(), (float)query.getColumn(4).getDouble() };
+		track.lastPoint = cv::Point2f{ (float)query.getColumn(5).getDouble(), (float)query.getColumn(6).getDouble() };
+		track.firstGround = cv::Point2f{ (float)query.getColumn(7).getDouble(), (float)query.getColumn(8).getDouble() };
+		track.lastGround = cv::Point2f{ (float)query.getColumn(9).getDouble(), (float)query.getColumn(10).getDouble() };
+		track.pathLength = (float)query.getColumn(11).getDouble();
+		track.crossing = query.getColumn(12).getInt();
+		if (!query.getColumn(13).isNull()) track.crossingFrame = (size_t)query.getColumn(13).getInt64();
+		return track;
+	}
+};
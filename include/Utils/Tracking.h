@@ -3,6 +3,7 @@
 #include <OpenPoseWrapper/MinimumOpenPose.h>
 #include <Utils/SqlOpenPose.h>
 #include <Utils/Database.h>
+#include <Utils/TrackSummary.h>
 #include <optional>
 
 class Tracking
@@ -12,27 +13,30 @@ private:
 	using Node = MinOpenPose::Node;
 
 public:
-	// (numberFramesToLost - 1)t[O猻݂̃t[܂ł̊ԂŌoꂽłVSĂ̍i
+	// (numberFramesToLost - 1)フレーム前から現在のフレームまでの間で検出された最も新しい全ての骨格
 	People currentPeople;
 
-	// 1t[OcurrentPeople̕
+	// 1フレーム前のcurrentPeopleの複製
 	People backPeople;
 
-	// currentPeoplebackPeopleɑ݂鍜i߂ĉʂɉf肱񂾂Ƃ̍i
+	// currentPeopleもしくはbackPeopleに存在する骨格が初めて画面に映りこんだときの骨格
 	People firstPeople;
 
-	// ݂̃t[Ŏ擾łSĂ̍i
+	// 現在のフレームで取得できた全ての骨格
 	People latestPeople;
 
-	// backPeopleɂ݂͑邪currentPeopleɂ݂͑ȂlSẴCfbNX
+	// backPeopleには存在するがcurrentPeopleには存在しない人全てのインデックス
 	std::vector<size_t> untrackedPeopleIndex;
 
+	// 人ごとの要約 (track_summary) 地面上の移動距離を記録する場合は summary.setGroundTransform() で変換を設定する
+	TrackSummary summary;
+
 	/**
-	 * OpenPoseł̓t[ƂɐlIDϓ邽߁ÃNXłOpenPoseœꂽĩgbLOs
-	 * @param confidenceThreshold ֐߂̐Ml̒lȉłꍇ́A֐߂݂Ȃ̂Ƃď
-	 * @param numberNodesToTrust MlconfidenceThreshold傫֐߂̐̒lłꍇ́A̐lȂ̂Ƃď
-	 * @param numberFramesToLost xgbLOOꂽl̃t[o߂ĂĔȂꍇ́ÂƂď
-	 * @param distanceThreshold gbLO̐l1t[i񂾂ƂAړ̒l傫ꍇ͓ľ₩O
+	 * OpenPoseではフレームごとに人のIDが変動するため、このクラスではOpenPoseで得られた骨格のトラッキングを行う
+	 * @param confidenceThreshold 関節の信頼値がこの値以下である場合は、関節が存在しないものとして処理する
+	 * @param numberNodesToTrust 信頼値がconfidenceThresholdより大きい関節の数がこの値未満である場合は、その人がいないものとして処理する
+	 * @param numberFramesToLost 一度トラッキングが外れた人がこのフレーム数が経過しても再発見されない場合は、消失したものとして処理する
+	 * @param distanceThreshold トラッキング中の人が1フレーム進んだとき、移動距離がこの値よりも大きい場合は同一人物の候補から外す
 	 */
 	Tracking(
 		float confidenceThreshold = 0.5f,
@@ -54,123 +58,115 @@ public:
 	virtual ~Tracking() {};
 
 	/**
-	 * gbLOɎgpe[u폜
-	 * @param sql SqlOpenPosẽCX^X
+	 * トラッキングに使用するテーブルを削除する
+	 * @param sql SqlOpenPoseのインスタンスを入れる
 	 */
 	int deleteTable(SqlOpenPose& sql)
 	{
-		sql.deleteTableIfExist(u8"people_with_tracking");
+		sql.deleteTableIfExist(sql.tableName(u8"people_with_tracking"));
+		sql.deleteTableIfExist(summary.tableName(sql));
+		return 0;
 	}
 
 	/**
-	 * gbLOs
-	 * @param sql SqlOpenPosẽCX^X
-	 * @param frameNumber ݍĐ̓̃t[ԍw肷
-	 * @param PeoplẽCX^X
+	 * トラッキングを行う
+	 * @param sql SqlOpenPoseのインスタンスを入れる
+	 * @param frameNumber 現在再生中の動画のフレーム番号を指定する
+	 * @param Peopleのインスタンスを入れる
 	 */
 	std::optional<People> tracking(const People& people, SqlOpenPose& sql, const size_t frameNumber)
 	{
-		// people_with_trackinge[u݂Ȃꍇ̓e[u𐶐
-		std::string row_title = u8"frame INTEGER, people INTEGER";
-		for (int i = 0; i < 25; i++)
-		{
-			row_title += u8", joint" + std::to_string(i) + u8"x REAL";
-			row_title += u8", joint" + std::to_string(i) + u8"y REAL";
-			row_title += u8", joint" + std::to_string(i) + u8"confidence REAL";
-		}
-		if (sql.createTableIfNoExist(u8"people_with_tracking", row_title)) return std::nullopt;
+		// people_with_trackingテーブルが存在しない場合はテーブルを生成
+		// (SQLの検索を高速化するためのIndexも作成される)
+		const std::string trackingTable = sql.tableName(u8"people_with_tracking");
+		if (sql.createPersonTableIfNoExist(trackingTable)) return std::nullopt;
+		const bool packed = sql.isPackedTable(trackingTable);
 
-		// SQĽ邽߂Index쐬
-		if (sql.createIndexIfNoExist(u8"people_with_tracking", u8"frame", false)) return std::nullopt;
-		if (sql.createIndexIfNoExist(u8"people_with_tracking", u8"people", false)) return std::nullopt;
-		if (sql.createIndexIfNoExist(u8"people_with_tracking", u8"frame", u8"people", true)) return std::nullopt;
+		// track_summaryテーブルが存在しない場合は、トラッキング済みの骨格から作成
+		if (summary.ensure(sql, trackingTable, Tracking::getJointAverage)) return std::nullopt;
 
 		try
 		{
-			// SQLKvȍi擾
+			// SQLから必要な骨格情報を取得
 			if (getPeopleFromSql(sql, frameNumber)) return std::nullopt;
 
-			// oꂽiȂΏI
+			// 検出された骨格がなければ終了
 			if (people.size() == 0) return people;
 
-			// łSQLɍif[^݂ΏI
+			// すでにSQLに骨格データが存在すれば終了
 			if (isDataExist(sql, frameNumber)) return currentPeople;
 
-			// ݂̃t[̐l[v
+			// 現在のフレームの人数分ループ
 			std::map<size_t, bool> usedIndex;
 			for (auto currentPerson = people.begin(); currentPerson != people.end(); currentPerson++)
 			{
-				// if[^̐Mx臒lł΃XLbv
+				// 骨格データの信頼度が閾値未満であればスキップ
 				auto&& currentNodes = currentPerson->second;
 				uint64_t confidenceCount = 0;
 				for (auto&& node : currentNodes) { if (node.confidence > confidenceThreshold) confidenceCount++; }
 				if (confidenceCount < numberNodesToTrust) continue;
 
-				// Ot[̒ňԋ߂l̃CfbNX擾
-				uint64_t nearestPeopleIndex = 0;  // Ot[̒ňԋ߂l̃CfbNXi[ꎞϐ
-				float nearestLength = -1.0f;  // Ot[̒ňԋ߂i[ꎞϐ
-				bool lostFlag = true;  // Ot[ňԋ߂lołȂꍇTrueɂȂtO
+				// 前フレームの中で一番距離が近かった人のインデックスを取得
+				uint64_t nearestPeopleIndex = 0;  // 前フレームの中で一番距離が近かった人のインデックスを格納する一時変数
+				float nearestLength = -1.0f;  // 前フレームの中で一番距離が近かった長さを格納する一時変数
+				bool lostFlag = true;  // 前フレームで一番距離が近かった人が検出できなかった場合にTrueになるフラグ
 
-				// Ot[̐l[v
+				// 前フレームの人数分ループ
 				for (auto backPerson = backPeople.begin(); backPerson != backPeople.end(); backPerson++)
 				{
-					uint64_t index = backPerson->first;  // CfbNX̎擾
+					uint64_t index = backPerson->first;  // インデックスの取得
 
-					if (usedIndex.count(index)) continue;  // CfbNXɎgpĂꍇ̓XLbv
+					if (usedIndex.count(index)) continue;  // インデックスが既に使用されていた場合はスキップ
 
-					auto&& backNodes = backPerson->second;  // i̎擾
+					auto&& backNodes = backPerson->second;  // 骨格情報の取得
 
-					// Ot[̈ړZo
+					// 前フレームからの移動距離を算出
 					float distance = getDistance(backNodes, currentNodes);
 
-					// ړɎZołȂAdistanceThreshold傫lłꍇ͏O
+					// 移動距離が正常に算出できなかった、もしくはdistanceThresholdより大きい値であった場合は除外
 					if ((distance < 0.0f) || (distance > distanceThreshold)) continue;
 
-					// L^XV
+					// 記録更新判定
 					if (lostFlag || (distance < nearestLength))
 					{
-						nearestPeopleIndex = index;  // ԋ߂l̃CfbNXXV
-						nearestLength = distance;  // ̋XV
-						lostFlag = false;  // tO܂
+						nearestPeopleIndex = index;  // 一番距離が近い人のインデックスを更新
+						nearestLength = distance;  // その距離を更新
+						lostFlag = false;  // フラグを折る
 					}
 				}
 
-				// Ot[ňԋ߂lołꍇ͂̐l̃CfbNX߂
+				// 前フレームで一番距離が近かった人が検出できた場合はその人のインデックスを求める
 				uint64_t addIndex = nearestPeopleIndex;
 
-				// Ot[ňԋ߂lołȂꍇ͐VCfbNX߂
+				// 前フレームで一番距離が近かった人が検出できなかった場合は新しいインデックスを求める
 				if (lostFlag)
 				{
-					// SQLɓo^ꂽl̑擾
-					SQLite::Statement peopleCountQuery(*(sql.database), "SELECT COUNT(DISTINCT people) from people_with_tracking");
-					(void)peopleCountQuery.executeStep();
-					addIndex = peopleCountQuery.getColumn(0).getInt();
+					// 現在SQLに登録された人のIDの次のIDを取得 (前のセグメントから引き継いだIDも考慮される)
+					addIndex = sql.nextPeopleId(trackingTable);
 				}
 
-				// gpς݃CfbNX֒ǉ
+				// 使用済みインデックスへ追加
 				usedIndex[addIndex] = true;
 
-				// SQL̐
-				std::string row = u8"?";
-				for (int colIndex = 0; colIndex < 76; colIndex++) row += u8", ?";
-				row = u8"INSERT INTO people_with_tracking VALUES (" + row + u8")";
-				SQLite::Statement insertQuery(*(sql.database), row);
-
-				// ݂̃t[ŌoꂽSĂ̍if[^SQLɒǋL
-				insertQuery.reset();
-				insertQuery.bind(1, (long long)frameNumber);
-				insertQuery.bind(2, (long long)addIndex);
-				for (size_t nodeIndex = 0; nodeIndex < currentNodes.size(); nodeIndex++)
-				{
-					insertQuery.bind(3 + nodeIndex * 3 + 0, (double)currentNodes[nodeIndex].x);
-					insertQuery.bind(3 + nodeIndex * 3 + 1, (double)currentNodes[nodeIndex].y);
-					insertQuery.bind(3 + nodeIndex * 3 + 2, (double)currentNodes[nodeIndex].confidence);
-				}
-				(void)insertQuery.exec();
+				// SQL文の生成
+				auto insertQuery = sql.getStatement(sql.insertPersonQuery(trackingTable));
+
+				// 現在のフレームで検出された全ての骨格データをSQLに追記
+				insertQuery->bind(1, (long long)frameNumber);
+				insertQuery->bind(2, (long long)addIndex);
+				SqlOpenPose::bindPerson(*insertQuery, 3, currentNodes, packed);
+				(void)insertQuery->exec();
+				sql.markFrame(trackingTable, frameNumber);
 			}
 
-			// ēxSQLKvȍi擾
+			// 再度SQLから必要な骨格情報を取得
 			if (getPeopleFromSql(sql, frameNumber)) return std::nullopt;
+
+			// 現在のフレームで取得できた人の要約を更新
+			if (summary.update(sql, frameNumber, getJointAverages(latestPeople))) return std::nullopt;
+
+			// 列形式のファイルにも追記する (このフレームで取得できた人だけを追記し、消失中の人の古い骨格は含めない)
+			sql.mirrorPeople(trackingTable, frameNumber, latestPeople);
 		}
 		catch (const std::exception& e)
 		{
@@ -181,12 +177,12 @@ public:
 		return currentPeople;
 	}
 
-	// w肳ꂽt[ԍ̃f[^SQLɑ݂邩ǂ
+	// 指定されたフレーム番号のデータがSQLに存在するかどうか
 	bool isDataExist(const SqlOpenPose& sql, size_t frame) const {
-		return sql.isDataExist(u8"people_with_tracking", u8"frame", frame);
+		return sql.isFrameExist(sql.tableName(u8"people_with_tracking"), frame);
 	}
 
-	// ȉdS擾
+	// 骨格の重心を取得する
 	static Node getJointAverage(const MinOpenPose::Person& person)
 	{
 		Node result{ 0.0f, 0.0f, 1.0f };
@@ -221,15 +217,15 @@ public:
 		};
 	}
 
-	// imapȉdSmapɕϊ
+	// 骨格のmapを骨格の重心のmapに変換する
 	static std::map<size_t, Node> getJointAverages(const People& people)
 	{
 		std::map<size_t, Node> result;
 
-		// SĂ̍i[v
+		// 全ての骨格分ループ
 		for (auto personItr = people.begin(); personItr != people.end(); personItr++)
 		{
-			// ȉdS߂resultɒǉ
+			// 骨格の重心を求めてresultに追加
 			result[personItr->first] = getJointAverage(personItr->second);
 		}
 
@@ -237,38 +233,33 @@ public:
 	}
 
 private:
-	// ֐߂̐Ml̒lȉłꍇ́A֐߂݂Ȃ̂Ƃď
+	// 関節の信頼値がこの値以下である場合は、関節が存在しないものとして処理する
 	float confidenceThreshold;
 
-	// MlconfidenceThreshold傫֐߂̐̒lłꍇ́A̐lȂ̂Ƃď
+	// 信頼値がconfidenceThresholdより大きい関節の数がこの値未満である場合は、その人がいないものとして処理する
 	uint64_t numberNodesToTrust;
 
-	// xgbLOOꂽl̃t[o߂ĂĔȂꍇ́ÂƂď
+	// 一度トラッキングが外れた人がこのフレーム数が経過しても再発見されない場合は、消失したものとして処理する
 	uint64_t numberFramesToLost;
 
-	// gbLO̐l1t[i񂾂ƂAړ̒l傫ꍇ͓ľ₩O
+	// トラッキング中の人が1フレーム進んだとき、移動距離がこの値よりも大きい場合は同一人物の候補から外す
 	float distanceThreshold;
 
-	// SQLɕۑĂfirstFrameNumbert[endFrameNumbert[܂ł̊ԂɌoꂽłVSĂ̍ipeopleɑ
+	// SQLに保存されているfirstFrameNumberフレームからendFrameNumberフレームまでの間に検出された最も新しい全ての骨格をpeopleに代入
 	int getLatestPeopleFromSql(const SqlOpenPose& sql, std::map<size_t, std::vector<Node>>& people, int64_t firstFrameNumber, int64_t endFrameNumber)
 	{
 		try
 		{
 			firstFrameNumber = (firstFrameNumber < 0) ? 0 : firstFrameNumber;
 			endFrameNumber = (endFrameNumber < 0) ? 0 : endFrameNumber;
-			SQLite::Statement peopleQuery(*(sql.database), u8"SELECT * FROM people_with_tracking WHERE ? <= frame AND frame <= ? GROUP BY people HAVING frame = MAX(frame)");
-			if (sql.bindAll(peopleQuery, firstFrameNumber, endFrameNumber)) return 1;
-			while (peopleQuery.executeStep())
+			const std::string trackingTable = sql.tableName(u8"people_with_tracking");
+			const bool packed = sql.isPackedTable(trackingTable);
+			auto peopleQuery = sql.getStatement(u8"SELECT * FROM " + trackingTable + u8" WHERE ? <= frame AND frame <= ? GROUP BY people HAVING frame = MAX(frame)");
+			if (sql.bindAll(*peopleQuery, firstFrameNumber, endFrameNumber)) return 1;
+			while (peopleQuery->executeStep())
 			{
-				size_t index = (size_t)peopleQuery.getColumn(1).getInt64();
-				for (int nodeIndex = 0; nodeIndex < 25; nodeIndex++)
-				{
-					people[index].push_back(Node{
-						(float)peopleQuery.getColumn(2 + nodeIndex * 3 + 0).getDouble(),
-						(float)peopleQuery.getColumn(2 + nodeIndex * 3 + 1).getDouble(),
-						(float)peopleQuery.getColumn(2 + nodeIndex * 3 + 2).getDouble()
-					});
-				}
+				size_t index = (size_t)peopleQuery->getColumn(1).getInt64();
+				people[index] = SqlOpenPose::getPerson(*peopleQuery, 2, packed);
 			}
 		}
 		catch (const std::exception& e)
@@ -280,26 +271,26 @@ private:
 		return 0;
 	}
 
-	// SQLɕۑĂfirstFrameNumbert[endFrameNumbert[܂ł̊ԂɌoꂽSĂ̍íAŏɉʂɉf̍ipeopleɑ
+	// SQLに保存されているfirstFrameNumberフレームからendFrameNumberフレームまでの間に検出された全ての骨格の、最初に画面に映った時の骨格をpeopleに代入
+	// (全ての行をGROUP BYする代わりに、track_summaryから映っていた人と最初のフレームを求める)
 	int getOldestPeopleFromSql(const SqlOpenPose& sql, std::map<size_t, std::vector<Node>>& people, int64_t firstFrameNumber, int64_t endFrameNumber)
 	{
 		try
 		{
 			firstFrameNumber = (firstFrameNumber < 0) ? 0 : firstFrameNumber;
 			endFrameNumber = (endFrameNumber < 0) ? 0 : endFrameNumber;
-			SQLite::Statement peopleQuery(*(sql.database), u8"SELECT * FROM people_with_tracking WHERE people IN (SELECT people FROM people_with_tracking WHERE ? <= frame AND frame <= ?) GROUP BY people HAVING frame=MIN(frame)");
-			if (sql.bindAll(peopleQuery, firstFrameNumber, endFrameNumber)) return 1;
-			while (peopleQuery.executeStep())
+			const std::string trackingTable = sql.tableName(u8"people_with_tracking");
+			const bool packed = sql.isPackedTable(trackingTable);
+			const std::string summaryTable = summary.tableName(sql);
+
+			// track_summaryに記録された最初のフレームの骨格を、人ごとに1行ずつ読み込む
+			auto peopleQuery = sql.getStatement(u8"SELECT t.* FROM " + summaryTable + u8" AS s JOIN " + trackingTable
+				+ u8" AS t ON t.frame = s.first_frame AND t.people = s.people WHERE ? <= s.last_frame AND s.first_frame <= ?");
+			if (sql.bindAll(*peopleQuery, firstFrameNumber, endFrameNumber)) return 1;
+			while (peopleQuery->executeStep())
 			{
-				size_t index = (size_t)peopleQuery.getColumn(1).getInt64();
-				for (int nodeIndex = 0; nodeIndex < 25; nodeIndex++)
-				{
-					people[index].push_back(Node{
-						(float)peopleQuery.getColumn(2 + nodeIndex * 3 + 0).getDouble(),
-						(float)peopleQuery.getColumn(2 + nodeIndex * 3 + 1).getDouble(),
-						(float)peopleQuery.getColumn(2 + nodeIndex * 3 + 2).getDouble()
-					});
-				}
+				size_t index = (size_t)peopleQuery->getColumn(1).getInt64();
+				people[index] = SqlOpenPose::getPerson(*peopleQuery, 2, packed);
 			}
 		}
 		catch (const std::exception& e)
@@ -311,41 +302,71 @@ private:
 		return 0;
 	}
 
-	// SQLcurrentPeople, backPeople, currentPeopleFirst, untrackedPeopleId擾
+	// targetに含まれるがpeopleに含まれない人の、トラッキングのテーブルに記録された最初の骨格をpeopleに代入
+	int getMissingOldestPeopleFromSql(const SqlOpenPose& sql, const People& target, std::map<size_t, std::vector<Node>>& people)
+	{
+		try
+		{
+			const std::string trackingTable = sql.tableName(u8"people_with_tracking");
+			const bool packed = sql.isPackedTable(trackingTable);
+			for (auto&& person : target)
+			{
+				if (people.count(person.first)) continue;
+				auto peopleQuery = sql.getStatement(u8"SELECT * FROM " + trackingTable + u8" WHERE people = ? ORDER BY frame ASC LIMIT 1");
+				if (sql.bindAll(*peopleQuery, (long long)person.first)) return 1;
+				if (peopleQuery->executeStep()) people[person.first] = SqlOpenPose::getPerson(*peopleQuery, 2, packed);
+				else people[person.first] = person.second;
+				peopleQuery->reset();
+			}
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+			return 1;
+		}
+
+		return 0;
+	}
+
+	// SQLからcurrentPeople, backPeople, currentPeopleFirst, untrackedPeopleIdを取得
 	int getPeopleFromSql(const SqlOpenPose& sql, size_t frame)
 	{
-		// 
+		// 初期化
 		backPeople.clear();
 		currentPeople.clear();
 		firstPeople.clear();
 		latestPeople.clear();
 		untrackedPeopleIndex.clear();
 
-		// numberFramesToLostt[O1t[O܂ł̊ԂŌoꂽłViSĎ擾
+		// numberFramesToLostフレーム前から1フレーム前までの間で検出された最も新しい骨格を全て取得
 		if (getLatestPeopleFromSql(
 			sql, backPeople,
 			(int64_t)frame - (int64_t)numberFramesToLost,
 			(int64_t)frame - 1
 		)) return 1;
 
-		// (numberFramesToLost - 1)t[O猻݂̃t[܂ł̊ԂŌoꂽłViSĎ擾
+		// (numberFramesToLost - 1)フレーム前から現在のフレームまでの間で検出された最も新しい骨格を全て取得
 		if (getLatestPeopleFromSql(
 			sql, currentPeople,
 			(int64_t)frame - ((int64_t)numberFramesToLost - 1),
 			(int64_t)frame
 		)) return 1;
 
-		// numberFramesToLostt[O猻݂̃t[܂ł̊ԂŌoꂽłÂiSĎ擾
+		// numberFramesToLostフレーム前から現在のフレームまでの間で検出された最も古い骨格を全て取得
 		if (getOldestPeopleFromSql(
 			sql, firstPeople,
 			(int64_t)frame - (int64_t)numberFramesToLost,
 			(int64_t)frame
 		)) return 1;
 
-		// ݂̃t[Ŏ擾łlSẴCfbNX擾
+		// track_summaryにまだ無い人 (このフレームで初めて検出された人や、セグメントの切り替えで引き継がれた人) は、トラッキングのテーブルから最初の骨格を取得
+		if (getMissingOldestPeopleFromSql(sql, currentPeople, firstPeople)) return 1;
+		if (getMissingOldestPeopleFromSql(sql, backPeople, firstPeople)) return 1;
+
+		// 現在のフレームで取得できた人全てのインデックスを取得
 		if (getLatestPeopleFromSql(sql, latestPeople, (int64_t)frame, (int64_t)frame)) return 1;
 
-		// backPeopleɂ݂͑邪currentPeopleɂ݂͑ȂlSẴCfbNX擾
+		// backPeopleには存在するがcurrentPeopleには存在しない人全てのインデックスを取得
 		for (auto backPerson = backPeople.begin(); backPerson != backPeople.end(); backPerson++)
 		{
 			if (currentPeople.count(backPerson->first) == 0) untrackedPeopleIndex.push_back(backPerson->first);
@@ -354,16 +375,16 @@ private:
 		return 0;
 	}
 
-	// 2̍i̊e֐߂̋̕ς擾(MxconfidenceThresholdȉ̊֐߂͌vZ珜O)
-	// 0.0fȏ̒lԂ
-	// SĂ̊֐߂̐MxconfidenceThresholdȉꍇ-1.0fԂ
+	// 2つの骨格の各関節の距離差の平均を取得(信頼度がconfidenceThreshold以下の関節は計算から除外される)
+	// 成功すると0.0f以上の値が返される
+	// 全ての関節の信頼度がconfidenceThreshold以下だった場合は-1.0fが返される
 	float getDistance(const std::vector<Node>& nodes1, const std::vector<Node>& nodes2)
 	{
-		uint64_t samples = 0;  // LȊ֐߂̃Tv
-		float distance = 0.0f;  // LȑS֐߂̈ړʂ̕
+		uint64_t samples = 0;  // 有効な関節のサンプル数
+		float distance = 0.0f;  // 有効な全関節の移動量の平均
 		for (uint64_t index = 0; index < nodes1.size(); index++)
 		{
-			// 臒lȉ̊֐߂͖
+			// 閾値以下の関節は無効
 			if ((nodes1[index].confidence <= confidenceThreshold) || (nodes2[index].confidence <= confidenceThreshold)) continue;
 			float x = nodes1[index].x - nodes2[index].x;
 			float y = nodes1[index].y - nodes2[index].y;
@@ -0,0 +1,327 @@
+#pragma once
+
+#include <OpenPoseWrapper/MinimumOpenPose.h>
+#include <Utils/SqlOpenPose.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+
+/**
+ * 軌跡 (trajectoryなど) を人ごとの折れ線にまとめてから描画するクラス
+ * 表示倍率ごとに折れ線を Douglas-Peucker 法で間引き、画面を一定の大きさのタイルに分けて複数のスレッドで描画する
+ * 描画したタイルは表示倍率ごとにキャッシュするため、同じ倍率で表示位置を動かしても新しく見えた部分だけが描画される
+ */
+class TrajectoryRenderer
+{
+private:
+	using Node = MinOpenPose::Node;
+
+public:
+	/**
+	 * @param tileSize タイルの大きさ (画素)
+	 * @param tolerance 折れ線を間引くときに許容するずれ (画素)
+	 * @param cacheCapacity キャッシュするタイルの数
+	 */
+	TrajectoryRenderer(const int tileSize = 256, const float tolerance = 0.5f, const size_t cacheCapacity = 1024)
+		: tileSize{ tileSize }, tolerance{ tolerance }, cacheCapacity{ cacheCapacity } {}
+
+	virtual ~TrajectoryRenderer() {};
+
+	/**
+	 * SQLから軌跡を読み込み、人ごとの折れ線にまとめる
+	 * @param sql SqlOpenPoseのインスタンス
+	 * @param tableName テーブル名
+	 * @param firstFrame 読み込む最初のフレーム番号
+	 * @param lastFrame 読み込む最後のフレーム番号 (このフレームは含まない)
+	 * @param transform 記録された座標を描画する座標 (倍率が1のときの画素) に変換する関数 (vt::ScreenToGround::plot() など)
+	 * @param maxGapFrames 同じ人でもこのフレーム数より長く途切れた場合は、別の折れ線にする
+	 * @return 成功すると 0 が返る
+	 */
+	int load(
+		SqlOpenPose& sql, const std::string& tableName, const size_t firstFrame, const size_t lastFrame,
+		const std::function<cv::Point2f(const cv::Point2f&)>& transform = {}, const size_t maxGapFrames = 30
+	)
+	{
+		clear();
+		std::map<size_t, size_t> current;  // 人のID -> 描画中の折れ線のインデックス
+		std::map<size_t, size_t> lastSeen;  // 人のID -> 最後に映ったフレーム番号
+		int ret = sql.readPointsRange(tableName, firstFrame, lastFrame, [&](size_t frameNumber, const std::map<size_t, Node>& points) {
+			for (auto&& point : points)
+			{
+				const cv::Point2f raw{ point.second.x, point.second.y };
+				const cv::Point2f p = transform ? transform(raw) : raw;
+				auto seen = lastSeen.find(point.first);
+				if ((seen == lastSeen.end()) || (frameNumber > seen->second + maxGapFrames))
+				{
+					current[point.first] = tracks.size();
+					tracks.push_back(Track{ point.first, {}, cv::Rect2f{ p.x, p.y, 0.0f, 0.0f }, {} });
+				}
+				Track& track = tracks[current[point.first]];
+				track.points.push_back(p);
+				extend(track.bounds, p);
+				lastSeen[point.first] = frameNumber;
+			}
+			return true;
+		});
+		if (ret) return ret;
+
+		for (auto&& track : tracks)
+		{
+			if (&track == &tracks.front()) bounds = track.bounds;
+			extend(bounds, track.bounds.tl());
+			extend(bounds, track.bounds.br());
+		}
+		return 0;
+	}
+
+	// 読み込んだ軌跡と、キャッシュを全て削除する
+	void clear()
+	{
+		tracks.clear();
+		tiles.clear();
+		bounds = cv::Rect2f{};
+	}
+
+	/**
+	 * 軌跡を描画する (frame に加算する)
+	 * 描画する座標は (読み込んだ座標 - origin) * 2^zoom になる
+	 * @param frame 描画先の画像 (CV_8UC3)
+	 * @param origin 画像の左上に表示する座標 (倍率が1のときの画素)
+	 * @param zoom 表示倍率の指数 (負の値は縮小)
+	 */
+	void render(cv::Mat& frame, const cv::Point2f& origin, const int zoom)
+	{
+		if (frame.empty()) return;
+		const float scale = std::pow(2.0f, (float)zoom);
+
+		// 表示範囲に含まれるタイル
+		const int left = (int)std::floor(origin.x * scale / (float)tileSize);
+		const int top = (int)std::floor(origin.y * scale / (float)tileSize);
+		const int right = (int)std::floor((origin.x * scale + (float)frame.cols) / (float)tileSize);
+		const int bottom = (int)std::floor((origin.y * scale + (float)frame.rows) / (float)tileSize);
+
+		// キャッシュが一杯であれば、表示範囲に含まれないタイルを先に削除する
+		const cv::Rect view{ left, top, right - left + 1, bottom - top + 1 };
+		if (tiles.size() + (size_t)view.area() > cacheCapacity) evict(zoom, view);
+
+		// キャッシュに無いタイルを複数のスレッドで描画する
+		std::vector<TileKey> missing;
+		for (int ty = top; ty <= bottom; ty++) for (int tx = left; tx <= right; tx++)
+		{
+			if (tiles.count(TileKey{ zoom, tx, ty }) == 0) missing.push_back(TileKey{ zoom, tx, ty });
+		}
+		cacheHits += (uint64_t)view.area() - (uint64_t)missing.size();
+		if (!missing.empty())
+		{
+			simplify(zoom);
+			std::vector<cv::Mat> rendered(missing.size());
+			parallelFor(missing.size(), [&](size_t i) { rendered[i] = renderTile(missing[i]); });
+			for (size_t i = 0; i < missing.size(); i++) tiles[missing[i]] = rendered[i];
+			renderedTiles += missing.size();
+		}
+
+		// タイルを画像に加算する
+		for (int ty = top; ty <= bottom; ty++) for (int tx = left; tx <= right; tx++)
+		{
+			const cv::Mat& tile = tiles.at(TileKey{ zoom, tx, ty });
+			const int x = tx * tileSize - (int)std::floor(origin.x * scale);
+			const int y = ty * tileSize - (int)std::floor(origin.y * scale);
+			const cv::Rect dst = cv::Rect{ x, y, tileSize, tileSize } & cv::Rect{ 0, 0, frame.cols, frame.rows };
+			if (dst.area() <= 0) continue;
+			cv::Mat roi = frame(dst);
+			roi += tile(cv::Rect{ dst.x - x, dst.y - y, dst.width, dst.height });
+		}
+	}
+
+	/**
+	 * 画像全体に軌跡全体が収まる表示位置と表示倍率を求める
+	 * @param size 画像の大きさ
+	 * @param origin 画像の左上に表示する座標
+	 * @param zoom 表示倍率の指数
+	 */
+	void fit(const cv::Size& size, cv::Point2f& origin, int& zoom) const
+	{
+		const float scaleX = (bounds.width > 0.0f) ? ((float)size.width / bounds.width) : 1.0f;
+		const float scaleY = (bounds.height > 0.0f) ? ((float)size.height / bounds.height) : 1.0f;
+		zoom = (int)std::floor(std::log2(std::min(scaleX, scaleY)));
+		origin = bounds.tl();
+	}
+
+	// 読み込んだ折れ線の数を取得
+	size_t getPolylineCount() const { return tracks.size(); }
+
+	// 読み込んだ点の数を取得
+	size_t getPointCount() const
+	{
+		size_t count = 0;
+		for (auto&& track : tracks) count += track.points.size();
+		return count;
+	}
+
+	// 描画したタイルの数を取得
+	uint64_t getRenderedTiles() const { return renderedTiles; }
+
+	// キャッシュから表示したタイルの数を取得
+	uint64_t getCacheHits() const { return cacheHits; }
+
+	// 人のIDから軌跡の色を求める (PlotTrajectory と同じ色)
+	static cv::Scalar color(const size_t id)
+	{
+		return cv::Scalar{
+			(double)((int)((std::sin(((double)id) * 463763.0) + 1.0) * 100000.0) % 120 + 80),
+			(double)((int)((std::sin(((double)id) * 1279.0) + 1.0) * 100000.0) % 120 + 80),
+			(double)((int)((std::sin(((double)id) * 92763.0) + 1.0) * 100000.0) % 120 + 80)
+		};
+	}
+
+private:
+	// 1人分の折れ線
+	struct Track
+	{
+		size_t id;
+		std::vector<cv::Point2f> points;
+		cv::Rect2f bounds;
+		std::map<int, std::vector<cv::Point2f>> simplified;  // 表示倍率の指数 -> 間引いた折れ線
+	};
+
+	// タイルの表示倍率の指数と位置
+	using TileKey = std::tuple<int, int, int>;
+
+	int tileSize;
+	float tolerance;
+	size_t cacheCapacity;
+
+	std::vector<Track> tracks;
+	cv::Rect2f bounds;
+	std::map<TileKey, cv::Mat> tiles;
+	uint64_t renderedTiles = 0, cacheHits = 0;
+
+	// 矩形を点を含むように広げる
+	static void extend(cv::Rect2f& rect, const cv::Point2f& p)
+	{
+		const float left = std::min(rect.x, p.x), top = std::min(rect.y, p.y);
+		const float right = std::max(rect.x + rect.width, p.x), bottom = std::max(rect.y + rect.height, p.y);
+		rect = cv::Rect2f{ left, top, right - left, bottom - top };
+	}
+
+	/**
+	 * キャッシュが一杯になったら、他の表示倍率のタイルから削除する (それでも一杯なら同じ表示倍率で表示範囲の外のタイルを削除する)
+	 * 表示範囲に含まれるタイルは、このフレームで使うため削除しない
+	 * @param zoom 表示倍率の指数
+	 * @param view 表示範囲に含まれるタイルの位置の範囲
+	 */
+	void evict(const int zoom, const cv::Rect& view)
+	{
+		for (auto itr = tiles.begin(); itr != tiles.end();)
+		{
+			if (std::get<0>(itr->first) != zoom) itr = tiles.erase(itr);
+			else itr++;
+		}
+		if (tiles.size() < cacheCapacity / 2) return;
+		for (auto itr = tiles.begin(); itr != tiles.end();)
+		{
+			if (!view.contains(cv::Point{ std::get<1>(itr->first), std::get<2>(itr->first) })) itr = tiles.erase(itr);
+			else itr++;
+		}
+	}
+
+	// 0からcount-1までの処理を複数のスレッドに分けて行う
+	static void parallelFor(const size_t count, const std::function<void(size_t)>& function)
+	{
+		const size_t threadCount = std::max<size_t>(1, std::min<size_t>(count, std::thread::hardware_concurrency()));
+		std::atomic<size_t> next(0);
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < threadCount; t++)
+		{
+			threads.emplace_back([&]() {
+				for (size_t i = next++; i < count; i = next++) function(i);
+			});
+		}
+		for (auto&& thread : threads) thread.join();
+	}
+
+	// 全ての折れ線を表示倍率に合わせて間引く (間引き済みの倍率は何もしない)
+	void simplify(const int zoom)
+	{
+		const float epsilon = tolerance / std::pow(2.0f, (float)zoom);
+		parallelFor(tracks.size(), [&](size_t i) {
+			Track& track = tracks[i];
+			if (track.simplified.count(zoom)) return;
+			track.simplified[zoom] = douglasPeucker(track.points, epsilon);
+		});
+	}
+
+	// Douglas-Peucker 法で、元の折れ線からのずれが epsilon 以下になるように点を間引く
+	static std::vector<cv::Point2f> douglasPeucker(const std::vector<cv::Point2f>& points, const float epsilon)
+	{
+		if (points.size() <= 2) return points;
+		std::vector<bool> keep(points.size(), false);
+		keep.front() = keep.back() = true;
+		std::vector<std::pair<size_t, size_t>> stack = { { 0, points.size() - 1 } };
+		while (!stack.empty())
+		{
+			const auto range = stack.back();
+			stack.pop_back();
+			const cv::Point2f a = points[range.first], b = points[range.second];
+			const cv::Point2f ab = b - a;
+			const float length = std::sqrt(ab.x * ab.x + ab.y * ab.y);
+
+			// 両端を結ぶ線分から最も離れた点を探す
+			float maxDistance = -1.0f;
+			size_t farthest = range.first;
+			for (size_t i = range.first + 1; i < range.second; i++)
+			{
+				const cv::Point2f ap = points[i] - a;
+				const float distance = (length > 0.0f) ? (std::abs(ab.x * ap.y - ab.y * ap.x) / length) : std::sqrt(ap.x * ap.x + ap.y * ap.y);
+				if (distance > maxDistance)
+				{
+					maxDistance = distance;
+					farthest = i;
+				}
+			}
+			if (maxDistance <= epsilon) continue;
+			keep[farthest] = true;
+			stack.push_back({ range.first, farthest });
+			stack.push_back({ farthest, range.second });
+		}
+
+		std::vector<cv::Point2f> result;
+		for (size_t i = 0; i < points.size(); i++) if (keep[i]) result.push_back(points[i]);
+		return result;
+	}
+
+	// 1枚のタイルを描画する (複数のスレッドから同時に呼ばれる)
+	cv::Mat renderTile(const TileKey& key) const
+	{
+		const int zoom = std::get<0>(key);
+		const float scale = std::pow(2.0f, (float)zoom);
+		cv::Mat tile(tileSize, tileSize, CV_8UC3, cv::Scalar{ 0, 0, 0 });
+
+		// タイルが覆う範囲 (読み込んだ座標、線の太さの分だけ広げる)
+		const float margin = 2.0f / scale;
+		const cv::Rect2f area{
+			(float)(std::get<1>(key) * tileSize) / scale - margin, (float)(std::get<2>(key) * tileSize) / scale - margin,
+			(float)tileSize / scale + margin * 2.0f, (float)tileSize / scale + margin * 2.0f
+		};
+		const cv::Point2f offset{ (float)(std::get<1>(key) * tileSize), (float)(std::get<2>(key) * tileSize) };
+
+		std::vector<cv::Point> polyline;
+		for (auto&& track : tracks)
+		{
+			const cv::Rect2f& b = track.bounds;
+			if ((b.x > area.x + area.width) || (b.x + b.width < area.x) || (b.y > area.y + area.height) || (b.y + b.height < area.y)) continue;
+			const std::vector<cv::Point2f>& points = track.simplified.at(zoom);
+			polyline.clear();
+			for (auto&& p : points) polyline.push_back(cv::Point{ (int)std::lround(p.x * scale - offset.x), (int)std::lround(p.y * scale - offset.y) });
+			cv::polylines(tile, polyline, false, color(track.id), 2);
+		}
+		return tile;
+	}
+};
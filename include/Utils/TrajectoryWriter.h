@@ -0,0 +1,157 @@
+#pragma once
+
+#include <OpenPoseWrapper/MinimumOpenPose.h>
+#include <Utils/SqlOpenPose.h>
+#include <Utils/PoseColumnFile.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+/**
+ * 軌跡 (trajectoryなど) をフレームごとに受け取り、複数フレームをまとめて書き込むクラス
+ * 書き込み先はSQL (SqlOpenPose::writePointsBatch()) か、列形式のファイル (PoseColumnWriter) を選べる
+ * シークして同じフレームを処理し直した場合など、前回書き込んだ内容と同じフレームは書き込まない
+ */
+class TrajectoryWriter
+{
+private:
+	using Node = MinOpenPose::Node;
+	using Points = std::map<size_t, Node>;
+
+	// 書き込み先 (どちらか一方のみ)
+	SqlOpenPose* sql = nullptr;
+	PoseColumnWriter* columnWriter = nullptr;
+
+	// 書き込み先のテーブル名
+	std::string tableName;
+
+	// まとめて書き込むフレーム数
+	size_t batchFrames;
+
+	// 書き込み待ちのフレーム
+	std::vector<std::pair<size_t, Points>> pending;
+
+	// 最後に書き込んだ座標のハッシュ値を覚えておくフレーム数
+	// フレーム番号を hashCapacity で割った余りの位置に記録し、同じ位置の古いフレームは上書きする (長時間の記録でもメモリが増えない)
+	static constexpr size_t hashCapacity = 65536;
+
+	// フレーム番号と、最後に書き込んだ座標のハッシュ値 (ハッシュ値が0の場合は未書き込み)
+	std::vector<std::pair<size_t, uint64_t>> frameHashes;
+
+	// 統計情報
+	uint64_t writtenFrames = 0, skippedFrames = 0;
+
+	// 座標のハッシュ値を求める (FNV-1a, 0にはならない)
+	static uint64_t hashPoints(const Points& points)
+	{
+		uint64_t hash = 14695981039346656037ULL;
+		auto add = [&hash](const void* data, size_t bytes) {
+			const uint8_t* p = (const uint8_t*)data;
+			for (size_t i = 0; i < bytes; i++) hash = (hash ^ p[i]) * 1099511628211ULL;
+		};
+		for (auto&& point : points)
+		{
+			const uint64_t index = (uint64_t)point.first;
+			add(&index, sizeof(index));
+			add(&point.second.x, sizeof(float));
+			add(&point.second.y, sizeof(float));
+		}
+		return hash | 1;
+	}
+
+public:
+	/**
+	 * SQLに書き込む
+	 * @param sql 書き込み先
+	 * @param tableName テーブル名
+	 * @param batchFrames まとめて書き込むフレーム数
+	 */
+	TrajectoryWriter(SqlOpenPose& sql, const std::string& tableName, const size_t batchFrames = 64)
+		: sql{ &sql }, tableName{ tableName }, batchFrames{ (batchFrames == 0) ? 1 : batchFrames } {}
+
+	/**
+	 * 列形式のファイルに書き込む
+	 * 列形式のファイルは追記のみのため、既に書き込んだフレーム以前のフレームの書き換えは無視される
+	 * @param columnWriter 書き込み先
+	 * @param tableName テーブル名
+	 * @param batchFrames まとめて書き込むフレーム数
+	 */
+	TrajectoryWriter(PoseColumnWriter& columnWriter, const std::string& tableName, const size_t batchFrames = 64)
+		: columnWriter{ &columnWriter }, tableName{ tableName }, batchFrames{ (batchFrames == 0) ? 1 : batchFrames } {}
+
+	virtual ~TrajectoryWriter()
+	{
+		if (flush()) std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << tableName << " : the pending frames could not be written" << std::endl;
+	}
+
+	/**
+	 * 1フレーム分の座標を書き込み待ちにする (batchFrames フレーム溜まると書き込む)
+	 * @param frameNumber フレーム番号
+	 * @param points 人のIDと座標
+	 * @return 成功すると 0 が返る
+	 */
+	int write(const size_t frameNumber, const Points& points)
+	{
+		// 前回書き込んだ内容と同じであれば書き込まない
+		const uint64_t hash = hashPoints(points);
+		if (frameHashes.empty()) frameHashes.assign(hashCapacity, { 0, 0 });
+		auto& frameHash = frameHashes[frameNumber % hashCapacity];
+		if ((frameHash.first == frameNumber) && (frameHash.second == hash))
+		{
+			skippedFrames++;
+			return 0;
+		}
+		frameHash = { frameNumber, hash };
+
+		// 書き込み待ちの中に同じフレームがあれば置き換える
+		for (auto&& item : pending)
+		{
+			if (item.first != frameNumber) continue;
+			item.second = points;
+			return 0;
+		}
+
+		pending.push_back({ frameNumber, points });
+		if (pending.size() >= batchFrames) return flush();
+		return 0;
+	}
+
+	/**
+	 * 書き込み待ちのフレームを書き込む
+	 * 失敗した場合は、次に同じ内容を受け取ったときに書き込み直すように、そのフレームのハッシュ値を消去する
+	 * @return 成功すると 0 が返る
+	 */
+	int flush()
+	{
+		if (pending.empty()) return 0;
+
+		int ret = 0;
+		if (sql != nullptr)
+		{
+			ret = sql->writePointsBatch(tableName, pending);
+		}
+		else if (columnWriter != nullptr)
+		{
+			for (auto&& item : pending) ret |= columnWriter->appendPoints(tableName, item.first, item.second);
+		}
+		if (ret)
+		{
+			for (auto&& item : pending)
+			{
+				auto& frameHash = frameHashes[item.first % hashCapacity];
+				if (frameHash.first == item.first) frameHash.second = 0;
+			}
+		}
+		else writtenFrames += pending.size();
+		pending.clear();
+		return ret;
+	}
+
+	// 書き込んだフレーム数を取得
+	uint64_t getWrittenFrames() const { return writtenFrames; }
+
+	// 前回と同じ内容だったため書き込まなかったフレーム数を取得
+	uint64_t getSkippedFrames() const { return skippedFrames; }
+};
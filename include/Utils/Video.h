@@ -2,6 +2,16 @@
 
 #include <OpenPoseWrapper/MinimumOpenPose.h>
 
+#include <filesystem>
+#include <sstream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+
 class Video
 {
 private:
@@ -9,94 +19,327 @@ private:
 	bool play_, needUpdate;
 	cv::Mat buffer;
 
+	// 開いている動画ファイルのパス
+	std::string videoPath;
+
+	// getFingerprint() で計算した指紋 (ファイルを開き直すまで使い回す)
+	std::string fingerprint;
+
+	// 次に読み込むフレームの番号 (読み込んだフレームの数) と、全フレームの枚数
+	long long position = 0;
+	size_t frameSum = 0;
+
+	// フレームごとの時刻 (ミリ秒) の索引と、それを作成するスレッド
+	// 索引は動画ファイルの隣 (動画ファイルのパス + ".seekindex") に保存し、次回からは読み込むだけにする
+	std::vector<int64_t> timeStamps;
+	std::atomic<bool> isIndexReady{ false };
+	std::atomic<bool> isIndexStopped{ false };
+	std::thread indexThread;
+
+	// この枚数以内の前方へのシークは、シークせずにフレームを読み進める
+	static constexpr long long forwardLimit = 120;
+
+	// 索引のファイルの識別子
+	static constexpr char indexMagic[8] = { 'V', 'T', 'S', 'E', 'E', 'K', '0', '1' };
+
 public:
 	struct FrameInfo{
 		size_t frameNumber, frameSum, frameTimeStamp;
 	};
 	Video() : play_(true), needUpdate(false) {}
-	virtual ~Video() {};
+	virtual ~Video() { stopIndex(); };
 
-	// t@CJ
+	// 動画ファイルを開く
 	int open(const std::string& videoPath)
 	{
-		// t@CJ
+		// 動画ファイルを開く
+		stopIndex();
 		videoCapture.open(videoPath);
+		this->videoPath = videoPath;
+		fingerprint.clear();
+		position = 0;
+		buffer = cv::Mat();
 
-		// G[̊mF
+		// エラーの確認
 		if (!videoCapture.isOpened())
 		{
-			std::cout << videoPath << "J܂łB" << std::endl;
+			std::cout << videoPath << "を開けませんでした。" << std::endl;
 			return 1;
 		}
+		frameSum = (size_t)videoCapture.get(cv::CAP_PROP_FRAME_COUNT);
+
+		// 保存済みの索引を読み込む (無ければ別のスレッドで作成する)
+		if (loadIndex() == 0) return 0;
+		isIndexStopped = false;
+		indexThread = std::thread([this]() { buildIndex(); });
 
 		return 0;
 	}
 
-	// ̎̃t[擾
+	// 動画の次のフレームを取得する
 	cv::Mat next()
 	{
 		cv::Mat ret;
 
-		// JĂȂꍇ͏I
+		// 動画を開いていない場合は処理を終了
 		if (!videoCapture.isOpened()) return ret;
 
-		// ꎞ~ԂAʂXVKvȂΈȑO擾t[Ԃ
+		// 一時停止状態かつ、画面を更新する必要がなければ以前取得したフレームを返す
 		if ((!play_) && (!needUpdate) && (!buffer.empty())) return buffer.clone();
 		needUpdate = false;
 
-		// ̃t[擾
-		videoCapture.read(ret);
+		// 次のフレームを取得
+		if (videoCapture.read(ret) && !ret.empty()) position++;
 		buffer = ret;
 
 		return ret.clone();
 	}
 
-	// ̍ĐԂ擾
+	// 動画の再生状態を取得
 	FrameInfo getInfo() const
 	{
 		FrameInfo ret;
 
-		// ݂̍Đʒu(t[P)
-		ret.frameNumber = (size_t)videoCapture.get(cv::CAP_PROP_POS_FRAMES);
+		// 現在の再生位置(フレーム単位)
+		ret.frameNumber = (size_t)position;
 		
-		// St[̖
-		ret.frameSum = (size_t)videoCapture.get(cv::CAP_PROP_FRAME_COUNT);
+		// 全フレームの枚数 (索引があれば実際に読み込めた枚数)
+		ret.frameSum = isIndexReady ? timeStamps.size() : frameSum;
 		
-		// ݂̍Đʒu(~bP)
-		ret.frameTimeStamp = (size_t)videoCapture.get(cv::CAP_PROP_POS_MSEC);
+		// 現在の再生位置(ミリ秒単位) (索引が作成されるまでは動画から取得する)
+		if (isIndexReady && (position > 0) && ((size_t)position <= timeStamps.size())) ret.frameTimeStamp = (size_t)timeStamps[(size_t)position - 1];
+		else ret.frameTimeStamp = (size_t)videoCapture.get(cv::CAP_PROP_POS_MSEC);
 
 		return ret;
 	}
 
-	// Đ
+	// 動画のフレームレートを取得 (取得できない場合は 0)
+	double getFps() const
+	{
+		return videoCapture.get(cv::CAP_PROP_FPS);
+	}
+
+	/**
+	 * 動画ファイルの指紋を取得する
+	 * ファイルサイズ、フレーム数、フレームレート、解像度と、ファイルの先頭、末尾、その間から等間隔に読み込んだバイト列のハッシュ値から生成される
+	 * デコードやシークを行わないため、デコーダーの違いに影響されず、起動時の待ち時間も短い
+	 * 同じパスのファイルが差し替えられた場合に、SQLに記録された古い結果を使わないようにするために用いる
+	 * @param samples ハッシュ値の計算に使う区間の数 (先頭と末尾を含む)
+	 * @param blockSize 1区間で読み込むバイト数
+	 * @return 指紋を表す文字列 (動画を開いていない場合は空文字列)
+	 */
+	std::string getFingerprint(int samples = 8, const size_t blockSize = 64 * 1024)
+	{
+		if (!fingerprint.empty()) return fingerprint;
+		if (!videoCapture.isOpened()) return fingerprint;
+		samples = std::max(2, samples);
+
+		// ファイルサイズ
+		std::error_code ec;
+		const uintmax_t fileSize = std::filesystem::file_size(videoPath, ec);
+
+		// 先頭と末尾 (コンテナのヘッダーや索引が置かれる) と、その間を等間隔に読み込んでハッシュ値を計算する
+		uint64_t hash = 14695981039346656037ULL;  // FNV-1a
+		std::ifstream file(videoPath, std::ios::binary);
+		std::vector<char> block(blockSize);
+		const uintmax_t lastOffset = (!ec && (fileSize > blockSize)) ? (fileSize - blockSize) : 0;
+		for (int i = 0; (i < samples) && file; i++)
+		{
+			file.seekg((std::streamoff)(lastOffset * (uintmax_t)i / (uintmax_t)(samples - 1)));
+			file.read(block.data(), (std::streamsize)block.size());
+			const std::streamsize count = file.gcount();
+			for (std::streamsize j = 0; j < count; j++)
+			{
+				hash ^= (uint64_t)(uint8_t)block[(size_t)j];
+				hash *= 1099511628211ULL;
+			}
+			file.clear();
+		}
+
+		std::ostringstream ss;
+		ss << fileSize << u8":" << (size_t)videoCapture.get(cv::CAP_PROP_FRAME_COUNT)
+			<< u8":" << videoCapture.get(cv::CAP_PROP_FPS)
+			<< u8":" << (int)videoCapture.get(cv::CAP_PROP_FRAME_WIDTH) << u8"x" << (int)videoCapture.get(cv::CAP_PROP_FRAME_HEIGHT)
+			<< u8":" << std::hex << std::setw(16) << std::setfill('0') << hash;
+		fingerprint = ss.str();
+		return fingerprint;
+	}
+
+	// 動画を再生する
 	void play() { play_ = true; }
 	
-	// ꎞ~
+	// 動画を一時停止する
 	void pause() { play_ = false; }
 
-	// 悪ĐԂǂ
+	// 動画が再生状態かどうか
 	bool isPlay() const { return (videoCapture.isOpened() && (play_)); }
 
-	// ̍Đʒuw̃t[ԍ܂ňړ
+	// 動画の再生位置を指定のフレーム番号まで移動する
 	void seekAbsolute(long long frame)
 	{
-		if (videoCapture.isOpened())
+		if (!videoCapture.isOpened()) return;
+		const long long sum = (long long)(isIndexReady ? timeStamps.size() : frameSum);
+		if (frame >= sum) frame = sum - 1;
+		if (frame < 0) frame = 0;
+		needUpdate = true;
+
+		// 近い前方へのシークは、フレームを読み進めるだけにする
+		if ((frame >= position) && (frame - position <= forwardLimit))
+		{
+			skip(frame - position);
+			return;
+		}
+
+		// 索引が無い場合は動画の機能でシークする
+		if (!isIndexReady)
 		{
-			size_t frameSum = (size_t)videoCapture.get(cv::CAP_PROP_FRAME_COUNT);
-			if (frame < 0) frame = 0;
-			if (frame >= frameSum) frame = frameSum - 1;
-			videoCapture.set(CV_CAP_PROP_POS_FRAMES, (double)frame);
-			needUpdate = true;
+			videoCapture.set(cv::CAP_PROP_POS_FRAMES, (double)frame);
+			position = (long long)videoCapture.get(cv::CAP_PROP_POS_FRAMES);
+			return;
 		}
+
+		// 目標より手前にシークし、読み込んだフレームの時刻から実際の位置を索引で求めてから目標まで読み進める
+		// (シークした位置が目標を越えていた場合は、さらに手前からやり直す)
+		long long margin = 30;
+		while (true)
+		{
+			const long long anchor = std::max(0LL, frame - margin);
+			videoCapture.set(cv::CAP_PROP_POS_FRAMES, (double)anchor);
+			if (!videoCapture.grab()) break;
+			const long long landed = findFrame((int64_t)videoCapture.get(cv::CAP_PROP_POS_MSEC)) + 1;
+			if (landed <= frame)
+			{
+				position = landed;
+				skip(frame - position);
+				return;
+			}
+			if (anchor == 0) break;
+			margin *= 4;
+		}
+
+		// 最初のフレームより手前に戻れない場合やシークに失敗した場合は、最初から読み直す
+		videoCapture.set(cv::CAP_PROP_POS_FRAMES, 0.0);
+		position = 0;
+		skip(frame);
 	}
 
-	// ̍Đʒuw肵t[ړ
+	// 動画の再生位置を指定したフレーム数分移動する
 	void seekRelative(long long frame)
 	{
 		if (videoCapture.isOpened())
 		{
-			long long frameNumber = (size_t)videoCapture.get(cv::CAP_PROP_POS_FRAMES);
-			seekAbsolute(frameNumber + frame);
+			seekAbsolute(position + frame);
+		}
+	}
+
+	// フレームごとの時刻の索引が使えるかどうか
+	bool hasIndex() const { return isIndexReady; }
+
+	/**
+	 * 索引の作成が終わるまで待つ (索引が無いと seekAbsolute() の遠いシークは動画の機能に頼るため、位置が正確でない場合がある)
+	 * @return 索引が使える場合は true が返る (作成に失敗した場合は false)
+	 */
+	bool waitIndex()
+	{
+		if (indexThread.joinable()) indexThread.join();
+		return isIndexReady;
+	}
+
+private:
+	// 画像を取り出さずに指定した枚数のフレームを読み進める
+	void skip(long long frames)
+	{
+		for (; frames > 0; frames--)
+		{
+			if (!videoCapture.grab()) break;
+			position++;
 		}
 	}
+
+	// 時刻から、そのフレームの番号を索引で求める (最も近い時刻のフレーム)
+	long long findFrame(const int64_t timeStamp) const
+	{
+		auto itr = std::lower_bound(timeStamps.begin(), timeStamps.end(), timeStamp);
+		if (itr == timeStamps.end()) return (long long)timeStamps.size() - 1;
+		if ((itr != timeStamps.begin()) && (timeStamp - *(itr - 1) < *itr - timeStamp)) itr--;
+		return (long long)(itr - timeStamps.begin());
+	}
+
+	// 索引が作成済みの動画ファイルと同じものかを確認するための値 (ファイルサイズと更新日時)
+	std::pair<uint64_t, int64_t> getFileStamp() const
+	{
+		std::error_code ec;
+		const uint64_t size = (uint64_t)std::filesystem::file_size(videoPath, ec);
+		const int64_t time = (int64_t)std::filesystem::last_write_time(videoPath, ec).time_since_epoch().count();
+		return { size, time };
+	}
+
+	// 保存済みの索引を読み込む
+	int loadIndex()
+	{
+		std::ifstream file(videoPath + u8".seekindex", std::ios::binary);
+		if (!file) return 1;
+
+		char magic[sizeof(indexMagic)];
+		uint64_t size = 0, count = 0;
+		int64_t time = 0;
+		file.read(magic, sizeof(magic));
+		file.read((char*)&size, sizeof(size));
+		file.read((char*)&time, sizeof(time));
+		file.read((char*)&count, sizeof(count));
+		if (!file || (std::memcmp(magic, indexMagic, sizeof(indexMagic)) != 0)) return 1;
+		if (std::make_pair(size, time) != getFileStamp()) return 1;
+
+		// 壊れた索引で巨大な配列を確保しないように、残りのバイト数と枚数が一致することを確認する
+		const std::streamoff header = file.tellg();
+		file.seekg(0, std::ios::end);
+		const std::streamoff remaining = file.tellg() - header;
+		file.seekg(header);
+		if (!file || (remaining < 0) || (count != (uint64_t)remaining / sizeof(int64_t)) || ((uint64_t)remaining % sizeof(int64_t) != 0)) return 1;
+
+		std::vector<int64_t> loaded((size_t)count);
+		file.read((char*)loaded.data(), (std::streamsize)(sizeof(int64_t) * loaded.size()));
+		if (!file) return 1;
+
+		timeStamps.swap(loaded);
+		isIndexReady = true;
+		return 0;
+	}
+
+	// 動画を最初から最後まで読み進めて索引を作成し、保存する
+	void buildIndex()
+	{
+		cv::VideoCapture scanner(videoPath);
+		if (!scanner.isOpened()) return;
+		std::vector<int64_t> scanned;
+		scanned.reserve(std::min<size_t>(frameSum, 1 << 24));
+		while (!isIndexStopped && scanner.grab()) scanned.push_back((int64_t)scanner.get(cv::CAP_PROP_POS_MSEC));
+		if (isIndexStopped) return;
+
+		// 保存できなくても (書き込み禁止のフォルダなど) 索引は使う
+		std::ofstream file(videoPath + u8".seekindex", std::ios::binary | std::ios::trunc);
+		if (file)
+		{
+			const auto stamp = getFileStamp();
+			const uint64_t count = (uint64_t)scanned.size();
+			file.write(indexMagic, sizeof(indexMagic));
+			file.write((const char*)&stamp.first, sizeof(stamp.first));
+			file.write((const char*)&stamp.second, sizeof(stamp.second));
+			file.write((const char*)&count, sizeof(count));
+			file.write((const char*)scanned.data(), (std::streamsize)(sizeof(int64_t) * scanned.size()));
+		}
+
+		// isIndexReady が true になるまで、処理側のスレッドは timeStamps を参照しない
+		timeStamps.swap(scanned);
+		isIndexReady = true;
+	}
+
+	// 索引を作成するスレッドを止めて、索引を破棄する
+	void stopIndex()
+	{
+		isIndexStopped = true;
+		if (indexThread.joinable()) indexThread.join();
+		isIndexReady = false;
+		timeStamps.clear();
+	}
 };
\ No newline at end of file
@@ -12,8 +12,17 @@ private:
 	cv::Point mouse;
 	bool isClicked;
 
+	// 最後に描画したときの状態 (変化が無ければ描き直さない)
+	bool isDrawn = false;
+	cv::Point drawnMouse;
+	int drawnFrameNumber = -1, drawnFrameSum = -1;
+	bool drawnPlaying = false;
+
 public:
-	VideoControllerUI() : uiWindow("Video Controll Panel"), ui(120, 360, CV_8UC3), mouse(0, 0), isClicked(false)
+	/**
+	 * @param display 表示を行うスレッド (nullptr の場合は showUI() を呼んだスレッドで表示する)
+	 */
+	VideoControllerUI(DisplayThread* display = nullptr) : uiWindow("Video Controll Panel", display), ui(120, 360, CV_8UC3), mouse(0, 0), isClicked(false)
 	{
 		uiWindow.addMouseEventListener([&](int event, int x, int y) {
 			if (event == cv::EVENT_LBUTTONDOWN) { isClicked = true; }
@@ -24,25 +33,25 @@ public:
 	virtual ~VideoControllerUI() {};
 
 	/**
-	 * EBhEɃV[gJbgL[ǉ
-	 * @param previewWindow V[gJbgL[ǉPreview̃CX^X
+	 * ウィンドウにショートカットキーを追加する
+	 * @param previewWindow ショートカットキーを追加するPreviewのインスタンス
 	 * @note
-	 * PreviewwithoutKeyWaitfalseɎw肳ĂEBhEw肵ĂB
-	 * ȉ͂̊֐ŒǉV[gJbgꗗłB
-	 * - 'j' : 30t[߂
-	 * - 'k' : 30t[i
-	 * - Xy[XL[ : Đ / ꎞ~
+	 * PreviewはwithoutKeyWaitがfalseに指定されているウィンドウを指定してください。
+	 * 以下はこの関数で追加されるショートカット一覧です。
+	 * - 'j' : 30フレーム戻る
+	 * - 'k' : 30フレーム進む
+	 * - スペースキー : 再生 / 一時停止
 	 */
 	void addShortcutKeys(Preview& previewWindow, Video& video)
 	{
 		previewWindow.addKeyboardEventListener([&](int key) {
-			// JL[30t[߂
+			// Jキーで30フレーム戻る
 			if ('j' == key) video.seekRelative(-31);
 
-			// KL[30t[i
+			// Kキーで30フレーム進む
 			if ('k' == key) video.seekRelative(29);
 
-			// Xy[XL[ Đ / ꎞ~
+			// スペースキーで 再生 / 一時停止
 			if (32 == key)
 			{
 				if (video.isPlay()) video.pause();
@@ -52,12 +61,12 @@ public:
 	}
 
 	/**
-	 * UIEBhẺʍXV
-	 * @param video VideõCX^X
+	 * UIウィンドウの画面更新
+	 * @param video Videoのインスタンス
 	 */
 	void showUI(Video& video)
 	{
-		// Đ̎擾
+		// 再生情報の取得
 		auto videoInfo = video.getInfo();
 		double progress = 0;
 		if (videoInfo.frameSum >= 2)
@@ -65,14 +74,21 @@ public:
 			progress = (int)videoInfo.frameNumber / (double)(videoInfo.frameSum - 1);
 		}
 
-		// ʂ̏
-		ui = cv::Mat(120, 360, CV_8UC3, cv::Scalar(255, 255, 255));
+		// 表示を行うスレッドから届いたマウスイベントを処理する
+		uiWindow.poll();
+
+		// 再生位置、再生状態、マウス座標が変わっておらず、クリックもされていなければ描き直さない
+		if (isDrawn && !isClicked && (mouse == drawnMouse) && ((int)videoInfo.frameNumber == drawnFrameNumber)
+			&& ((int)videoInfo.frameSum == drawnFrameSum) && (video.isPlay() == drawnPlaying)) return;
+
+		// 画面の初期化
+		ui.setTo(cv::Scalar(255, 255, 255));
 
-		// ꎞϐ
+		// 一時変数
 		cv::Rect area;
 		cv::Point points[3];
 
-		// 30t[߂{^̕\
+		// 30フレーム戻るボタンの表示
 		area = { 90, 0, 60, 60 };
 		if (area.contains(mouse))
 		{
@@ -85,7 +101,7 @@ public:
 		cv::fillConvexPoly(ui, points, 3, { 180, 0, 120 });
 		cv::rectangle(ui, { area.x + 20, area.y + 15, 5, 30 }, { 180, 0, 120 }, -1);
 
-		// Đ / ꎞ~ {^̕\
+		// 再生 / 一時停止 ボタンの表示
 		area.x += 60;
 		if (area.contains(mouse))
 		{
@@ -109,7 +125,7 @@ public:
 			cv::fillConvexPoly(ui, points, 3, { 180, 0, 120 });
 		}
 		
-		// 30t[iރ{^̕\
+		// 30フレーム進むボタンの表示
 		area.x += 60;
 		if (area.contains(mouse))
 		{
@@ -122,7 +138,7 @@ public:
 		cv::fillConvexPoly(ui, points, 3, { 180, 0, 120 });
 		cv::rectangle(ui, { area.x + 35, area.y + 15, 5, 30 }, { 180, 0, 120 }, -1);
 
-		// Đʒu\vOXo[\
+		// 再生位置を表すプログレスバーを表示
 		area = { 0, 82, 360, 16 };
 		cv::rectangle(ui, { area.x + 30, area.y + (area.height / 2) - 2, area.width - 60, 4 }, { 180, 180, 180 }, -1);
 		if (area.contains(mouse))
@@ -136,10 +152,15 @@ public:
 		}
 		cv::circle(ui, { area.x + 30 + (int)((double)(area.width - 60) * progress), area.y + (area.height / 2) }, 8, { 180, 0, 120 }, -1);
 
-		// EBhEɕ`
+		// ウィンドウに描画
 		uiWindow.preview(ui, 0, true);
+		isDrawn = true;
+		drawnMouse = mouse;
+		drawnFrameNumber = (int)videoInfo.frameNumber;
+		drawnFrameSum = (int)videoInfo.frameSum;
+		drawnPlaying = video.isPlay();
 
-		// NbNԂɖ߂
+		// クリック状態を元に戻す
 		isClicked = false;
 	}
 };
\ No newline at end of file
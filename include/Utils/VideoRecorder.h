@@ -0,0 +1,328 @@
+#pragma once
+
+#include <OpenPoseWrapper/MinimumOpenPose.h>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+
+/**
+ * 描画済みのフレームを動画ファイルに保存するクラス
+ * write() はフレームを複製して上限付きのキューに入れるだけで、縮小とエンコードは専用のスレッドで行う
+ * キューが一杯の場合はフレームを捨てる (解析の処理を待たせない)
+ * 全てのフレームを1つのファイルに保存するほかに、trigger() で指定した時刻の前後だけを別々のファイルに保存することもできる
+ */
+class VideoRecorder
+{
+public:
+	/**
+	 * @param queueCapacity キューに溜めておけるフレームの数
+	 */
+	VideoRecorder(const size_t queueCapacity = 60) : queueCapacity{ std::max<size_t>(1, queueCapacity) } {}
+
+	virtual ~VideoRecorder() { close(); }
+
+	/**
+	 * 全てのフレームを1つのファイルに保存する
+	 * @param path 保存する動画ファイルのパス
+	 * @param fps 入力するフレームのフレームレート
+	 * @param scale 保存する解像度の倍率
+	 * @param frameStep このフレーム数ごとに1フレームを保存する (保存する動画のフレームレートは fps / frameStep になる)
+	 * @param fourcc 動画のコーデック
+	 * @return 成功すると 0 が返る
+	 */
+	int open(const std::string& path, const double fps, const double scale = 1.0, const int frameStep = 1, const int fourcc = cv::VideoWriter::fourcc('m', 'p', '4', 'v'))
+	{
+		return start(path, false, fps, scale, frameStep, fourcc, 0, 0);
+	}
+
+	/**
+	 * trigger() で指定した時刻の前後だけを保存する (1回の通過ごとに1つのファイルになり、前後が重なる場合は1つにまとめる)
+	 * 保存するファイルのパスは「pathPrefix_最初のフレームの時刻.mp4」になる
+	 * @param pathPrefix 保存する動画ファイルのパスの先頭
+	 * @param fps 入力するフレームのフレームレート
+	 * @param beforeMillis trigger() の時刻の何ミリ秒前から保存するか
+	 * @param afterMillis trigger() の時刻の何ミリ秒後まで保存するか
+	 * @param scale 保存する解像度の倍率
+	 * @param frameStep このフレーム数ごとに1フレームを保存する
+	 * @param fourcc 動画のコーデック
+	 * @return 成功すると 0 が返る
+	 */
+	int openClips(const std::string& pathPrefix, const double fps, const int64_t beforeMillis = 3000, const int64_t afterMillis = 3000,
+		const double scale = 1.0, const int frameStep = 1, const int fourcc = cv::VideoWriter::fourcc('m', 'p', '4', 'v'))
+	{
+		return start(pathPrefix, true, fps, scale, frameStep, fourcc, beforeMillis, afterMillis);
+	}
+
+	/**
+	 * フレームを保存する (キューに入れるだけで、エンコードを待たない)
+	 * @param frame 保存するフレーム (複製して保持するため、呼び出し後に書き換えても良い)
+	 * @param timeStamp フレームの時刻 (ミリ秒)
+	 * @return キューが一杯でフレームを捨てた場合は false が返る (frameStep で間引いたフレームは true)
+	 */
+	bool write(const cv::Mat& frame, const int64_t timeStamp)
+	{
+		if (frame.empty() || !recorderThread.joinable()) return true;
+		if ((frameCount++ % (uint64_t)frameStep) != 0) return true;
+
+		// 複製はロックの外で行い、キューの空きの確認と追加は1回のロックの中で行う (確認してから追加するまでに上限を超えないようにする)
+		Item item;
+		item.frame = frame.clone();
+		item.timeStamp = timeStamp;
+		{
+			std::lock_guard<std::mutex> lock(recorderMutex);
+			if (queue.size() >= queueCapacity)
+			{
+				droppedFrames++;
+				return false;
+			}
+			queue.push_back(std::move(item));
+		}
+		recorderCondition.notify_one();
+		return true;
+	}
+
+	/**
+	 * 指定した時刻の前後を保存する (openClips() で開いた場合のみ)
+	 * フレームと同じキューに入れるが、画像を持たないためフレームの上限とは別に triggerCapacity 個までとする
+	 * @param timeStamp 保存する区間の中心となる時刻 (ミリ秒)
+	 * @return 溜まっている指定が多すぎて捨てた場合は false が返る
+	 */
+	bool trigger(const int64_t timeStamp)
+	{
+		if (!isClipMode || !recorderThread.joinable()) return true;
+		Item item;
+		item.isTrigger = true;
+		item.timeStamp = timeStamp;
+		{
+			std::lock_guard<std::mutex> lock(recorderMutex);
+			if (queuedTriggers >= triggerCapacity)
+			{
+				droppedTriggers++;
+				return false;
+			}
+			queuedTriggers++;
+			queue.push_back(item);
+		}
+		recorderCondition.notify_one();
+		return true;
+	}
+
+	// キューに残っているフレームを全て保存してからファイルを閉じる
+	void close()
+	{
+		if (!recorderThread.joinable()) return;
+		{
+			std::lock_guard<std::mutex> lock(recorderMutex);
+			isRecorderStopped = true;
+		}
+		recorderCondition.notify_all();
+		recorderThread.join();
+	}
+
+	// 保存したフレームの数
+	uint64_t getWrittenFrames() const { return writtenFrames; }
+
+	// キューが一杯で捨てたフレームの数
+	uint64_t getDroppedFrames() const
+	{
+		std::lock_guard<std::mutex> lock(recorderMutex);
+		return droppedFrames;
+	}
+
+	// 溜まっている指定が多すぎて捨てた trigger() の数
+	uint64_t getDroppedTriggers() const
+	{
+		std::lock_guard<std::mutex> lock(recorderMutex);
+		return droppedTriggers;
+	}
+
+private:
+	// キューに入れるフレーム、または保存する区間の指定
+	struct Item
+	{
+		cv::Mat frame;
+		int64_t timeStamp = 0;
+		bool isTrigger = false;
+	};
+
+	size_t queueCapacity;
+
+	// キューと、まだフレームが届いていない時刻の指定のそれぞれに溜めておける trigger() の数
+	static constexpr size_t triggerCapacity = 256;
+
+	// 保存の設定
+	std::string path;
+	bool isClipMode = false;
+	double fps = 30.0, scale = 1.0;
+	int frameStep = 1, fourcc = 0;
+	int64_t beforeMillis = 0, afterMillis = 0;
+	uint64_t frameCount = 0;
+
+	// 保存を行うスレッドと、その停止の通知
+	std::thread recorderThread;
+	mutable std::mutex recorderMutex;
+	std::condition_variable recorderCondition;
+	bool isRecorderStopped = false;
+	std::deque<Item> queue;
+	uint64_t droppedFrames = 0;
+	size_t queuedTriggers = 0;  // キューにある時刻の指定の数
+	uint64_t droppedTriggers = 0;
+
+	// 以下は保存を行うスレッドだけが使う
+	cv::VideoWriter writer;
+	std::deque<Item> preRoll;  // 区間の前に保存するために取っておく直前のフレーム
+	int64_t clipEnd = -1;  // 保存中の区間の終わりの時刻 (保存中でない場合は -1)
+	int64_t lastTimeStamp = 0;  // 最後に届いたフレームの時刻
+	std::vector<int64_t> pendingTriggers;  // まだフレームが届いていない時刻の指定
+	std::atomic<uint64_t> writtenFrames{ 0 };
+
+	int start(const std::string& path, const bool isClipMode, const double fps, const double scale, const int frameStep, const int fourcc,
+		const int64_t beforeMillis, const int64_t afterMillis)
+	{
+		close();
+		if ((fps <= 0.0) || (scale <= 0.0) || (frameStep < 1))
+		{
+			std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << "invalid recorder settings" << std::endl;
+			return 1;
+		}
+		this->path = path;
+		this->isClipMode = isClipMode;
+		this->fps = fps;
+		this->scale = scale;
+		this->frameStep = frameStep;
+		this->fourcc = fourcc;
+		this->beforeMillis = beforeMillis;
+		this->afterMillis = afterMillis;
+		frameCount = 0;
+		droppedFrames = 0;
+		queuedTriggers = 0;
+		droppedTriggers = 0;
+		writtenFrames = 0;
+		isRecorderStopped = false;
+		queue.clear();
+		preRoll.clear();
+		pendingTriggers.clear();
+		clipEnd = -1;
+		lastTimeStamp = 0;
+
+		recorderThread = std::thread([this]() { run(); });
+		return 0;
+	}
+
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(recorderMutex);
+		while (true)
+		{
+			recorderCondition.wait(lock, [this]() { return isRecorderStopped || !queue.empty(); });
+			if (queue.empty()) break;
+			Item item = queue.front();
+			queue.pop_front();
+			if (item.isTrigger)
+			{
+				queuedTriggers--;
+				if (pendingTriggers.size() >= triggerCapacity)
+				{
+					droppedTriggers++;
+					continue;
+				}
+			}
+
+			// エンコードしている間もキューに入れられるようにする
+			lock.unlock();
+			if (item.isTrigger) pendingTriggers.push_back(item.timeStamp);
+			else process(item);
+			lock.lock();
+		}
+		lock.unlock();
+		writer.release();
+	}
+
+	void process(Item& item)
+	{
+		// 保存する解像度に縮小する
+		if (scale != 1.0)
+		{
+			cv::Mat resized;
+			cv::resize(item.frame, resized, cv::Size{ std::max(1, (int)(item.frame.cols * scale)), std::max(1, (int)(item.frame.rows * scale)) }, 0, 0, cv::INTER_AREA);
+			item.frame = resized;
+		}
+
+		if (!isClipMode)
+		{
+			if (!writer.isOpened() && openWriter(path, item.frame)) return;
+			writer.write(item.frame);
+			writtenFrames++;
+			return;
+		}
+
+		// 時刻が戻った場合 (シークした場合など) は直前のフレームと保存中の区間を終わらせる
+		if (item.timeStamp < lastTimeStamp)
+		{
+			preRoll.clear();
+			pendingTriggers.clear();
+			writer.release();
+			clipEnd = -1;
+		}
+		lastTimeStamp = item.timeStamp;
+
+		// 届いたフレームの時刻までの指定で、保存する区間を開始または延長する
+		for (auto itr = pendingTriggers.begin(); itr != pendingTriggers.end();)
+		{
+			if (*itr > item.timeStamp)
+			{
+				itr++;
+				continue;
+			}
+			if (clipEnd < 0)
+			{
+				// 区間の始まりより前のフレームを捨ててから、新しいファイルに直前のフレームを保存する
+				while (!preRoll.empty() && (preRoll.front().timeStamp < *itr - beforeMillis)) preRoll.pop_front();
+				const cv::Mat& first = preRoll.empty() ? item.frame : preRoll.front().frame;
+				const int64_t firstTime = preRoll.empty() ? item.timeStamp : preRoll.front().timeStamp;
+				if (openWriter(path + u8"_" + std::to_string(firstTime) + u8".mp4", first) == 0)
+				{
+					for (auto&& frame : preRoll) { writer.write(frame.frame); writtenFrames++; }
+				}
+				preRoll.clear();
+			}
+			clipEnd = std::max(clipEnd, *itr + afterMillis);
+			itr = pendingTriggers.erase(itr);
+		}
+
+		// 保存中の区間に含まれるフレームを保存し、区間が終わったらファイルを閉じる
+		if (clipEnd >= 0)
+		{
+			if (item.timeStamp <= clipEnd)
+			{
+				if (writer.isOpened()) { writer.write(item.frame); writtenFrames++; }
+				return;
+			}
+			writer.release();
+			clipEnd = -1;
+		}
+
+		// 次の区間のために直前のフレームを取っておく
+		preRoll.push_back(item);
+		while (!preRoll.empty() && (preRoll.front().timeStamp < item.timeStamp - beforeMillis)) preRoll.pop_front();
+	}
+
+	int openWriter(const std::string& filePath, const cv::Mat& frame)
+	{
+		writer.release();
+		writer.open(filePath, fourcc, fps / (double)frameStep, cv::Size{ frame.cols, frame.rows }, frame.channels() == 3);
+		if (!writer.isOpened())
+		{
+			std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << filePath << " could not be opened" << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+};
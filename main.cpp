@@ -1,12 +1,17 @@
 #include <OpenPoseWrapper/MinimumOpenPose.h>
 #include <Utils/Video.h>
 #include <Utils/Preview.h>
+#include <Utils/DisplayThread.h>
 #include <Utils/VideoControllerUI.h>
 #include <Utils/PlotInfo.h>
+#include <Utils/Overlay.h>
 #include <Utils/SqlOpenPose.h>
+#include <Utils/TrajectoryWriter.h>
 #include <Utils/Tracking.h>
 #include <Utils/PeopleCounter.h>
 #include <Utils/Vector.h>
+#include <Utils/Heatmap.h>
+#include <Utils/TrackAnalytics.h>
 
 using People = MinOpenPose::People;
 using Person = MinOpenPose::Person;
@@ -27,7 +32,7 @@ int main(int argc, char* argv[])
 	// 入出力するsqlファイルのフルパス
 	std::string sqlPath = videoPath + ".sqlite3";
 
-	// openposeのラッパークラス
+	// openposeのラッパークラス (姿勢推定が必要になるまで OpenPose は起動しない)
 	MinOpenPose openpose;
 
 	// 動画を読み込むクラス
@@ -35,8 +40,11 @@ int main(int argc, char* argv[])
 	ret = video.open(videoPath);
 	if (ret) return ret;
 
+	// ウィンドウの表示とキー入力の待機を別スレッドで行うクラス (処理のフレームレートに関係なく30fpsで表示を更新する)
+	DisplayThread display(30.0);
+
 	// プレビューウィンドウを生成するクラス
-	Preview preview("result");
+	Preview preview("result", &display);
 
 	// 画面のクリックでコンソールに座標を出力する
 	preview.onClick([](int x, int y) { std::cout << x << ", " << y << std::endl; });
@@ -45,11 +53,27 @@ int main(int argc, char* argv[])
 	PlotFrameInfo plotFrameInfo;
 	PlotTrajectory plotTrajectory;
 
+	// 骨格やIDなどの描画をまとめて映像に合成するクラス
+	Overlay overlay;
+
 	// SQLファイルの読み込み、書き込みを行うクラス
 	SqlOpenPose sql;
 	ret = sql.open(sqlPath, 300);
 	if (ret) return ret;
 
+	// 動画と姿勢推定の設定の組み合わせごとに、結果を保存するテーブルを切り替える
+	ret = sql.selectConfig(video.getFingerprint(), openpose);
+	if (ret) return ret;
+
+	// 記録済みのフレームを別スレッドで先読みする (シークや記録済みの区間の再生を速くする)
+	sql.enablePrefetch(300);
+
+	// 解析済みのフレーム数と、解析されていない区間の数を表示する
+	const auto& coverage = sql.coverage(sql.tableName(u8"timestamp"));
+	const size_t frameSum = video.getInfo().frameSum;
+	std::cout << "analyzed frames : " << coverage.count() << " / " << frameSum
+		<< " (" << coverage.missingRanges(0, frameSum).size() << " missing ranges)" << std::endl;
+
 	// 骨格をトラッキングするクラス
 	Tracking tracker(
 		0.5f,  // 関節の信頼値がこの値以下である場合は、関節が存在しないものとして処理する
@@ -61,6 +85,9 @@ int main(int argc, char* argv[])
 	// 通行人をカウントするクラス
 	PeopleCounter count(200, 250, 500, 250, 100);
 
+	// 現実座標での軌跡を複数フレームまとめてSQLに書き込むクラス
+	TrajectoryWriter trajectoryWriter(sql, sql.tableName(u8"trajectory"));
+
 	// 射影変換をするクラス
 	vt::ScreenToGround screenToGround;
 
@@ -99,8 +126,19 @@ int main(int argc, char* argv[])
 		2.334, 1.800
 	);
 
+	// 地面上で人がいたフレーム数を1時間ごとに積算するクラス (地面上の範囲 (-1, -1) から (4, 4) を 100x100 のグリッドに分ける)
+	Heatmap heatmap(cv::Rect2f{ -1.0f, -1.0f, 5.0f, 5.0f }, 100, 100);
+	size_t heatmapFrame = 0;  // 積算済みの最後のフレーム番号 (シークして戻った場合に同じフレームを積算しないため)
+
+	// 人ごとの速度、移動距離、ゾーンの滞在時間を計算し、1分ごとにヒストグラムをSQLに書き込むクラス
+	TrackAnalytics analytics;
+	analytics.addZone(u8"center", { { 0.0f, 0.0f }, { 2.334f, 0.0f }, { 2.334f, 1.800f }, { 0.0f, 1.800f } });
+
+	// 人ごとの要約 (track_summary) に、地面上での移動距離を記録する
+	tracker.summary.setGroundTransform([&screenToGround](const cv::Point2f& p) { return screenToGround.translate(p); });
+
 	// 動画再生のコントロールをUIで行えるようにするクラス
-	VideoControllerUI videoController;
+	VideoControllerUI videoController(&display);
 	videoController.addShortcutKeys(preview, video);
 
 	while (true)
@@ -120,7 +158,14 @@ int main(int argc, char* argv[])
 		// SQLに姿勢が記録されていれば、その値を使う
 		auto peopleOpt = sql.readBones(frameInfo.frameNumber);
 		People people;
-		if (peopleOpt) { people = peopleOpt.value(); }
+		if (peopleOpt)
+		{
+			people = peopleOpt.value();
+
+			// 30フレーム以内にSQLに記録されていないフレームがあれば、姿勢推定が必要になる前に OpenPose を起動しておく
+			const size_t missingFrame = sql.coverage(sql.tableName(u8"timestamp")).firstMissing(frameInfo.frameNumber);
+			if ((missingFrame < frameInfo.frameNumber + 30) && (missingFrame < frameInfo.frameSum)) openpose.warmup();
+		}
 
 		// SQLに姿勢が記録されていなければ姿勢推定を行う
 		else
@@ -149,15 +194,27 @@ int main(int argc, char* argv[])
 		}
 
 		// 現実座標での軌跡を保存
-		sql.writePoints("trajectory", frameInfo.frameNumber, convertedPoint);
+		trajectoryWriter.write(frameInfo.frameNumber, convertedPoint);
+
+		// 現実座標で人がいたフレーム数を積算し、速度などを計算する
+		if ((heatmapFrame == 0) || (frameInfo.frameNumber > heatmapFrame))
+		{
+			heatmap.add((int64_t)frameInfo.frameTimeStamp, convertedPoint);
+			heatmapFrame = frameInfo.frameNumber;
+
+			// 速度、移動距離、滞在時間を更新する
+			analytics.update((int64_t)frameInfo.frameTimeStamp, convertedPoint);
+			analytics.flushIfDue(sql, sql.tableName(u8"track_histograms"), (int64_t)frameInfo.frameTimeStamp);
+		}
 
 		// 通行人のカウント状況をプレビュー
-		count.drawInfo(frame, tracker);
+		count.drawInfo(overlay, tracker);
 
-		// 映像の上に骨格を描画
-		plotBone(frame, tracked_people, openpose);  // 骨格を描画
-		plotId(frame, tracked_people);  // 人のIDの描画
-		plotFrameInfo.plot(frame, video);  // フレームレートとフレーム番号の描画
+		// 映像の上に骨格を描画 (描画した部分だけをまとめて合成する)
+		plotBone(overlay, cv::Size{ frame.cols, frame.rows }, tracked_people, openpose);  // 骨格を描画
+		plotId(overlay, tracked_people);  // 人のIDの描画
+		plotFrameInfo.plot(overlay, video);  // フレームレートとフレーム番号の描画
+		overlay.composite(frame);
 
 		// 映像を上から見たように射影変換
 		auto frame2 = screenToGround.translateMat(frame, 0.3f, true);
@@ -169,11 +226,12 @@ int main(int argc, char* argv[])
 			personItr->second = Node{ (float)p.x, (float)p.y };
 		}
 		plotTrajectory.plot(frame2, plotPoint);
-		cv::imshow("screen to ground", frame2);
-		cv::imshow("trajectory", plotTrajectory.image);
+		display.show("screen to ground", frame2);
+		display.show("trajectory", plotTrajectory.image);
+		display.show("heatmap", heatmap.render(0, (int64_t)frameInfo.frameTimeStamp + 1));
 
-		// プレビュー
-		int ret = preview.preview(frame, 1);
+		// プレビュー (一時停止中は同じフレームを処理し続けるため、画面の更新の間隔だけ待つ)
+		int ret = preview.preview(frame, video.isPlay() ? 1 : 33);
 
 		// 動画再生コントローラーの表示
 		videoController.showUI(video);
@@ -182,5 +240,14 @@ int main(int argc, char* argv[])
 		if (0x1b == ret) break;
 	}
 
+	// 積算した時間帯ごとのグリッドを保存する
+	heatmap.write(sql, sql.tableName(u8"heatmap"), u8"main");
+
+	// 書き込んでいないヒストグラムを保存する
+	analytics.flush(sql, sql.tableName(u8"track_histograms"), (int64_t)video.getInfo().frameTimeStamp);
+
+	// SQLに記録されていた結果を使った割合を表示する
+	std::cout << "cache hit rate : " << sql.getCacheHitRate() * 100.0 << "% (" << sql.getCacheHits() << " / " << (sql.getCacheHits() + sql.getCacheMisses()) << ")" << std::endl;
+
 	return 0;
 }
@@ -0,0 +1,109 @@
+/*
+
+このプログラムでは、CountingEngine に多数の基準線とゾーンを登録し、多数の人がランダムに歩いた場合のカウントの速さを計測します。
+グリッドのセルを画面より大きくした場合 (全ての基準線とゾーンを毎回判定する場合) と比較し、カウントが一致することも確認します。
+
+使い方 : BenchmarkCountingEngine [基準線の数] [人数] [フレーム数]
+
+*/
+
+#include <Utils/CountingEngine.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <cstdlib>
+
+using Node = MinOpenPose::Node;
+
+int main(int argc, char* argv[])
+{
+	const size_t lineCount = (argc >= 2) ? (size_t)std::atoll(argv[1]) : 100;
+	const size_t peopleCount = (argc >= 3) ? (size_t)std::atoll(argv[2]) : 200;
+	const size_t frameCount = (argc >= 4) ? (size_t)std::atoll(argv[3]) : 9000;
+	const size_t zoneCount = lineCount / 5;
+	const float width = 1920.0f, height = 1080.0f;
+
+	// グリッドを使う場合と、全てを1つのセルに入れる場合
+	CountingEngine gridEngine(64.0f);
+	CountingEngine bruteEngine(1.0e6f);
+
+	// ランダムな基準線とゾーン
+	std::mt19937 random(0);
+	std::uniform_real_distribution<float> randomX(0.0f, width), randomY(0.0f, height), randomSize(20.0f, 200.0f);
+	for (size_t i = 0; i < lineCount; i++)
+	{
+		const cv::Point2f start{ randomX(random), randomY(random) };
+		const cv::Point2f end = start + cv::Point2f{ randomSize(random), randomSize(random) - 110.0f };
+		gridEngine.addLine(u8"line" + std::to_string(i), start, end);
+		bruteEngine.addLine(u8"line" + std::to_string(i), start, end);
+	}
+	for (size_t i = 0; i < zoneCount; i++)
+	{
+		const cv::Point2f center{ randomX(random), randomY(random) };
+		const float size = randomSize(random);
+		const std::vector<cv::Point2f> polygon = { center + cv::Point2f{ -size, 0.0f }, center + cv::Point2f{ 0.0f, -size },
+			center + cv::Point2f{ size, 0.0f }, center + cv::Point2f{ 0.0f, size * 0.5f } };
+		gridEngine.addZone(u8"zone" + std::to_string(i), polygon);
+		bruteEngine.addZone(u8"zone" + std::to_string(i), polygon);
+	}
+
+	// ランダムに歩く人 (一定の周期で人が入れ替わる)
+	std::vector<std::map<size_t, Node>> frames(frameCount);
+	std::vector<cv::Point2f> positions(peopleCount), velocities(peopleCount);
+	std::normal_distribution<float> randomStep(0.0f, 0.5f);
+	for (size_t i = 0; i < peopleCount; i++)
+	{
+		positions[i] = cv::Point2f{ randomX(random), randomY(random) };
+		velocities[i] = cv::Point2f{ randomStep(random) * 4.0f, randomStep(random) * 4.0f };
+	}
+	for (size_t frame = 0; frame < frameCount; frame++)
+	{
+		for (size_t i = 0; i < peopleCount; i++)
+		{
+			velocities[i] += cv::Point2f{ randomStep(random), randomStep(random) } * 0.2f;
+			positions[i] += velocities[i];
+			if (positions[i].x < 0.0f || positions[i].x > width) velocities[i].x = -velocities[i].x;
+			if (positions[i].y < 0.0f || positions[i].y > height) velocities[i].y = -velocities[i].y;
+			const size_t index = i + (frame / 600) * peopleCount;
+			frames[frame][index] = Node{ positions[i].x, positions[i].y, 1.0f };
+		}
+	}
+
+	std::cout << lineCount << u8" lines, " << zoneCount << u8" zones, " << peopleCount << u8" people, " << frameCount << u8" frames" << std::endl;
+
+	auto measure = [&](CountingEngine& engine) {
+		auto start = std::chrono::steady_clock::now();
+		for (size_t frame = 0; frame < frameCount; frame++) engine.update(frames[frame], frame);
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return (double)frameCount / seconds;
+	};
+	const double gridRate = measure(gridEngine);
+	const double bruteRate = measure(bruteEngine);
+
+	// カウントが一致するかどうか
+	uint64_t up = 0, down = 0, in = 0, out = 0;
+	bool isSame = true;
+	for (size_t i = 0; i < lineCount; i++)
+	{
+		auto&& a = gridEngine.getLines()[i];
+		auto&& b = bruteEngine.getLines()[i];
+		isSame = isSame && (a.upCount == b.upCount) && (a.downCount == b.downCount);
+		up += a.upCount;
+		down += a.downCount;
+	}
+	for (size_t i = 0; i < zoneCount; i++)
+	{
+		auto&& a = gridEngine.getZones()[i];
+		auto&& b = bruteEngine.getZones()[i];
+		isSame = isSame && (a.inCount == b.inCount) && (a.outCount == b.outCount) && (a.occupancy == b.occupancy);
+		in += a.inCount;
+		out += a.outCount;
+	}
+
+	std::cout << u8"grid : " << gridRate << u8" frames/s" << std::endl;
+	std::cout << u8"all lines and zones : " << bruteRate << u8" frames/s" << std::endl;
+	std::cout << u8"up " << up << u8", down " << down << u8", in " << in << u8", out " << out
+		<< (isSame ? u8" (same counts)" : u8" (counts differ)") << std::endl;
+
+	return isSame ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+/*
+
+このプログラムでは、SQLの用途ごとの設定 (StorageProfile) ごとに、
+骨格を記録する速さと、記録中のファイルを別の接続から読み込んだときの待ち時間を計測します。
+ダミーの骨格を一時ファイルに書き込みながら、別スレッドで直近のフレームの人数を繰り返し検索します。
+
+使い方 : BenchmarkStorageProfile [フレーム数] [1フレームあたりの人数]
+
+*/
+
+#include <Utils/SqlOpenPose.h>
+#include <filesystem>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+
+using People = MinOpenPose::People;
+using Person = MinOpenPose::Person;
+using Node = MinOpenPose::Node;
+
+// 一時ファイルを削除する (WALのファイルも含む)
+void removeDatabase(const std::string& path)
+{
+	std::error_code ec;
+	for (auto&& suffix : { u8"", u8"-wal", u8"-shm", u8"-journal" }) std::filesystem::remove(path + suffix, ec);
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t frameCount = (argc >= 2) ? (size_t)std::atoll(argv[1]) : 9000;
+	const size_t peopleCount = (argc >= 3) ? (size_t)std::atoll(argv[2]) : 10;
+	const std::string path = (std::filesystem::temp_directory_path() / u8"BenchmarkStorageProfile.sqlite3").string();
+
+	const std::vector<std::pair<StorageProfile, std::string>> profiles = {
+		{ StorageProfile::Default, u8"Default" },
+		{ StorageProfile::LiveIngest, u8"LiveIngest" },
+		{ StorageProfile::BulkImport, u8"BulkImport" }
+	};
+
+	// ダミーの骨格
+	People people;
+	for (size_t index = 0; index < peopleCount; index++)
+	{
+		Person person;
+		for (size_t nodeIndex = 0; nodeIndex < 25; nodeIndex++) person.push_back(Node{ (float)(index * 50 + nodeIndex), (float)(nodeIndex * 10), 0.8f });
+		people[index] = person;
+	}
+
+	std::cout << frameCount << u8" frames, " << peopleCount << u8" people per frame" << std::endl;
+	for (auto&& profile : profiles)
+	{
+		removeDatabase(path);
+
+		SqlOpenPose sql;
+		if (sql.open(path, 30, false, profile.first)) return 1;
+		if (sql.commit()) return 1;
+
+		// 記録中のファイルを別の接続から繰り返し読み込み、1回の検索にかかった時間を記録する
+		std::atomic<bool> isFinished(false);
+		std::atomic<size_t> writtenFrames(0);
+		std::vector<double> latencies;
+		size_t readErrors = 0;
+		std::thread reader([&]() {
+			std::shared_ptr<SQLite::Database> connection;
+			try
+			{
+				connection = Database::createConnection(path, SQLite::OPEN_READONLY);
+				if (Database::applyProfile(*connection, StorageProfile::ReadOnlyAnalytics)) return;
+			}
+			catch (const std::exception& e)
+			{
+				std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+				return;
+			}
+			while (!isFinished)
+			{
+				auto start = std::chrono::steady_clock::now();
+				try
+				{
+					SQLite::Statement query(*connection, u8"SELECT COUNT(*) FROM people WHERE frame=?");
+					query.bind(1, (long long)writtenFrames.load());
+					(void)query.executeStep();
+				}
+				catch (const std::exception&)
+				{
+					readErrors++;
+				}
+				latencies.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		});
+
+		// 読み込むスレッドを止める (失敗して戻る場合も、joinable な std::thread を破棄しないように必ず呼ぶ)
+		auto stopReader = [&]() {
+			isFinished = true;
+			if (reader.joinable()) reader.join();
+		};
+
+		// 骨格を記録する
+		auto start = std::chrono::steady_clock::now();
+		for (size_t frame = 0; frame < frameCount; frame++)
+		{
+			if (sql.writeBones(frame, frame * 33, people))
+			{
+				stopReader();
+				return 1;
+			}
+			writtenFrames = frame;
+		}
+		if (sql.commit())
+		{
+			stopReader();
+			return 1;
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		stopReader();
+
+		// 結果を表示する
+		std::sort(latencies.begin(), latencies.end());
+		auto percentile = [&](double ratio) { return latencies.empty() ? 0.0 : latencies[std::min(latencies.size() - 1, (size_t)(latencies.size() * ratio))] * 1000.0; };
+		std::cout << profile.second << u8" : ingest " << (double)frameCount / seconds << u8" frames/s, read latency p50 "
+			<< percentile(0.5) << u8" ms, p99 " << percentile(0.99) << u8" ms, max " << percentile(1.0) << u8" ms ("
+			<< latencies.size() << u8" reads, " << readErrors << u8" busy)" << std::endl;
+	}
+	removeDatabase(path);
+
+	return 0;
+}
@@ -0,0 +1,132 @@
+/*
+
+このプログラムでは、ダミーの軌跡を長時間分書き込み、書き込み方法ごとの速さを計測します。
+  DELETE+INSERT     : 以前の writePoints() と同じく、フレームごとに削除してから1行ずつ追加する
+  writePoints       : フレームごとにupsertする
+  TrajectoryWriter  : 複数フレームをまとめてupsertする (SQL, 列形式のファイル)
+いずれも、動画の前半をもう1度処理し直した場合 (シークして戻った場合) を含めて計測します。
+
+使い方 : BenchmarkTrajectoryWriter [フレーム数] [1フレームあたりの人数]
+
+*/
+
+#include <Utils/SqlOpenPose.h>
+#include <Utils/TrajectoryWriter.h>
+#include <Utils/PoseColumnFile.h>
+#include <filesystem>
+#include <functional>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <cstdlib>
+
+using Node = MinOpenPose::Node;
+
+// 一時ファイルを削除する
+void removeFile(const std::string& path)
+{
+	std::error_code ec;
+	for (auto&& suffix : { u8"", u8"-wal", u8"-shm", u8"-journal" }) std::filesystem::remove(path + suffix, ec);
+}
+
+// ダミーの軌跡 (人ごとに円を描いて歩く、一定の周期で人が入れ替わる)
+std::map<size_t, Node> makePoints(size_t frame, size_t peopleCount)
+{
+	std::map<size_t, Node> points;
+	for (size_t i = 0; i < peopleCount; i++)
+	{
+		const size_t index = i + (frame / 300) * peopleCount / 2;
+		const float angle = (float)frame * 0.01f + (float)i;
+		points[index] = Node{ 5.0f + 3.0f * std::cos(angle), 5.0f + 3.0f * std::sin(angle), 0.0f };
+	}
+	return points;
+}
+
+/**
+ * 動画を最後まで処理し、前半をもう1度処理した場合の書き込み時間を計測する
+ * @param frameCount フレーム数
+ * @param peopleCount 1フレームあたりの人数
+ * @param write 1フレーム分の書き込み
+ * @param finish 最後に行う処理 (書き込み待ちのフレームの書き込みやコミット)
+ * @return 1秒あたりに処理したフレーム数
+ */
+double measure(size_t frameCount, size_t peopleCount, const std::function<int(size_t, const std::map<size_t, Node>&)>& write, const std::function<int()>& finish)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (size_t frame = 0; frame < frameCount; frame++) if (write(frame, makePoints(frame, peopleCount))) return 0.0;
+	for (size_t frame = 0; frame < frameCount / 2; frame++) if (write(frame, makePoints(frame, peopleCount))) return 0.0;
+	if (finish()) return 0.0;
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return (double)(frameCount + frameCount / 2) / seconds;
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t frameCount = (argc >= 2) ? (size_t)std::atoll(argv[1]) : 54000;
+	const size_t peopleCount = (argc >= 3) ? (size_t)std::atoll(argv[2]) : 10;
+	const std::string path = (std::filesystem::temp_directory_path() / u8"BenchmarkTrajectoryWriter.sqlite3").string();
+	const std::string columnPath = (std::filesystem::temp_directory_path() / u8"BenchmarkTrajectoryWriter.pcol").string();
+
+	std::cout << frameCount << u8" frames + " << frameCount / 2 << u8" frames rewritten, " << peopleCount << u8" people per frame" << std::endl;
+
+	// 以前の writePoints() と同じ書き込み方
+	{
+		removeFile(path);
+		SqlOpenPose sql;
+		if (sql.open(path, 300)) return 1;
+		if (sql.writePoints(u8"trajectory", 0, {})) return 1;
+		const double rate = measure(frameCount, peopleCount, [&](size_t frame, const std::map<size_t, Node>& points) {
+			SQLite::Statement deleteQuery(*sql.database, u8"DELETE FROM trajectory WHERE frame=?");
+			SQLite::Statement insertQuery(*sql.database, u8"INSERT INTO trajectory VALUES (?, ?, ?, ?)");
+			if (sql.bindAllAndExec(deleteQuery, (long long)frame)) return 1;
+			for (auto&& point : points)
+			{
+				if (sql.bindAllAndExec(insertQuery, (long long)frame, (long long)point.first, point.second.x, point.second.y)) return 1;
+			}
+			return 0;
+		}, [&]() { return sql.commit(); });
+		std::cout << u8"DELETE+INSERT : " << rate << u8" frames/s" << std::endl;
+	}
+
+	// フレームごとにupsertする
+	{
+		removeFile(path);
+		SqlOpenPose sql;
+		if (sql.open(path, 300)) return 1;
+		const double rate = measure(frameCount, peopleCount, [&](size_t frame, const std::map<size_t, Node>& points) {
+			return sql.writePoints(u8"trajectory", frame, points);
+		}, [&]() { return sql.commit(); });
+		std::cout << u8"writePoints : " << rate << u8" frames/s" << std::endl;
+	}
+
+	// 複数フレームをまとめてupsertする
+	{
+		removeFile(path);
+		SqlOpenPose sql;
+		if (sql.open(path, 300)) return 1;
+		TrajectoryWriter writer(sql, u8"trajectory");
+		const double rate = measure(frameCount, peopleCount, [&](size_t frame, const std::map<size_t, Node>& points) {
+			return writer.write(frame, points);
+		}, [&]() { return writer.flush() | sql.commit(); });
+		std::cout << u8"TrajectoryWriter (sqlite3) : " << rate << u8" frames/s, "
+			<< writer.getWrittenFrames() << u8" written, " << writer.getSkippedFrames() << u8" skipped" << std::endl;
+	}
+
+	// 列形式のファイルに書き込む
+	{
+		removeFile(columnPath);
+		PoseColumnWriter columnWriter;
+		if (columnWriter.open(columnPath)) return 1;
+		TrajectoryWriter writer(columnWriter, u8"trajectory");
+		const double rate = measure(frameCount, peopleCount, [&](size_t frame, const std::map<size_t, Node>& points) {
+			return writer.write(frame, points);
+		}, [&]() { return writer.flush() | columnWriter.flush(); });
+		std::cout << u8"TrajectoryWriter (pcol) : " << rate << u8" frames/s, "
+			<< writer.getWrittenFrames() << u8" written, " << writer.getSkippedFrames() << u8" skipped" << std::endl;
+	}
+
+	removeFile(path);
+	removeFile(columnPath);
+
+	return 0;
+}
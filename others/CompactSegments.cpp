@@ -0,0 +1,85 @@
+/*
+
+このプログラムでは、SqlOpenPose::openSegments() で記録したセグメントのうち、記録を終えたものを圧縮します。
+セグメントごとにWALを書き戻してジャーナルを通常の形式に戻し、統計情報を更新してから VACUUM します。
+記録中のセグメントには触れないため、Webカメラの記録を止めずに実行できます。
+(セグメントの削除は、記録中のプログラムが SegmentPolicy の保存期間に従って行います)
+
+使い方 : CompactSegments セグメントのファイルのパスの先頭 (openSegments() の basePath)
+
+*/
+
+#include <Utils/Database.h>
+#include <Utils/SegmentManifest.h>
+#include <filesystem>
+#include <chrono>
+#include <string>
+
+// WALのファイルも含めたファイルサイズを取得する
+uint64_t getFileSize(const std::string& path)
+{
+	uint64_t bytes = 0;
+	std::error_code ec;
+	for (auto&& suffix : { u8"", u8"-wal" })
+	{
+		const auto size = std::filesystem::file_size(path + suffix, ec);
+		if (!ec) bytes += (uint64_t)size;
+	}
+	return bytes;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cout << u8"使い方 : CompactSegments セグメントのファイルのパスの先頭" << std::endl;
+		return 1;
+	}
+	const std::string basePath = argv[1];
+
+	SegmentManifest manifest;
+	if (manifest.load(basePath)) return 1;
+	if (manifest.segments.empty())
+	{
+		std::cout << SegmentManifest::manifestPath(basePath) << u8"にセグメントが記録されていません。" << std::endl;
+		return 1;
+	}
+
+	uint64_t totalBefore = 0, totalAfter = 0;
+	for (auto&& segment : manifest.segments)
+	{
+		if (segment.isActive())
+		{
+			std::cout << segment.path << u8" : recording (skipped)" << std::endl;
+			continue;
+		}
+		if (!std::filesystem::exists(segment.path)) continue;
+
+		const uint64_t before = getFileSize(segment.path);
+		auto start = std::chrono::steady_clock::now();
+		try
+		{
+			auto database = Database::createConnection(segment.path, SQLite::OPEN_READWRITE);
+			database->setBusyTimeout(5000);
+			database->exec(u8"PRAGMA wal_checkpoint(TRUNCATE)");
+			database->exec(u8"PRAGMA journal_mode=DELETE");
+			database->exec(u8"ANALYZE");
+			database->exec(u8"VACUUM");
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+			continue;
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		const uint64_t after = getFileSize(segment.path);
+		totalBefore += before;
+		totalAfter += after;
+
+		std::cout << segment.path << u8" : frames " << segment.firstFrame << u8" - " << segment.lastFrame << u8", "
+			<< before << u8" bytes -> " << after << u8" bytes (" << seconds << u8" s)" << std::endl;
+	}
+	std::cout << u8"total : " << totalBefore << u8" bytes -> " << totalAfter << u8" bytes" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,164 @@
+/*
+
+このプログラムでは、既に生成されたSQLファイルの骨格のテーブル (people, people_with_trackingなど) と
+座標のテーブル (trajectoryなど) を、列形式のファイル (.pcol) に変換します。
+変換後に、SQLから全ての行を読み込むのにかかった時間と、.pcol をメモリマップして読み込むのにかかった時間を表示します。
+どちらも全ての列を復元して、フレームごとの骨格 (もしくは座標) のmapを作るまでの時間を計測します。
+元のファイルは書き換えられません。
+
+使い方 : ConvertToColumnFile 入力ファイル [出力ファイル]
+
+*/
+
+#include <Utils/SqlOpenPose.h>
+#include <Utils/PoseColumnFile.h>
+#include <filesystem>
+#include <chrono>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cout << u8"使い方 : ConvertToColumnFile 入力ファイル [出力ファイル]" << std::endl;
+		return 1;
+	}
+	const std::string inputPath = argv[1];
+	const std::string outputPath = (argc >= 3) ? argv[2] : (inputPath + u8".pcol");
+
+	try
+	{
+		SQLite::Database database(inputPath, SQLite::OPEN_READONLY);
+
+		// 骨格のテーブル (75列のREAL型, もしくはBLOB) と座標のテーブル (x, y) を探す
+		std::map<std::string, PoseColumnFormat::Kind> tables;
+		std::map<std::string, bool> packedTables;
+		{
+			SQLite::Statement tableQuery(database, u8"SELECT name FROM sqlite_master WHERE type='table'");
+			while (tableQuery.executeStep())
+			{
+				const std::string tableName = tableQuery.getColumn(0).getString();
+				SQLite::Statement columnQuery(database, u8"SELECT * FROM " + tableName + u8" LIMIT 0");
+				if ((columnQuery.getColumnCount() < 3) || (columnQuery.getColumnName(0) != std::string(u8"frame")) || (columnQuery.getColumnName(1) != std::string(u8"people"))) continue;
+				if ((columnQuery.getColumnCount() == 2 + 75) || (columnQuery.getColumnCount() == 3))
+				{
+					tables[tableName] = PoseColumnFormat::Kind::People;
+					packedTables[tableName] = (columnQuery.getColumnCount() == 3);
+				}
+				else if (columnQuery.getColumnCount() == 4)
+				{
+					tables[tableName] = PoseColumnFormat::Kind::Points;
+				}
+			}
+		}
+		if (tables.empty())
+		{
+			std::cout << u8"変換できるテーブルがありません。" << std::endl;
+			return 1;
+		}
+
+		// テーブルごとにフレーム番号の昇順で読み込み、.pcol に書き込む
+		// SQLから全ての行を読み込む時間も同時に計測する
+		std::map<std::string, double> sqlSeconds;
+		std::map<std::string, size_t> rowCounts;
+		std::map<std::string, std::pair<size_t, size_t>> frameRanges;
+		std::filesystem::remove(outputPath);
+		{
+			PoseColumnWriter writer;
+			if (writer.open(outputPath)) return 1;
+			for (auto&& table : tables)
+			{
+				const std::string& tableName = table.first;
+				const bool isPeople = (table.second == PoseColumnFormat::Kind::People);
+				MinOpenPose::People people;
+				std::map<size_t, MinOpenPose::Node> points;
+				size_t frame = 0, firstFrame = 0, rows = 0;
+				bool hasFrame = false;
+				double seconds = 0.0;
+
+				auto start = std::chrono::steady_clock::now();
+				SQLite::Statement selectQuery(database, u8"SELECT * FROM " + tableName + u8" ORDER BY frame ASC, people ASC");
+				while (selectQuery.executeStep())
+				{
+					const size_t rowFrame = (size_t)selectQuery.getColumn(0).getInt64();
+					const size_t index = (size_t)selectQuery.getColumn(1).getInt64();
+
+					// フレームが変わったら、それまでのフレームを書き込む (書き込みの時間は計測に含めない)
+					if (hasFrame && (rowFrame != frame))
+					{
+						auto pause = std::chrono::steady_clock::now();
+						if (isPeople) writer.appendPeople(tableName, frame, people);
+						else writer.appendPoints(tableName, frame, points);
+						people.clear();
+						points.clear();
+						start += std::chrono::steady_clock::now() - pause;
+					}
+					if (!hasFrame) firstFrame = rowFrame;
+					frame = rowFrame;
+					hasFrame = true;
+
+					if (isPeople) people[index] = SqlOpenPose::getPerson(selectQuery, 2, packedTables[tableName]);
+					else points[index] = MinOpenPose::Node{ (float)selectQuery.getColumn(2).getDouble(), (float)selectQuery.getColumn(3).getDouble(), 0.0f };
+					rows++;
+				}
+				seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				if (hasFrame)
+				{
+					if (isPeople) writer.appendPeople(tableName, frame, people);
+					else writer.appendPoints(tableName, frame, points);
+				}
+
+				sqlSeconds[tableName] = seconds;
+				rowCounts[tableName] = rows;
+				if (hasFrame) frameRanges[tableName] = { firstFrame, frame + 1 };
+			}
+			if (writer.close()) return 1;
+		}
+
+		// .pcol をメモリマップして、SQLと同じ形 (フレームごとのmap) で全ての行を読み込む時間を計測する
+		PoseColumnReader reader;
+		if (reader.open(outputPath))
+		{
+			std::cout << outputPath << u8"を開けませんでした。" << std::endl;
+			return 1;
+		}
+		std::cout << u8"file size : " << std::filesystem::file_size(inputPath) << u8" bytes -> "
+			<< std::filesystem::file_size(outputPath) << u8" bytes" << std::endl;
+		for (auto&& table : tables)
+		{
+			const std::string& tableName = table.first;
+			const auto range = frameRanges[tableName];
+			size_t columnRows = 0;
+			auto start = std::chrono::steady_clock::now();
+			if (table.second == PoseColumnFormat::Kind::People)
+			{
+				(void)reader.readPeopleRange(tableName, range.first, range.second, [&](size_t, const MinOpenPose::People& people) {
+					columnRows += people.size();
+					return true;
+				});
+			}
+			else
+			{
+				(void)reader.readPointsRange(tableName, range.first, range.second, [&](size_t, const std::map<size_t, MinOpenPose::Node>& points) {
+					columnRows += points.size();
+					return true;
+				});
+			}
+			const double columnSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			// 読み込んだ行の数が異なる場合は、同じ内容を読み込んだ比較にならないため表示する
+			if (columnRows != rowCounts[tableName]) std::cout << tableName << u8" : " << columnRows << u8" rows in pcol" << std::endl;
+
+			std::cout << tableName << u8" : " << rowCounts[tableName] << u8" rows, read "
+				<< sqlSeconds[tableName] * 1000.0 << u8" ms (sqlite3) -> " << columnSeconds * 1000.0 << u8" ms (pcol)" << std::endl;
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
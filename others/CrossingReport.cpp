@@ -0,0 +1,68 @@
+/*
+
+このプログラムでは、CrossingLog で記録した基準線の通過人数を、1時間ごとに表示します。
+1時間ごとの集計を読み込むだけのため、長期間の記録でもすぐに表示されます。
+
+使い方 : CrossingReport SQLファイルのパス [表示する日数 (既定値は7日)] [基準線のID (既定値は0)] [テーブル名の接尾辞]
+
+時刻は記録したときの時刻 (example10 ではUNIX時間、example08 では動画の再生位置) で表示されます。
+
+*/
+
+#include <Utils/Database.h>
+#include <Utils/CrossingLog.h>
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <cstdlib>
+
+// 時刻 (ミリ秒) をローカル時刻の文字列にする
+std::string formatTime(int64_t time)
+{
+	std::time_t t = (std::time_t)(time / 1000);
+	std::tm tm;
+#ifdef _WIN32
+	localtime_s(&tm, &t);
+#else
+	localtime_r(&t, &tm);
+#endif
+	char buffer[32];
+	std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M", &tm);
+	return buffer;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cout << u8"使い方 : CrossingReport SQLファイルのパス [表示する日数] [基準線のID] [テーブル名の接尾辞]" << std::endl;
+		return 1;
+	}
+	const std::string path = argv[1];
+	const int64_t days = (argc >= 3) ? (int64_t)std::atoll(argv[2]) : 7;
+	const int64_t line = (argc >= 4) ? (int64_t)std::atoll(argv[3]) : 0;
+	const std::string tableSuffix = (argc >= 5) ? argv[4] : u8"";
+
+	Database database;
+	if (database.create(path, SQLite::OPEN_READONLY, StorageProfile::ReadOnlyAnalytics)) return 1;
+	CrossingLog crossingLog(tableSuffix);
+
+	const int64_t now = (int64_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	const int64_t from = CrossingLog::startOfDay(now) - (days - 1) * 24LL * CrossingLog::hour;
+	const int64_t to = now + 1;
+
+	auto start = std::chrono::steady_clock::now();
+	auto buckets = crossingLog.readBuckets(database, line, from, to);
+	auto total = crossingLog.count(database, line, from, to);
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (!buckets || !total) return 1;
+
+	for (auto&& bucket : buckets.value())
+	{
+		std::cout << formatTime(bucket.time) << u8"  up : " << bucket.up << u8"  down : " << bucket.down << std::endl;
+	}
+	std::cout << u8"total (" << formatTime(from) << u8" - " << formatTime(now) << u8")  up : " << total->up << u8"  down : " << total->down
+		<< u8"  (" << seconds * 1000.0 << u8" ms)" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,86 @@
+/*
+
+このプログラムでは、複数のSQLファイル (複数のカメラや、複数の日の記録) に保存された Heatmap を合算し、1枚の画像として保存します。
+範囲と解像度が同じグリッドのみを合算します (最初に見つかったグリッドの範囲と解像度に合わせます)。
+
+使い方 : MergeHeatmaps 出力する画像のパス SQLファイルのパス [SQLファイルのパス ...]
+
+*/
+
+#include <Utils/Database.h>
+#include <Utils/Heatmap.h>
+#include <memory>
+#include <limits>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		std::cout << u8"使い方 : MergeHeatmaps 出力する画像のパス SQLファイルのパス [SQLファイルのパス ...]" << std::endl;
+		return 1;
+	}
+	const std::string outputPath = argv[1];
+	const int64_t from = 0;
+	const int64_t to = std::numeric_limits<int64_t>::max();
+
+	std::unique_ptr<Heatmap> merged;
+	for (int i = 2; i < argc; i++)
+	{
+		Database database;
+		if (database.create(argv[i], SQLite::OPEN_READONLY, StorageProfile::ReadOnlyAnalytics)) return 1;
+
+		// heatmap で始まるテーブルを全て合算する (動画と姿勢推定の設定ごとにテーブル名の接尾辞が異なる)
+		std::vector<std::string> tables;
+		try
+		{
+			SQLite::Statement query(*database.database, u8"SELECT name FROM sqlite_master WHERE type='table' AND name LIKE 'heatmap%'");
+			while (query.executeStep()) tables.push_back(query.getColumn(0).getString());
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+			return 1;
+		}
+
+		for (auto&& table : tables)
+		{
+			// 最初に見つかったグリッドの範囲と解像度に合わせる
+			if (!merged)
+			{
+				try
+				{
+					SQLite::Statement query(*database.database, u8"SELECT cols, rows, area_x, area_y, area_width, area_height FROM " + table + u8" LIMIT 1");
+					if (!query.executeStep()) continue;
+					merged = std::make_unique<Heatmap>(
+						cv::Rect2f{ (float)query.getColumn(2).getDouble(), (float)query.getColumn(3).getDouble(), (float)query.getColumn(4).getDouble(), (float)query.getColumn(5).getDouble() },
+						query.getColumn(0).getInt(), query.getColumn(1).getInt());
+				}
+				catch (const std::exception& e)
+				{
+					std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+					return 1;
+				}
+			}
+
+			// 範囲や解像度が異なるグリッドは読み込めないため、別のグリッドに読み込んでから合算する
+			Heatmap heatmap(merged->getArea(), merged->getCols(), merged->getRows());
+			if (heatmap.read(database, table, u8"", from, to) || merged->merge(heatmap))
+			{
+				std::cout << argv[i] << u8" : " << table << u8" (skipped, different grid)" << std::endl;
+				continue;
+			}
+			std::cout << argv[i] << u8" : " << table << u8" (" << heatmap.getBuckets().size() << u8" buckets)" << std::endl;
+		}
+	}
+
+	if (!merged)
+	{
+		std::cout << u8"Heatmap が保存されていません。" << std::endl;
+		return 1;
+	}
+	cv::imwrite(outputPath, merged->render(from, to));
+
+	return 0;
+}
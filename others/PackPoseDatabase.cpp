@@ -0,0 +1,137 @@
+/*
+
+このプログラムでは、既に生成されたSQLファイルの骨格のテーブル (people, people_with_trackingなど) を、
+骨格をBLOBに詰めた形式 (PackedPose) に変換したファイルを新しく生成します。
+変換前後のファイルサイズと、全ての骨格を読み込むのにかかった時間を表示します。
+元のファイルは書き換えられません。
+
+使い方 : PackPoseDatabase 入力ファイル [出力ファイル]
+
+*/
+
+#include <Utils/SqlOpenPose.h>
+#include <Utils/PackedPose.h>
+#include <filesystem>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// テーブルの全ての骨格を読み込み、かかった時間(秒)を返す
+double scanTable(SQLite::Database& database, const std::string& tableName, bool packed, size_t& rows)
+{
+	auto start = std::chrono::steady_clock::now();
+	SQLite::Statement query(database, u8"SELECT * FROM " + tableName + u8" ORDER BY frame ASC, people ASC");
+	rows = 0;
+	float checksum = 0.0f;
+	while (query.executeStep())
+	{
+		MinOpenPose::Person person = SqlOpenPose::getPerson(query, 2, packed);
+		if (!person.empty()) checksum += person[0].x;
+		rows++;
+	}
+	auto end = std::chrono::steady_clock::now();
+	if (checksum < 0.0f) std::cout << checksum << std::endl;  // 最適化で読み込みが省略されないようにする
+	return std::chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cout << u8"使い方 : PackPoseDatabase 入力ファイル [出力ファイル]" << std::endl;
+		return 1;
+	}
+	const std::string inputPath = argv[1];
+	const std::string outputPath = (argc >= 3) ? argv[2] : (inputPath + u8".packed.sqlite3");
+
+	try
+	{
+		// 元のファイルを複製し、複製したファイルを変換する
+		std::filesystem::copy_file(inputPath, outputPath, std::filesystem::copy_options::overwrite_existing);
+
+		// 75列のREAL型で骨格を保存しているテーブルを探す
+		std::vector<std::string> tables;
+		{
+			SQLite::Database database(outputPath, SQLite::OPEN_READONLY);
+			SQLite::Statement tableQuery(database, u8"SELECT name FROM sqlite_master WHERE type='table'");
+			while (tableQuery.executeStep())
+			{
+				const std::string tableName = tableQuery.getColumn(0).getString();
+				SQLite::Statement columnQuery(database, u8"SELECT * FROM " + tableName + u8" LIMIT 0");
+				if ((columnQuery.getColumnCount() == 2 + 75) && (columnQuery.getColumnName(0) == std::string(u8"frame"))) tables.push_back(tableName);
+			}
+		}
+		if (tables.empty())
+		{
+			std::cout << u8"変換できるテーブルがありません。" << std::endl;
+			return 1;
+		}
+
+		// 変換前の読み込み時間を計測する
+		std::map<std::string, double> legacySeconds;
+		{
+			SQLite::Database database(outputPath, SQLite::OPEN_READONLY);
+			for (auto&& tableName : tables)
+			{
+				size_t rows = 0;
+				legacySeconds[tableName] = scanTable(database, tableName, false, rows);
+			}
+		}
+
+		// テーブルごとに変換する
+		{
+			Database database;
+			if (database.create(outputPath, SQLite::OPEN_READWRITE)) return 1;
+			for (auto&& tableName : tables)
+			{
+				const std::string packedTable = tableName + u8"_packed";
+				if (database.deleteTableIfExist(packedTable)) return 1;
+				if (database.createTableIfNoExist(packedTable, u8"frame INTEGER, people INTEGER, joints BLOB")) return 1;
+
+				SQLite::Statement selectQuery(*database.database, u8"SELECT * FROM " + tableName + u8" ORDER BY frame ASC, people ASC");
+				SQLite::Statement insertQuery(*database.database, u8"INSERT INTO " + packedTable + u8" VALUES (?, ?, ?)");
+				while (selectQuery.executeStep())
+				{
+					insertQuery.reset();
+					insertQuery.bind(1, selectQuery.getColumn(0).getInt64());
+					insertQuery.bind(2, selectQuery.getColumn(1).getInt64());
+					SqlOpenPose::bindPerson(insertQuery, 3, SqlOpenPose::getPerson(selectQuery, 2, false), true);
+					(void)insertQuery.exec();
+				}
+
+				// 元のテーブルを置き換え、Indexを作り直す
+				if (database.deleteTableIfExist(tableName)) return 1;
+				database.database->exec(u8"ALTER TABLE " + packedTable + u8" RENAME TO " + tableName);
+				if (database.createIndexIfNoExist(tableName, u8"frame", false)) return 1;
+				if (database.createIndexIfNoExist(tableName, u8"people", false)) return 1;
+				if (database.createIndexIfNoExist(tableName, u8"frame", u8"people", true)) return 1;
+			}
+			if (database.commit()) return 1;
+		}
+
+		// 削除したテーブルの領域を解放する (トランザクションの外で実行する必要がある)
+		{
+			SQLite::Database database(outputPath, SQLite::OPEN_READWRITE);
+			database.exec(u8"VACUUM");
+		}
+
+		// 結果を表示する
+		std::cout << u8"file size : " << std::filesystem::file_size(inputPath) << u8" bytes -> "
+			<< std::filesystem::file_size(outputPath) << u8" bytes" << std::endl;
+		SQLite::Database database(outputPath, SQLite::OPEN_READONLY);
+		for (auto&& tableName : tables)
+		{
+			size_t rows = 0;
+			const double packedSeconds = scanTable(database, tableName, true, rows);
+			std::cout << tableName << u8" : " << rows << u8" rows, read "
+				<< legacySeconds[tableName] * 1000.0 << u8" ms -> " << packedSeconds * 1000.0 << u8" ms" << std::endl;
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -7,6 +7,8 @@
 #include <Utils/Tracking.h>
 #include <Utils/PeopleCounter.h>
 #include <Utils/Vector.h>
+#include <Utils/TrajectoryRenderer.h>
+#include <chrono>
 
 using People = MinOpenPose::People;
 using Person = MinOpenPose::Person;
@@ -19,7 +21,7 @@ int main(int argc, char* argv[])
 
 	// SQLファイルの読み込み、書き込みを行うクラス
 	SqlOpenPose sql;
-	ret = sql.open(R"(D:\思い出\Dropbox\Dropbox\SDK\openpose\video\out1.mp4.sqlite3)");
+	ret = sql.open(R"(D:\思い出\Dropbox\Dropbox\SDK\openpose\video\out1.mp4.sqlite3)", 0, false, StorageProfile::ReadOnlyAnalytics);
 	if (ret) return ret;
 
 	// データベースに関する情報を取得する
@@ -39,48 +41,61 @@ int main(int argc, char* argv[])
 	// プレビューウィンドウを生成するクラス
 	Preview preview("result");
 
-	// フレームレートなどを表示するクラス
-	PlotFrameInfo plotFrameInfo;
-	PlotTrajectory plotTrajectory;
-
 	cv::Mat frame = cv::Mat(720, 1280, CV_8UC3, { 0, 0, 0 });
 
-	for (size_t frameNumber = firstFrameNumber; frameNumber <= lastFrameNumber; frameNumber++)
-	{
-		// フレームレートの描画
-		plotFrameInfo.plotFPS(frame);
-
-		// 軌跡情報の取得
-		auto trajectoryPoint = sql.readPoints("trajectory", frameNumber);
-
-		// 画面に収まるように調整
-		for (auto personItr = trajectoryPoint.begin(); personItr != trajectoryPoint.end(); personItr++)
+	// 全てのフレームの軌跡を1回の検索でまとめて読み込み、人ごとの折れ線にする (画面に収まるように調整する)
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	TrajectoryRenderer renderer;
+	ret = renderer.load(sql, "trajectory", firstFrameNumber, lastFrameNumber + 1, [&](const cv::Point2f& point) {
+		cv::Point2f p = point;
+		p.x -= leftTop.x;
+		p.y -= leftTop.y;
+		p.x *= (float)frame.cols / (rightBottom.x - leftTop.x);
+		p.y *= (float)frame.rows / (rightBottom.y - leftTop.y);
+		return p;
+	});
+	if (ret) return ret;
+	std::cout << renderer.getPointCount() << " points, " << renderer.getPolylineCount() << " polylines, load : "
+		<< std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count() << " [ms]" << std::endl;
+
+	// 表示位置と表示倍率 (最初は全体を表示する)
+	cv::Point2f origin;
+	int zoom = 0;
+	renderer.fit(cv::Size{ frame.cols, frame.rows }, origin, zoom);
+
+	// ドラッグで表示位置を動かす
+	bool isDragging = false;
+	cv::Point dragStart;
+	preview.addMouseEventListener([&](int event, int x, int y) {
+		if (event == cv::EVENT_LBUTTONDOWN) { isDragging = true; dragStart = cv::Point{ x, y }; }
+		if (event == cv::EVENT_LBUTTONUP) isDragging = false;
+		if ((event == cv::EVENT_MOUSEMOVE) && isDragging)
 		{
-			cv::Point2f p{ personItr->second.x, personItr->second.y };
-			p.x -= leftTop.x;
-			p.y -= leftTop.y;
-			p.x *= (float)frame.cols / (rightBottom.x - leftTop.x);
-			p.y *= (float)frame.rows / (rightBottom.y - leftTop.y);
-			personItr->second = Node{ (float)p.x, (float)p.y };
+			const float scale = std::pow(2.0f, (float)zoom);
+			origin.x -= (float)(x - dragStart.x) / scale;
+			origin.y -= (float)(y - dragStart.y) / scale;
+			dragStart = cv::Point{ x, y };
 		}
+	});
 
-		// 軌跡の描画
-		plotTrajectory.plot(frame, trajectoryPoint);
-
-		// 100フレームごとに進捗をプレビュー
-		if (frameNumber % 100 == 0) {
-			ret = preview.preview(plotTrajectory.image, 1);
-		}
-
-		// Escキーが押されたら終了する
-		if (0x1b == ret) return 0;
+	// z キーで拡大、x キーで縮小 (画面の中心を基準にする)、Escキーで終了
+	int key = 0;
+	while (0x1b != key)
+	{
+		const float scale = std::pow(2.0f, (float)zoom);
+		const cv::Point2f center = origin + cv::Point2f{ (float)frame.cols * 0.5f / scale, (float)frame.rows * 0.5f / scale };
+		if (key == 'z') zoom++;
+		if (key == 'x') zoom--;
+		const float newScale = std::pow(2.0f, (float)zoom);
+		origin = center - cv::Point2f{ (float)frame.cols * 0.5f / newScale, (float)frame.rows * 0.5f / newScale };
+
+		// 軌跡の描画 (キャッシュに無いタイルのみ描画される)
+		frame.setTo(cv::Scalar{ 0, 0, 0 });
+		renderer.render(frame, origin, zoom);
+		gui::text(frame, "zoom : " + std::to_string(zoom) + ", tiles : " + std::to_string(renderer.getRenderedTiles()) + " rendered, " + std::to_string(renderer.getCacheHits()) + " cached", { 20, 20 });
+
+		key = preview.preview(frame, 15);
 	}
 
-	// 最後にプレビュー
-	preview.preview(plotTrajectory.image, 1);
-
-	// キー入力があるまで待機
-	cv::waitKey(0);
-
 	return 0;
 }
@@ -7,6 +7,9 @@
 #include <Utils/Tracking.h>
 #include <Utils/PeopleCounter.h>
 #include <Utils/Vector.h>
+#include <Utils/TrajectoryRenderer.h>
+#include <chrono>
+#include <limits>
 
 using People = MinOpenPose::People;
 using Person = MinOpenPose::Person;
@@ -30,7 +33,7 @@ int main(int argc, char* argv[])
 
 	// SQLファイルの読み込み、書き込みを行うクラス
 	SqlOpenPose sql;
-	ret = sql.open(sqlPath);
+	ret = sql.open(sqlPath, 0, false, StorageProfile::ReadOnlyAnalytics);
 	if (ret) return ret;
 
 	// データベースに関する情報を取得する
@@ -73,70 +76,78 @@ int main(int argc, char* argv[])
 	// プレビューウィンドウを生成するクラス
 	Preview preview("result");
 
-	// フレームレートなどを表示するクラス
-	PlotFrameInfo plotFrameInfo;
-	PlotTrajectory plotTrajectory;
-
 	cv::Mat frameOrg = video.next();
 	cv::rotate(frameOrg, frameOrg, cv::ROTATE_180);
 	frameOrg = screenToGround.translateMat(frameOrg, 0.3f, true);
 	cv::Mat frame = frameOrg.clone();
 
-	size_t count = 0;
+	// 全てのフレームの軌跡を1回の検索でまとめて読み込み、人ごとの折れ線にする (背景の画像に合わせる)
 	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	TrajectoryRenderer renderer;
+	ret = renderer.load(sql, "trajectory", 0, std::numeric_limits<size_t>::max(), [&](const cv::Point2f& point) {
+		return screenToGround.plot(point, frameOrg, 0.3f);
+	});
+	if (ret) return ret;
+	std::cout << renderer.getPointCount() << " points, " << renderer.getPolylineCount() << " polylines, load : "
+		<< std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count() << " [ms]" << std::endl;
+
+	// 表示位置と表示倍率 (最初は背景の画像全体を表示する)
+	cv::Point2f origin;
+	int zoom = 0;
+
+	// ドラッグで表示位置を動かす
+	bool isDragging = false;
+	cv::Point dragStart;
+	preview.addMouseEventListener([&](int event, int x, int y) {
+		if (event == cv::EVENT_LBUTTONDOWN) { isDragging = true; dragStart = cv::Point{ x, y }; }
+		if (event == cv::EVENT_LBUTTONUP) isDragging = false;
+		if ((event == cv::EVENT_MOUSEMOVE) && isDragging)
+		{
+			const float scale = std::pow(2.0f, (float)zoom);
+			origin.x -= (float)(x - dragStart.x) / scale;
+			origin.y -= (float)(y - dragStart.y) / scale;
+			dragStart = cv::Point{ x, y };
+		}
+	});
 
-	// 指定されたフレーム番号に映る人すべての骨格の重心を検索する
-	SQLite::Statement peopleQuery(*(sql.database), u8"SELECT * FROM trajectory");
-	std::map<size_t, Node> trajectoryPoint;
-	size_t currentFrame = 0;
-	while (peopleQuery.executeStep())
+	// z キーで拡大、x キーで縮小 (画面の中心を基準にする)、Escキーで終了
+	int key = 0;
+	while (0x1b != key)
 	{
-		// 座標情報を取得
-		size_t frameNumber = (size_t)peopleQuery.getColumn(0).getUInt();
-		size_t index = (size_t)peopleQuery.getColumn(1).getUInt();
-		cv::Point2f p{
-			(float)peopleQuery.getColumn(2).getDouble(),
-			(float)peopleQuery.getColumn(3).getDouble()
-		};
-
-		// 画面に収まるように調整
-		p = screenToGround.plot(p, frame, 0.3f);
-
-		// フレーム番号に変化があれば、以前のフレームの描画を行う
-		if (frameNumber != currentFrame)
+		const float scale = std::pow(2.0f, (float)zoom);
+		const cv::Point2f center = origin + cv::Point2f{ (float)frame.cols * 0.5f / scale, (float)frame.rows * 0.5f / scale };
+		if (key == 'z') zoom++;
+		if (key == 'x') zoom--;
+		const float newScale = std::pow(2.0f, (float)zoom);
+		origin = center - cv::Point2f{ (float)frame.cols * 0.5f / newScale, (float)frame.rows * 0.5f / newScale };
+
+		// 背景の画像のうち表示範囲に含まれる部分だけを拡大縮小する
+		frame.setTo(cv::Scalar{ 0, 0, 0 });
+		const cv::Rect src = cv::Rect{
+			(int)std::floor(origin.x), (int)std::floor(origin.y),
+			(int)std::ceil((float)frame.cols / newScale) + 1, (int)std::ceil((float)frame.rows / newScale) + 1
+		} & cv::Rect{ 0, 0, frameOrg.cols, frameOrg.rows };
+		if (src.area() > 0)
 		{
-			// 軌跡の描画
-			plotTrajectory.plot(frame, trajectoryPoint);
-
-			// フレーム番号の更新
-			currentFrame = frameNumber;
-
-			trajectoryPoint.clear();
-
-			// 1000ループごとに進捗をプレビュー
-			if ((count++) % 1000 == 0) {
-				ret = preview.preview(frame, 1);
+			cv::Mat scaled;
+			cv::resize(frameOrg(src), scaled, cv::Size{ (int)std::round((float)src.width * newScale), (int)std::round((float)src.height * newScale) },
+				0, 0, (newScale < 1.0f) ? cv::INTER_AREA : cv::INTER_NEAREST);
+			const int x = (int)std::round(((float)src.x - origin.x) * newScale);
+			const int y = (int)std::round(((float)src.y - origin.y) * newScale);
+			const cv::Rect dst = cv::Rect{ x, y, scaled.cols, scaled.rows } & cv::Rect{ 0, 0, frame.cols, frame.rows };
+			if (dst.area() > 0)
+			{
+				cv::Mat roi = frame(dst);
+				scaled(cv::Rect{ dst.x - x, dst.y - y, dst.width, dst.height }).copyTo(roi);
 			}
 		}
 
-		trajectoryPoint[index] = Node{ (float)p.x, (float)p.y };
+		// 軌跡の描画 (キャッシュに無いタイルのみ描画される)
+		renderer.render(frame, origin, zoom);
+		gui::text(frame, "zoom : " + std::to_string(zoom) + ", tiles : " + std::to_string(renderer.getRenderedTiles()) + " rendered, " + std::to_string(renderer.getCacheHits()) + " cached", { 20, 20 });
 
-		// Escキーが押されたら終了する
-		if (0x1b == ret) return 0;
+		key = preview.preview(frame, 15);
 	}
 
-	float time = (float)(std::chrono::duration_cast<std::chrono::milliseconds>(
-		std::chrono::high_resolution_clock::now() - start
-	).count()) / 1000.0f;
-	std::cout << "time score: " << time << " [sec]" << std::endl;
-
-	// 最後にプレビュー
-	frame = frameOrg.clone();
-	plotTrajectory.plot(frame, trajectoryPoint);
-	preview.preview(frame, 1);
-
-	// キー入力があるまで待機
-	cv::waitKey(0);
-
 	return 0;
 }
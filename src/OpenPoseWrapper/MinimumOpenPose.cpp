@@ -1,299 +1,444 @@
-#include "OpenPoseWrapper/MinimumOpenPose.h"
-
-MinOpenPose::WUserInputProcessing::WUserInputProcessing(std::mutex& inOutMtx) : inOutMtx(inOutMtx) {}
-
-void MinOpenPose::WUserInputProcessing::initializationOnThread()
-{
-	std::lock_guard<std::mutex> inOutLock(inOutMtx);
-}
-
-void MinOpenPose::WUserInputProcessing::work(std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>>& datumsPtr)
-{
-	std::lock_guard<std::mutex> inOutLock(inOutMtx);
-	try
-	{
-		// キューに画像が入っていた場合、1枚ずつ OpenPose に送る
-		datumsPtr = std::make_shared<std::vector<std::shared_ptr<op::Datum>>>();
-		if (!images.empty())
-		{
-			auto datumPtr = std::make_shared<op::Datum>();
-			datumPtr->subId = 0;
-			datumPtr->subIdMax = 0;
-			datumPtr->name = "output";
-			datumPtr->frameNumber = images.front().second;
-			datumPtr->cvInputData = images.front().first;
-			images.pop();
-			datumPtr->cvOutputData = datumPtr->cvInputData;
-			datumsPtr->push_back(datumPtr); // datumsPtr は2つ以上の要素を持てない
-		}
-	}
-	catch (const std::exception& e)
-	{
-		errorMessage.push_back(e.what());
-		this->stop();
-	}
-}
-
-int MinOpenPose::WUserInputProcessing::pushImage(const cv::Mat& image, size_t frameNumber, size_t maxQueueSize)
-{
-	std::lock_guard<std::mutex> inOutLock(inOutMtx);
-	if (images.size() >= maxQueueSize) return 1;
-	images.push(std::pair<cv::Mat, size_t>(image, frameNumber));
-	return 0;
-}
-
-void MinOpenPose::WUserInputProcessing::getErrors(std::vector<std::string>& errorMessage, bool clearErrors)
-{
-	std::lock_guard<std::mutex> inOutLock(inOutMtx);
-	for (auto error : this->errorMessage) errorMessage.push_back(error);
-	if (clearErrors) this->errorMessage.clear();
-}
-
-void MinOpenPose::WUserInputProcessing::shutdown()
-{
-	std::lock_guard<std::mutex> inOutLock(inOutMtx);
-	this->stop();
-}
-
-MinOpenPose::WUserOutputProcessing::WUserOutputProcessing(std::mutex& inOutMtx) : inOutMtx(inOutMtx)
-{
-	std::lock_guard<std::mutex> inOutLock(inOutMtx);
-	results = std::make_shared<std::vector<std::shared_ptr<op::Datum>>>();
-	assert(static_cast<bool>(results));
-}
-
-void MinOpenPose::WUserOutputProcessing::initializationOnThread()
-{
-	std::lock_guard<std::mutex> inOutLock(inOutMtx);
-}
-
-void MinOpenPose::WUserOutputProcessing::work(std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>>& datumsPtr)
-{
-	std::lock_guard<std::mutex> inOutLock(inOutMtx);
-	assert(static_cast<bool>(results));
-	if (static_cast<bool>(datumsPtr) && !datumsPtr->empty()) {
-		for (auto datumPtr : *datumsPtr) results->push_back(datumPtr);
-	}
-}
-
-size_t MinOpenPose::WUserOutputProcessing::getResultsSize()
-{
-	std::lock_guard<std::mutex> inOutLock(inOutMtx);
-	assert(static_cast<bool>(results));
-	return results->size();
-}
-
-std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>> MinOpenPose::WUserOutputProcessing::getResultsAndReset()
-{
-	std::lock_guard<std::mutex> inOutLock(inOutMtx);
-	auto results = std::make_shared<std::vector<std::shared_ptr<op::Datum>>>();
-	results.swap(this->results);
-	assert(static_cast<bool>(results));
-	return results;
-}
-
-void MinOpenPose::WUserOutputProcessing::getErrors(std::vector<std::string>& errorMessage, bool clearErrors)
-{
-	std::lock_guard<std::mutex> inOutLock(inOutMtx);
-	for (auto error : this->errorMessage) errorMessage.push_back(error);
-	if (clearErrors) this->errorMessage.clear();
-}
-
-void MinOpenPose::WUserOutputProcessing::shutdown()
-{
-	std::lock_guard<std::mutex> inOutLock(inOutMtx);
-	this->stop();
-}
-
-MinOpenPose::MinOpenPose(op::PoseModel poseModel, op::Point<int> netInputSize)
-{
-	opInput = std::make_shared<WUserInputProcessing>(inOutMtx);
-	opOutput = std::make_shared<WUserOutputProcessing>(inOutMtx);
-	startup(poseModel, netInputSize);
-}
-
-MinOpenPose::~MinOpenPose()
-{
-	shutdown();
-}
-
-int MinOpenPose::startup(op::PoseModel poseModel, op::Point<int> netInputSize)
-{
-	// 変数の初期化
-	jobCount = 0;
-	errorMessage.clear();
-	opWrapper = std::make_unique<op::Wrapper>();
-
-	// 使用する骨格モデルの選択
-	wrapperStructPose.poseModel = poseModel;
-
-	// ネットワークの解像度の設定 (16の倍数のみ指定可能, -1は縦横比に合わせて自動計算される)
-	// 値は大きいほど精度が高く、処理も重い
-	wrapperStructPose.netInputSize = netInputSize;
-
-	// OpenPose に設定を適応
-	opWrapper->configure(wrapperStructPose);
-
-	// 画像入力 Worker の設定
-	opWrapper->setWorker(op::WorkerType::Input, opInput, true);
-
-	// 画像出力 Worker の設定
-	opWrapper->setWorker(op::WorkerType::Output, opOutput, true);
-
-	// OpenPose を別スレッドで実行
-	opThread = std::thread([&] {
-		try {
-			opWrapper->exec();
-		}
-		catch (const std::exception& e) {
-			std::lock_guard<std::mutex> inOutLock(inOutMtx);
-			errorMessage.push_back(e.what());
-		}
-	});
-	return 0;
-}
-
-MinOpenPose::People MinOpenPose::estimate(const cv::Mat& inputImage)
-{
-	// この関数が返す予定の値
-	People people;
-
-	// 画像が空であれば処理を終了する
-	if (inputImage.empty()) return people;
-
-	// OpenPose を実行しているスレッドで姿勢推定が終了するまでループして待つ
-	while (true)
-	{
-		// OpenPose の処理状態の確認
-		const ProcessState state = getProcessState();
-
-		// OpenPose が入力待機状態の場合
-		if (ProcessState::WaitInput == state)
-		{			
-			// OpenPose に画像を渡す
-			pushImage(inputImage, 0);
-
-			// 処理が終わるまでループ
-			continue;
-		}
-
-		// OpenPose が処理中の場合
-		if (ProcessState::Processing == state)
-		{
-			// 処理が終わるまでループ
-			continue;
-		}
-
-		// OpenPose のスレッドが終了している場合
-		if (ProcessState::Shutdown == state)
-		{
-			// エラーが発生して終了した場合はエラー内容を出力
-			for (auto err : errorMessage)
-			{
-				std::cout << err << std::endl;
-			}
-
-			// 処理を終了
-			return people;
-		}
-
-		// OpenPose の処理が終了した場合
-		if (ProcessState::Finish == state)
-		{
-			// 出力されたデータの取得
-			auto results = getResultsAndReset();
-			if (!static_cast<bool>(results)) return people;
-
-			// 出力されるデータの数だけループする (1つしか入力していないので1回だけループするはず)
-			for (auto result : *results)
-			{
-				// 画面内に映っている人数分ループする
-				for (int personIndex = 0; personIndex < result->poseKeypoints.getSize(0); personIndex++)
-				{
-					Person& nodes = people[(size_t)personIndex];
-					nodes.reserve(result->poseKeypoints.getSize(1));
-
-					// 骨格の数だけループする (BODY25のモデルを使う場合は25回)
-					for (int nodeIndex = 0; nodeIndex < result->poseKeypoints.getSize(1); nodeIndex++)
-					{
-						nodes.push_back(Node{
-							result->poseKeypoints[{personIndex, nodeIndex, 0}],
-							result->poseKeypoints[{personIndex, nodeIndex, 1}],
-							result->poseKeypoints[{personIndex, nodeIndex, 2}]
-						});
-					}
-				}
-
-				// 姿勢推定のプレビュー画像
-				//cv::Mat outputImage = result->cvOutputData;
-			}
-
-			return people;
-		}
-
-		// ここまで到達するこはないはず
-		assert(false);
-	}
-
-	// ここまで到達するこはないはず
-	assert(false);
-}
-
-void MinOpenPose::shutdown()
-{
-	// 既にシャットダウン済みの場合は何もしない
-	if (!isStartup()) return;
-
-	// スレッドを終了する
-	opInput->shutdown();
-	opOutput->shutdown();
-
-	// OpenPoseのスレッドが停止するまで待機
-	opThread.join();
-}
-
-bool MinOpenPose::isStartup() { return opThread.joinable(); }
-
-int MinOpenPose::pushImage(const cv::Mat& image, size_t frameNumber, size_t maxQueueSize)
-{
-	if (
-		(!isStartup()) ||
-		(image.type() != CV_8UC3)
-	) return 1;
-	if (opInput->pushImage(image, frameNumber, maxQueueSize)) return 1;
-	jobCount++;
-	return 0;
-}
-
-MinOpenPose::ProcessState MinOpenPose::getProcessState()
-{
-	assert(opOutput->getResultsSize() > jobCount);
-	
-	opInput->getErrors(errorMessage, true);
-	opOutput->getErrors(errorMessage, true);
-	if (!errorMessage.empty())
-	{
-		shutdown();
-	}
-
-	if (!isStartup()) { return ProcessState::Shutdown; }
-	else if (opOutput->getResultsSize() < jobCount) { return ProcessState::Processing; }
-	else if (opOutput->getResultsSize() == jobCount)
-	{ 
-		if (opOutput->getResultsSize() == 0) return ProcessState::WaitInput;
-		else return ProcessState::Finish;
-	}
-}
-
-std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>> MinOpenPose::getResultsAndReset()
-{
-	if (
-		(!isStartup()) ||
-		(getProcessState() != ProcessState::Finish)
-	)
-	{
-		return std::make_shared<std::vector<std::shared_ptr<op::Datum>>>();
-	}
-	jobCount = 0;
-	return opOutput->getResultsAndReset();
+#include "OpenPoseWrapper/MinimumOpenPose.h"
+
+MinOpenPose::WUserInputProcessing::WUserInputProcessing(std::mutex& inOutMtx) : inOutMtx(inOutMtx) {}
+
+void MinOpenPose::WUserInputProcessing::initializationOnThread()
+{
+	std::lock_guard<std::mutex> inOutLock(inOutMtx);
+}
+
+void MinOpenPose::WUserInputProcessing::work(std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>>& datumsPtr)
+{
+	std::lock_guard<std::mutex> inOutLock(inOutMtx);
+	try
+	{
+		// キューに画像が入っていた場合、1枚ずつ OpenPose に送る
+		datumsPtr = std::make_shared<std::vector<std::shared_ptr<op::Datum>>>();
+		if (!images.empty())
+		{
+			auto datumPtr = std::make_shared<op::Datum>();
+			datumPtr->subId = 0;
+			datumPtr->subIdMax = 0;
+			datumPtr->name = "output";
+			datumPtr->frameNumber = images.front().second;
+			datumPtr->cvInputData = images.front().first;
+			images.pop();
+			datumPtr->cvOutputData = datumPtr->cvInputData;
+			datumsPtr->push_back(datumPtr); // datumsPtr は2つ以上の要素を持てない
+		}
+	}
+	catch (const std::exception& e)
+	{
+		errorMessage.push_back(e.what());
+		this->stop();
+	}
+}
+
+int MinOpenPose::WUserInputProcessing::pushImage(const cv::Mat& image, size_t frameNumber, size_t maxQueueSize)
+{
+	std::lock_guard<std::mutex> inOutLock(inOutMtx);
+	if (images.size() >= maxQueueSize) return 1;
+	images.push(std::pair<cv::Mat, size_t>(image, frameNumber));
+	return 0;
+}
+
+void MinOpenPose::WUserInputProcessing::getErrors(std::vector<std::string>& errorMessage, bool clearErrors)
+{
+	std::lock_guard<std::mutex> inOutLock(inOutMtx);
+	for (auto error : this->errorMessage) errorMessage.push_back(error);
+	if (clearErrors) this->errorMessage.clear();
+}
+
+void MinOpenPose::WUserInputProcessing::shutdown()
+{
+	std::lock_guard<std::mutex> inOutLock(inOutMtx);
+	this->stop();
+}
+
+MinOpenPose::WUserOutputProcessing::WUserOutputProcessing(std::mutex& inOutMtx) : inOutMtx(inOutMtx)
+{
+	std::lock_guard<std::mutex> inOutLock(inOutMtx);
+	results = std::make_shared<std::vector<std::shared_ptr<op::Datum>>>();
+	assert(static_cast<bool>(results));
+}
+
+void MinOpenPose::WUserOutputProcessing::initializationOnThread()
+{
+	std::lock_guard<std::mutex> inOutLock(inOutMtx);
+}
+
+void MinOpenPose::WUserOutputProcessing::work(std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>>& datumsPtr)
+{
+	std::lock_guard<std::mutex> inOutLock(inOutMtx);
+	assert(static_cast<bool>(results));
+	if (static_cast<bool>(datumsPtr) && !datumsPtr->empty()) {
+		for (auto datumPtr : *datumsPtr) results->push_back(datumPtr);
+	}
+}
+
+size_t MinOpenPose::WUserOutputProcessing::getResultsSize()
+{
+	std::lock_guard<std::mutex> inOutLock(inOutMtx);
+	assert(static_cast<bool>(results));
+	return results->size();
+}
+
+std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>> MinOpenPose::WUserOutputProcessing::getResultsAndReset()
+{
+	std::lock_guard<std::mutex> inOutLock(inOutMtx);
+	auto results = std::make_shared<std::vector<std::shared_ptr<op::Datum>>>();
+	results.swap(this->results);
+	assert(static_cast<bool>(results));
+	return results;
+}
+
+void MinOpenPose::WUserOutputProcessing::getErrors(std::vector<std::string>& errorMessage, bool clearErrors)
+{
+	std::lock_guard<std::mutex> inOutLock(inOutMtx);
+	for (auto error : this->errorMessage) errorMessage.push_back(error);
+	if (clearErrors) this->errorMessage.clear();
+}
+
+void MinOpenPose::WUserOutputProcessing::shutdown()
+{
+	std::lock_guard<std::mutex> inOutLock(inOutMtx);
+	this->stop();
+}
+
+MinOpenPose::MinOpenPose(op::PoseModel poseModel, op::Point<int> netInputSize)
+{
+	// OpenPose は最初に姿勢推定が必要になったときに起動する
+	// (SQLに記録済みの結果のみを使う場合はモデルを読み込まずに済む)
+	wrapperStructPose.poseModel = poseModel;
+	wrapperStructPose.netInputSize = netInputSize;
+}
+
+MinOpenPose::~MinOpenPose()
+{
+	shutdown();
+}
+
+int MinOpenPose::startup(op::PoseModel poseModel, op::Point<int> netInputSize)
+{
+	// 既に OpenPose が開始していた場合は何もしない
+	if (isStartup()) return 0;
+
+	// 変数の初期化
+	// 停止した Worker は再利用できないため、起動のたびに生成する
+	isLaunched = true;
+	jobCount = 0;
+	errorMessage.clear();
+	opInput = std::make_shared<WUserInputProcessing>(inOutMtx);
+	opOutput = std::make_shared<WUserOutputProcessing>(inOutMtx);
+	opWrapper = std::make_unique<op::Wrapper>();
+
+	// 使用する骨格モデルの選択
+	wrapperStructPose.poseModel = poseModel;
+
+	// ネットワークの解像度の設定 (16の倍数のみ指定可能, -1は縦横比に合わせて自動計算される)
+	// 値は大きいほど精度が高く、処理も重い
+	wrapperStructPose.netInputSize = netInputSize;
+
+	// OpenPose に設定を適応
+	opWrapper->configure(wrapperStructPose);
+
+	// 画像入力 Worker の設定
+	opWrapper->setWorker(op::WorkerType::Input, opInput, true);
+
+	// 画像出力 Worker の設定
+	opWrapper->setWorker(op::WorkerType::Output, opOutput, true);
+
+	// OpenPose を別スレッドで実行
+	opThread = std::thread([&] {
+		try {
+			opWrapper->exec();
+		}
+		catch (const std::exception& e) {
+			std::lock_guard<std::mutex> inOutLock(inOutMtx);
+			errorMessage.push_back(e.what());
+		}
+	});
+	return 0;
+}
+
+MinOpenPose::People MinOpenPose::estimate(const cv::Mat& inputImage)
+{
+	// この関数が返す予定の値
+	People people;
+
+	// 画像が空であれば処理を終了する
+	if (inputImage.empty()) return people;
+
+	// OpenPose が一度も起動していなければ起動する
+	if (!isLaunched) warmup();
+
+	// OpenPose を実行しているスレッドで姿勢推定が終了するまでループして待つ
+	while (true)
+	{
+		// OpenPose の処理状態の確認
+		const ProcessState state = getProcessState();
+
+		// OpenPose が入力待機状態の場合
+		if (ProcessState::WaitInput == state)
+		{			
+			// OpenPose に画像を渡す
+			pushImage(inputImage, 0);
+
+			// 処理が終わるまでループ
+			continue;
+		}
+
+		// OpenPose が処理中の場合
+		if (ProcessState::Processing == state)
+		{
+			// 処理が終わるまでループ
+			continue;
+		}
+
+		// OpenPose のスレッドが終了している場合
+		if (ProcessState::Shutdown == state)
+		{
+			// エラーが発生して終了した場合はエラー内容を出力
+			for (auto err : errorMessage)
+			{
+				std::cout << err << std::endl;
+			}
+
+			// 処理を終了
+			return people;
+		}
+
+		// OpenPose の処理が終了した場合
+		if (ProcessState::Finish == state)
+		{
+			// 出力されたデータの取得
+			auto results = getResultsAndReset();
+			if (!static_cast<bool>(results)) return people;
+
+			// 出力されるデータの数だけループする (1つしか入力していないので1回だけループするはず)
+			for (auto result : *results)
+			{
+				// 画面内に映っている人数分ループする
+				for (int personIndex = 0; personIndex < result->poseKeypoints.getSize(0); personIndex++)
+				{
+					Person& nodes = people[(size_t)personIndex];
+					nodes.reserve(result->poseKeypoints.getSize(1));
+
+					// 骨格の数だけループする (BODY25のモデルを使う場合は25回)
+					for (int nodeIndex = 0; nodeIndex < result->poseKeypoints.getSize(1); nodeIndex++)
+					{
+						nodes.push_back(Node{
+							result->poseKeypoints[{personIndex, nodeIndex, 0}],
+							result->poseKeypoints[{personIndex, nodeIndex, 1}],
+							result->poseKeypoints[{personIndex, nodeIndex, 2}]
+						});
+					}
+				}
+
+				// 姿勢推定のプレビュー画像
+				//cv::Mat outputImage = result->cvOutputData;
+			}
+
+			return people;
+		}
+
+		// ここまで到達するこはないはず
+		assert(false);
+	}
+
+	// ここまで到達するこはないはず
+	assert(false);
+}
+
+MinOpenPose::People MinOpenPose::estimate(const cv::Mat& inputImage, const std::vector<cv::Rect>& regions)
+{
+	// この関数が返す予定の値
+	People people;
+
+	// 画像が空であれば処理を終了する
+	if (inputImage.empty()) return people;
+
+	// 領域をタイルに分けてモザイクに並べる
+	std::vector<Tile> tiles;
+	const int mosaicWidth = layoutTiles(cv::Size{ inputImage.cols, inputImage.rows }, regions, tiles);
+	if (tiles.empty()) return people;
+
+	// モザイクの方が画像全体より計算量が少なくならない場合は、画像全体の姿勢推定を行う
+	if ((wrapperStructPose.netInputSize.x != -1) || (mosaicWidth >= inputImage.cols)) return estimate(inputImage);
+
+	// 領域を切り出してモザイクに並べ、1回で姿勢推定を行う
+	cv::Mat mosaic(inputImage.rows, mosaicWidth, inputImage.type(), cv::Scalar{ 0, 0, 0 });
+	for (auto&& tile : tiles)
+	{
+		cv::Mat dst = mosaic(cv::Rect{ tile.position.x, tile.position.y, tile.source.width, tile.source.height });
+		inputImage(tile.source).copyTo(dst);
+	}
+	People mosaicPeople = estimate(mosaic);
+
+	// 検出された骨格の座標を元の画像の座標に戻す
+	size_t personIndex = 0;
+	for (auto&& person : mosaicPeople)
+	{
+		// 信頼値が 0 より大きい関節の重心から、人が検出されたタイルを求める
+		float sumX = 0.0f, sumY = 0.0f;
+		int count = 0;
+		for (auto&& node : person.second)
+		{
+			if (node.confidence == 0.0f) continue;
+			sumX += node.x;
+			sumY += node.y;
+			count++;
+		}
+		if (count == 0) continue;
+		const cv::Point center{ (int)(sumX / (float)count), (int)(sumY / (float)count) };
+		auto tile = std::find_if(tiles.begin(), tiles.end(), [&](const Tile& tile) {
+			return cv::Rect{ tile.position.x, tile.position.y, tile.source.width, tile.source.height }.contains(center);
+		});
+		if (tile == tiles.end()) continue;
+
+		// 分割した領域の重なりで検出された人は、担当するタイルで検出された方だけを残す
+		const int offsetX = tile->source.x - tile->position.x;
+		const int offsetY = tile->source.y - tile->position.y;
+		if ((center.x + offsetX < tile->coreLeft) || (center.x + offsetX >= tile->coreRight)) continue;
+
+		for (auto&& node : person.second)
+		{
+			// 信頼値が 0 の関節は座標が (0, 0) になっているので移動しない
+			if (node.confidence == 0.0f) continue;
+			node.x += (float)offsetX;
+			node.y += (float)offsetY;
+		}
+		people[personIndex++] = std::move(person.second);
+	}
+
+	return people;
+}
+
+int MinOpenPose::layoutTiles(const cv::Size& imageSize, const std::vector<cv::Rect>& regions, std::vector<Tile>& tiles)
+{
+	// タイルの間の余白 (隣り合うタイルにまたがって人が検出されないようにする)
+	const int gap = 16;
+
+	tiles.clear();
+	const cv::Rect imageRect{ 0, 0, imageSize.width, imageSize.height };
+	int columnX = 0, columnY = 0, columnWidth = 0;
+	for (auto region : regions)
+	{
+		// 画像からはみ出した部分を切り捨てる
+		region &= imageRect;
+		if (region.area() == 0) continue;
+
+		// 1列に積み重ねられる数だけ、高さと同じ幅を重ねて分割する (分割した幅が重なりに対して狭すぎる場合は減らす)
+		const int overlap = region.height;
+		int count = std::max(1, (imageSize.height + gap) / (region.height + gap));
+		while ((count > 1) && ((region.width + (count - 1) * overlap) / count < overlap * 2)) count--;
+		const int width = (region.width + (count - 1) * overlap + count - 1) / count;
+
+		// 分割したタイルの左端 (最後のタイルは領域の右端に揃える)
+		std::vector<int> lefts;
+		for (int i = 0; i < count; i++) lefts.push_back((i == count - 1) ? (region.x + region.width - width) : (region.x + i * (width - overlap)));
+
+		for (int i = 0; i < count; i++)
+		{
+			Tile tile;
+			tile.source = cv::Rect{ lefts[i], region.y, width, region.height };
+			tile.coreLeft = (i == 0) ? region.x : (lefts[i - 1] + width + lefts[i]) / 2;
+			tile.coreRight = (i == count - 1) ? (region.x + region.width) : (lefts[i] + width + lefts[i + 1]) / 2;
+
+			// 列に収まらない場合は次の列に並べる
+			if ((columnY > 0) && (columnY + region.height > imageSize.height))
+			{
+				columnX += columnWidth + gap;
+				columnY = 0;
+				columnWidth = 0;
+			}
+			tile.position = cv::Point{ columnX, columnY };
+			columnY += region.height + gap;
+			columnWidth = std::max(columnWidth, width);
+			tiles.push_back(tile);
+		}
+	}
+
+	return columnX + columnWidth;
+}
+
+void MinOpenPose::warmup()
+{
+	startup(wrapperStructPose.poseModel, wrapperStructPose.netInputSize);
+}
+
+int MinOpenPose::setNetInputSize(op::Point<int> netInputSize)
+{
+	// 解像度に変更が無ければ何もしない
+	if (isStartup() && (wrapperStructPose.netInputSize == netInputSize)) return 0;
+
+	// まだ起動していなければ、起動時に使う解像度のみを変更する
+	if (!isLaunched)
+	{
+		wrapperStructPose.netInputSize = netInputSize;
+		return 0;
+	}
+
+	// OpenPose を再起動して新しい解像度を適用する
+	shutdown();
+	return startup(wrapperStructPose.poseModel, netInputSize);
+}
+
+void MinOpenPose::shutdown()
+{
+	// 既にシャットダウン済みの場合は何もしない
+	if (!isStartup()) return;
+
+	// スレッドを終了する
+	opInput->shutdown();
+	opOutput->shutdown();
+
+	// OpenPoseのスレッドが停止するまで待機
+	opThread.join();
+}
+
+bool MinOpenPose::isStartup() { return opThread.joinable(); }
+
+int MinOpenPose::pushImage(const cv::Mat& image, size_t frameNumber, size_t maxQueueSize)
+{
+	if (
+		(!isStartup()) ||
+		(image.type() != CV_8UC3)
+	) return 1;
+	if (opInput->pushImage(image, frameNumber, maxQueueSize)) return 1;
+	jobCount++;
+	return 0;
+}
+
+MinOpenPose::ProcessState MinOpenPose::getProcessState()
+{
+	assert(opOutput->getResultsSize() > jobCount);
+	
+	opInput->getErrors(errorMessage, true);
+	opOutput->getErrors(errorMessage, true);
+	if (!errorMessage.empty())
+	{
+		shutdown();
+	}
+
+	if (!isStartup()) { return ProcessState::Shutdown; }
+	else if (opOutput->getResultsSize() < jobCount) { return ProcessState::Processing; }
+	else if (opOutput->getResultsSize() == jobCount)
+	{ 
+		if (opOutput->getResultsSize() == 0) return ProcessState::WaitInput;
+		else return ProcessState::Finish;
+	}
+}
+
+std::shared_ptr<std::vector<std::shared_ptr<op::Datum>>> MinOpenPose::getResultsAndReset()
+{
+	if (
+		(!isStartup()) ||
+		(getProcessState() != ProcessState::Finish)
+	)
+	{
+		return std::make_shared<std::vector<std::shared_ptr<op::Datum>>>();
+	}
+	jobCount = 0;
+	return opOutput->getResultsAndReset();
 }
\ No newline at end of file
@@ -1,5 +1,8 @@
 #include <Utils/Database.h>
 
+#include <algorithm>
+#include <filesystem>
+
 #ifdef SQLITECPP_ENABLE_ASSERT_HANDLER
 namespace SQLite
 {
@@ -41,26 +44,228 @@ Database::Database() {}
 
 Database::~Database()
 {
-	if (upTransaction) upTransaction->commit();
+	clearStatementCache();
+	if (commitPending()) std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << path << " : the last changes could not be committed" << std::endl;
+	stopCheckpointThread();
 }
 
-int Database::create(const std::string& path, const int aFlags)
+int Database::create(const std::string& path, const int aFlags, const StorageProfile profile)
 {
+	stopCheckpointThread();
+	clearStatementCache();
+	upTransaction.reset();
+	this->path = path;
+	this->profile = profile;
+
 	try
 	{
-		// path̕R[hK؂łȂ\̂ŁAtryŎsꍇcatchUTF8ɕϊĂxĂ݂
-		try
+		// sqlファイルの作成
+		database = createConnection(path, (profile == StorageProfile::ReadOnlyAnalytics) ? SQLite::OPEN_READONLY : aFlags);
+
+		// 設定の反映 (journal_modeはトランザクションの中では変更できないため、トランザクションの前に行う)
+		if (applyProfile(*database, profile)) return 1;
+
+		// トランザクションの開始
+		// (読み込み専用の場合は、他のプロセスが書き込んだ結果が見えるようにトランザクションを張り続けない)
+		if (profile != StorageProfile::ReadOnlyAnalytics) upTransaction = std::make_unique<SQLite::Transaction>(*database);
+	}
+	catch (const std::exception & e)
+	{
+		std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+		return 1;
+	}
+
+	// WALのチェックポイントは記録中のスレッドとは別に行う
+	if (profile == StorageProfile::LiveIngest) return startCheckpointThread();
+
+	return 0;
+}
+
+int Database::applyProfile(SQLite::Database& connection, const StorageProfile profile)
+{
+	try
+	{
+		switch (profile)
 		{
-			// sqlt@C̍쐬
-			database = std::make_shared<SQLite::Database>(path, aFlags);
+		case StorageProfile::Default:
+			// 先読みなどの別の接続が読み込み中でも、コミットがすぐに失敗しないように待つ
+			connection.setBusyTimeout(5000);
+			break;
+
+		case StorageProfile::LiveIngest:
+			// page_sizeはWALに切り替える前に設定する必要がある
+			connection.exec(u8"PRAGMA page_size=4096");
+			connection.exec(u8"PRAGMA journal_mode=WAL");
+			connection.exec(u8"PRAGMA synchronous=NORMAL");
+			connection.exec(u8"PRAGMA wal_autocheckpoint=0");
+			connection.exec(u8"PRAGMA mmap_size=268435456");
+			connection.exec(u8"PRAGMA cache_size=-32768");
+			connection.exec(u8"PRAGMA temp_store=MEMORY");
+			connection.setBusyTimeout(5000);
+			break;
+
+		case StorageProfile::BulkImport:
+			connection.exec(u8"PRAGMA page_size=16384");
+			connection.exec(u8"PRAGMA journal_mode=WAL");
+			connection.exec(u8"PRAGMA synchronous=OFF");
+			connection.exec(u8"PRAGMA mmap_size=1073741824");
+			connection.exec(u8"PRAGMA cache_size=-262144");
+			connection.exec(u8"PRAGMA temp_store=MEMORY");
+			connection.setBusyTimeout(5000);
+			break;
+
+		case StorageProfile::ReadOnlyAnalytics:
+			connection.exec(u8"PRAGMA query_only=1");
+			connection.exec(u8"PRAGMA mmap_size=1073741824");
+			connection.exec(u8"PRAGMA cache_size=-65536");
+			connection.exec(u8"PRAGMA temp_store=MEMORY");
+			connection.setBusyTimeout(5000);
+			break;
 		}
-		catch (const std::exception& e)
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+int Database::startCheckpointThread(const std::chrono::milliseconds interval)
+{
+	stopCheckpointThread();
+
+	// チェックポイント専用の接続を開く
+	std::shared_ptr<SQLite::Database> connection;
+	try
+	{
+		connection = createConnection(path, SQLite::OPEN_READWRITE);
+		connection->setBusyTimeout(1000);
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+		return 1;
+	}
+
+	isCheckpointStopped = false;
+	checkpointThread = std::thread([this, connection, interval]() {
+		std::unique_lock<std::mutex> lock(checkpointMutex);
+		while (!isCheckpointStopped)
 		{
-			// sqlt@C̍쐬
-			database = std::make_shared<SQLite::Database>(toUTF8(path), aFlags);
+			checkpointCondition.wait_for(lock, interval, [this]() { return isCheckpointStopped; });
+
+			// 読み込み中の接続を待たずに、書き戻せる分だけ書き戻す
+			try
+			{
+				(void)connection->exec(u8"PRAGMA wal_checkpoint(PASSIVE)");
+			}
+			catch (const std::exception& e)
+			{
+				std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+			}
 		}
+	});
+
+	return 0;
+}
+
+void Database::stopCheckpointThread()
+{
+	if (!checkpointThread.joinable()) return;
+	{
+		std::lock_guard<std::mutex> lock(checkpointMutex);
+		isCheckpointStopped = true;
+	}
+	checkpointCondition.notify_all();
+	checkpointThread.join();
+}
 
-		// gUNV̊Jn
+std::shared_ptr<SQLite::Database> Database::createConnection(const std::string& path, const int aFlags)
+{
+	// pathの文字コードが適切でない可能性があるので、tryで失敗した場合はcatchでUTF8に変換してもう一度試してみる
+	try
+	{
+		return std::make_shared<SQLite::Database>(path, aFlags);
+	}
+	catch (const std::exception& e)
+	{
+		return std::make_shared<SQLite::Database>(toUTF8(path), aFlags);
+	}
+}
+
+std::shared_ptr<SQLite::Statement> Database::getStatement(const std::string& query) const
+{
+	auto itr = statements.find(query);
+	if (itr == statements.end())
+	{
+		// キャッシュに無い場合はSQL文をコンパイルし、容量を超えた場合は最も長く使われていないものを削除する
+		auto statement = std::make_shared<SQLite::Statement>(*database, query);
+		statementOrder.push_front(query);
+		itr = statements.emplace(query, std::make_pair(statement, statementOrder.begin())).first;
+		while (statements.size() > std::max<size_t>(statementCacheCapacity, 1))
+		{
+			statements.erase(statementOrder.back());
+			statementOrder.pop_back();
+		}
+	}
+	else
+	{
+		// 使用中の場合 (戻り値がまだ破棄されていない場合) は、キャッシュしないSQL文を返す
+		if (itr->second.first.use_count() > 1) return std::make_shared<SQLite::Statement>(*database, query);
+
+		// 最近使われたものとして一覧の先頭に移動する
+		statementOrder.splice(statementOrder.begin(), statementOrder, itr->second.second);
+	}
+
+	// 戻り値が破棄されたときにreset()する (キャッシュが先に消去された場合でもSQL文は戻り値が破棄されるまで残る)
+	std::shared_ptr<SQLite::Statement> statement = itr->second.first;
+	statement->reset();
+	statement->clearBindings();
+	return std::shared_ptr<SQLite::Statement>(statement.get(), [statement](SQLite::Statement* query) {
+		try { query->reset(); }
+		catch (const std::exception&) {}
+	});
+}
+
+void Database::clearStatementCache() const
+{
+	statements.clear();
+	statementOrder.clear();
+	knownTables.clear();
+	knownIndexes.clear();
+}
+
+bool Database::isSchemaExist(const std::string& type, const std::string& name) const
+{
+	auto query = getStatement(u8"SELECT count(*) FROM sqlite_master WHERE type=? AND name=?");
+	query->bind(1, type);
+	query->bind(2, name);
+	(void)query->executeStep();
+	return (0 < query->getColumn(0).getInt());
+}
+
+bool Database::isTableExist(const std::string& tableName) const
+{
+	if (knownTables.count(tableName)) return true;
+	if (!isSchemaExist(u8"table", tableName)) return false;
+	knownTables.insert(tableName);
+	return true;
+}
+
+int Database::commit()
+{
+	// 読み込み専用の場合はトランザクションを張らない
+	if (profile == StorageProfile::ReadOnlyAnalytics) return 0;
+
+	if (commitPending()) return 1;
+
+	// WALが大きくなりすぎた場合は、トランザクションを張り直す前に書き戻してWALを切り詰める
+	if (profile == StorageProfile::LiveIngest) truncateWal();
+
+	try
+	{
 		upTransaction = std::make_unique<SQLite::Transaction>(*database);
 	}
 	catch (const std::exception & e)
@@ -72,12 +277,35 @@ int Database::create(const std::string& path, const int aFlags)
 	return 0;
 }
 
-int Database::commit()
+void Database::truncateWal()
 {
+	if (walSizeLimit == 0) return;
+	std::error_code ec;
+	const auto size = std::filesystem::file_size(path + u8"-wal", ec);
+	if (ec || ((uint64_t)size < walSizeLimit)) return;
+
+	// 読み込み中の接続がある場合は少しだけ待ち、それでも切り詰められない場合は記録を止めずに次のコミットでやり直す
 	try
 	{
-		if (upTransaction) upTransaction->commit();
-		upTransaction = std::make_unique<SQLite::Transaction>(*database);
+		database->setBusyTimeout(100);
+		(void)database->exec(u8"PRAGMA wal_checkpoint(TRUNCATE)");
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+	}
+	database->setBusyTimeout(5000);
+}
+
+int Database::commitPending()
+{
+	if (!upTransaction) return 0;
+
+	try
+	{
+		// 失敗した場合 (ビジータイムアウトを過ぎた場合など) はトランザクションを残し、次の commit() でやり直す
+		upTransaction->commit();
+		upTransaction.reset();
 	}
 	catch (const std::exception & e)
 	{
@@ -92,9 +320,10 @@ int Database::createTableIfNoExist(const std::string& tableName, const std::stri
 {
 	try
 	{
-		if (!isDataExist("sqlite_master", "type", "name", "table", tableName))
+		if (!isTableExist(tableName))
 		{
 			database->exec(u8"CREATE TABLE " + tableName + " (" + rowTitles + u8")");
+			knownTables.insert(tableName);
 		}
 	}
 	catch (const std::exception & e)
@@ -111,10 +340,12 @@ int Database::createIndexIfNoExist(const std::string& tableName, const std::stri
 	try
 	{
 		std::string indexName = "idx_" + rowTitle + u8"_on_" + tableName;
-		if (!isDataExist("sqlite_master", "type", "name", "index", indexName))
+		if (knownIndexes.count(indexName)) return 0;
+		if (!isSchemaExist(u8"index", indexName))
 		{
 			database->exec(u8"CREATE" + std::string(isUnique ? u8" UNIQUE" : u8"") + " INDEX " + indexName + u8" ON " + tableName + u8"(" + rowTitle + u8")");
 		}
+		knownIndexes.insert(indexName);
 	}
 	catch (const std::exception & e)
 	{
@@ -130,10 +361,12 @@ int Database::createIndexIfNoExist(const std::string& tableName, const std::stri
 	try
 	{
 		std::string indexName = "idx_" + rowTitle1 + u8"_and_" + rowTitle2 + u8"_on_" + tableName;
-		if (!isDataExist("sqlite_master", "type", "name", "index", indexName))
+		if (knownIndexes.count(indexName)) return 0;
+		if (!isSchemaExist(u8"index", indexName))
 		{
 			database->exec(u8"CREATE" + std::string(isUnique ? u8" UNIQUE" : u8"") + " INDEX " + indexName + u8" ON " + tableName + u8"(" + rowTitle1 + u8", " + rowTitle2 + u8")");
 		}
+		knownIndexes.insert(indexName);
 	}
 	catch (const std::exception & e)
 	{
@@ -148,6 +381,8 @@ int Database::deleteTableIfExist(const std::string& tableName)
 {
 	try
 	{
+		// キャッシュされたSQL文が削除するテーブルを参照している可能性があるため、先に消去する
+		clearStatementCache();
 		database->exec(u8"DROP TABLE IF EXISTS " + tableName);
 	}
 	catch (const std::exception & e)
@@ -161,36 +396,36 @@ int Database::deleteTableIfExist(const std::string& tableName)
 
 bool Database::isDataExist(const  std::string& tableName, const  std::string& rowTitle, long long number) const
 {
-	SQLite::Statement timestampQuery(*database, u8"SELECT count(*) FROM " + tableName + " WHERE " + rowTitle + "=?");
-	timestampQuery.bind(1, (long long)number);
-	(void)timestampQuery.executeStep();
-	return (0 < timestampQuery.getColumn(0).getInt());
+	auto timestampQuery = getStatement(u8"SELECT count(*) FROM " + tableName + " WHERE " + rowTitle + "=?");
+	timestampQuery->bind(1, (long long)number);
+	(void)timestampQuery->executeStep();
+	return (0 < timestampQuery->getColumn(0).getInt());
 }
 
 bool Database::isDataExist(const  std::string& tableName, const  std::string& rowTitle1, std::string rowTitle2, long long number1, long long number2) const
 {
-	SQLite::Statement timestampQuery(*database, u8"SELECT count(*) FROM " + tableName + " WHERE " + rowTitle1 + "=? AND " + rowTitle2 + "=?");
-	timestampQuery.bind(1, (long long)number1);
-	timestampQuery.bind(2, (long long)number2);
-	(void)timestampQuery.executeStep();
-	return (0 < timestampQuery.getColumn(0).getInt());
+	auto timestampQuery = getStatement(u8"SELECT count(*) FROM " + tableName + " WHERE " + rowTitle1 + "=? AND " + rowTitle2 + "=?");
+	timestampQuery->bind(1, (long long)number1);
+	timestampQuery->bind(2, (long long)number2);
+	(void)timestampQuery->executeStep();
+	return (0 < timestampQuery->getColumn(0).getInt());
 }
 
 bool Database::isDataExist(const  std::string& tableName, const  std::string& rowTitle, const  std::string& text) const
 {
-	SQLite::Statement timestampQuery(*database, u8"SELECT count(*) FROM " + tableName + " WHERE " + rowTitle + "=?");
-	timestampQuery.bind(1, text);
-	(void)timestampQuery.executeStep();
-	return (0 < timestampQuery.getColumn(0).getInt());
+	auto timestampQuery = getStatement(u8"SELECT count(*) FROM " + tableName + " WHERE " + rowTitle + "=?");
+	timestampQuery->bind(1, text);
+	(void)timestampQuery->executeStep();
+	return (0 < timestampQuery->getColumn(0).getInt());
 }
 
 bool Database::isDataExist(const  std::string& tableName, const  std::string& rowTitle1, const  std::string& rowTitle2, const  std::string& text1, const  std::string& text2) const
 {
-	SQLite::Statement timestampQuery(*database, u8"SELECT count(*) FROM " + tableName + " WHERE " + rowTitle1 + "=? AND " + rowTitle2 + "=?");
-	timestampQuery.bind(1, text1);
-	timestampQuery.bind(2, text2);
-	(void)timestampQuery.executeStep();
-	return (0 < timestampQuery.getColumn(0).getInt());
+	auto timestampQuery = getStatement(u8"SELECT count(*) FROM " + tableName + " WHERE " + rowTitle1 + "=? AND " + rowTitle2 + "=?");
+	timestampQuery->bind(1, text1);
+	timestampQuery->bind(2, text2);
+	(void)timestampQuery->executeStep();
+	return (0 < timestampQuery->getColumn(0).getInt());
 }
 
 void Database::bind(SQLite::Statement&, size_t) const {}
\ No newline at end of file
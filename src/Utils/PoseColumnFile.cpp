@@ -0,0 +1,549 @@
+#include <Utils/PoseColumnFile.h>
+
+#include <filesystem>
+#include <cstring>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	// ファイルの末尾のサイズ (フッターの位置, フッターのサイズ, 識別子)
+	constexpr uint64_t tailSize = sizeof(uint64_t) * 2 + sizeof(PoseColumnFormat::magic);
+
+	// バイト列に値を追加する
+	template<typename T>
+	void put(std::vector<uint8_t>& buffer, const T& value)
+	{
+		const uint8_t* p = (const uint8_t*)&value;
+		buffer.insert(buffer.end(), p, p + sizeof(T));
+	}
+
+	// バイト列から値を取り出す (範囲外の場合はfalseを返す)
+	template<typename T>
+	bool get(const uint8_t*& p, const uint8_t* end, T& value)
+	{
+		if ((size_t)(end - p) < sizeof(T)) return false;
+		std::memcpy(&value, p, sizeof(T));
+		p += sizeof(T);
+		return true;
+	}
+
+	/**
+	 * フッターからテーブルとチャンクの一覧を読み込む
+	 * @param footer フッターの先頭
+	 * @param footerSize フッターのサイズ
+	 * @param footerOffset フッターの位置 (チャンクがフッターより手前にあるかの確認に使う)
+	 * @return 正しく読み込めた場合はtrueが返る
+	 */
+	bool parseFooter(
+		const uint8_t* footer, size_t footerSize, uint64_t footerOffset,
+		std::vector<std::pair<std::string, PoseColumnFormat::Kind>>& tables,
+		std::vector<PoseColumnFormat::ChunkInfo>& chunks
+	)
+	{
+		const uint8_t* p = footer;
+		const uint8_t* end = footer + footerSize;
+
+		// テーブルの一覧
+		uint32_t tableCount = 0;
+		if (!get(p, end, tableCount)) return false;
+		for (uint32_t i = 0; i < tableCount; i++)
+		{
+			uint16_t length = 0;
+			uint8_t kind = 0;
+			if (!get(p, end, length)) return false;
+			if ((size_t)(end - p) < length) return false;
+			std::string name((const char*)p, length);
+			p += length;
+			if (!get(p, end, kind) || (kind > (uint8_t)PoseColumnFormat::Kind::Points)) return false;
+			tables.push_back({ name, (PoseColumnFormat::Kind)kind });
+		}
+
+		// チャンクの一覧
+		uint32_t chunkCount = 0;
+		if (!get(p, end, chunkCount)) return false;
+		for (uint32_t i = 0; i < chunkCount; i++)
+		{
+			PoseColumnFormat::ChunkInfo chunk;
+			if (!get(p, end, chunk.table) || !get(p, end, chunk.rows) || !get(p, end, chunk.firstFrame) || !get(p, end, chunk.lastFrame) || !get(p, end, chunk.offset)) return false;
+			if (chunk.table >= tables.size()) return false;
+			const size_t valuesPerRow = PoseColumnFormat::valuesPerRow(tables[chunk.table].second);
+			if (PoseColumnFormat::valuesOffset(chunk) + chunk.rows * valuesPerRow * sizeof(float) > footerOffset) return false;
+			chunks.push_back(chunk);
+		}
+
+		return true;
+	}
+}
+
+PoseColumnWriter::PoseColumnWriter(size_t chunkRows) : chunkRows{ (chunkRows == 0) ? 1 : chunkRows } {}
+
+PoseColumnWriter::~PoseColumnWriter()
+{
+	close();
+}
+
+int PoseColumnWriter::open(const std::string& path)
+{
+	close();
+	this->path = path;
+	tables.clear();
+	chunks.clear();
+	dataEnd = 0;
+	fileEnd = 0;
+
+	try
+	{
+		// 既存のファイルがあれば、フッターを読み込んで末尾に追記する
+		std::error_code ec;
+		if (std::filesystem::exists(path, ec) && (std::filesystem::file_size(path, ec) > 0))
+		{
+			const uint64_t fileSize = (uint64_t)std::filesystem::file_size(path, ec);
+			std::ifstream input(path, std::ios::binary);
+			char header[sizeof(PoseColumnFormat::magic)] = {};
+			uint8_t tail[tailSize] = {};
+			input.read(header, sizeof(header));
+			if (fileSize >= PoseColumnFormat::alignment + tailSize)
+			{
+				input.seekg((std::streamoff)(fileSize - tailSize), std::ios::beg);
+				input.read((char*)tail, sizeof(tail));
+			}
+			uint64_t footerOffset = 0, footerSize = 0;
+			const uint8_t* p = tail;
+			get(p, tail + tailSize, footerOffset);
+			get(p, tail + tailSize, footerSize);
+			std::vector<std::pair<std::string, Kind>> tableList;
+			bool isValid =
+				input.good() &&
+				(std::memcmp(header, PoseColumnFormat::magic, sizeof(header)) == 0) &&
+				(std::memcmp(tail + sizeof(uint64_t) * 2, PoseColumnFormat::magic, sizeof(PoseColumnFormat::magic)) == 0) &&
+				(footerOffset >= PoseColumnFormat::alignment) && (footerOffset + footerSize + tailSize <= fileSize);
+			if (isValid)
+			{
+				std::vector<uint8_t> footer((size_t)footerSize);
+				input.seekg((std::streamoff)footerOffset, std::ios::beg);
+				input.read((char*)footer.data(), (std::streamsize)footer.size());
+				isValid = input.good() && parseFooter(footer.data(), footer.size(), footerOffset, tableList, chunks);
+			}
+			if (!isValid)
+			{
+				std::cout << path << u8"は.pcol形式のファイルではありません。" << std::endl;
+				chunks.clear();
+				return 1;
+			}
+
+			// テーブルごとに、最後に追記したフレーム番号を復元する
+			for (auto&& item : tableList)
+			{
+				Table table;
+				table.name = item.first;
+				table.kind = item.second;
+				tables.push_back(table);
+			}
+			for (auto&& chunk : chunks)
+			{
+				tables[chunk.table].lastFrame = std::max(tables[chunk.table].lastFrame, (int64_t)chunk.lastFrame);
+			}
+
+			// フッターの位置から追記する (フッターは閉じるときに書き直す)
+			dataEnd = footerOffset;
+			input.close();
+			file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+		}
+
+		// ファイルが無ければヘッダーを書き込む
+		else
+		{
+			file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+			std::vector<uint8_t> header(PoseColumnFormat::alignment, 0);
+			std::memcpy(header.data(), PoseColumnFormat::magic, sizeof(PoseColumnFormat::magic));
+			file.write((const char*)header.data(), (std::streamsize)header.size());
+			dataEnd = header.size();
+		}
+
+		if (!file.is_open() || !file.good())
+		{
+			std::cout << path << u8"を開けませんでした。" << std::endl;
+			file.close();
+			return 1;
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+PoseColumnWriter::Table* PoseColumnWriter::getTable(const std::string& tableName, Kind kind)
+{
+	for (auto&& table : tables)
+	{
+		if (table.name == tableName) return (table.kind == kind) ? &table : nullptr;
+	}
+	Table table;
+	table.name = tableName;
+	table.kind = kind;
+	tables.push_back(table);
+	return &tables.back();
+}
+
+int PoseColumnWriter::appendPeople(const std::string& tableName, size_t frameNumber, const MinOpenPose::People& people)
+{
+	if (!isOpen()) return 1;
+	Table* table = getTable(tableName, Kind::People);
+	if (table == nullptr) return 1;
+
+	// 既に追記したフレーム以前のフレームは無視する
+	if ((int64_t)frameNumber <= table->lastFrame) return 0;
+	table->lastFrame = (int64_t)frameNumber;
+
+	for (auto&& person : people)
+	{
+		table->frames.push_back((uint64_t)frameNumber);
+		table->ids.push_back((uint32_t)person.first);
+		for (size_t nodeIndex = 0; nodeIndex < 25; nodeIndex++)
+		{
+			const MinOpenPose::Node node = (nodeIndex < person.second.size()) ? person.second[nodeIndex] : MinOpenPose::Node{ 0.0f, 0.0f, 0.0f };
+			table->values.push_back(node.x);
+			table->values.push_back(node.y);
+			table->values.push_back(node.confidence);
+		}
+	}
+
+	if (table->frames.size() >= chunkRows) return writeChunk((uint32_t)(table - tables.data()));
+	return 0;
+}
+
+int PoseColumnWriter::appendPoints(const std::string& tableName, size_t frameNumber, const std::map<size_t, MinOpenPose::Node>& points)
+{
+	if (!isOpen()) return 1;
+	Table* table = getTable(tableName, Kind::Points);
+	if (table == nullptr) return 1;
+
+	// 既に追記したフレーム以前のフレームは無視する
+	if ((int64_t)frameNumber <= table->lastFrame) return 0;
+	table->lastFrame = (int64_t)frameNumber;
+
+	for (auto&& point : points)
+	{
+		table->frames.push_back((uint64_t)frameNumber);
+		table->ids.push_back((uint32_t)point.first);
+		table->values.push_back(point.second.x);
+		table->values.push_back(point.second.y);
+	}
+
+	if (table->frames.size() >= chunkRows) return writeChunk((uint32_t)(table - tables.data()));
+	return 0;
+}
+
+int PoseColumnWriter::writeChunk(uint32_t tableIndex)
+{
+	Table& table = tables[tableIndex];
+	if (table.frames.empty()) return 0;
+
+	try
+	{
+		PoseColumnFormat::ChunkInfo chunk{
+			tableIndex, (uint64_t)table.frames.size(), table.frames.front(), table.frames.back(), PoseColumnFormat::align(dataEnd)
+		};
+
+		// 各列を境界に揃えて書き込む (列の間は0で埋める)
+		static const char zeros[PoseColumnFormat::alignment] = {};
+		auto writeColumn = [&](uint64_t& position, uint64_t offset, const void* src, size_t bytes) {
+			file.seekp((std::streamoff)position, std::ios::beg);
+			file.write(zeros, (std::streamsize)(offset - position));
+			file.write((const char*)src, (std::streamsize)bytes);
+			position = offset + bytes;
+		};
+		uint64_t position = dataEnd;
+		writeColumn(position, chunk.offset, table.frames.data(), table.frames.size() * sizeof(uint64_t));
+		writeColumn(position, PoseColumnFormat::idsOffset(chunk), table.ids.data(), table.ids.size() * sizeof(uint32_t));
+		writeColumn(position, PoseColumnFormat::valuesOffset(chunk), table.values.data(), table.values.size() * sizeof(float));
+		if (!file.good()) throw std::runtime_error(u8"failed to write " + path);
+
+		dataEnd = position;
+		chunks.push_back(chunk);
+		table.frames.clear();
+		table.ids.clear();
+		table.values.clear();
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+int PoseColumnWriter::writeFooter()
+{
+	try
+	{
+		// テーブルの一覧
+		std::vector<uint8_t> footer;
+		put(footer, (uint32_t)tables.size());
+		for (auto&& table : tables)
+		{
+			put(footer, (uint16_t)table.name.size());
+			footer.insert(footer.end(), table.name.begin(), table.name.end());
+			put(footer, (uint8_t)table.kind);
+		}
+
+		// チャンクの一覧
+		put(footer, (uint32_t)chunks.size());
+		for (auto&& chunk : chunks)
+		{
+			put(footer, chunk.table);
+			put(footer, chunk.rows);
+			put(footer, chunk.firstFrame);
+			put(footer, chunk.lastFrame);
+			put(footer, chunk.offset);
+		}
+
+		// 末尾
+		put(footer, dataEnd);
+		put(footer, (uint64_t)(footer.size() - sizeof(uint64_t)));
+		footer.insert(footer.end(), PoseColumnFormat::magic, PoseColumnFormat::magic + sizeof(PoseColumnFormat::magic));
+
+		file.seekp((std::streamoff)dataEnd, std::ios::beg);
+		file.write((const char*)footer.data(), (std::streamsize)footer.size());
+		file.flush();
+		fileEnd = dataEnd + footer.size();
+		if (!file.good()) throw std::runtime_error(u8"failed to write " + path);
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "error : " << __FILE__ << " : L" << __LINE__ << "\n" << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+int PoseColumnWriter::flush()
+{
+	if (!isOpen()) return 1;
+	for (uint32_t tableIndex = 0; tableIndex < tables.size(); tableIndex++)
+	{
+		if (writeChunk(tableIndex)) return 1;
+	}
+	return writeFooter();
+}
+
+int PoseColumnWriter::close()
+{
+	if (!isOpen()) return 0;
+	int ret = flush();
+	file.close();
+
+	// 追記前のフッターの方が長かった場合に備えて、ファイルの末尾を切り詰める
+	if (ret == 0)
+	{
+		std::error_code ec;
+		std::filesystem::resize_file(path, fileEnd, ec);
+	}
+	return ret;
+}
+
+PoseColumnReader::~PoseColumnReader()
+{
+	close();
+}
+
+int PoseColumnReader::open(const std::string& path)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) return 1;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(hFile, &fileSize) || (fileSize.QuadPart == 0)) { CloseHandle(hFile); return 1; }
+	HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (hMapping == NULL) { CloseHandle(hFile); return 1; }
+	const void* view = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == NULL) { CloseHandle(hMapping); CloseHandle(hFile); return 1; }
+	fileHandle = hFile;
+	mappingHandle = hMapping;
+	data = (const uint8_t*)view;
+	size = (size_t)fileSize.QuadPart;
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) return 1;
+	struct stat st;
+	if ((fstat(fd, &st) != 0) || (st.st_size == 0)) { ::close(fd); return 1; }
+	void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (view == MAP_FAILED) { ::close(fd); return 1; }
+	madvise(view, (size_t)st.st_size, MADV_SEQUENTIAL);
+	fileDescriptor = fd;
+	data = (const uint8_t*)view;
+	size = (size_t)st.st_size;
+#endif
+
+	if (readFooter())
+	{
+		close();
+		return 1;
+	}
+	return 0;
+}
+
+void PoseColumnReader::close()
+{
+	if (data != nullptr)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+		CloseHandle((HANDLE)mappingHandle);
+		CloseHandle((HANDLE)fileHandle);
+#else
+		munmap((void*)data, size);
+		::close(fileDescriptor);
+#endif
+	}
+	data = nullptr;
+	size = 0;
+	fileHandle = nullptr;
+	mappingHandle = nullptr;
+	fileDescriptor = -1;
+	tables.clear();
+	chunks.clear();
+}
+
+int PoseColumnReader::readFooter()
+{
+	// ヘッダーと末尾の識別子を確認する
+	if (size < PoseColumnFormat::alignment + tailSize) return 1;
+	if (std::memcmp(data, PoseColumnFormat::magic, sizeof(PoseColumnFormat::magic)) != 0) return 1;
+	const uint8_t* tail = data + size - tailSize;
+	if (std::memcmp(tail + sizeof(uint64_t) * 2, PoseColumnFormat::magic, sizeof(PoseColumnFormat::magic)) != 0) return 1;
+
+	uint64_t footerOffset = 0, footerSize = 0;
+	const uint8_t* p = tail;
+	get(p, data + size, footerOffset);
+	get(p, data + size, footerSize);
+	if ((footerOffset > size) || (footerOffset + footerSize > size)) return 1;
+
+	if (!parseFooter(data + footerOffset, (size_t)footerSize, footerOffset, tables, chunks)) return 1;
+
+	return 0;
+}
+
+std::vector<std::string> PoseColumnReader::getTableNames() const
+{
+	std::vector<std::string> result;
+	for (auto&& table : tables) result.push_back(table.first);
+	return result;
+}
+
+std::vector<PoseColumnReader::Chunk> PoseColumnReader::getChunks(const std::string& tableName) const
+{
+	std::vector<Chunk> result;
+	for (auto&& chunk : chunks)
+	{
+		if (tables[chunk.table].first != tableName) continue;
+		result.push_back(Chunk{
+			(size_t)chunk.rows, chunk.firstFrame, chunk.lastFrame,
+			(const uint64_t*)(data + chunk.offset),
+			(const uint32_t*)(data + PoseColumnFormat::idsOffset(chunk)),
+			(const float*)(data + PoseColumnFormat::valuesOffset(chunk)),
+			PoseColumnFormat::valuesPerRow(tables[chunk.table].second)
+		});
+	}
+	return result;
+}
+
+int PoseColumnReader::readPeopleRange(
+	const std::string& tableName, size_t firstFrame, size_t lastFrame,
+	const std::function<bool(size_t, const MinOpenPose::People&)>& callback
+) const
+{
+	if (data == nullptr) return 1;
+
+	MinOpenPose::People people;
+	bool hasFrame = false;
+	size_t frame = 0;
+	for (auto&& chunk : getChunks(tableName))
+	{
+		// 区間と重ならないチャンクは読み飛ばす
+		if ((chunk.lastFrame < firstFrame) || (chunk.firstFrame >= lastFrame)) continue;
+		if (chunk.valuesPerRow != 75) return 1;
+
+		for (size_t row = 0; row < chunk.rows; row++)
+		{
+			const size_t rowFrame = (size_t)chunk.frames[row];
+			if ((rowFrame < firstFrame) || (rowFrame >= lastFrame)) continue;
+
+			// フレームが変わったら、それまでのフレームを渡す
+			if (hasFrame && (rowFrame != frame))
+			{
+				if (!callback(frame, people)) return 0;
+				people.clear();
+			}
+			frame = rowFrame;
+			hasFrame = true;
+
+			const float* values = chunk.values + row * chunk.valuesPerRow;
+			MinOpenPose::Person& person = people[(size_t)chunk.ids[row]];
+			person.resize(25);
+			for (size_t nodeIndex = 0; nodeIndex < 25; nodeIndex++)
+			{
+				person[nodeIndex] = MinOpenPose::Node{ values[nodeIndex * 3 + 0], values[nodeIndex * 3 + 1], values[nodeIndex * 3 + 2] };
+			}
+		}
+	}
+	if (hasFrame) (void)callback(frame, people);
+
+	return 0;
+}
+
+int PoseColumnReader::readPointsRange(
+	const std::string& tableName, size_t firstFrame, size_t lastFrame,
+	const std::function<bool(size_t, const std::map<size_t, MinOpenPose::Node>&)>& callback
+) const
+{
+	if (data == nullptr) return 1;
+
+	std::map<size_t, MinOpenPose::Node> points;
+	size_t frame = firstFrame;
+	for (auto&& chunk : getChunks(tableName))
+	{
+		// 区間と重ならないチャンクは読み飛ばす
+		if ((chunk.lastFrame < firstFrame) || (chunk.firstFrame >= lastFrame)) continue;
+		if (chunk.valuesPerRow != 2) return 1;
+
+		for (size_t row = 0; row < chunk.rows; row++)
+		{
+			const size_t rowFrame = (size_t)chunk.frames[row];
+			if ((rowFrame < firstFrame) || (rowFrame >= lastFrame)) continue;
+
+			// フレームが変わったら、それまでのフレームを渡す
+			for (; frame < rowFrame; frame++)
+			{
+				if (!callback(frame, points)) return 0;
+				points.clear();
+			}
+
+			const float* values = chunk.values + row * chunk.valuesPerRow;
+			points[(size_t)chunk.ids[row]] = MinOpenPose::Node{ values[0], values[1], 0.0f };
+		}
+	}
+	for (; frame < lastFrame; frame++)
+	{
+		if (!callback(frame, points)) return 0;
+		points.clear();
+	}
+
+	return 0;
+}
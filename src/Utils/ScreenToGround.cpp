@@ -12,7 +12,7 @@ namespace vt
 		float rect_width, float rect_height
 	)
 	{
-		// p[^ɕύXȂΌvZsȂ悤ɂ
+		// パラメータに変更がなければ計算を行わないようにする
 		if (
 			(this->cam_w != cam_w) ||
 			(this->cam_h != cam_h) ||
@@ -23,7 +23,7 @@ namespace vt
 			(rect_size != cv::Point2f(rect_width, rect_height))
 		)
 		{
-			// Ɏw肳ꂽlL^
+			// 引数に指定された値を記録する
 			this->cam_w = cam_w;
 			this->cam_h = cam_h;
 			p1_ = cv::Point2f{ x1, y1 };
@@ -32,13 +32,13 @@ namespace vt
 			p4_ = cv::Point2f{ x4, y4 };
 			rect_size = cv::Point2f{ rect_width, rect_height };
 
-			// cݕ␳4_
+			// 歪み補正後の4点
 			p1 = fisheyeToFlat.translate(p1_, this->cam_w, this->cam_h);
 			p2 = fisheyeToFlat.translate(p2_, this->cam_w, this->cam_h);
 			p3 = fisheyeToFlat.translate(p3_, this->cam_w, this->cam_h);
 			p4 = fisheyeToFlat.translate(p4_, this->cam_w, this->cam_h);
 
-			// ϊs߂
+			// 透視変換行列を求める
 			std::vector<cv::Point2f> srcPoint = { p1, p2, p3, p4 };
 			std::vector<cv::Point2f> dstPoint = {
 				cv::Point2f{ 0          , 0           },
@@ -63,13 +63,13 @@ namespace vt
 	}
 	cv::Point2f ScreenToGround::translate(cv::Point2f p) const
 	{
-		// ჌YɂcݏC
+		// 魚眼レンズによる歪み修正
 		p = fisheyeToFlat.translate(p, cam_w, cam_h);
 		
-		// s̐擪AhX߂
+		// 行列の先頭アドレスを求める
 		const double* mat = perspectiveTransformMatrix.ptr<double>(0);
 
-		// pxNgmats̐
+		// pベクトルとmat行列の積
 		cv::Point3f result{
 			p.x * (float)mat[0] + p.y * (float)mat[1] + 1.0f * (float)mat[2],
 			p.x * (float)mat[3] + p.y * (float)mat[4] + 1.0f * (float)mat[5],
@@ -83,7 +83,7 @@ namespace vt
 	}
 	cv::Mat ScreenToGround::translateMat(const cv::Mat& src, float zoom, bool drawLine)
 	{
-		// ϊs߂
+		// 透視変換行列を求める
 		std::vector<cv::Point2f> srcPoint = { p1, p2, p3, p4 };
 		std::vector<cv::Point2f> dstPoint = {
 			plot({0.f, 0.f}, src, zoom),
@@ -93,7 +93,7 @@ namespace vt
 		};
 		auto mat = cv::getPerspectiveTransform(srcPoint, dstPoint);
 
-		//}`ϊ
+		//図形変換処理
 		cv::Mat dst = fisheyeToFlat.translateMat(src);
 		cv::warpPerspective(dst, dst, mat, dst.size(), cv::INTER_LINEAR);
 
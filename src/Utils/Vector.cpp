@@ -1,3 +1,3 @@
-#pragma once
-
-#include <Utils/Vector.h>
+#pragma once
+
+#include <Utils/Vector.h>